@@ -0,0 +1,106 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+
+"""
+Measure CPU broadcast and reduction throughput over a matrix of shapes and axes, e.g.
+
+    OMP_NUM_THREADS=1 python broadcast_reduce.py
+    OMP_NUM_THREADS=8 python broadcast_reduce.py
+
+Each case reports the time per call and the bandwidth in GB/s counting the bytes of
+every input read once and the output written once.
+"""
+import time
+import argparse
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark CPU broadcast and reduction operators",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--repeat', type=int, default=20,
+                    help='number of timed calls per case')
+PARSER.add_argument('--dtype', type=str, default='float32',
+                    help='data type of the inputs')
+
+# (shape, reduce axes) pairs covering the inner axis, the outer axis, a middle axis,
+# several axes and the whole array.
+REDUCE_CASES = [
+    ((4096, 4096), (1,)),
+    ((4096, 4096), (0,)),
+    ((64, 1024, 256), (1,)),
+    ((64, 1024, 256), (0, 2)),
+    ((16777216,), None),
+    ((1048576, 16), (1,)),
+    ((16, 1048576), (0,)),
+]
+
+# (lhs shape, rhs shape) pairs where the rhs is broadcast along different axes.
+BROADCAST_CASES = [
+    ((4096, 4096), (1, 4096)),
+    ((4096, 4096), (4096, 1)),
+    ((64, 1024, 256), (64, 1, 256)),
+    ((64, 1024, 256), (1, 1024, 1)),
+    ((1048576, 16), (1, 16)),
+    ((16, 1048576), (16, 1)),
+]
+
+
+def timeit(func, repeat):
+    func().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = func()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+def report(name, shape, extra, sec, nbytes):
+    print('%-14s %-18s %-16s %9.3f ms %8.2f GB/s'
+          % (name, shape, extra, sec * 1e3, nbytes / sec / 1e9))
+
+
+def run_reduce(repeat, dtype):
+    for shape, axis in REDUCE_CASES:
+        data = mx.nd.array(np.random.uniform(-1, 1, shape), dtype=dtype)
+        for name in ['sum', 'mean', 'max', 'prod']:
+            func = getattr(mx.nd, name)
+            sec = timeit(lambda: func(data, axis=axis), repeat)
+            out_size = np.prod([1 if axis is None or i in axis else n
+                                for i, n in enumerate(shape)])
+            report(name, shape, 'axis=%s' % (axis,), sec,
+                   (data.size + out_size) * data.dtype(0).itemsize)
+
+
+def run_broadcast(repeat, dtype):
+    for lshape, rshape in BROADCAST_CASES:
+        lhs = mx.nd.array(np.random.uniform(-1, 1, lshape), dtype=dtype)
+        rhs = mx.nd.array(np.random.uniform(-1, 1, rshape), dtype=dtype)
+        for name in ['broadcast_add', 'broadcast_mul']:
+            func = getattr(mx.nd, name)
+            sec = timeit(lambda: func(lhs, rhs), repeat)
+            report(name, lshape, 'rhs=%s' % (rshape,), sec,
+                   (2 * lhs.size + rhs.size) * lhs.dtype(0).itemsize)
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    run_reduce(ARGS.repeat, ARGS.dtype)
+    run_broadcast(ARGS.repeat, ARGS.dtype)
@@ -0,0 +1,110 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+
+"""
+Measure CPU Convolution forward and backward time on the convolution layers of ResNet-50,
+comparing the per-image im2col path (workspace=0) with the batched GEMM and Winograd
+paths the operator takes within its default workspace, e.g.
+
+    python convolution.py --batch-size 32
+
+Set MXNET_CPU_WINOGRAD_CONV=0 to time the batched im2col path for the 3x3 layers instead.
+"""
+import time
+import argparse
+
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark CPU convolution on ResNet-50 layers",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch-size', type=int, default=32,
+                    help='batch size')
+PARSER.add_argument('--repeat', type=int, default=5,
+                    help='number of timed iterations per layer')
+PARSER.add_argument('--workspace', type=int, default=1024,
+                    help='workspace (MB) of the batched run')
+PARSER.add_argument('--forward-only', action='store_true',
+                    help='only time the forward pass')
+
+# (input size, input channels, output channels, kernel, stride, pad) of the distinct
+# convolution layers of ResNet-50 v1
+RESNET50_LAYERS = [
+    (224, 3, 64, 7, 2, 3),
+    (56, 64, 64, 1, 1, 0),
+    (56, 64, 64, 3, 1, 1),
+    (56, 64, 256, 1, 1, 0),
+    (56, 256, 64, 1, 1, 0),
+    (56, 256, 128, 1, 1, 0),
+    (56, 128, 128, 3, 2, 1),
+    (56, 256, 512, 1, 2, 0),
+    (28, 128, 512, 1, 1, 0),
+    (28, 512, 128, 1, 1, 0),
+    (28, 128, 128, 3, 1, 1),
+    (28, 512, 256, 1, 1, 0),
+    (28, 256, 256, 3, 2, 1),
+    (28, 512, 1024, 1, 2, 0),
+    (14, 256, 1024, 1, 1, 0),
+    (14, 1024, 256, 1, 1, 0),
+    (14, 256, 256, 3, 1, 1),
+    (14, 1024, 512, 1, 1, 0),
+    (14, 512, 512, 3, 2, 1),
+    (14, 1024, 2048, 1, 2, 0),
+    (7, 512, 2048, 1, 1, 0),
+    (7, 2048, 512, 1, 1, 0),
+    (7, 512, 512, 3, 1, 1),
+]
+
+
+def time_layer(layer, batch_size, workspace, repeat, forward_only):
+    size, in_channels, out_channels, kernel, stride, pad = layer
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data=data, num_filter=out_channels, kernel=(kernel, kernel),
+                              stride=(stride, stride), pad=(pad, pad), workspace=workspace)
+    exe = conv.simple_bind(mx.cpu(), data=(batch_size, in_channels, size, size),
+                           grad_req='null' if forward_only else 'write')
+    for arr in exe.arg_arrays:
+        arr[:] = mx.nd.random.uniform(-1, 1, arr.shape)
+
+    def step():
+        exe.forward(is_train=not forward_only)
+        if not forward_only:
+            exe.backward(exe.outputs[0])
+        mx.nd.waitall()
+
+    step()
+    tic = time.time()
+    for _ in range(repeat):
+        step()
+    return (time.time() - tic) / repeat
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    TOTAL_BASE, TOTAL = 0., 0.
+    for LAYER in RESNET50_LAYERS:
+        BASE = time_layer(LAYER, ARGS.batch_size, 0, ARGS.repeat, ARGS.forward_only)
+        SEC = time_layer(LAYER, ARGS.batch_size, ARGS.workspace, ARGS.repeat, ARGS.forward_only)
+        TOTAL_BASE += BASE
+        TOTAL += SEC
+        print('%3dx%-3d %4d -> %-4d k%d s%d  per-image %9.2f ms  batched %9.2f ms  speedup %.2fx'
+              % (LAYER[0], LAYER[0], LAYER[1], LAYER[2], LAYER[3], LAYER[4],
+                 BASE * 1e3, SEC * 1e3, BASE / SEC))
+    print('total   per-image %9.2f ms  batched %9.2f ms  speedup %.2fx'
+          % (TOTAL_BASE * 1e3, TOTAL * 1e3, TOTAL_BASE / TOTAL))
@@ -0,0 +1,86 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+"""
+Measure the CPU time of CTCLoss forward and backward over (sequence length, batch, alphabet)
+settings, e.g.
+
+    python ctc.py --settings 100,32,29 400,32,29 200,16,5000
+
+Label lengths are up to a quarter of the sequence length, data lengths are drawn between
+half and the full sequence length. CTCLoss computes the gradient together with the loss,
+backward only scales it by the head gradient.
+"""
+import time
+import argparse
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark CTCLoss on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--settings', type=str, nargs='+',
+                    default=['100,32,29', '400,32,29', '800,16,29', '200,16,5000'],
+                    help='comma separated sequence length, batch size and alphabet size')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed calls per setting')
+
+
+def make_inputs(seq_len, batch, alphabet):
+    data = mx.nd.random.normal(0, 2, shape=(seq_len, batch, alphabet))
+    data_lens = np.random.randint(seq_len // 2, seq_len + 1, batch)
+    label_len = max(seq_len // 4, 1)
+    label_lens = np.random.randint(1, label_len + 1, batch)
+    labels = np.random.randint(1, alphabet, (batch, label_len))
+    return (data, mx.nd.array(labels), mx.nd.array(data_lens), mx.nd.array(label_lens))
+
+
+def time_ctc(inputs, backward, repeat):
+    data, labels, data_lens, label_lens = inputs
+    data.attach_grad()
+
+    def ctc():
+        return mx.nd.contrib.CTCLoss(data, labels, data_lens, label_lens,
+                                     use_data_lengths=True, use_label_lengths=True)
+
+    def run():
+        if not backward:
+            return ctc()
+        with mx.autograd.record():
+            loss = ctc()
+        loss.backward()
+        return data.grad
+
+    run().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = run()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    for SETTING in ARGS.settings:
+        SEQ_LEN, BATCH, ALPHABET = [int(x) for x in SETTING.split(',')]
+        INPUTS = make_inputs(SEQ_LEN, BATCH, ALPHABET)
+        FORWARD = time_ctc(INPUTS, False, ARGS.repeat)
+        TRAIN = time_ctc(INPUTS, True, ARGS.repeat)
+        print('T=%-5d batch=%-4d alphabet=%-6d forward %9.3f ms  forward+backward %9.3f ms'
+              % (SEQ_LEN, BATCH, ALPHABET, FORWARD * 1e3, TRAIN * 1e3))
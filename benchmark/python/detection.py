@@ -0,0 +1,116 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+"""
+Measure the CPU time of ROIPooling forward and backward with thousands of rois, and of the
+Proposal and MultiBoxDetection post-processing, e.g.
+
+    OMP_NUM_THREADS=8 python detection.py --num-rois 4000
+
+Run it with different OMP_NUM_THREADS to see how the operators scale.
+"""
+import time
+import argparse
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark ROIPooling and detection "
+                                             "post-processing on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch', type=int, default=2,
+                    help='number of images')
+PARSER.add_argument('--channels', type=int, default=256,
+                    help='channels of the pooled feature map')
+PARSER.add_argument('--feat-shape', type=str, default='38,50',
+                    help='height,width of the stride 16 feature map')
+PARSER.add_argument('--num-rois', type=int, default=2000,
+                    help='number of rois of ROIPooling')
+PARSER.add_argument('--pooled-size', type=int, default=7,
+                    help='pooled_size of ROIPooling')
+PARSER.add_argument('--pre-nms', type=int, default=6000,
+                    help='rpn_pre_nms_top_n of Proposal')
+PARSER.add_argument('--post-nms', type=int, default=300,
+                    help='rpn_post_nms_top_n of Proposal')
+PARSER.add_argument('--num-anchors', type=int, default=8732,
+                    help='number of anchors of MultiBoxDetection')
+PARSER.add_argument('--num-classes', type=int, default=21,
+                    help='number of classes of MultiBoxDetection, background included')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed calls per operator')
+
+
+def time_op(func, repeat):
+    func().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = func()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+def random_rois(num_rois, batch, height, width):
+    x1 = np.random.uniform(0, width - 1, num_rois)
+    y1 = np.random.uniform(0, height - 1, num_rois)
+    x2 = np.minimum(x1 + np.random.uniform(1, width / 2., num_rois), width - 1)
+    y2 = np.minimum(y1 + np.random.uniform(1, height / 2., num_rois), height - 1)
+    index = np.random.randint(0, batch, num_rois)
+    return mx.nd.array(np.stack([index, x1, y1, x2, y2], axis=1))
+
+
+def roi_pooling_backward(data, rois, pooled_size):
+    data.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.ROIPooling(data, rois, pooled_size=pooled_size, spatial_scale=0.0625)
+    out.backward(mx.nd.ones_like(out))
+    return data.grad
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    HEIGHT, WIDTH = [int(x) for x in ARGS.feat_shape.split(',')]
+    POOLED = (ARGS.pooled_size, ARGS.pooled_size)
+    DATA = mx.nd.random.uniform(shape=(ARGS.batch, ARGS.channels, HEIGHT, WIDTH))
+    ROIS = random_rois(ARGS.num_rois, ARGS.batch, HEIGHT * 16, WIDTH * 16)
+
+    NUM_ANCHORS = 12
+    CLS_PROB = mx.nd.random.uniform(shape=(1, 2 * NUM_ANCHORS, HEIGHT, WIDTH))
+    BBOX_PRED = mx.nd.random.normal(0, 0.1, shape=(1, 4 * NUM_ANCHORS, HEIGHT, WIDTH))
+    IM_INFO = mx.nd.array([[HEIGHT * 16, WIDTH * 16, 1.0]])
+
+    MBOX_PROB = mx.nd.softmax(mx.nd.random.normal(
+        shape=(ARGS.batch, ARGS.num_classes, ARGS.num_anchors)), axis=1)
+    MBOX_LOC = mx.nd.random.normal(0, 0.1, shape=(ARGS.batch, ARGS.num_anchors * 4))
+    CENTER = np.random.uniform(0.05, 0.95, (ARGS.num_anchors, 2))
+    SIZE = np.random.uniform(0.05, 0.3, (ARGS.num_anchors, 2))
+    MBOX_ANCHOR = mx.nd.array(np.hstack([CENTER - SIZE / 2, CENTER + SIZE / 2])
+                              .reshape((1, ARGS.num_anchors, 4)))
+
+    BENCHMARKS = [
+        ('ROIPooling forward', lambda: mx.nd.ROIPooling(
+            DATA, ROIS, pooled_size=POOLED, spatial_scale=0.0625)),
+        ('ROIPooling backward', lambda: roi_pooling_backward(DATA, ROIS, POOLED)),
+        ('Proposal', lambda: mx.nd.contrib.Proposal(
+            CLS_PROB, BBOX_PRED, IM_INFO, rpn_pre_nms_top_n=ARGS.pre_nms,
+            rpn_post_nms_top_n=ARGS.post_nms)),
+        ('MultiBoxDetection', lambda: mx.nd.contrib.MultiBoxDetection(
+            MBOX_PROB, MBOX_LOC, MBOX_ANCHOR, threshold=0.01, nms_threshold=0.45)),
+    ]
+    for NAME, FUNC in BENCHMARKS:
+        print('%-20s %10.3f ms' % (NAME, time_op(FUNC, ARGS.repeat) * 1e3))
@@ -0,0 +1,81 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+
+"""
+Measure the CPU backward time of Embedding at realistic vocabulary and batch sizes, e.g.
+
+    OMP_NUM_THREADS=1 python embedding.py
+    OMP_NUM_THREADS=16 python embedding.py
+
+Token ids are drawn from a Zipf distribution, so frequent rows receive many updates
+as they do in language models, or uniformly with --uniform.
+"""
+import time
+import argparse
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark Embedding backward on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--vocab-sizes', type=str, default='10000,100000,500000',
+                    help='comma separated list of vocabulary sizes')
+PARSER.add_argument('--num-tokens', type=str, default='4096,65536',
+                    help='comma separated list of tokens per batch (batch size * sequence length)')
+PARSER.add_argument('--dims', type=str, default='128,256',
+                    help='comma separated list of embedding sizes')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed backward passes per case')
+PARSER.add_argument('--uniform', action='store_true',
+                    help='draw token ids uniformly instead of from a Zipf distribution')
+
+
+def token_ids(vocab, num_tokens, uniform):
+    if uniform:
+        return np.random.randint(0, vocab, size=num_tokens)
+    return np.minimum(np.random.zipf(1.2, size=num_tokens) - 1, vocab - 1)
+
+
+def time_backward(vocab, num_tokens, dim, repeat, uniform):
+    data = mx.sym.Variable('data')
+    embed = mx.sym.Embedding(data=data, input_dim=vocab, output_dim=dim, name='embed')
+    exe = embed.simple_bind(mx.cpu(), grad_req={'data': 'null', 'embed_weight': 'write'},
+                            data=(num_tokens,))
+    exe.arg_dict['data'][:] = token_ids(vocab, num_tokens, uniform)
+    exe.forward(is_train=True)
+    out_grad = mx.nd.random.uniform(-1, 1, exe.outputs[0].shape)
+    exe.backward([out_grad])
+    mx.nd.waitall()
+    tic = time.time()
+    for _ in range(repeat):
+        exe.backward([out_grad])
+    mx.nd.waitall()
+    return (time.time() - tic) / repeat
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    for VOCAB in [int(n) for n in ARGS.vocab_sizes.split(',')]:
+        for TOKENS in [int(n) for n in ARGS.num_tokens.split(',')]:
+            for DIM in [int(n) for n in ARGS.dims.split(',')]:
+                SEC = time_backward(VOCAB, TOKENS, DIM, ARGS.repeat, ARGS.uniform)
+                print('vocab %-8d tokens %-7d dim %-5d backward %9.3f ms  %8.2f GB/s'
+                      % (VOCAB, TOKENS, DIM, SEC * 1e3,
+                         2 * TOKENS * DIM * 4 / SEC / 1e9))
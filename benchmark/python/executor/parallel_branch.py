@@ -0,0 +1,79 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""
+Compare cpu inference latency of multi-branch networks with and without
+running independent branches of a bulked segment concurrently
+(MXNET_EXEC_BULK_EXEC_PARALLEL_BRANCH).
+"""
+import os
+import sys
+import time
+import argparse
+from importlib import import_module
+
+import mxnet as mx
+
+CURR_PATH = os.path.dirname(os.path.abspath(os.path.expanduser(__file__)))
+sys.path.insert(0, os.path.join(CURR_PATH, '../../../example/image-classification'))
+
+PARSER = argparse.ArgumentParser(description="Benchmark branch parallel bulk execution",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--networks', type=str, default='googlenet,inception-bn,inception-v3',
+                    help='comma separated list of networks in example/image-classification/symbols')
+PARSER.add_argument('--batch-sizes', type=str, default='1,4,16',
+                    help='comma separated list of batch sizes')
+PARSER.add_argument('--num-batches', type=int, default=20,
+                    help='number of timed batches')
+ARGS = PARSER.parse_args()
+
+
+def get_symbol(network):
+    image_shape = (3, 299, 299) if network == 'inception-v3' else (3, 224, 224)
+    net = import_module('symbols.' + network)
+    sym = net.get_symbol(num_classes=1000, image_shape=','.join([str(i) for i in image_shape]))
+    return sym, image_shape
+
+
+def measure(sym, data_shape, parallel_branch):
+    # the flag is read when the executor is bound
+    os.environ['MXNET_EXEC_BULK_EXEC_PARALLEL_BRANCH'] = '1' if parallel_branch else '0'
+    mod = mx.mod.Module(symbol=sym, context=mx.cpu(), label_names=None)
+    mod.bind(for_training=False, inputs_need_grad=False, data_shapes=[('data', data_shape)])
+    mod.init_params(initializer=mx.init.Xavier(magnitude=2.))
+    batch = mx.io.DataBatch([mx.nd.random.uniform(-1.0, 1.0, shape=data_shape)], [])
+    dry_run = 5
+    for i in range(dry_run + ARGS.num_batches):
+        if i == dry_run:
+            tic = time.time()
+        mod.forward(batch, is_train=False)
+        for output in mod.get_outputs():
+            output.wait_to_read()
+    return (time.time() - tic) * 1000.0 / ARGS.num_batches
+
+
+if __name__ == '__main__':
+    print("%16s %10s %16s %16s %8s" % ('network', 'batch', 'sequential(ms)', 'parallel(ms)',
+                                       'speedup'))
+    for network in ARGS.networks.split(','):
+        sym, image_shape = get_symbol(network)
+        for batch_size in [int(b) for b in ARGS.batch_sizes.split(',')]:
+            data_shape = (batch_size,) + image_shape
+            seq = measure(sym, data_shape, False)
+            par = measure(sym, data_shape, True)
+            print("%16s %10d %16.2f %16.2f %8.2f" % (network, batch_size, seq, par, seq / par))
@@ -0,0 +1,69 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""
+Measure the CPU throughput of contrib.fft, contrib.ifft and contrib.count_sketch, e.g.
+
+    python fft.py --batch 256 --dims 128,1000,1024,4096
+
+Lengths with large prime factors take the generic radix path and are slower per element.
+"""
+import time
+import argparse
+
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark fft, ifft and count_sketch on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch', type=int, default=256,
+                    help='number of transforms per call')
+PARSER.add_argument('--dims', type=str, default='128,1000,1024,4096',
+                    help='comma separated list of transform lengths')
+PARSER.add_argument('--sketch-dim', type=int, default=1024,
+                    help='out_dim of count_sketch')
+PARSER.add_argument('--repeat', type=int, default=20,
+                    help='number of timed calls per setting')
+
+
+def time_op(func, repeat):
+    func().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = func()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+def run(batch, dim, sketch_dim, repeat):
+    real = mx.nd.random.normal(shape=(batch, dim))
+    cplx = mx.nd.random.normal(shape=(batch, 2 * dim))
+    h = mx.nd.array(mx.nd.random.uniform(0, sketch_dim, shape=(1, dim)).floor())
+    s = mx.nd.random.uniform(0, 2, shape=(1, dim)).floor() * 2 - 1
+    for name, func in [('fft', lambda: mx.nd.contrib.fft(real)),
+                       ('ifft', lambda: mx.nd.contrib.ifft(cplx)),
+                       ('count_sketch', lambda: mx.nd.contrib.count_sketch(
+                           real, h, s, out_dim=sketch_dim))]:
+        sec = time_op(func, repeat)
+        print('%-12s batch=%-5d dim=%-6d %10.3f ms  %10.1f Melem/sec'
+              % (name, batch, dim, sec * 1e3, batch * dim / sec / 1e6))
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    for DIM in [int(d) for d in ARGS.dims.split(',')]:
+        run(ARGS.batch, DIM, ARGS.sketch_dim, ARGS.repeat)
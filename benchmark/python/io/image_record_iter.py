@@ -0,0 +1,163 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""
+Measure ImageRecordIter throughput on a synthetic RecordIO file of large JPEG images,
+with full resolution decoding and with DCT scaled decoding (scaled_decode=True).
+Also reports the image buffer allocations per image made in the timed epoch,
+which should be zero once the per thread buffers have seen the largest image.
+
+With --mode scaling it reports how throughput scales with preprocess_threads, e.g.
+
+    python image_record_iter.py --mode scaling --image-size 96,96 --resize 64 \\
+        --data-shape 3,56,56 --num-images 20000 --threads 1,2,4,8,16,32,64
+
+The iterator caps preprocess_threads at about the number of physical cores.
+"""
+import os
+import re
+import time
+import argparse
+import tempfile
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark ImageRecordIter decoding throughput",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--num-images', type=int, default=512,
+                    help='number of images in the synthetic record file')
+PARSER.add_argument('--image-size', type=str, default='1536,2048',
+                    help='height,width of the encoded images')
+PARSER.add_argument('--data-shape', type=str, default='3,224,224',
+                    help='output data shape')
+PARSER.add_argument('--resize', type=int, default=256,
+                    help='shorter edge after resizing')
+PARSER.add_argument('--batch-size', type=int, default=32,
+                    help='batch size')
+PARSER.add_argument('--threads', type=str, default='1,4',
+                    help='comma separated list of preprocess_threads')
+PARSER.add_argument('--mode', type=str, default='decode', choices=['decode', 'scaling'],
+                    help='compare full and scaled decoding, or thread scaling')
+PARSER.add_argument('--stages', action='store_true',
+                    help='print the per stage (decode, augment, convert) time of each run')
+PARSER.add_argument('--fuse-resize-crop', action='store_true',
+                    help='interpolate the resize and crop straight into the batch')
+PARSER.add_argument('--rec', type=str, default='',
+                    help='existing record file to use instead of a synthetic one')
+ARGS = PARSER.parse_args()
+
+
+def make_record(path, num_images, height, width):
+    """Write num_images smooth random images, which compress like natural photos."""
+    rng = np.random.RandomState(0)
+    record = mx.recordio.MXRecordIO(path, 'w')
+    ys, xs = np.mgrid[0:height, 0:width].astype(np.float32)
+    for i in range(num_images):
+        freq = rng.uniform(0.002, 0.02, size=3)
+        img = np.stack([127.5 * (1 + np.sin(xs * f + ys * f * 0.7 + i)) for f in freq], axis=2)
+        img += rng.uniform(-8, 8, size=img.shape)
+        img = np.clip(img, 0, 255).astype(np.uint8)
+        header = mx.recordio.IRHeader(0, float(i % 1000), i, 0)
+        record.write(mx.recordio.pack_img(header, img, quality=90))
+    record.close()
+
+
+class CaptureStderr(object):
+    """Collect what native code writes to stderr, where the parser logs its counters."""
+    def __init__(self):
+        self.text = ''
+        self._file = None
+        self._saved = None
+
+    def __enter__(self):
+        self._file = tempfile.TemporaryFile(mode='w+')
+        self._saved = os.dup(2)
+        os.dup2(self._file.fileno(), 2)
+        return self
+
+    def __exit__(self, *args):
+        os.dup2(self._saved, 2)
+        os.close(self._saved)
+        self._file.seek(0)
+        self.text = self._file.read()
+        self._file.close()
+
+
+def parse_allocations(log):
+    counts = re.findall(r'(\d+) images decoded with (\d+) image buffer allocations', log)
+    return [(int(images), int(allocs)) for images, allocs in counts]
+
+
+def measure(path, threads, **kwargs):
+    """Return images/sec and allocations/image of the second epoch."""
+    data_iter = mx.io.ImageRecordIter(path_imgrec=path,
+                                      data_shape=tuple(int(i) for i in ARGS.data_shape.split(',')),
+                                      batch_size=ARGS.batch_size,
+                                      resize=ARGS.resize,
+                                      rand_crop=True,
+                                      rand_mirror=True,
+                                      preprocess_threads=threads,
+                                      round_batch=False,
+                                      verbose=True,
+                                      fuse_resize_crop=ARGS.fuse_resize_crop,
+                                      **kwargs)
+    with CaptureStderr() as log:
+        # warm up with one pass so file caches, thread pools and buffers are ready
+        for _ in data_iter:
+            pass
+        data_iter.reset()
+        num_images = 0
+        tic = time.time()
+        for batch in data_iter:
+            batch.data[0].wait_to_read()
+            num_images += ARGS.batch_size - batch.pad
+        toc = time.time()
+        data_iter.reset()
+    stages = re.findall(r'per image .*', log.text)
+    if ARGS.stages and stages:
+        print("  threads=%d %s: %s" % (threads, kwargs, stages[-1]))
+    counts = parse_allocations(log.text)
+    allocs = float('nan')
+    if len(counts) >= 2:
+        allocs = float(counts[-1][1] - counts[-2][1]) / (counts[-1][0] - counts[-2][0])
+    return num_images / (toc - tic), allocs
+
+
+if __name__ == '__main__':
+    rec = ARGS.rec
+    if not rec:
+        height, width = [int(i) for i in ARGS.image_size.split(',')]
+        rec = os.path.join(tempfile.mkdtemp(), 'synthetic.rec')
+        make_record(rec, ARGS.num_images, height, width)
+    if ARGS.mode == 'scaling':
+        print("%8s %16s %16s %8s" % ('threads', 'img/s', 'img/s/thread', 'speedup'))
+        base = None
+        for threads in [int(t) for t in ARGS.threads.split(',')]:
+            speed, _ = measure(rec, threads)
+            base = base or speed
+            print("%8d %16.1f %16.1f %8.2f" % (threads, speed, speed / threads, speed / base))
+        exit(0)
+    print("%8s %16s %16s %16s %8s %12s" % ('threads', 'full(img/s)', 'scaled(img/s)',
+                                           'scaled/core', 'speedup', 'allocs/img'))
+    for threads in [int(t) for t in ARGS.threads.split(',')]:
+        full, full_allocs = measure(rec, threads, scaled_decode=False)
+        scaled, scaled_allocs = measure(rec, threads, scaled_decode=True)
+        print("%8d %16.1f %16.1f %16.1f %8.2f %12.3f" % (threads, full, scaled,
+                                                         scaled / threads, scaled / full,
+                                                         max(full_allocs, scaled_allocs)))
@@ -0,0 +1,118 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+"""
+Measure LibSVMIter and CSVIter parsing throughput in rows/sec on synthetic text files,
+and how it scales with preprocess_threads, e.g.
+
+    python text_iter.py --num-rows 200000 --threads 1,2,4,8,16
+
+With --cache the iterators write a binary cache in the untimed first epoch,
+so the timed epochs read the mapped cache instead of parsing text.
+"""
+import os
+import time
+import argparse
+import tempfile
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark CSVIter and LibSVMIter parsing throughput",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--num-rows', type=int, default=100000,
+                    help='number of rows in the synthetic files')
+PARSER.add_argument('--num-features', type=int, default=10000,
+                    help='number of columns of the libsvm data')
+PARSER.add_argument('--nnz', type=int, default=64,
+                    help='number of non-zero entries per libsvm row')
+PARSER.add_argument('--csv-width', type=int, default=256,
+                    help='number of columns of the csv data')
+PARSER.add_argument('--batch-size', type=int, default=256,
+                    help='batch size')
+PARSER.add_argument('--threads', type=str, default='1,2,4,8',
+                    help='comma separated list of preprocess_threads')
+PARSER.add_argument('--epochs', type=int, default=2,
+                    help='number of timed epochs per setting')
+PARSER.add_argument('--cache', action='store_true',
+                    help='time epochs read from the binary cache_file')
+
+
+def write_libsvm(path, num_rows, num_features, nnz):
+    rng = np.random.RandomState(0)
+    with open(path, 'w') as fout:
+        for _ in range(num_rows):
+            cols = np.sort(rng.choice(num_features, nnz, replace=False))
+            vals = rng.uniform(-1, 1, nnz)
+            entries = ' '.join('%d:%.6f' % (c, v) for c, v in zip(cols, vals))
+            fout.write('%d %s\n' % (rng.randint(2), entries))
+
+
+def write_csv(path, num_rows, width):
+    rng = np.random.RandomState(0)
+    np.savetxt(path, rng.uniform(-1, 1, (num_rows, width)), fmt='%.6f', delimiter=',')
+
+
+def rows_per_sec(make_iter, num_rows, epochs):
+    data_iter = make_iter()
+    for _ in data_iter:
+        pass
+    tic = time.time()
+    for _ in range(epochs):
+        data_iter.reset()
+        for _ in data_iter:
+            pass
+    return num_rows * epochs / (time.time() - tic)
+
+
+def run(name, make_iter, num_rows, threads, epochs, cache):
+    base = None
+    for nthread in threads:
+        if cache and os.path.exists(cache):
+            os.remove(cache)
+        speed = rows_per_sec(lambda: make_iter(nthread), num_rows, epochs)
+        base = base or speed
+        print('%-10s preprocess_threads=%-3d %12.0f rows/sec  speedup %.2fx'
+              % (name, nthread, speed, speed / base))
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    THREADS = [int(t) for t in ARGS.threads.split(',')]
+    TMP = tempfile.mkdtemp()
+    LIBSVM = os.path.join(TMP, 'data.libsvm')
+    CSV = os.path.join(TMP, 'data.csv')
+    write_libsvm(LIBSVM, ARGS.num_rows, ARGS.num_features, ARGS.nnz)
+    write_csv(CSV, ARGS.num_rows, ARGS.csv_width)
+    CACHE = os.path.join(TMP, 'cache.bin') if ARGS.cache else ''
+    try:
+        run('LibSVMIter',
+            lambda n: mx.io.LibSVMIter(data_libsvm=LIBSVM, data_shape=(ARGS.num_features,),
+                                       batch_size=ARGS.batch_size, preprocess_threads=n,
+                                       cache_file=CACHE),
+            ARGS.num_rows, THREADS, ARGS.epochs, CACHE)
+        run('CSVIter',
+            lambda n: mx.io.CSVIter(data_csv=CSV, data_shape=(ARGS.csv_width,),
+                                    batch_size=ARGS.batch_size, preprocess_threads=n,
+                                    cache_file=CACHE),
+            ARGS.num_rows, THREADS, ARGS.epochs, CACHE)
+    finally:
+        for path in os.listdir(TMP):
+            os.remove(os.path.join(TMP, path))
+        os.rmdir(TMP)
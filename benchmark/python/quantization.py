@@ -0,0 +1,118 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Compare the CPU time of float32 and int8 convolution and fully connected layers, e.g.
+
+    python quantization.py --batch 32
+
+The int8 timings are for the quantized operators on already quantized inputs, and
+separately for the whole int8 layer with quantize and requantize, which is what a quantized
+model pays at the boundaries of its quantized subgraphs.
+"""
+import time
+import argparse
+
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark int8 against float32 layers on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch', type=int, default=32,
+                    help='batch size')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed calls per operator')
+
+# (channels, height and width, filters, kernel, stride, pad) of ResNet-50 style convolutions
+CONVOLUTIONS = [
+    (64, 56, 64, 3, 1, 1),
+    (256, 56, 64, 1, 1, 0),
+    (128, 28, 128, 3, 1, 1),
+    (256, 14, 256, 3, 1, 1),
+    (512, 7, 512, 3, 1, 1),
+]
+# (inputs, outputs) of fully connected layers
+FULLY_CONNECTED = [(2048, 1000), (4096, 4096)]
+
+
+def time_op(func, repeat):
+    func().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = func()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+def quantize(data):
+    return mx.nd.contrib.quantize(data, mx.nd.min(data), mx.nd.max(data), out_type='int8')
+
+
+def report(name, fp32, int8, layer):
+    print('%-40s fp32 %8.3f ms  int8 %8.3f ms  int8 layer %8.3f ms  speedup %.2fx' %
+          (name, fp32 * 1e3, int8 * 1e3, layer * 1e3, fp32 / int8))
+
+
+def bench_conv(batch, channels, size, filters, kernel, stride, pad, repeat):
+    data = mx.nd.random.uniform(-1, 1, shape=(batch, channels, size, size))
+    weight = mx.nd.random.normal(0, 0.1, shape=(filters, channels, kernel, kernel))
+    bias = mx.nd.random.normal(0, 0.1, shape=(filters,))
+    kwargs = dict(kernel=(kernel, kernel), stride=(stride, stride), pad=(pad, pad),
+                  num_filter=filters)
+    qdata, qweight, qbias = quantize(data), quantize(weight), quantize(bias)
+    qargs = [qdata[0], qweight[0], qbias[0]] + list(qdata[1:] + qweight[1:] + qbias[1:])
+
+    def layer():
+        quantized = quantize(data)
+        out = mx.nd.contrib.quantized_conv(quantized[0], qweight[0], qbias[0],
+                                           *(quantized[1:] + qweight[1:] + qbias[1:]),
+                                           **kwargs)
+        return mx.nd.contrib.requantize(*out)[0]
+
+    report('conv %dx%dx%d k%d s%d -> %d' % (channels, size, size, kernel, stride, filters),
+           time_op(lambda: mx.nd.Convolution(data, weight, bias, **kwargs), repeat),
+           time_op(lambda: mx.nd.contrib.quantized_conv(*qargs, **kwargs)[0], repeat),
+           time_op(layer, repeat))
+
+
+def bench_fc(batch, num_input, num_hidden, repeat):
+    data = mx.nd.random.uniform(-1, 1, shape=(batch, num_input))
+    weight = mx.nd.random.normal(0, 0.1, shape=(num_hidden, num_input))
+    bias = mx.nd.random.normal(0, 0.1, shape=(num_hidden,))
+    qdata, qweight, qbias = quantize(data), quantize(weight), quantize(bias)
+    qargs = [qdata[0], qweight[0], qbias[0]] + list(qdata[1:] + qweight[1:] + qbias[1:])
+
+    def layer():
+        quantized = quantize(data)
+        out = mx.nd.contrib.quantized_fully_connected(
+            quantized[0], qweight[0], qbias[0], *(quantized[1:] + qweight[1:] + qbias[1:]),
+            num_hidden=num_hidden)
+        return mx.nd.contrib.requantize(*out)[0]
+
+    report('fc %d -> %d' % (num_input, num_hidden),
+           time_op(lambda: mx.nd.FullyConnected(data, weight, bias, num_hidden=num_hidden),
+                   repeat),
+           time_op(lambda: mx.nd.contrib.quantized_fully_connected(
+               *qargs, num_hidden=num_hidden)[0], repeat),
+           time_op(layer, repeat))
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    for CONV in CONVOLUTIONS:
+        bench_conv(ARGS.batch, *CONV, repeat=ARGS.repeat)
+    for FC in FULLY_CONNECTED:
+        bench_fc(ARGS.batch, *FC, repeat=ARGS.repeat)
@@ -0,0 +1,86 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""
+Measure the CPU time of the R-FCN detection head operators: MultiProposal on a batch of
+images, and PSROIPooling / DeformablePSROIPooling over its rois, e.g.
+
+    python rfcn.py --batch 2 --num-classes 21 --group 7
+"""
+import time
+import argparse
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark the R-FCN head operators on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch', type=int, default=2,
+                    help='number of images')
+PARSER.add_argument('--feat-shape', type=str, default='38,50',
+                    help='height,width of the stride 16 feature map')
+PARSER.add_argument('--num-classes', type=int, default=21,
+                    help='output_dim of the position sensitive pooling')
+PARSER.add_argument('--group', type=int, default=7,
+                    help='group_size and pooled_size')
+PARSER.add_argument('--pre-nms', type=int, default=6000,
+                    help='rpn_pre_nms_top_n')
+PARSER.add_argument('--post-nms', type=int, default=300,
+                    help='rpn_post_nms_top_n')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed calls per operator')
+
+
+def time_op(func, repeat):
+    func().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = func()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    HEIGHT, WIDTH = [int(x) for x in ARGS.feat_shape.split(',')]
+    NUM_ANCHORS = 12
+    CLS_PROB = mx.nd.random.uniform(shape=(ARGS.batch, 2 * NUM_ANCHORS, HEIGHT, WIDTH))
+    BBOX_PRED = mx.nd.random.normal(0, 0.1, shape=(ARGS.batch, 4 * NUM_ANCHORS, HEIGHT, WIDTH))
+    IM_INFO = mx.nd.array(np.tile([HEIGHT * 16, WIDTH * 16, 1.0], (ARGS.batch, 1)))
+    ROIS = mx.nd.contrib.MultiProposal(CLS_PROB, BBOX_PRED, IM_INFO,
+                                       rpn_pre_nms_top_n=ARGS.pre_nms,
+                                       rpn_post_nms_top_n=ARGS.post_nms)
+    DATA = mx.nd.random.uniform(shape=(ARGS.batch, ARGS.num_classes * ARGS.group ** 2,
+                                       HEIGHT, WIDTH))
+    TRANS = mx.nd.random.normal(0, 0.1, shape=(ROIS.shape[0], 2, ARGS.group, ARGS.group))
+
+    BENCHMARKS = [
+        ('MultiProposal', lambda: mx.nd.contrib.MultiProposal(
+            CLS_PROB, BBOX_PRED, IM_INFO, rpn_pre_nms_top_n=ARGS.pre_nms,
+            rpn_post_nms_top_n=ARGS.post_nms)),
+        ('PSROIPooling', lambda: mx.nd.contrib.PSROIPooling(
+            DATA, ROIS, spatial_scale=0.0625, output_dim=ARGS.num_classes,
+            pooled_size=ARGS.group, group_size=ARGS.group)),
+        ('DeformablePSROIPooling', lambda: mx.nd.contrib.DeformablePSROIPooling(
+            DATA, ROIS, TRANS, spatial_scale=0.0625, output_dim=ARGS.num_classes,
+            group_size=ARGS.group, pooled_size=ARGS.group, part_size=ARGS.group,
+            sample_per_part=4, trans_std=0.1)),
+    ]
+    for NAME, FUNC in BENCHMARKS:
+        print('%-24s batch=%d rois=%d %10.3f ms'
+              % (NAME, ARGS.batch, ROIS.shape[0], time_op(FUNC, ARGS.repeat) * 1e3))
@@ -0,0 +1,83 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+"""
+Measure the CPU time of the softmax operators on the output layer of a large vocabulary
+language model, e.g.
+
+    python softmax.py --batch 128 --vocab 100000
+
+softmax_cross_entropy computes the loss and gradient straight from the logits, so it is
+compared with softmax followed by the loss computed by separate operators.
+"""
+import time
+import argparse
+
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark the softmax operators on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch', type=int, default=128,
+                    help='number of rows')
+PARSER.add_argument('--vocab', type=int, default=100000,
+                    help='number of classes')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed calls per operator')
+
+
+def time_op(func, repeat):
+    func().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = func()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+
+def forward_backward(func, data, *args):
+    data.attach_grad()
+    with mx.autograd.record():
+        out = func(data, *args)
+    out.backward()
+    return data.grad
+
+
+def separate_loss(data, label):
+    prob = mx.nd.softmax(data)
+    return -mx.nd.log(mx.nd.pick(prob, label) + 1e-8).sum()
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    DATA = mx.nd.random.normal(0, 5, shape=(ARGS.batch, ARGS.vocab))
+    LABEL = mx.nd.array(mx.nd.random.uniform(0, ARGS.vocab, shape=(ARGS.batch,)).floor())
+
+    BENCHMARKS = [
+        ('softmax', lambda: mx.nd.softmax(DATA)),
+        ('log_softmax', lambda: mx.nd.log_softmax(DATA)),
+        ('log_softmax fwd+bwd', lambda: forward_backward(mx.nd.log_softmax, DATA)),
+        ('SoftmaxOutput', lambda: mx.nd.SoftmaxOutput(DATA, LABEL)),
+        ('softmax + pick + log', lambda: separate_loss(DATA, LABEL)),
+        ('softmax_cross_entropy', lambda: mx.nd.softmax_cross_entropy(DATA, LABEL)),
+        ('softmax + pick + log fwd+bwd', lambda: forward_backward(separate_loss, DATA, LABEL)),
+        ('softmax_cross_entropy fwd+bwd',
+         lambda: forward_backward(mx.nd.softmax_cross_entropy, DATA, LABEL)),
+    ]
+    for NAME, FUNC in BENCHMARKS:
+        print('%-30s %10.3f ms' % (NAME, time_op(FUNC, ARGS.repeat) * 1e3))
@@ -0,0 +1,73 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+
+
+"""
+Measure CPU topk time across k and row length, against numpy argpartition + argsort, e.g.
+
+    python topk.py --batch-size 64 --row-lengths 1000,100000 --ks 1,10,100,1000
+"""
+import time
+import argparse
+
+import numpy as np
+import mxnet as mx
+
+PARSER = argparse.ArgumentParser(description="Benchmark topk on CPU",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+PARSER.add_argument('--batch-size', type=int, default=64,
+                    help='number of rows')
+PARSER.add_argument('--row-lengths', type=str, default='100,1000,10000,100000',
+                    help='comma separated list of row lengths')
+PARSER.add_argument('--ks', type=str, default='1,5,10,100,1000',
+                    help='comma separated list of k')
+PARSER.add_argument('--repeat', type=int, default=10,
+                    help='number of timed calls per case')
+
+
+def timeit(func, repeat):
+    func()
+    tic = time.time()
+    for _ in range(repeat):
+        func()
+    return (time.time() - tic) / repeat
+
+
+def numpy_topk(data, k):
+    rows = np.arange(data.shape[0])[:, None]
+    part = np.argpartition(-data, k - 1, axis=1)[:, :k]
+    order = np.argsort(-data[rows, part], axis=1, kind='mergesort')
+    return part[rows, order]
+
+
+if __name__ == '__main__':
+    ARGS = PARSER.parse_args()
+    for length in [int(n) for n in ARGS.row_lengths.split(',')]:
+        data_np = np.random.uniform(size=(ARGS.batch_size, length)).astype(np.float32)
+        data = mx.nd.array(data_np)
+        for k in [int(n) for n in ARGS.ks.split(',')]:
+            if k > length:
+                continue
+            sec = timeit(lambda: mx.nd.topk(data, k=k, ret_typ='both')[1].wait_to_read(),
+                         ARGS.repeat)
+            sec_np = timeit(lambda: numpy_topk(data_np, k), ARGS.repeat)
+            print('rows %-5d length %-8d k %-6d topk %9.3f ms  numpy %9.3f ms  '
+                  '%8.1f Melem/s'
+                  % (ARGS.batch_size, length, k, sec * 1e3, sec_np * 1e3,
+                     ARGS.batch_size * length / sec / 1e6))
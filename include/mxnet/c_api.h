@@ -359,6 +359,27 @@ MXNET_DLL int MXNDArraySave(const char* fname,
                             mx_uint num_args,
                             NDArrayHandle* args,
                             const char** keys);
+/*!
+ * \brief Save list of dense narray into a file that can be loaded by memory mapping it.
+ *  MXNDArrayLoad detects this format and returns cpu arrays pointing into the mapping.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveMappable(const char* fname,
+                                    mx_uint num_args,
+                                    NDArrayHandle* args,
+                                    const char** keys);
+/*!
+ * \brief Convert a file saved by MXNDArraySave into the format of MXNDArraySaveMappable.
+ * \param src_fname name of the file to convert.
+ * \param dst_fname name of the converted file.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayConvertToMappable(const char* src_fname,
+                                         const char* dst_fname);
 /*!
  * \brief Load list of narray from the file.
  * \param fname name of the file.
@@ -49,6 +49,8 @@ typedef float mx_float;
 typedef void *PredictorHandle;
 /*! \brief handle to NDArray list */
 typedef void *NDListHandle;
+/*! \brief handle to batch Predictor */
+typedef void *BatchPredictorHandle;
 
 /*!
  * \brief Get the last error happeneed.
@@ -119,6 +121,66 @@ MXNET_DLL int MXPredCreatePartialOut(const char* symbol_json_str,
                                      mx_uint num_output_nodes,
                                      const char** output_keys,
                                      PredictorHandle* out);
+/*!
+ * \brief create a predictor, loading the parameters from a memory-mapped file
+ *  instead of a user buffer holding the whole file. Files saved in the mappable
+ *  format (MXNDArraySaveMappable) are mapped read-only and used by cpu predictors
+ *  without any copy. Files saved by MXNDArraySave are parsed into copies like in
+ *  MXPredCreate, convert them with MXNDArrayConvertToMappable to avoid the copies.
+ * \param symbol_json_str The JSON string of the symbol.
+ * \param param_file Path of the parameter ndarray file.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictor.
+ * \param num_input_nodes Number of input nodes to the net,
+ *    For feedforward net, this is 1.
+ * \param input_keys The name of input argument.
+ *    For feedforward net, this is {"data"}
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ *    The length of this array = num_input_nodes + 1.
+ *    For feedforward net that takes 4 dimensional input, this is {0, 4}.
+ * \param input_shape_data A flatted data of shapes of each input node.
+ *    For feedforward net that takes 4 dimensional input, this is the shape data.
+ * \param num_output_nodes Number of output nodes to the net, 0 for the outputs of the symbol.
+ * \param output_keys The name of output argument.
+ *    For example {"global_pool"}
+ * \param out The created predictor handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredCreateFromParamFile(const char* symbol_json_str,
+                                        const char* param_file,
+                                        int dev_type, int dev_id,
+                                        mx_uint num_input_nodes,
+                                        const char** input_keys,
+                                        const mx_uint* input_shape_indptr,
+                                        const mx_uint* input_shape_data,
+                                        mx_uint num_output_nodes,
+                                        const char** output_keys,
+                                        PredictorHandle* out);
+/*!
+ * \brief create a predictor that shares the parameters of an existing predictor.
+ *  The parameters are shared read-only without a copy when the device is the same,
+ *  so that several predictors, e.g. one per thread or one per input shape, cost
+ *  one copy of the weights. The base predictor must outlive the created one.
+ * \param base The predictor whose symbol and parameters are used.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictor.
+ * \param num_input_nodes Number of input nodes to the net,
+ *    For feedforward net, this is 1.
+ * \param input_keys The name of input argument.
+ *    For feedforward net, this is {"data"}
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ *    The length of this array = num_input_nodes + 1.
+ * \param input_shape_data A flatted data of shapes of each input node.
+ * \param out The created predictor handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredCreateShared(PredictorHandle base,
+                                 int dev_type, int dev_id,
+                                 mx_uint num_input_nodes,
+                                 const char** input_keys,
+                                 const mx_uint* input_shape_indptr,
+                                 const mx_uint* input_shape_data,
+                                 PredictorHandle* out);
 /*!
  * \brief Get the shape of output node.
  *  The returned shape_data and shape_ndim is only valid before next call to MXPred function.
@@ -186,6 +248,90 @@ MXNET_DLL int MXPredGetOutput(PredictorHandle handle,
  * \return 0 when success, -1 when failure.
  */
 MXNET_DLL int MXPredFree(PredictorHandle handle);
+/*!
+ * \brief create a batch predictor that serves many independent requests.
+ *  Requests submitted concurrently by MXPredBatchPredict are batched dynamically,
+ *  up to max_batch_size requests or until the oldest one waited timeout_us,
+ *  and run through executors sharing one copy of the weights.
+ *  One executor is bound for every batch size from 1 to max_batch_size on creation,
+ *  so that requests never wait for a bind.
+ * \param symbol_json_str The JSON string of the symbol.
+ * \param param_bytes The in-memory raw bytes of parameter ndarray file.
+ * \param param_size The size of parameter ndarray file.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictor.
+ * \param num_input_nodes Number of input nodes to the net,
+ *    For feedforward net, this is 1.
+ * \param input_keys The name of input argument.
+ *    For feedforward net, this is {"data"}
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ *    The length of this array = num_input_nodes + 1.
+ * \param input_shape_data A flatted data of shapes of each input node for a single request,
+ *    without the batch axis. For feedforward net on images, this is {3, 224, 224}.
+ * \param max_batch_size The maximum number of requests run in one batch.
+ * \param timeout_us The maximum time in microseconds a request waits for the batch to fill up.
+ * \param out The created batch predictor handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchCreate(const char* symbol_json_str,
+                                const void* param_bytes,
+                                int param_size,
+                                int dev_type, int dev_id,
+                                mx_uint num_input_nodes,
+                                const char** input_keys,
+                                const mx_uint* input_shape_indptr,
+                                const mx_uint* input_shape_data,
+                                mx_uint max_batch_size,
+                                mx_uint timeout_us,
+                                BatchPredictorHandle* out);
+/*!
+ * \brief Get the shape of output node for a single request, without the batch axis.
+ *  The returned shape_data and shape_ndim is only valid before next call to MXPredBatch function.
+ * \param handle The handle of the batch predictor.
+ * \param index The index of output node, set to 0 if there is only one output.
+ * \param shape_data Used to hold pointer to the shape data
+ * \param shape_ndim Used to hold shape dimension.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchGetOutputShape(BatchPredictorHandle handle,
+                                        mx_uint index,
+                                        mx_uint** shape_data,
+                                        mx_uint* shape_ndim);
+/*!
+ * \brief Run the prediction of a single request. Thread safe, blocks until the batch
+ *  containing the request has been run and the outputs have been written.
+ * \param handle The handle of the batch predictor.
+ * \param input_data The data of each input node, with the shape given in MXPredBatchCreate.
+ * \param output_data User allocated buffers of each output node, with the shape
+ *    given by MXPredBatchGetOutputShape.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchPredict(BatchPredictorHandle handle,
+                                 const mx_float** input_data,
+                                 mx_float** output_data);
+/*!
+ * \brief Get the counters of a batch predictor.
+ * \param handle The handle of the batch predictor.
+ * \param num_requests Number of requests served.
+ * \param num_batches Number of batches run.
+ * \param avg_latency_ms Average time from submission to completion of a request.
+ * \param max_latency_ms Maximum time from submission to completion of a request.
+ * \param throughput Requests served per second since the first request.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchGetStats(BatchPredictorHandle handle,
+                                  mx_uint* num_requests,
+                                  mx_uint* num_batches,
+                                  mx_float* avg_latency_ms,
+                                  mx_float* max_latency_ms,
+                                  mx_float* throughput);
+/*!
+ * \brief Free a batch predictor handle.
+ *  All calls to MXPredBatchPredict must have returned.
+ * \param handle The handle of the batch predictor.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatchFree(BatchPredictorHandle handle);
 /*!
  * \brief Create a NDArray List by loading from ndarray file.
  *     This can be used to load mean image file.
@@ -629,6 +629,36 @@ class NDArray {
   static void Load(dmlc::Stream* fi,
                    std::vector<NDArray>* data,
                    std::vector<std::string>* keys);
+  /*!
+   * \brief Save list of dense ndarray into a versioned file format in which the data
+   *  of every array starts at an aligned offset, so that it can be memory mapped.
+   * \param fo The stream of output.
+   * \param data the NDArrays to be saved.
+   * \param names the name of the NDArray, optional, can be zero length.
+   */
+  static void SaveMappable(dmlc::Stream* fo,
+                           const std::vector<NDArray>& data,
+                           const std::vector<std::string>& names);
+  /*!
+   * \brief Load list of ndarray from a file written by SaveMappable without copying.
+   *  The file is memory mapped and the returned cpu arrays point directly into the
+   *  mapping, pages are read lazily. The mapping is released with the last array
+   *  referencing it.
+   * \param fname The path of the local file.
+   * \param data the NDArrays to be loaded
+   * \param keys the name of the NDArray, if saved in the file.
+   * \param copy_on_write whether the arrays may be written to, pages are then copied
+   *  on the first write. Otherwise the mapping is read-only and writes fault.
+   */
+  static void LoadMapped(const std::string& fname,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys,
+                         bool copy_on_write = true);
+  /*!
+   * \brief Check whether the stream starts with the header written by SaveMappable.
+   * \param fi The stream of the input file, positioned at the beginning.
+   */
+  static bool IsMappable(dmlc::Stream* fi);
 
  private:
   friend class Imperative;
@@ -670,6 +700,8 @@ class NDArray {
     // The shape of aux data. The default value for the shape depends on the type of storage.
     // If aux_shapes[i].Size() is zero, aux data i is empty.
     std::vector<TShape> aux_shapes;
+    // Keeps the memory of static data alive, e.g. the mapping of a file.
+    std::shared_ptr<void> static_data_owner;
 
     /*! \brief default cosntructor */
     Chunk() : static_data(true), delay_alloc(false) {}
@@ -866,7 +898,9 @@ class NDArray {
       bool skip_free = static_data || delay_alloc;
       Storage::Handle h = this->shandle;
       std::vector<Storage::Handle> aux_h = this->aux_handles;
-      Engine::Get()->DeleteVariable([h, aux_h, skip_free](RunContext s) {
+      // released only after all pending operations on the data are done
+      std::shared_ptr<void> owner = this->static_data_owner;
+      Engine::Get()->DeleteVariable([h, aux_h, skip_free, owner](RunContext s) {
         if (skip_free == false) {
           Storage::Get()->Free(h);
           for (size_t i = 0; i < aux_h.size(); i++) {
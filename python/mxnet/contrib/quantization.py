@@ -0,0 +1,297 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# coding: utf-8
+"""Quantization of symbolic models for int8 inference on CPU.
+
+`quantize_model` replaces Convolution and FullyConnected with their int8 counterparts and
+keeps the tensors between them quantized through Pooling, relu Activation and Flatten.
+`quantize`, `requantize` and `dequantize` are inserted at the boundaries of these quantized
+subgraphs, so every other operator still sees float32 inputs.
+"""
+from __future__ import absolute_import
+
+import json
+import logging
+
+from .. import ndarray as nd
+from ..context import cpu
+from ..symbol import load_json, Group
+
+_QUANTIZED_OPS = {
+    'Convolution': '_contrib_quantized_conv',
+    'FullyConnected': '_contrib_quantized_fully_connected',
+    'Pooling': '_contrib_quantized_pooling',
+    'Activation': '_contrib_quantized_act',
+    'Flatten': '_contrib_quantized_flatten',
+}
+
+
+def _is_2d_kernel(attrs):
+    return len([k for k in attrs.get('kernel', '').strip('()[] ').split(',') if k.strip()]) == 2
+
+
+def _quantizable(node, excluded_sym_names):
+    """Whether node has a quantized counterpart for its parameters."""
+    op, attrs = node['op'], node.get('attrs', {})
+    if op not in _QUANTIZED_OPS or node['name'] in excluded_sym_names:
+        return False
+    if op == 'Convolution':
+        return _is_2d_kernel(attrs) and attrs.get('layout', 'NCHW') in ('NCHW', 'None')
+    if op == 'Pooling':
+        return _is_2d_kernel(attrs) and attrs.get('pool_type') in ('max', 'avg')
+    if op == 'Activation':
+        return attrs.get('act_type') == 'relu'
+    return True
+
+
+def _entry_name(node):
+    """Name of the first output of node in `Symbol.get_internals()`."""
+    return node['name'] if node['op'] == 'null' else node['name'] + '_output'
+
+
+def _calibration_names(sym, excluded_sym_names):
+    """The internal outputs whose ranges are used by `_quantize_symbol`."""
+    nodes = json.loads(sym.tojson())['nodes']
+    names = set()
+    for node in nodes:
+        if _quantizable(node, excluded_sym_names):
+            names.add(_entry_name(node))
+            names.add(_entry_name(nodes[node['inputs'][0][0]]))
+    outputs = set(sym.get_internals().list_outputs())
+    return sorted(names & outputs)
+
+
+def _quantize_symbol(sym, excluded_sym_names=(), offline_params=(), calib_ranges=None):
+    """Rewrites sym into its quantized version.
+
+    Parameters
+    ----------
+    sym : Symbol
+        The float32 model.
+    excluded_sym_names : collection of str
+        Names of the operators which stay in float32.
+    offline_params : collection of str
+        Names of the weights and biases which are quantized ahead of time. Each one is
+        replaced by the arguments `<name>_quantize`, `<name>_min` and `<name>_max`.
+    calib_ranges : dict of str to (float, float)
+        Calibrated (min, max) of the internal outputs. The other ranges are found at runtime.
+
+    Returns
+    -------
+    Symbol
+        The quantized model.
+    """
+    calib_ranges = calib_ranges or {}
+    conf = json.loads(sym.tojson())
+    nodes = conf['nodes']
+    new_nodes = []
+    # old node id to the new id of the float32 nodes which are kept
+    float_nodes = {}
+    # (old node id, output index) to new entries
+    dequantized_entries = {}
+    # ... and to new (data, min_range, max_range) entries
+    int32_entries = {}
+    quantized_entries = {}
+
+    def add_node(op, name, inputs, attrs=None):
+        node = {'op': op, 'name': name, 'inputs': [[i, index, 0] for i, index in inputs]}
+        if attrs:
+            node['attrs'] = attrs
+        new_nodes.append(node)
+        return len(new_nodes) - 1
+
+    def add_constant(name, value):
+        return (add_node('_full', name, [], {'shape': '(1,)', 'value': repr(float(value))}), 0)
+
+    def get_float(entry):
+        """The float32 version of an old entry."""
+        nid, index = entry
+        if nid not in float_nodes and nodes[nid]['op'] == 'null':
+            float_nodes[nid] = add_node('null', nodes[nid]['name'], [], nodes[nid].get('attrs'))
+        if nid in float_nodes:
+            return (float_nodes[nid], index)
+        if entry not in dequantized_entries:
+            quantized = int32_entries.get(entry) or get_quantized(entry)
+            dequantized_entries[entry] = (add_node('_contrib_dequantize',
+                                                   nodes[nid]['name'] + '_dequantize',
+                                                   list(quantized)), 0)
+        return dequantized_entries[entry]
+
+    def get_quantized(entry, signed=False):
+        """The int8 version of an old entry, or a uint8 version unless signed."""
+        if (entry, signed) in quantized_entries:
+            return quantized_entries[(entry, signed)]
+        if not signed and (entry, True) in quantized_entries:
+            return quantized_entries[(entry, True)]
+        node = nodes[entry[0]]
+        name = node['name']
+        calib_range = calib_ranges.get(_entry_name(node)) if entry[1] == 0 else None
+        if entry in int32_entries:
+            attrs = None
+            if calib_range is not None:
+                attrs = {'min_calib_range': repr(calib_range[0]),
+                         'max_calib_range': repr(calib_range[1])}
+            qid = add_node('_contrib_requantize', name + '_requantize',
+                           list(int32_entries[entry]), attrs)
+            quantized = ((qid, 0), (qid, 1), (qid, 2))
+            signed = True
+        elif node['op'] == 'null' and name in offline_params:
+            quantized = tuple((add_node('null', name + suffix, []), 0)
+                              for suffix in ('_quantize', '_min', '_max'))
+            signed = True
+        else:
+            data = get_float(entry)
+            out_type = 'int8'
+            if calib_range is not None:
+                # non-negative tensors keep one more bit as uint8 with a zero minimum
+                if calib_range[0] >= 0 and calib_range[1] > 0 and not signed:
+                    out_type = 'uint8'
+                min_range = add_constant(name + '_calib_min',
+                                         0 if out_type == 'uint8' else calib_range[0])
+                max_range = add_constant(name + '_calib_max', calib_range[1])
+            else:
+                min_range = (add_node('min', name + '_min_range', [data]), 0)
+                max_range = (add_node('max', name + '_max_range', [data]), 0)
+            qid = add_node('_contrib_quantize', name + '_quantize',
+                           [data, min_range, max_range], {'out_type': out_type})
+            quantized = ((qid, 0), (qid, 1), (qid, 2))
+            signed = out_type == 'int8'
+        quantized_entries[(entry, signed)] = quantized
+        return quantized
+
+    for nid, node in enumerate(nodes):
+        if node['op'] == 'null':
+            continue
+        inputs = [tuple(x[:2]) for x in node['inputs']]
+        attrs = node.get('attrs')
+        data_is_quantized = inputs and (inputs[0] in int32_entries or
+                                        (inputs[0], False) in quantized_entries or
+                                        (inputs[0], True) in quantized_entries)
+        # pooling, relu and flatten are only worth quantizing inside a quantized subgraph
+        if _quantizable(node, excluded_sym_names) and \
+                (node['op'] in ('Convolution', 'FullyConnected') or data_is_quantized):
+            quantized = [get_quantized(inputs[0])]
+            quantized += [get_quantized(entry, signed=True) for entry in inputs[1:]]
+            qid = add_node(_QUANTIZED_OPS[node['op']], 'quantized_' + node['name'],
+                           [x[0] for x in quantized] + [r for x in quantized for r in x[1:]],
+                           attrs)
+            outputs = ((qid, 0), (qid, 1), (qid, 2))
+            if node['op'] in ('Convolution', 'FullyConnected'):
+                int32_entries[(nid, 0)] = outputs
+            else:
+                quantized_entries[((nid, 0), False)] = outputs
+        else:
+            float_nodes[nid] = add_node(node['op'], node['name'],
+                                        [get_float(x) for x in inputs], attrs)
+
+    heads = [get_float(tuple(x[:2])) for x in conf['heads']]
+    new_conf = {
+        'nodes': new_nodes,
+        'arg_nodes': [i for i, node in enumerate(new_nodes) if node['op'] == 'null'],
+        'heads': [[i, index, 0] for i, index in heads],
+        'attrs': conf.get('attrs', {}),
+    }
+    return load_json(json.dumps(new_conf))
+
+
+def _collect_ranges(sym, arg_params, aux_params, names, calib_data, num_calib_examples,
+                    ctx, logger):
+    """Naive calibration: the min and max of each internal output over the data."""
+    from ..module import Module
+    outputs = Group([sym.get_internals()[name] for name in names])
+    data_names = [desc[0] for desc in calib_data.provide_data]
+    mod = Module(outputs, data_names=data_names, label_names=None, context=ctx)
+    mod.bind(for_training=False, data_shapes=calib_data.provide_data)
+    mod.set_params(arg_params, aux_params, allow_extra=True)
+    ranges = {}
+    num_examples = 0
+    calib_data.reset()
+    for batch in calib_data:
+        mod.forward(batch, is_train=False)
+        for name, output in zip(names, mod.get_outputs()):
+            output = output.asnumpy()
+            lo, hi = float(output.min()), float(output.max())
+            if name in ranges:
+                lo, hi = min(lo, ranges[name][0]), max(hi, ranges[name][1])
+            ranges[name] = (lo, hi)
+        num_examples += calib_data.batch_size
+        if num_calib_examples is not None and num_examples >= num_calib_examples:
+            break
+    logger.info('Collected ranges of %d tensors from %d examples', len(ranges), num_examples)
+    return ranges
+
+
+def quantize_model(sym, arg_params, aux_params, ctx=cpu(), excluded_sym_names=None,
+                   calib_data=None, num_calib_examples=None, logger=logging):
+    """Converts a float32 model into a model for int8 inference on CPU.
+
+    Weights and biases of the quantized operators are quantized ahead of time. The ranges of
+    the other quantized tensors are found by running `calib_data` through the float32 model
+    when it is given, and at runtime otherwise, which costs an extra pass over each tensor.
+
+    Parameters
+    ----------
+    sym : Symbol
+        The float32 model.
+    arg_params : dict of str to NDArray
+        Its arguments.
+    aux_params : dict of str to NDArray
+        Its auxiliary states.
+    ctx : Context
+        Where the calibration runs.
+    excluded_sym_names : list of str
+        Names of the operators which stay in float32, e.g. a first convolution which is
+        sensitive to quantization.
+    calib_data : DataIter
+        Calibration data.
+    num_calib_examples : int
+        Stop calibrating after this many examples, by default all of `calib_data` is used.
+    logger : Object
+        For progress messages.
+
+    Returns
+    -------
+    tuple of (Symbol, dict of str to NDArray, dict of str to NDArray)
+        The quantized model, its arguments and its auxiliary states.
+
+    Examples
+    --------
+    >>> qsym, qarg_params, aux_params = mx.contrib.quantization.quantize_model(
+    ...     sym, arg_params, aux_params, excluded_sym_names=['conv0'],
+    ...     calib_data=val_iter, num_calib_examples=500)
+    """
+    excluded_sym_names = set(excluded_sym_names or [])
+    calib_ranges = None
+    if calib_data is not None:
+        names = _calibration_names(sym, excluded_sym_names)
+        calib_ranges = _collect_ranges(sym, arg_params, aux_params, names, calib_data,
+                                       num_calib_examples, ctx, logger)
+    qsym = _quantize_symbol(sym, excluded_sym_names, set(arg_params), calib_ranges)
+    qarg_params = {}
+    for name in qsym.list_arguments():
+        if name in arg_params:
+            qarg_params[name] = arg_params[name]
+        elif name.endswith('_quantize') and name[:-len('_quantize')] in arg_params:
+            param = arg_params[name[:-len('_quantize')]]
+            data, min_range, max_range = nd.contrib.quantize(
+                param, nd.min(param), nd.max(param), out_type='int8')
+            prefix = name[:-len('_quantize')]
+            qarg_params[name] = data
+            qarg_params[prefix + '_min'] = min_range
+            qarg_params[prefix + '_max'] = max_range
+    return qsym, qarg_params, aux_params
@@ -19,16 +19,19 @@
 from __future__ import absolute_import
 from collections import OrderedDict, namedtuple
 
+import os
 import sys
 import ctypes
 import logging
 import threading
+import traceback
+import multiprocessing
 try:
     import h5py
 except ImportError:
     h5py = None
 import numpy as np
-from .base import _LIB
+from .base import _LIB, MXNetError
 from .base import c_str_array, mx_uint, py_str
 from .base import DataIterHandle, NDArrayHandle
 from .base import mx_real_t
@@ -39,6 +42,7 @@ from .ndarray.sparse import array as sparse_array
 from .ndarray import _ndarray_cls
 from .ndarray import array
 from .ndarray import concatenate
+from .ndarray.ndarray import _new_from_shared_mem
 
 class DataDesc(namedtuple('DataDesc', ['name', 'shape'])):
     """DataDesc is used to store name, shape, type and layout
@@ -867,6 +871,212 @@ class MXDataIter(DataIter):
         check_call(_LIB.MXDataIterGetPadNum(self.handle, ctypes.byref(pad)))
         return pad.value
 
+def _shared_mem_worker(conn, iter_name, kwargs, part_index, num_parts, window, cores):
+    """Worker loop of `MultiProcessIter`. Runs one part of a C++ iterator that
+    writes its batches into shared memory, and sends their handles to `conn`.
+    Errors are sent back to be raised in the trainer."""
+    try:
+        if cores and hasattr(os, 'sched_setaffinity'):
+            os.sched_setaffinity(0, cores)
+        data_iter = getattr(sys.modules[__name__], iter_name)(
+            part_index=part_index, num_parts=num_parts, ctx='cpu_shared', **kwargs)
+        conn.send(('desc',
+                   [tuple(desc) + (desc.dtype, desc.layout) for desc in data_iter.provide_data],
+                   [tuple(desc) + (desc.dtype, desc.layout) for desc in data_iter.provide_label]))
+        # the iterator recycles a batch after `window` more batches, so stop when
+        # that many batches are not yet released by the trainer
+        credits = window
+        finished = False
+        while True:
+            while conn.poll() or credits == 0 or finished:
+                cmd = conn.recv()
+                if cmd == 'release':
+                    credits += 1
+                elif cmd == 'reset':
+                    data_iter.reset()
+                    credits = window
+                    finished = False
+                    conn.send(('reset',))
+                elif cmd == 'close':
+                    return
+            try:
+                batch = data_iter.next()
+            except StopIteration:
+                conn.send(('end',))
+                finished = True
+                continue
+            credits -= 1
+            conn.send(('batch', [arr._to_shared_mem() for arr in batch.data],
+                       [arr._to_shared_mem() for arr in batch.label], batch.pad, batch.index))
+    except Exception:  # pylint: disable=broad-except
+        conn.send(('error', traceback.format_exc()))
+
+
+class MultiProcessIter(DataIter):
+    """Runs a C++ data iterator in worker processes.
+
+    Each of the `num_workers` processes creates the iterator `iter_name` with
+    ``part_index`` set to its rank and ``num_parts`` to `num_workers`, so every
+    worker reads and decodes its own part of the data. The workers allocate
+    their batches in shared memory (``ctx='cpu_shared'``) and send only the
+    shared memory handles back, so decoding runs outside of the training
+    process, optionally on dedicated cores, without copying the batches.
+
+    Batches of the workers are returned in turn. A batch is valid until the
+    next call to `next` or `reset`, after which the worker may overwrite it.
+    Errors of the workers are raised as `MXNetError`. A ``cache_file`` argument
+    gets the rank appended, so that each worker caches its own part.
+    Only iterators with dense outputs and ``part_index``/``num_parts`` arguments
+    are supported, e.g. `ImageRecordIter`, `CSVIter` and `MNISTIter`.
+
+    Parameters
+    ----------
+    iter_name : str
+        Name of the iterator in `mx.io`, e.g. ``'ImageRecordIter'``.
+    num_workers : int
+        Number of worker processes.
+    cpu_affinity : list of int, optional
+        Cores the workers run on, split evenly between them.
+    **kwargs
+        Arguments of the iterator.
+
+    Examples
+    --------
+    >>> data_iter = mx.io.MultiProcessIter('ImageRecordIter', num_workers=4,
+    ...                                    cpu_affinity=list(range(8, 16)),
+    ...                                    path_imgrec='data/train.rec',
+    ...                                    data_shape=(3, 224, 224), batch_size=64)
+    """
+    def __init__(self, iter_name, num_workers, cpu_affinity=None, **kwargs):
+        super(MultiProcessIter, self).__init__()
+        window = int(kwargs.get('prefetch_buffer', 4))
+        self._conns = []
+        self._workers = []
+        for rank in range(num_workers):
+            cores = None
+            if cpu_affinity:
+                cores = cpu_affinity[rank * len(cpu_affinity) // num_workers:
+                                     (rank + 1) * len(cpu_affinity) // num_workers]
+            worker_kwargs = kwargs
+            if kwargs.get('cache_file'):
+                worker_kwargs = dict(kwargs, cache_file='%s.%d' % (kwargs['cache_file'], rank))
+            conn, worker_conn = multiprocessing.Pipe()
+            worker = multiprocessing.Process(
+                target=_shared_mem_worker,
+                args=(worker_conn, iter_name, worker_kwargs, rank, num_workers, window, cores))
+            worker.daemon = True
+            worker.start()
+            # only the worker keeps its end open, so recv sees EOF if the worker dies
+            worker_conn.close()
+            self._conns.append(conn)
+            self._workers.append(worker)
+        try:
+            descs = [self._recv(conn) for conn in self._conns]
+        except MXNetError:
+            self.close()
+            raise
+        self.provide_data = [DataDesc(*desc) for desc in descs[0][1]]
+        self.provide_label = [DataDesc(*desc) for desc in descs[0][2]]
+        self.batch_size = self.provide_data[0].shape[0]
+        # arrays mapped from the workers, by shared memory handle
+        self._arrays = {}
+        self._active = list(range(num_workers))
+        self._turn = 0
+        self._held = None
+        self.current_batch = None
+
+    def __del__(self):
+        self.close()
+
+    def close(self):
+        """Stops the worker processes."""
+        self._held = None
+        for conn in getattr(self, '_conns', []):
+            try:
+                conn.send('close')
+            except (IOError, OSError):
+                pass
+        for worker in getattr(self, '_workers', []):
+            worker.join()
+        self._conns = []
+        self._workers = []
+        self._arrays = {}
+
+    @staticmethod
+    def _recv(conn):
+        """Receives a message of a worker, raising the errors of the worker."""
+        try:
+            msg = conn.recv()
+        except EOFError:
+            raise MXNetError('MultiProcessIter worker exited unexpectedly')
+        if msg[0] == 'error':
+            raise MXNetError('MultiProcessIter worker failed:\n' + msg[1])
+        return msg
+
+    def _map(self, handle):
+        if handle not in self._arrays:
+            self._arrays[handle] = NDArray(_new_from_shared_mem(*handle))
+        return self._arrays[handle]
+
+    def _release(self):
+        """Waits until the held batch is not used any more and gives it back."""
+        if self._held is None:
+            return
+        rank, batch = self._held
+        for arr in batch.data + batch.label:
+            arr.wait_to_write()
+        self._conns[rank].send('release')
+        self._held = None
+
+    def reset(self):
+        self._release()
+        for conn in self._conns:
+            conn.send('reset')
+        for conn in self._conns:
+            # drop what was sent before the reset
+            while self._recv(conn)[0] != 'reset':
+                pass
+        self._active = list(range(len(self._conns)))
+        self._turn = 0
+        self.current_batch = None
+
+    def iter_next(self):
+        self._release()
+        while self._active:
+            self._turn %= len(self._active)
+            rank = self._active[self._turn]
+            msg = self._recv(self._conns[rank])
+            if msg[0] == 'end':
+                del self._active[self._turn]
+                continue
+            self._turn += 1
+            _, data, label, pad, index = msg
+            self.current_batch = DataBatch(data=[self._map(h) for h in data],
+                                           label=[self._map(h) for h in label],
+                                           pad=pad, index=index,
+                                           provide_data=self.provide_data,
+                                           provide_label=self.provide_label)
+            self._held = (rank, self.current_batch)
+            return True
+        return False
+
+    def next(self):
+        if self.iter_next():
+            return self.current_batch
+        raise StopIteration
+
+    def getdata(self):
+        return self.current_batch.data
+
+    def getlabel(self):
+        return self.current_batch.label
+
+    def getindex(self):
+        return self.current_batch.index
+
+    def getpad(self):
+        return self.current_batch.pad
+
 def _make_io_iterator(handle):
     """Create an io iterator by handle."""
     name = ctypes.c_char_p()
@@ -34,7 +34,7 @@ try:
 except ImportError:
     spsp = None
 
-__all__ = ['zeros', 'empty', 'array', 'load', 'save']
+__all__ = ['zeros', 'empty', 'array', 'load', 'save', 'convert_to_mappable']
 
 
 def zeros(shape, ctx=None, dtype=None, stype=None, **kwargs):
@@ -182,7 +182,7 @@ def load(fname):
             for i in range(out_size.value))
 
 
-def save(fname, data):
+def save(fname, data, mappable=False):
     """Saves a list of arrays or a dict of str->array to file.
 
     Examples of filenames:
@@ -199,6 +199,9 @@ def save(fname, data):
            or list of NDArray, RowSparseNDArray or CSRNDArray, \
            or dict of str to NDArray, RowSparseNDArray or CSRNDArray
         The data to save.
+    mappable : bool, optional
+        Save dense arrays in an alignment-padded format. ``load`` memory maps such
+        files and returns cpu arrays backed by the mapped pages, without copying.
 
     Examples
     --------
@@ -230,7 +233,30 @@ def save(fname, data):
     else:
         raise ValueError("data needs to either be a NDArray, dict of str, NDArray pairs "
                          "or a list of NDarrays.")
-    check_call(_LIB.MXNDArraySave(c_str(fname),
-                                  mx_uint(len(handles)),
-                                  handles,
-                                  keys))
+    save_fn = _LIB.MXNDArraySaveMappable if mappable else _LIB.MXNDArraySave
+    check_call(save_fn(c_str(fname),
+                       mx_uint(len(handles)),
+                       handles,
+                       keys))
+
+
+def convert_to_mappable(src_fname, dst_fname):
+    """Converts a file written by ``save`` into the format of ``save`` with ``mappable=True``.
+
+    Parameters
+    ----------
+    src_fname : str
+        The file to convert.
+    dst_fname : str
+        The converted file.
+
+    Examples
+    --------
+    >>> mx.nd.save('my_dict', {'x':mx.nd.zeros((2,3))})
+    >>> mx.nd.convert_to_mappable('my_dict', 'my_dict.mappable')
+    >>> mx.nd.load('my_dict.mappable')
+    {'x': <NDArray 2x3 @cpu(0)>}
+    """
+    if not isinstance(src_fname, string_types) or not isinstance(dst_fname, string_types):
+        raise TypeError('fname required to be a string')
+    check_call(_LIB.MXNDArrayConvertToMappable(c_str(src_fname), c_str(dst_fname)))
@@ -327,6 +327,45 @@ int MXNDArraySave(const char* fname,
   API_END();
 }
 
+int MXNDArraySaveMappable(const char* fname,
+                          mx_uint num_args,
+                          NDArrayHandle* args,
+                          const char** keys) {
+  API_BEGIN();
+  std::vector<NDArray> data(num_args);
+  std::vector<std::string> names;
+  for (mx_uint i = 0; i < num_args; ++i) {
+    data[i] = *static_cast<NDArray*>(args[i]);
+  }
+  if (keys != nullptr) {
+    names.resize(num_args);
+    for (mx_uint i = 0; i < num_args; ++i) {
+      names[i] = keys[i];
+    }
+  }
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
+    mxnet::NDArray::SaveMappable(fo.get(), data, names);
+  }
+  API_END();
+}
+
+int MXNDArrayConvertToMappable(const char* src_fname,
+                               const char* dst_fname) {
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> names;
+  {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(src_fname, "r"));
+    mxnet::NDArray::Load(fi.get(), &data, &names);
+  }
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(dst_fname, "w"));
+    mxnet::NDArray::SaveMappable(fo.get(), data, names);
+  }
+  API_END();
+}
+
 int MXNDArrayLoad(const char* fname,
                   mx_uint *out_size,
                   NDArrayHandle** out_arr,
@@ -337,7 +376,15 @@ int MXNDArrayLoad(const char* fname,
   API_BEGIN();
   std::vector<NDArray> data;
   std::vector<std::string> &names = ret->ret_vec_str;
+  bool mappable;
   {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
+    mappable = mxnet::NDArray::IsMappable(fi.get());
+  }
+  if (mappable) {
+    // wrap the arrays around the mapped file without copying
+    mxnet::NDArray::LoadMapped(fname, &data, &names);
+  } else {
     std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
     mxnet::NDArray::Load(fi.get(), &data, &names);
   }
@@ -28,10 +28,18 @@
 #include <mxnet/executor.h>
 #include <mxnet/ndarray.h>
 #include <nnvm/pass_functions.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 #include <unordered_map>
 #include "./c_api_common.h"
+#include "../common/mapped_file.h"
 #include "../operator/operator_common.h"
 #include "../executor/exec_pass.h"
 
@@ -39,10 +47,20 @@ using namespace mxnet;
 
 // predictor interface
 struct MXAPIPredictor {
+  // the bound symbol
+  nnvm::Symbol sym;
+  // context of the executor
+  Context ctx;
+  // name of the input nodes
+  std::unordered_set<std::string> input_keys;
+  // name of the arguments and auxiliary states loaded from the param file
+  std::unordered_set<std::string> param_keys;
   // output arrays
   std::vector<NDArray> out_arrays;
   // argument arrays
   std::vector<NDArray> arg_arrays;
+  // auxiliary state arrays
+  std::vector<NDArray> aux_arrays;
   // output shapes
   std::vector<TShape> out_shapes;
   // uint32_t buffer for output shapes
@@ -53,6 +71,69 @@ struct MXAPIPredictor {
   std::unique_ptr<Executor> exec;
 };
 
+// a single request submitted to the batch predictor
+struct MXAPIBatchRequest {
+  // input data, one pointer per input node
+  const mx_float** input_data;
+  // output buffers, one pointer per output node
+  mx_float** output_data;
+  // time the request was submitted
+  std::chrono::steady_clock::time_point submit_time;
+  // whether the request has been processed
+  bool done{false};
+  // error message if the batch failed
+  std::string error;
+};
+
+// batch predictor interface, dynamically batches independent requests
+struct MXAPIBatchPredictor {
+  // the symbol to bind
+  nnvm::Symbol sym;
+  // context of the executors
+  Context ctx;
+  // name of the input nodes
+  std::vector<std::string> input_keys;
+  // shape of a single request for each input, without the batch axis
+  std::vector<TShape> input_shapes;
+  // shape of a single request for each output, without the batch axis
+  std::vector<TShape> out_shapes;
+  // uint32_t buffer for output shapes
+  std::vector<uint32_t> out_shapes_buffer;
+  // weights on ctx, shared by the executors of all batch sizes
+  std::unordered_map<std::string, NDArray> arg_params, aux_params;
+  // executor and its input arrays for each batch size, bound on creation
+  std::vector<std::unique_ptr<Executor> > execs;
+  std::vector<std::vector<NDArray> > exec_inputs;
+  // host staging buffers for inputs and outputs
+  std::vector<std::vector<mx_float> > input_buffers, output_buffers;
+  // maximum number of requests in a batch
+  mx_uint max_batch_size;
+  // time to wait for a batch to fill up
+  std::chrono::microseconds timeout;
+  // pending requests
+  std::deque<MXAPIBatchRequest*> queue;
+  std::mutex mutex;
+  std::condition_variable queue_cond, done_cond;
+  bool shutdown{false};
+  // thread forming and running the batches
+  std::thread worker;
+  // statistics
+  uint64_t num_requests{0};
+  uint64_t num_batches{0};
+  double total_latency_us{0};
+  double max_latency_us{0};
+  std::chrono::steady_clock::time_point first_submit_time;
+
+  ~MXAPIBatchPredictor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      shutdown = true;
+    }
+    queue_cond.notify_all();
+    if (worker.joinable()) worker.join();
+  }
+};
+
 struct MXAPINDList {
   std::vector<std::string> keys;
   std::vector<TShape> shapes;
@@ -86,23 +167,11 @@ int MXPredCreate(const char* symbol_json_str,
 }
 namespace mxnet {
 
-}  // namespace mxnet
-
-int MXPredCreatePartialOut(const char* symbol_json_str,
-                           const void* param_bytes,
-                           int param_size,
-                           int dev_type, int dev_id,
-                           mx_uint num_input_nodes,
-                           const char** input_keys,
-                           const mx_uint* input_shape_indptr,
-                           const mx_uint* input_shape_data,
-                           mx_uint num_output_nodes,
-                           const char** output_keys,
-                           PredictorHandle* out) {
+// load the symbol of the predictor, optionally exposing internal outputs
+nnvm::Symbol LoadPredSymbol(const char* symbol_json_str,
+                            mx_uint num_output_nodes,
+                            const char** output_keys) {
   using nnvm::Symbol;
-
-  MXAPIPredictor* ret = new MXAPIPredictor();
-  API_BEGIN();
   Symbol sym;
   // make sure symbols are registered
   {
@@ -134,63 +203,71 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
     }
     sym = nnvm::Symbol::CreateGroup(out_syms);
   }
+  return sym;
+}
 
-  // load the parameters
-  std::unordered_map<std::string, NDArray> arg_params, aux_params;
-  {
-    std::unordered_set<std::string> arg_names, aux_names;
-    std::vector<std::string> arg_names_vec = sym.ListInputNames(Symbol::kReadOnlyArgs);
-    std::vector<std::string> aux_names_vec = sym.ListInputNames(Symbol::kAuxiliaryStates);
-    for (size_t i = 0; i < arg_names_vec.size(); ++i) {
-      arg_names.insert(arg_names_vec[i]);
-    }
-    for (size_t i = 0; i < aux_names_vec.size(); ++i) {
-      aux_names.insert(aux_names_vec[i]);
-    }
-    std::vector<NDArray> data;
-    std::vector<std::string> names;
-    dmlc::MemoryFixedSizeStream fi((void*)param_bytes, param_size);  // NOLINT(*)
-    NDArray::Load(&fi, &data, &names);
-    CHECK_EQ(names.size(), data.size())
-        << "Invalid param file format";
-    for (size_t i = 0; i < names.size(); ++i) {
-      if (!strncmp(names[i].c_str(), "aux:", 4)) {
-        std::string name(names[i].c_str() + 4);
-        if (aux_names.count(name) != 0) {
-          aux_params[name] = data[i];
-        }
+// pick the "arg:" and "aux:" parameters used by the symbol
+void FilterPredParams(const nnvm::Symbol& sym,
+                      const std::vector<NDArray>& data,
+                      const std::vector<std::string>& names,
+                      std::unordered_map<std::string, NDArray>* arg_params,
+                      std::unordered_map<std::string, NDArray>* aux_params) {
+  using nnvm::Symbol;
+  std::unordered_set<std::string> arg_names, aux_names;
+  std::vector<std::string> arg_names_vec = sym.ListInputNames(Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names_vec = sym.ListInputNames(Symbol::kAuxiliaryStates);
+  for (size_t i = 0; i < arg_names_vec.size(); ++i) {
+    arg_names.insert(arg_names_vec[i]);
+  }
+  for (size_t i = 0; i < aux_names_vec.size(); ++i) {
+    aux_names.insert(aux_names_vec[i]);
+  }
+  CHECK_EQ(names.size(), data.size())
+      << "Invalid param file format";
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (!strncmp(names[i].c_str(), "aux:", 4)) {
+      std::string name(names[i].c_str() + 4);
+      if (aux_names.count(name) != 0) {
+        (*aux_params)[name] = data[i];
       }
-      if (!strncmp(names[i].c_str(), "arg:", 4)) {
-        std::string name(names[i].c_str() + 4);
-        if (arg_names.count(name) != 0) {
-          arg_params[name] = data[i];
-        }
+    }
+    if (!strncmp(names[i].c_str(), "arg:", 4)) {
+      std::string name(names[i].c_str() + 4);
+      if (arg_names.count(name) != 0) {
+        (*arg_params)[name] = data[i];
       }
     }
   }
+}
 
-  // shape inference and bind
-  std::unordered_map<std::string, TShape> known_shape;
-  for (mx_uint i = 0; i < num_input_nodes; ++i) {
-    known_shape[std::string(input_keys[i])] =
-        TShape(input_shape_data + input_shape_indptr[i],
-               input_shape_data + input_shape_indptr[i + 1]);
-  }
-  std::vector<std::string> arg_names = sym.ListInputNames(Symbol::kReadOnlyArgs);
-  std::vector<std::string> aux_names = sym.ListInputNames(Symbol::kAuxiliaryStates);
-  std::vector<TShape> out_shapes(sym.ListOutputNames().size());
-  std::vector<TShape> aux_shapes(aux_names.size());
-  std::vector<TShape> arg_shapes;
-  for (size_t i = 0; i < arg_names.size(); ++i) {
-    std::string key = arg_names[i];
-    ret->key2arg[key] = i;
-  }
+// load the parameters used by the symbol from the raw bytes of a ndarray file
+void LoadPredParams(const nnvm::Symbol& sym,
+                    const void* param_bytes,
+                    int param_size,
+                    std::unordered_map<std::string, NDArray>* arg_params,
+                    std::unordered_map<std::string, NDArray>* aux_params) {
+  std::vector<NDArray> data;
+  std::vector<std::string> names;
+  dmlc::MemoryFixedSizeStream fi((void*)param_bytes, param_size);  // NOLINT(*)
+  NDArray::Load(&fi, &data, &names);
+  FilterPredParams(sym, data, names, arg_params, aux_params);
+}
 
+// infer the shapes of arguments, outputs and auxiliary states from the input shapes
+void InferPredShapes(const nnvm::Symbol& sym,
+                     const std::unordered_map<std::string, TShape>& known_shape,
+                     std::vector<TShape>* arg_shapes,
+                     std::vector<TShape>* out_shapes,
+                     std::vector<TShape>* aux_shapes) {
+  using nnvm::Symbol;
+  out_shapes->resize(sym.ListOutputNames().size());
+  aux_shapes->resize(sym.ListInputNames(Symbol::kAuxiliaryStates).size());
   try {
     std::vector<TShape> in_shapes;
     for (std::string key : sym.ListInputNames(Symbol::kAll)) {
-      if (known_shape.count(key) != 0) {
-        in_shapes.push_back(known_shape[key]);
+      auto it = known_shape.find(key);
+      if (it != known_shape.end()) {
+        in_shapes.push_back(it->second);
       } else {
         in_shapes.push_back(TShape());
       }
@@ -202,29 +279,64 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
       << "The shape information of is not enough to get the shapes";
     CopyAttr(g.indexed_graph(),
              g.GetAttr<nnvm::ShapeVector>("shape"),
-             &arg_shapes, &out_shapes, &aux_shapes);
+             arg_shapes, out_shapes, aux_shapes);
   } catch (const mxnet::op::InferShapeError &err) {
     throw dmlc::Error(err.msg);
   }
+}
 
-  Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+}  // namespace mxnet
+
+namespace mxnet {
+
+/*!
+ * \brief infer the shapes and bind the executor of a predictor.
+ * \param get_param returns the array of a parameter, or none if it has to be
+ *  initialized to zeros. Arrays on the predictor context with the right shape are
+ *  used directly, others are copied.
+ */
+template<typename FGetParam>
+void BindPredictor(MXAPIPredictor* ret,
+                   const std::unordered_map<std::string, TShape>& known_shape,
+                   FGetParam get_param) {
+  using nnvm::Symbol;
+  const nnvm::Symbol& sym = ret->sym;
+  const Context& ctx = ret->ctx;
+  std::vector<std::string> arg_names = sym.ListInputNames(Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names = sym.ListInputNames(Symbol::kAuxiliaryStates);
+  std::vector<TShape> out_shapes, aux_shapes, arg_shapes;
+  for (size_t i = 0; i < arg_names.size(); ++i) {
+    std::string key = arg_names[i];
+    ret->key2arg[key] = i;
+  }
+  for (const auto& kv : known_shape) {
+    ret->input_keys.insert(kv.first);
+  }
+  InferPredShapes(sym, known_shape, &arg_shapes, &out_shapes, &aux_shapes);
 
+  auto make_array = [&](const std::string& name, const TShape& shape, bool is_aux) -> NDArray {
+    if (!is_aux && known_shape.count(name) != 0) return NDArray(shape, ctx);
+    NDArray param = get_param(name, is_aux);
+    if (!param.is_none() && param.ctx() == ctx && param.shape() == shape &&
+        param.dtype() == mshadow::default_type_flag &&
+        param.storage_type() == kDefaultStorage) {
+      return param;
+    }
+    NDArray nd = NDArray(shape, ctx);
+    if (!param.is_none()) {
+      CopyFromTo(param, &nd);
+    }
+    return nd;
+  };
   std::vector<NDArray> arg_arrays, aux_arrays;
   for (size_t i = 0; i < arg_shapes.size(); ++i) {
-    NDArray nd = NDArray(arg_shapes[i], ctx);
-    if (arg_params.count(arg_names[i]) != 0) {
-      CopyFromTo(arg_params[arg_names[i]], &nd);
-    }
-    arg_arrays.push_back(nd);
+    arg_arrays.push_back(make_array(arg_names[i], arg_shapes[i], false));
   }
   for (size_t i = 0; i < aux_shapes.size(); ++i) {
-    NDArray nd = NDArray(aux_shapes[i], ctx);
-    if (aux_params.count(aux_names[i]) != 0) {
-      CopyFromTo(aux_params[aux_names[i]], &nd);
-    }
-    aux_arrays.push_back(nd);
+    aux_arrays.push_back(make_array(aux_names[i], aux_shapes[i], true));
   }
   ret->arg_arrays = arg_arrays;
+  ret->aux_arrays = aux_arrays;
   // bind
   {
     std::map<std::string, Context> ctx_map;
@@ -239,6 +351,145 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
     ret->out_shapes = out_shapes;
     ret->out_arrays = ret->exec->outputs();
   }
+}
+
+// create a predictor from loaded parameters
+void InitPredictor(MXAPIPredictor* ret,
+                   const nnvm::Symbol& sym,
+                   const std::unordered_map<std::string, NDArray>& arg_params,
+                   const std::unordered_map<std::string, NDArray>& aux_params,
+                   int dev_type, int dev_id,
+                   mx_uint num_input_nodes,
+                   const char** input_keys,
+                   const mx_uint* input_shape_indptr,
+                   const mx_uint* input_shape_data) {
+  ret->sym = sym;
+  ret->ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  std::unordered_map<std::string, TShape> known_shape;
+  for (mx_uint i = 0; i < num_input_nodes; ++i) {
+    known_shape[std::string(input_keys[i])] =
+        TShape(input_shape_data + input_shape_indptr[i],
+               input_shape_data + input_shape_indptr[i + 1]);
+  }
+  for (const auto& kv : arg_params) ret->param_keys.insert(kv.first);
+  for (const auto& kv : aux_params) ret->param_keys.insert(kv.first);
+  BindPredictor(ret, known_shape, [&](const std::string& name, bool is_aux) -> NDArray {
+    const auto& params = is_aux ? aux_params : arg_params;
+    auto it = params.find(name);
+    return it != params.end() ? it->second : NDArray();
+  });
+}
+
+}  // namespace mxnet
+
+int MXPredCreatePartialOut(const char* symbol_json_str,
+                           const void* param_bytes,
+                           int param_size,
+                           int dev_type, int dev_id,
+                           mx_uint num_input_nodes,
+                           const char** input_keys,
+                           const mx_uint* input_shape_indptr,
+                           const mx_uint* input_shape_data,
+                           mx_uint num_output_nodes,
+                           const char** output_keys,
+                           PredictorHandle* out) {
+  using nnvm::Symbol;
+
+  MXAPIPredictor* ret = new MXAPIPredictor();
+  API_BEGIN();
+  Symbol sym = LoadPredSymbol(symbol_json_str, num_output_nodes, output_keys);
+
+  // load the parameters
+  std::unordered_map<std::string, NDArray> arg_params, aux_params;
+  LoadPredParams(sym, param_bytes, param_size, &arg_params, &aux_params);
+
+  // shape inference and bind
+  InitPredictor(ret, sym, arg_params, aux_params, dev_type, dev_id,
+                num_input_nodes, input_keys, input_shape_indptr, input_shape_data);
+  *out = ret;
+  API_END_HANDLE_ERROR(delete ret);
+}
+
+int MXPredCreateFromParamFile(const char* symbol_json_str,
+                              const char* param_file,
+                              int dev_type, int dev_id,
+                              mx_uint num_input_nodes,
+                              const char** input_keys,
+                              const mx_uint* input_shape_indptr,
+                              const mx_uint* input_shape_data,
+                              mx_uint num_output_nodes,
+                              const char** output_keys,
+                              PredictorHandle* out) {
+  using nnvm::Symbol;
+
+  MXAPIPredictor* ret = new MXAPIPredictor();
+  API_BEGIN();
+  Symbol sym = LoadPredSymbol(symbol_json_str, num_output_nodes, output_keys);
+
+  // parse the parameters directly from the mapped file
+  std::unordered_map<std::string, NDArray> arg_params, aux_params;
+  bool mappable;
+  {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(param_file, "r"));
+    mappable = NDArray::IsMappable(fi.get());
+  }
+  if (mappable) {
+    // the arrays point into a read-only mapping, cpu predictors use them without any
+    // copy and never write to their weights
+    std::vector<NDArray> data;
+    std::vector<std::string> names;
+    NDArray::LoadMapped(param_file, &data, &names, false);
+    FilterPredParams(sym, data, names, &arg_params, &aux_params);
+  } else {
+    // files saved by MXNDArraySave are still parsed into copies, the mapping only saves
+    // the buffer holding the whole file
+    common::MappedFile file(param_file);
+    CHECK_LE(file.size(), static_cast<size_t>(std::numeric_limits<int>::max()))
+        << "param file is too large";
+    LoadPredParams(sym, file.data(), static_cast<int>(file.size()),
+                   &arg_params, &aux_params);
+  }
+
+  // shape inference and bind
+  InitPredictor(ret, sym, arg_params, aux_params, dev_type, dev_id,
+                num_input_nodes, input_keys, input_shape_indptr, input_shape_data);
+  *out = ret;
+  API_END_HANDLE_ERROR(delete ret);
+}
+
+int MXPredCreateShared(PredictorHandle base,
+                       int dev_type, int dev_id,
+                       mx_uint num_input_nodes,
+                       const char** input_keys,
+                       const mx_uint* input_shape_indptr,
+                       const mx_uint* input_shape_data,
+                       PredictorHandle* out) {
+  using nnvm::Symbol;
+  const MXAPIPredictor* p = static_cast<MXAPIPredictor*>(base);
+
+  MXAPIPredictor* ret = new MXAPIPredictor();
+  API_BEGIN();
+  ret->sym = p->sym;
+  ret->ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  std::unordered_map<std::string, TShape> known_shape;
+  for (mx_uint i = 0; i < num_input_nodes; ++i) {
+    known_shape[std::string(input_keys[i])] =
+        TShape(input_shape_data + input_shape_indptr[i],
+               input_shape_data + input_shape_indptr[i + 1]);
+  }
+  // weights of the base predictor are shared read-only. Its inputs and the arrays missing
+  // from the param file, such as labels whose shape follows the batch size, are not shared.
+  ret->param_keys = p->param_keys;
+  std::unordered_map<std::string, size_t> key2aux;
+  std::vector<std::string> aux_names = p->sym.ListInputNames(Symbol::kAuxiliaryStates);
+  for (size_t i = 0; i < aux_names.size(); ++i) {
+    key2aux[aux_names[i]] = i;
+  }
+  BindPredictor(ret, known_shape, [&](const std::string& name, bool is_aux) -> NDArray {
+    if (p->param_keys.count(name) == 0) return NDArray();
+    if (is_aux) return p->aux_arrays[key2aux.at(name)];
+    return p->arg_arrays[p->key2arg.at(name)];
+  });
   *out = ret;
   API_END_HANDLE_ERROR(delete ret);
 }
@@ -308,6 +559,263 @@ int MXPredFree(PredictorHandle handle) {
   API_END();
 }
 
+namespace mxnet {
+
+// get the executor for a batch size, binding it with the shared weights if needed
+Executor* GetBatchExec(MXAPIBatchPredictor* p, mx_uint batch_size) {
+  using nnvm::Symbol;
+  if (p->execs[batch_size] != nullptr) return p->execs[batch_size].get();
+  std::unordered_map<std::string, TShape> known_shape;
+  for (size_t i = 0; i < p->input_keys.size(); ++i) {
+    const TShape& s = p->input_shapes[i];
+    TShape shape(s.ndim() + 1);
+    shape[0] = batch_size;
+    std::copy(s.begin(), s.end(), shape.begin() + 1);
+    known_shape[p->input_keys[i]] = shape;
+  }
+  std::vector<std::string> arg_names = p->sym.ListInputNames(Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names = p->sym.ListInputNames(Symbol::kAuxiliaryStates);
+  std::vector<TShape> arg_shapes, out_shapes, aux_shapes;
+  InferPredShapes(p->sym, known_shape, &arg_shapes, &out_shapes, &aux_shapes);
+
+  std::vector<NDArray> arg_arrays, aux_arrays;
+  std::vector<NDArray>& inputs = p->exec_inputs[batch_size];
+  inputs.resize(p->input_keys.size());
+  for (size_t i = 0; i < arg_shapes.size(); ++i) {
+    auto it = std::find(p->input_keys.begin(), p->input_keys.end(), arg_names[i]);
+    if (it != p->input_keys.end()) {
+      NDArray nd(arg_shapes[i], p->ctx);
+      inputs[it - p->input_keys.begin()] = nd;
+      arg_arrays.push_back(nd);
+      continue;
+    }
+    // only the loaded weights are shared, arguments missing from the param file such as
+    // labels may depend on the batch size and get their own array in every executor
+    auto pit = p->arg_params.find(arg_names[i]);
+    if (pit == p->arg_params.end()) {
+      arg_arrays.push_back(NDArray(arg_shapes[i], p->ctx));
+      continue;
+    }
+    CHECK_EQ(pit->second.shape(), arg_shapes[i])
+        << "shape of " << arg_names[i] << " depends on the batch size";
+    arg_arrays.push_back(pit->second);
+  }
+  for (size_t i = 0; i < aux_shapes.size(); ++i) {
+    auto pit = p->aux_params.find(aux_names[i]);
+    if (pit == p->aux_params.end()) {
+      aux_arrays.push_back(NDArray(aux_shapes[i], p->ctx));
+      continue;
+    }
+    CHECK_EQ(pit->second.shape(), aux_shapes[i])
+        << "shape of " << aux_names[i] << " depends on the batch size";
+    aux_arrays.push_back(pit->second);
+  }
+  // share the memory pool with the executor of the maximum batch size,
+  // batches are run one at a time so the pool is never used concurrently
+  Executor* shared_exec = p->execs[p->max_batch_size].get();
+  std::map<std::string, Context> ctx_map;
+  std::vector<NDArray> grad_store(arg_arrays.size());
+  std::vector<OpReqType> grad_req(arg_arrays.size(), kNullOp);
+  p->execs[batch_size].reset(Executor::Bind(p->sym, p->ctx, ctx_map,
+                                            arg_arrays,
+                                            grad_store, grad_req,
+                                            aux_arrays, shared_exec));
+  return p->execs[batch_size].get();
+}
+
+// run a batch of requests and scatter the outputs back
+void RunBatch(MXAPIBatchPredictor* p, const std::vector<MXAPIBatchRequest*>& batch) {
+  const mx_uint batch_size = static_cast<mx_uint>(batch.size());
+  Executor* exec = GetBatchExec(p, batch_size);
+  const std::vector<NDArray>& inputs = p->exec_inputs[batch_size];
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const size_t size = p->input_shapes[i].Size();
+    std::vector<mx_float>& buf = p->input_buffers[i];
+    buf.resize(size * batch_size);
+    for (size_t j = 0; j < batch.size(); ++j) {
+      std::copy(batch[j]->input_data[i], batch[j]->input_data[i] + size,
+                buf.begin() + j * size);
+    }
+    inputs[i].SyncCopyFromCPU(buf.data(), buf.size());
+  }
+  exec->Forward(false);
+  const std::vector<NDArray>& outputs = exec->outputs();
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    const size_t size = p->out_shapes[i].Size();
+    std::vector<mx_float>& buf = p->output_buffers[i];
+    buf.resize(size * batch_size);
+    outputs[i].SyncCopyToCPU(buf.data(), buf.size());
+    for (size_t j = 0; j < batch.size(); ++j) {
+      std::copy(buf.begin() + j * size, buf.begin() + (j + 1) * size,
+                batch[j]->output_data[i]);
+    }
+  }
+}
+
+// worker loop: wait for the batch to fill up or time out, then run it
+void BatchPredictorLoop(MXAPIBatchPredictor* p) {
+  std::vector<MXAPIBatchRequest*> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(p->mutex);
+      p->queue_cond.wait(lock, [p] { return p->shutdown || !p->queue.empty(); });
+      if (p->shutdown) return;
+      auto deadline = p->queue.front()->submit_time + p->timeout;
+      p->queue_cond.wait_until(lock, deadline, [p] {
+        return p->shutdown || p->queue.size() >= p->max_batch_size;
+      });
+      if (p->shutdown) return;
+      const size_t n = std::min<size_t>(p->queue.size(), p->max_batch_size);
+      batch.assign(p->queue.begin(), p->queue.begin() + n);
+      p->queue.erase(p->queue.begin(), p->queue.begin() + n);
+    }
+    std::string error;
+    // any exception escaping the worker thread would terminate the process
+    try {
+      RunBatch(p, batch);
+    } catch (std::exception &err) {
+      error = err.what();
+    } catch (...) {
+      error = "unknown exception in the batch predictor";
+    }
+    auto now = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(p->mutex);
+      for (MXAPIBatchRequest* req : batch) {
+        double latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - req->submit_time).count();
+        p->total_latency_us += latency;
+        p->max_latency_us = std::max(p->max_latency_us, latency);
+        req->error = error;
+        req->done = true;
+      }
+      p->num_requests += batch.size();
+      p->num_batches += 1;
+    }
+    p->done_cond.notify_all();
+  }
+}
+
+}  // namespace mxnet
+
+int MXPredBatchCreate(const char* symbol_json_str,
+                      const void* param_bytes,
+                      int param_size,
+                      int dev_type, int dev_id,
+                      mx_uint num_input_nodes,
+                      const char** input_keys,
+                      const mx_uint* input_shape_indptr,
+                      const mx_uint* input_shape_data,
+                      mx_uint max_batch_size,
+                      mx_uint timeout_us,
+                      BatchPredictorHandle* out) {
+  MXAPIBatchPredictor* ret = new MXAPIBatchPredictor();
+  API_BEGIN();
+  CHECK_GT(max_batch_size, 0U) << "max_batch_size must be positive";
+  ret->sym = LoadPredSymbol(symbol_json_str, 0, nullptr);
+  ret->ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  ret->max_batch_size = max_batch_size;
+  ret->timeout = std::chrono::microseconds(timeout_us);
+  for (mx_uint i = 0; i < num_input_nodes; ++i) {
+    ret->input_keys.emplace_back(input_keys[i]);
+    ret->input_shapes.emplace_back(input_shape_data + input_shape_indptr[i],
+                                   input_shape_data + input_shape_indptr[i + 1]);
+  }
+  // copy the weights to the device once
+  std::unordered_map<std::string, NDArray> arg_params, aux_params;
+  LoadPredParams(ret->sym, param_bytes, param_size, &arg_params, &aux_params);
+  for (const auto& kv : arg_params) {
+    ret->arg_params[kv.first] = kv.second.Copy(ret->ctx);
+  }
+  for (const auto& kv : aux_params) {
+    ret->aux_params[kv.first] = kv.second.Copy(ret->ctx);
+  }
+  ret->execs.resize(max_batch_size + 1);
+  ret->exec_inputs.resize(max_batch_size + 1);
+  ret->input_buffers.resize(num_input_nodes);
+  Executor* exec = GetBatchExec(ret, max_batch_size);
+  // bind the smaller batch sizes up front, so that no request pays for a bind
+  for (mx_uint batch_size = 1; batch_size < max_batch_size; ++batch_size) {
+    GetBatchExec(ret, batch_size);
+  }
+  for (const NDArray& nd : exec->outputs()) {
+    const TShape& s = nd.shape();
+    CHECK(s.ndim() > 0 && s[0] == max_batch_size)
+        << "outputs of the batch predictor must have the batch axis first";
+    ret->out_shapes.emplace_back(s.begin() + 1, s.end());
+  }
+  ret->output_buffers.resize(ret->out_shapes.size());
+  ret->worker = std::thread(BatchPredictorLoop, ret);
+  *out = ret;
+  API_END_HANDLE_ERROR(delete ret);
+}
+
+int MXPredBatchGetOutputShape(BatchPredictorHandle handle,
+                              mx_uint out_index,
+                              mx_uint** shape_data,
+                              mx_uint* shape_ndim) {
+  MXAPIBatchPredictor* p = static_cast<MXAPIBatchPredictor*>(handle);
+  API_BEGIN();
+  CHECK_LT(out_index, p->out_shapes.size())
+      << "Index exceed number of outputs";
+  std::lock_guard<std::mutex> lock(p->mutex);
+  const TShape& s = p->out_shapes[out_index];
+  p->out_shapes_buffer.resize(s.ndim());
+  nnvm::ShapeTypeCast(s.begin(), s.end(), p->out_shapes_buffer.data());
+  *shape_data = p->out_shapes_buffer.data();
+  *shape_ndim = s.ndim();
+  API_END();
+}
+
+int MXPredBatchPredict(BatchPredictorHandle handle,
+                       const mx_float** input_data,
+                       mx_float** output_data) {
+  MXAPIBatchPredictor* p = static_cast<MXAPIBatchPredictor*>(handle);
+  API_BEGIN();
+  MXAPIBatchRequest req;
+  req.input_data = input_data;
+  req.output_data = output_data;
+  std::unique_lock<std::mutex> lock(p->mutex);
+  req.submit_time = std::chrono::steady_clock::now();
+  if (p->num_requests == 0 && p->queue.empty()) {
+    p->first_submit_time = req.submit_time;
+  }
+  p->queue.push_back(&req);
+  if (p->queue.size() == 1 || p->queue.size() >= p->max_batch_size) {
+    p->queue_cond.notify_all();
+  }
+  p->done_cond.wait(lock, [&req] { return req.done; });
+  if (!req.error.empty()) throw dmlc::Error(req.error);
+  API_END();
+}
+
+int MXPredBatchGetStats(BatchPredictorHandle handle,
+                        mx_uint* num_requests,
+                        mx_uint* num_batches,
+                        mx_float* avg_latency_ms,
+                        mx_float* max_latency_ms,
+                        mx_float* throughput) {
+  MXAPIBatchPredictor* p = static_cast<MXAPIBatchPredictor*>(handle);
+  API_BEGIN();
+  std::lock_guard<std::mutex> lock(p->mutex);
+  *num_requests = static_cast<mx_uint>(p->num_requests);
+  *num_batches = static_cast<mx_uint>(p->num_batches);
+  *avg_latency_ms = p->num_requests == 0 ? 0.0f :
+      static_cast<mx_float>(p->total_latency_us / p->num_requests / 1000.0);
+  *max_latency_ms = static_cast<mx_float>(p->max_latency_us / 1000.0);
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - p->first_submit_time).count();
+  *throughput = p->num_requests == 0 || elapsed <= 0 ? 0.0f :
+      static_cast<mx_float>(p->num_requests / elapsed);
+  API_END();
+}
+
+int MXPredBatchFree(BatchPredictorHandle handle) {
+  API_BEGIN();
+  delete static_cast<MXAPIBatchPredictor*>(handle);
+  API_END();
+}
+
 int MXNDListCreate(const char* nd_file_bytes,
                    int nd_file_size,
                    NDListHandle *out,
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file mapped_file.h
+ * \brief Read-only or copy-on-write memory mapping of a file.
+ */
+#ifndef MXNET_COMMON_MAPPED_FILE_H_
+#define MXNET_COMMON_MAPPED_FILE_H_
+
+#include <dmlc/logging.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#else
+#include <Windows.h>
+#endif  // _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace mxnet {
+namespace common {
+
+/*!
+ * \brief Maps a whole file into memory. Pages are read lazily from the file. A read-only
+ *  mapping faults on writes; a copy-on-write mapping copies a page when it is written
+ *  to, and the copy is private to the process.
+ */
+class MappedFile {
+ public:
+  /*!
+   * \brief map the file
+   * \param filename path of the file to map
+   * \param copy_on_write whether the mapping may be written to
+   */
+  explicit MappedFile(const std::string& filename, bool copy_on_write = false) {
+#ifdef _WIN32
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    CHECK(file_ != INVALID_HANDLE_VALUE)
+        << "Failed to open " << filename << ", error " << GetLastError();
+    LARGE_INTEGER size;
+    CHECK(GetFileSizeEx(file_, &size)) << "Failed to get the size of " << filename;
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ != 0) {
+      map_handle_ = CreateFileMapping(file_, NULL,
+                                      copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY,
+                                      0, 0, NULL);
+      CHECK(map_handle_ != nullptr)
+          << "Failed to map " << filename << ", error " << GetLastError();
+      data_ = MapViewOfFile(map_handle_, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ,
+                            0, 0, 0);
+      CHECK(data_ != nullptr)
+          << "Failed to map " << filename << ", error " << GetLastError();
+    }
+#else
+    int fid = open(filename.c_str(), O_RDONLY);
+    CHECK_NE(fid, -1) << "Failed to open " << filename << ": " << strerror(errno);
+    struct stat st;
+    CHECK_EQ(fstat(fid, &st), 0) << "Failed to stat " << filename << ": " << strerror(errno);
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ != 0) {
+      data_ = mmap(NULL, size_, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_PRIVATE, fid, 0);
+      CHECK_NE(data_, MAP_FAILED) << "Failed to map " << filename << ": " << strerror(errno);
+    }
+    close(fid);
+#endif  // _WIN32
+  }
+
+  ~MappedFile() {
+#ifdef _WIN32
+    if (data_ != nullptr) UnmapViewOfFile(data_);
+    if (map_handle_ != nullptr) CloseHandle(map_handle_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+    if (data_ != nullptr) munmap(data_, size_);
+#endif  // _WIN32
+  }
+
+  /*! \brief start of the mapped file */
+  void* data() const { return data_; }
+  /*! \brief size of the mapped file in bytes */
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  /*! \brief start of the mapping */
+  void* data_ = nullptr;
+  /*! \brief size of the mapping */
+  size_t size_ = 0;
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE map_handle_ = nullptr;
+#endif  // _WIN32
+};
+
+}  // namespace common
+}  // namespace mxnet
+#endif  // MXNET_COMMON_MAPPED_FILE_H_
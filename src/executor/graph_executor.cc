@@ -27,10 +27,14 @@
 #include <nnvm/pass_functions.h>
 #include <vector>
 #include <algorithm>
+#include <limits>
+#include <map>
+#include <unordered_map>
 
 #include "./exec_pass.h"
 #include "./graph_executor.h"
 #include "../engine/profiler.h"
+#include "../engine/openmp.h"
 #include "../common/utils.h"
 
 namespace mxnet {
@@ -116,6 +120,17 @@ void GraphExecutor::Print(std::ostream &os) const {  // NOLINT(*)
   size_t total_bytes = graph_.GetAttr<size_t>("storage_allocated_bytes");
   os << "Total " << (total_bytes >> 20UL) <<" MB allocated\n";
   os << "Total " << 11 << " TempSpace resource requested\n";
+  // statistics of the memory plan of the data entries
+  const size_t allocated = mem_stats_.allocated_bytes;
+  os << "Memory plan: " << (mem_stats_.planned_bytes >> 10UL) << " KB planned, "
+     << (allocated >> 10UL) << " KB allocated";
+  if (mem_stats_.lower_bound_bytes != 0) {
+    const double fragmentation = allocated == 0 ? 0.0 :
+        1.0 - static_cast<double>(mem_stats_.lower_bound_bytes) / allocated;
+    os << ", " << (mem_stats_.lower_bound_bytes >> 10UL) << " KB lower bound, "
+       << fragmentation * 100.0 << "% fragmentation";
+  }
+  os << "\n";
 }
 
 void GraphExecutor::SetMonitorCallback(const MonitorCallback& callback) {
@@ -1073,6 +1088,82 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol,
   return g;
 }
 
+/*! \brief byte alignment of arrays placed in a memory arena */
+constexpr size_t kArenaAlignment = 64;
+
+/*! \brief number of real_t words backing the given number of bytes */
+inline size_t NumWords(size_t bytes) {
+  return (bytes + sizeof(real_t) - 1) / sizeof(real_t);
+}
+
+/*! \brief a storage block to be placed in a memory arena */
+struct ArenaBlockInfo {
+  // size of the block in bytes
+  size_t bytes{0};
+  // first node in topo order that touches the block
+  uint32_t start{std::numeric_limits<uint32_t>::max()};
+  // last node in topo order that touches the block
+  uint32_t end{0};
+  // assigned byte offset in the arena
+  size_t offset{0};
+};
+
+/*!
+ * \brief Assign arena offsets to blocks so that blocks with overlapping lifetimes
+ *  never overlap in memory. Blocks are placed greedily from the largest to the
+ *  smallest, each into the smallest gap left by the already placed blocks that are
+ *  alive at the same time (best-fit), or after them if no gap is large enough.
+ * \param blocks the blocks to place, offsets are written back
+ * \return the lower bound of the arena size, i.e. the peak of live bytes
+ */
+inline size_t PlanArenaOffsets(std::vector<ArenaBlockInfo>* blocks) {
+  auto aligned = [](size_t bytes) {
+    return (bytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+  };
+  std::vector<ArenaBlockInfo>& info = *blocks;
+  std::vector<size_t> order(info.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&info](size_t lhs, size_t rhs) {
+    if (info[lhs].bytes != info[rhs].bytes) return info[lhs].bytes > info[rhs].bytes;
+    return info[lhs].end - info[lhs].start > info[rhs].end - info[rhs].start;
+  });
+  // placed blocks ordered by offset
+  std::multimap<size_t, size_t> placed;
+  for (size_t i : order) {
+    ArenaBlockInfo& b = info[i];
+    const size_t bytes = aligned(b.bytes);
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t prev_end = 0;
+    for (const auto& kv : placed) {
+      const ArenaBlockInfo& p = info[kv.second];
+      if (p.end < b.start || b.end < p.start) continue;
+      if (kv.first > prev_end) {
+        const size_t gap = kv.first - prev_end;
+        if (gap >= bytes && gap < best_gap) {
+          best_gap = gap;
+          best_offset = prev_end;
+        }
+      }
+      prev_end = std::max(prev_end, kv.first + aligned(p.bytes));
+    }
+    b.offset = best_offset != std::numeric_limits<size_t>::max() ? best_offset : prev_end;
+    placed.emplace(b.offset, i);
+  }
+  // peak of live bytes over the topo order
+  std::map<uint32_t, int64_t> delta;
+  for (const ArenaBlockInfo& b : info) {
+    delta[b.start] += static_cast<int64_t>(b.bytes);
+    delta[b.end + 1] -= static_cast<int64_t>(b.bytes);
+  }
+  int64_t live = 0, peak = 0;
+  for (const auto& kv : delta) {
+    live += kv.second;
+    peak = std::max(peak, live);
+  }
+  return static_cast<size_t>(peak);
+}
+
 // initialize the memory of each entries
 void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
   using nnvm::DTypeVector;
@@ -1147,6 +1238,88 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
       info.bytes = std::max(info.bytes, bytes);
     }
   }
+  // Each allocation block is backed by one NDArray. Without the arena planner every
+  // storage id is its own block; with it, storage ids are packed into arenas and served
+  // as arrays with engine variables of their own at byte offsets within a block.
+  struct AllocBlock {
+    Context ctx;
+    size_t bytes;
+  };
+  std::vector<AllocBlock> blocks;
+  // block index and byte offset of every storage id
+  std::vector<std::pair<size_t, size_t> > pool_location(pool_info.size());
+  mem_stats_ = MemoryPlanStats();
+  for (const PoolEntry& info : pool_info) {
+    mem_stats_.planned_bytes += info.bytes;
+  }
+  const bool use_arena = dmlc::GetEnv("MXNET_EXEC_ARENA_MEMORY_PLAN", false);
+  // lifetime of each storage id in topo order: [first write, last read]
+  std::vector<ArenaBlockInfo> arena_info;
+  if (use_arena) {
+    const auto& skip_plus_node = graph_.GetAttr<std::vector<int> >("skip_plus_node");
+    arena_info.resize(pool_info.size());
+    for (size_t sid = 0; sid < pool_info.size(); ++sid) {
+      arena_info[sid].bytes = pool_info[sid].bytes;
+    }
+    auto touch = [&](uint32_t eid, uint32_t nid) {
+      if (!data_entry_[eid].is_none() || vstorage[eid] < 0) return;
+      ArenaBlockInfo& info = arena_info[vstorage[eid]];
+      info.start = std::min(info.start, nid);
+      info.end = std::max(info.end, nid);
+    };
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+      // skipped nodes never run, their entries are written in place by other nodes
+      if (skip_plus_node.at(nid)) continue;
+      for (const auto& e : idx[nid].inputs) touch(idx.entry_id(e), nid);
+      for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+        touch(idx.entry_id(nid, i), nid);
+      }
+    }
+    // graph outputs must stay alive until the end of the pass
+    for (const auto& e : idx.outputs()) touch(idx.entry_id(e), idx.num_nodes());
+    // plan each context separately
+    std::vector<bool> visited(pool_info.size(), false);
+    for (size_t sid = 0; sid < pool_info.size(); ++sid) {
+      if (visited[sid] || pool_info[sid].bytes == 0) continue;
+      const Context& ctx = pool_info[sid].ctx;
+      std::vector<size_t> sids;
+      std::vector<ArenaBlockInfo> ctx_info;
+      for (size_t j = sid; j < pool_info.size(); ++j) {
+        if (visited[j] || pool_info[j].bytes == 0 || pool_info[j].ctx != ctx) continue;
+        visited[j] = true;
+        sids.push_back(j);
+        ctx_info.push_back(arena_info[j]);
+      }
+      mem_stats_.lower_bound_bytes += PlanArenaOffsets(&ctx_info);
+      for (size_t k = 0; k < sids.size(); ++k) {
+        arena_info[sids[k]].offset = ctx_info[k].offset;
+      }
+      // storage ids overlapping in memory are served from one block, merging
+      // overlapping ranges yields disjoint arenas.
+      std::vector<size_t> order(sids.size());
+      for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+      std::sort(order.begin(), order.end(), [&ctx_info](size_t lhs, size_t rhs) {
+        return ctx_info[lhs].offset < ctx_info[rhs].offset;
+      });
+      size_t block_begin = 0, block_end = 0;
+      for (size_t k : order) {
+        const ArenaBlockInfo& info = ctx_info[k];
+        if (k == order.front() || info.offset >= block_end) {
+          blocks.push_back(AllocBlock{ctx, 0});
+          block_begin = info.offset;
+        }
+        block_end = std::max(block_end, info.offset + info.bytes);
+        blocks.back().bytes = block_end - block_begin;
+        pool_location[sids[k]] = std::make_pair(blocks.size() - 1, info.offset - block_begin);
+      }
+    }
+  } else {
+    for (size_t sid = 0; sid < pool_info.size(); ++sid) {
+      pool_location[sid] = std::make_pair(blocks.size(), 0);
+      blocks.push_back(AllocBlock{pool_info[sid].ctx, pool_info[sid].bytes});
+    }
+  }
+
   // construct the re-use pool, if needed
   std::multimap<size_t, NDArray> free_pool;
   if (shared_pool != nullptr) {
@@ -1155,48 +1328,117 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
       free_pool.insert(std::make_pair(bytes, nd));
     }
   }
-  // remake the data pool
-  data_pool_.clear();
-  data_pool_.resize(pool_info.size());
-
-  // sort the pool info the descending order before allocating memory
-  std::vector<size_t> sorted_pool_index;
-  for (size_t i = 0; i < pool_info.size(); i++) {
-    sorted_pool_index.push_back(i);
+  // sort the blocks in the descending order before allocating memory
+  std::vector<size_t> sorted_block_index;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    sorted_block_index.push_back(i);
   }
-  auto pool_comparator = [&pool_info](int lhs, int rhs){
-    return pool_info[lhs].bytes > pool_info[rhs].bytes;
+  auto block_comparator = [&blocks](int lhs, int rhs){
+    return blocks[lhs].bytes > blocks[rhs].bytes;
   };
-  std::sort(sorted_pool_index.begin(), sorted_pool_index.end(), pool_comparator);
+  std::sort(sorted_block_index.begin(), sorted_block_index.end(), block_comparator);
 
-  for (size_t i : sorted_pool_index) {
-    const Context& ctx = pool_info[i].ctx;
-    size_t bytes = pool_info[i].bytes;
+  std::vector<NDArray> block_arrays(blocks.size());
+  for (size_t i : sorted_block_index) {
+    const Context& ctx = blocks[i].ctx;
+    size_t bytes = blocks[i].bytes;
     bool allocated = false;
     for (auto it = free_pool.lower_bound(bytes); it != free_pool.end(); ++it) {
       if (it->second.ctx() == ctx && it->first >= bytes) {
-        data_pool_[i] = it->second;
+        block_arrays[i] = it->second;
         free_pool.erase(it);
         allocated = true;
         break;
       }
     }
     if (!allocated) {
-      size_t nword = (bytes + 3) / 4;
+      size_t nword = NumWords(bytes);
       CHECK_LE(nword, std::numeric_limits<nnvm::dim_t>::max());
       // allocate float arrays
       TShape shape{static_cast<nnvm::dim_t>(nword)};
       // TODO(junwu): adding delay_alloc=true to create nd
       // is a temporary solution.
       NDArray nd(shape, ctx, true);
-      data_pool_[i] = nd;
+      block_arrays[i] = nd;
       // put the new allocated arrays to shared pool
       if (shared_pool != nullptr)  {
         shared_pool->push_back(nd);
       }
     }
+    mem_stats_.allocated_bytes += bytes;
   }
-  CHECK_EQ(data_pool_.size(), pool_info.size());
+  // the allocated blocks form the data pool, which can be shared with other executors
+  data_pool_.swap(block_arrays);
+  // the array backing each storage id
+  std::vector<NDArray> storage_arrays(pool_info.size());
+  for (size_t sid = 0; sid < pool_info.size(); ++sid) {
+    const NDArray& block = data_pool_[pool_location[sid].first];
+    if (!use_arena) {
+      storage_arrays[sid] = block;
+    } else if (pool_info[sid].bytes != 0) {
+      // a view with its own engine variable, so that the storage ids of an arena do
+      // not depend on each other. Offsets are aligned to kArenaAlignment, a multiple
+      // of the word size.
+      const TBlob& blob = block.data();
+      real_t *dptr = blob.dptr<real_t>() + pool_location[sid].second / sizeof(real_t);
+      TShape shape{static_cast<nnvm::dim_t>(NumWords(pool_info[sid].bytes))};
+      storage_arrays[sid] = NDArray(TBlob(dptr, shape, blob.dev_mask(), blob.dev_id()),
+                                    blob.dev_id());
+    }
+  }
+  // Engine dependencies that replace the ones implied by sharing one variable per block.
+  // The first node touching a block mutates the block variable and all other nodes
+  // touching it read the variable, which orders the block against other executors sharing
+  // the data pool and against the previous run. The first node writing a storage id
+  // mutates the variables of the storage ids whose memory it takes over.
+  arena_deps_.clear();
+  if (use_arena) {
+    const auto& skip_plus_node = graph_.GetAttr<std::vector<int> >("skip_plus_node");
+    arena_deps_.resize(idx.num_nodes());
+    std::vector<std::vector<size_t> > block_sids(blocks.size());
+    for (size_t sid = 0; sid < pool_info.size(); ++sid) {
+      if (pool_info[sid].bytes == 0 || arena_info[sid].start >= idx.num_nodes()) continue;
+      block_sids[pool_location[sid].first].push_back(sid);
+    }
+    std::vector<uint32_t> block_first(blocks.size(), std::numeric_limits<uint32_t>::max());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      for (size_t sid : block_sids[b]) {
+        const ArenaBlockInfo& next = arena_info[sid];
+        block_first[b] = std::min(block_first[b], next.start);
+        for (size_t prev_sid : block_sids[b]) {
+          const ArenaBlockInfo& prev = arena_info[prev_sid];
+          if (prev.end < next.start && prev.offset < next.offset + next.bytes &&
+              next.offset < prev.offset + prev.bytes) {
+            arena_deps_[next.start].mutate_vars.push_back(storage_arrays[prev_sid].var());
+          }
+        }
+      }
+    }
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+      if (skip_plus_node.at(nid)) continue;
+      std::vector<uint32_t> eids;
+      for (const auto& e : idx[nid].inputs) eids.push_back(idx.entry_id(e));
+      for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+        eids.push_back(idx.entry_id(nid, i));
+      }
+      for (uint32_t eid : eids) {
+        if (!data_entry_[eid].is_none() || vstorage[eid] < 0) continue;
+        if (pool_info[vstorage[eid]].bytes == 0) continue;
+        const size_t b = pool_location[vstorage[eid]].first;
+        if (block_first[b] == nid) {
+          arena_deps_[nid].mutate_vars.push_back(data_pool_[b].var());
+        } else {
+          arena_deps_[nid].use_vars.push_back(data_pool_[b].var());
+        }
+      }
+    }
+  }
+  if (log_verbose_) {
+    LOG(INFO) << "\tmemory plan: planned " << mem_stats_.planned_bytes
+              << " bytes, allocated " << mem_stats_.allocated_bytes
+              << " bytes, lower bound " << mem_stats_.lower_bound_bytes << " bytes";
+  }
+  CHECK_EQ(data_pool_.size(), blocks.size());
   // assign the data entries
   for (size_t i = 0; i < data_entry_.size(); ++i) {
     // avoid pre-allocated arrays
@@ -1206,7 +1448,7 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
     auto storage_type = (NDArrayStorageType) vstorage_type[i];
     if (storage_type == kDefaultStorage) {
       CHECK_GE(storage_id, 0) << "Do not support runtime shape op yet";
-      const NDArray& src = data_pool_.at(storage_id);
+      const NDArray& src = storage_arrays.at(storage_id);
       data_entry_[i] = src.AsArray(vshape[i], vdtype[i]);
     } else {
       data_entry_[i] = NDArray(storage_type, vshape[i], data_context[i]);
@@ -1296,6 +1538,11 @@ void GraphExecutor::InitCachedOps() {
     if (exec->var() != nullptr) {
       mutate_vars.push_back(exec->var());
     }
+    if (!arena_deps_.empty()) {
+      const ArenaDeps& deps = arena_deps_[nid];
+      use_vars.insert(use_vars.end(), deps.use_vars.begin(), deps.use_vars.end());
+      mutate_vars.insert(mutate_vars.end(), deps.mutate_vars.begin(), deps.mutate_vars.end());
+    }
     // dedup vars
     Engine::Get()->DeduplicateVarHandle(&use_vars, &mutate_vars);
     // all vars include both mutate vars and use vars
@@ -1350,9 +1597,14 @@ void GraphExecutor::InitOpSegs() {
   bool prefer_bulk_exec = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_TRAIN", 1);
   // The maximum number of node in a segment executed in bulk
   size_t num_nodes_threshold = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_MAX_NODE_TRAIN", 15);
+  // Whether to run independent branches inside a cpu segment concurrently
+  bool parallel_branch = false;
   if (prefer_bulk_exec_inference && num_forward_nodes_ == total_num_nodes) {
     // bulk the whole graph for inference
     num_nodes_threshold = std::numeric_limits<size_t>::max();
+    // off by default: the OpenMP loops of the operators nest inside the branch loop and
+    // then run single threaded, which only pays off for many narrow branches
+    parallel_branch = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_PARALLEL_BRANCH", false);
   }
 
   if (prefer_bulk_exec) {
@@ -1366,13 +1618,14 @@ void GraphExecutor::InitOpSegs() {
       if (node->is_variable() || nid - topo_start > num_nodes_threshold ||
           op_node.exec->exec_type() != ExecType::kSync) {
         // create a new segment for the previous nodes if the current one cannot be bulked
-        cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid);
+        cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, nid, parallel_branch);
         topo_start = nid + 1;
       }
     }
     // the last segmenet
     if (topo_start != num_forward_nodes_) {
-      cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, num_forward_nodes_);
+      cached_seg_opr_[topo_start] = this->CreateCachedSegOpr(topo_start, num_forward_nodes_,
+                                                             parallel_branch);
     }
 
     // create backward segments for training
@@ -1490,7 +1743,8 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
   }
 }
 
-GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start, size_t topo_end) {
+GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start, size_t topo_end,
+                                                              bool parallel_branch) {
   std::vector<Engine::VarHandle> use_vars;
   std::vector<Engine::VarHandle> mutate_vars;
   Context *pctx = nullptr;
@@ -1538,11 +1792,33 @@ GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start,
   Engine::Get()->DeduplicateVarHandle(&use_vars, &mutate_vars);
 
   bool is_gpu = pctx->dev_mask() == gpu::kDevMask;
-  auto exec_fun = [exec_list, is_gpu] (
+  if (parallel_branch && !is_gpu && exec_list.size() > 1) {
+    this->InitSegStages(&ret);
+  }
+  const auto& stage_offsets = ret.stage_offsets;
+  auto exec_fun = [exec_list, stage_offsets, is_gpu] (
       RunContext ctx, Engine::CallbackOnComplete on_complete) {
-    // Run all opr in the sub-graph
-    for (auto &exec : exec_list) {
-      exec->Run(ctx, is_gpu);
+    if (stage_offsets.empty()) {
+      // Run all opr in the sub-graph
+      for (auto &exec : exec_list) {
+        exec->Run(ctx, is_gpu);
+      }
+    } else {
+      // Run stage by stage, the oprs within one stage are independent of each other
+      for (size_t s = 0; s + 1 < stage_offsets.size(); ++s) {
+        const int begin = static_cast<int>(stage_offsets[s]);
+        const int end = static_cast<int>(stage_offsets[s + 1]);
+        if (end - begin == 1) {
+          exec_list[begin]->Run(ctx, is_gpu);
+          continue;
+        }
+        const int omp_threads = std::min(end - begin,
+            engine::OpenMP::Get()->GetRecommendedOMPThreadCount());
+        #pragma omp parallel for num_threads(omp_threads)
+        for (int i = begin; i < end; ++i) {
+          exec_list[i]->Run(ctx, is_gpu);
+        }
+      }
     }
     if (is_gpu) {
 #if MXNET_USE_CUDA
@@ -1567,6 +1843,56 @@ GraphExecutor::CachedSegOpr GraphExecutor::CreateCachedSegOpr(size_t topo_start,
       PROFILER_MESSAGE(p_opr_name));
   return ret;
 }
+
+void GraphExecutor::InitSegStages(CachedSegOpr* seg) {
+  // Assign each node of the segment the earliest stage that respects all
+  // read-after-write, write-after-read and write-after-write dependencies
+  // on its engine variables. Since memory sharing and resources are expressed
+  // as variables as well, nodes in the same stage never touch the same memory.
+  std::unordered_map<Engine::VarHandle, int> last_write, last_read;
+  std::vector<std::pair<int, size_t> > stage_of;
+  int max_stage = 0;
+  const auto& idx = graph_.indexed_graph();
+  for (size_t nid = seg->topo_start; nid < seg->topo_end; ++nid) {
+    const OpNode& op_node = op_nodes_[nid];
+    if (op_node.skip_exec_node) continue;
+    if (idx[nid].source->is_variable()) continue;
+    int stage = 0;
+    for (auto var : op_node.use_vars) {
+      auto it = last_write.find(var);
+      if (it != last_write.end()) stage = std::max(stage, it->second + 1);
+    }
+    for (auto var : op_node.mutate_vars) {
+      auto it = last_write.find(var);
+      if (it != last_write.end()) stage = std::max(stage, it->second + 1);
+      it = last_read.find(var);
+      if (it != last_read.end()) stage = std::max(stage, it->second + 1);
+    }
+    for (auto var : op_node.use_vars) {
+      int& r = last_read[var];
+      r = std::max(r, stage);
+    }
+    for (auto var : op_node.mutate_vars) {
+      last_write[var] = stage;
+    }
+    max_stage = std::max(max_stage, stage);
+    stage_of.emplace_back(stage, stage_of.size());
+  }
+  CHECK_EQ(stage_of.size(), seg->exec_list.size());
+  // nothing to gain if the segment is a single chain
+  if (static_cast<size_t>(max_stage + 1) == stage_of.size()) return;
+  std::stable_sort(stage_of.begin(), stage_of.end());
+  std::vector<std::shared_ptr<OpExecutor> > exec_list;
+  exec_list.reserve(stage_of.size());
+  for (size_t i = 0; i < stage_of.size(); ++i) {
+    if (i == 0 || stage_of[i].first != stage_of[i - 1].first) {
+      seg->stage_offsets.push_back(i);
+    }
+    exec_list.push_back(seg->exec_list[stage_of[i].second]);
+  }
+  seg->stage_offsets.push_back(exec_list.size());
+  seg->exec_list.swap(exec_list);
+}
 }  // namespace exec
 
 Executor *Executor::SimpleBind(nnvm::Symbol symbol,
@@ -137,6 +137,23 @@ class GraphExecutor : public Executor {
     Engine::OprHandle opr = nullptr;
     // list of op executors
     std::vector<std::shared_ptr<OpExecutor> > exec_list;
+    // boundaries of stages in exec_list, executors within a stage are independent
+    // and can run concurrently. Empty if the segment is executed sequentially.
+    std::vector<size_t> stage_offsets;
+  };
+  // statistics of the memory plan of the internal data entries
+  struct MemoryPlanStats {
+    // bytes required by the storage ids planned by nnvm
+    size_t planned_bytes{0};
+    // bytes of the blocks backing the data pool
+    size_t allocated_bytes{0};
+    // peak of simultaneously live bytes, only computed by the arena planner
+    size_t lower_bound_bytes{0};
+  };
+  // engine variables the arena memory planner adds to the dependencies of a node
+  struct ArenaDeps {
+    std::vector<Engine::VarHandle> use_vars;
+    std::vector<Engine::VarHandle> mutate_vars;
   };
   // Initialize in_args, arg_grads, and aux_states
   void InitArguments(const nnvm::IndexedGraph& idx,
@@ -191,10 +208,14 @@ class GraphExecutor : public Executor {
    * \brief Try to create a cached operator to run segments between start and end
    * \param topo_start beginning of segment
    * \param topo_end end of segment
+   * \param parallel_branch whether to run independent nodes of a cpu segment concurrently
    * \return the cached operator.
    *  ret.opr Can be nullptr if creation failed.
   */
-  CachedSegOpr CreateCachedSegOpr(size_t topo_start, size_t topo_end);
+  CachedSegOpr CreateCachedSegOpr(size_t topo_start, size_t topo_end,
+                                  bool parallel_branch = false);
+  // group the executors of a cpu segment into stages of independent nodes
+  void InitSegStages(CachedSegOpr* seg);
   // run the monitor callback for node `nid`
   void ExecuteMonCallback(size_t nid);
 
@@ -207,6 +228,10 @@ class GraphExecutor : public Executor {
   // internal data pool of allocated entries.
   // these allocated entries can be used for static memory sharing between executors.
   std::vector<NDArray> data_pool_;
+  // statistics of the memory plan
+  MemoryPlanStats mem_stats_;
+  // extra dependencies of each node, only filled by the arena memory planner
+  std::vector<ArenaDeps> arena_deps_;
   // output arrays
   std::vector<NDArray> output_arrays_;
   // input argument map, key is arg name, value is arg's NDArray
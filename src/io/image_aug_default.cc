@@ -212,17 +212,14 @@ class DefaultImageAugmenter : public ImageAugmenter {
         << "invalid inter_method: valid value 0,1,2,3,9,10";
       int interpolation_method = GetInterMethod(param_.inter_method,
                    src.cols, src.rows, new_width, new_height, prnd);
-      cv::resize(src, res, cv::Size(new_width, new_height),
-                   0, 0, interpolation_method);
+      res = resize_buf_.Get(new_height, new_width, src.type());
+      cv::resize(src, res, res.size(), 0, 0, interpolation_method);
     } else {
       res = src;
     }
 
     // normal augmentation by affine transformation.
-    if (param_.max_rotate_angle > 0 || param_.max_shear_ratio > 0.0f
-        || param_.rotate > 0 || rotate_list_.size() > 0 || param_.max_random_scale != 1.0
-        || param_.min_random_scale != 1.0 || param_.max_aspect_ratio != 0.0f
-        || param_.max_img_size != 1e10f || param_.min_img_size != 0.0f) {
+    if (HasAffine()) {
       std::uniform_real_distribution<float> rand_uniform(0, 1);
       // shear
       float s = rand_uniform(*prnd) * param_.max_shear_ratio * 2 - param_.max_shear_ratio;
@@ -248,7 +245,7 @@ class DefaultImageAugmenter : public ImageAugmenter {
                                  std::min(param_.max_img_size, scale * res.cols));
       float new_height = std::max(param_.min_img_size,
                                   std::min(param_.max_img_size, scale * res.rows));
-      cv::Mat M(2, 3, CV_32F);
+      cv::Mat &M = rotateM_;
       M.at<float>(0, 0) = hs * a - s * b * ws;
       M.at<float>(1, 0) = -b * ws;
       M.at<float>(0, 1) = hs * b + s * a * ws;
@@ -262,18 +259,23 @@ class DefaultImageAugmenter : public ImageAugmenter {
          << "invalid inter_method: valid value 0,1,2,3,9,10";
       int interpolation_method = GetInterMethod(param_.inter_method,
                     res.cols, res.rows, new_width, new_height, prnd);
-      cv::warpAffine(res, temp_, M, cv::Size(new_width, new_height),
+      cv::Mat warped = warp_buf_.Get(static_cast<int>(new_height),
+                                     static_cast<int>(new_width), res.type());
+      cv::warpAffine(res, warped, M, warped.size(),
                      interpolation_method,
                      cv::BORDER_CONSTANT,
                      cv::Scalar(param_.fill_value, param_.fill_value, param_.fill_value));
-      res = temp_;
+      res = warped;
     }
 
     // pad logic
     if (param_.pad > 0) {
-      cv::copyMakeBorder(res, res, param_.pad, param_.pad, param_.pad, param_.pad,
+      cv::Mat padded = pad_buf_.Get(res.rows + 2 * param_.pad, res.cols + 2 * param_.pad,
+                                    res.type());
+      cv::copyMakeBorder(res, padded, param_.pad, param_.pad, param_.pad, param_.pad,
                          cv::BORDER_CONSTANT,
                          cv::Scalar(param_.fill_value, param_.fill_value, param_.fill_value));
+      res = padded;
     }
 
     // crop logic
@@ -294,8 +296,9 @@ class DefaultImageAugmenter : public ImageAugmenter {
       cv::Rect roi(x, y, rand_crop_size, rand_crop_size);
       int interpolation_method = GetInterMethod(param_.inter_method, rand_crop_size, rand_crop_size,
                                                 param_.data_shape[2], param_.data_shape[1], prnd);
-      cv::resize(res(roi), res, cv::Size(param_.data_shape[2], param_.data_shape[1])
-                , 0, 0, interpolation_method);
+      cv::Mat cropped = crop_buf_.Get(param_.data_shape[1], param_.data_shape[2], res.type());
+      cv::resize(res(roi), cropped, cropped.size(), 0, 0, interpolation_method);
+      res = cropped;
     } else {
       CHECK(static_cast<index_t>(res.rows) >= param_.data_shape[1]
             && static_cast<index_t>(res.cols) >= param_.data_shape[2])
@@ -336,9 +339,58 @@ class DefaultImageAugmenter : public ImageAugmenter {
     return res;
   }
 
+  int MinSourceEdge() const override {
+    // the shorter edge is rescaled to resize before anything else looks at the pixels
+    return param_.resize > 0 ? param_.resize : -1;
+  }
+
+  bool IsResizeCrop() const override {
+    return param_.inter_method == 1 && param_.pad == 0 &&
+        param_.max_crop_size == -1 && param_.min_crop_size == -1 &&
+        !HasAffine() && param_.random_h == 0 && param_.random_s == 0 && param_.random_l == 0;
+  }
+
+  void SampleResizeCrop(int rows, int cols, common::RANDOM_ENGINE *prnd,
+                        cv::Size *resized, cv::Rect *roi) override {
+    using mshadow::index_t;
+    // same arithmetic and random draws as Process
+    *resized = cv::Size(cols, rows);
+    if (param_.resize != -1) {
+      if (rows > cols) {
+        *resized = cv::Size(param_.resize, param_.resize * rows / cols);
+      } else {
+        *resized = cv::Size(param_.resize * cols / rows, param_.resize);
+      }
+    }
+    CHECK(static_cast<index_t>(resized->height) >= param_.data_shape[1]
+          && static_cast<index_t>(resized->width) >= param_.data_shape[2])
+        << "input image size smaller than input shape";
+    index_t y = resized->height - param_.data_shape[1];
+    index_t x = resized->width - param_.data_shape[2];
+    if (param_.rand_crop != 0) {
+      y = std::uniform_int_distribution<index_t>(0, y)(*prnd);
+      x = std::uniform_int_distribution<index_t>(0, x)(*prnd);
+    } else {
+      y /= 2; x /= 2;
+    }
+    *roi = cv::Rect(x, y, param_.data_shape[2], param_.data_shape[1]);
+  }
+
+  size_t NumAllocations() const override {
+    return resize_buf_.num_alloc() + warp_buf_.num_alloc() +
+           pad_buf_.num_alloc() + crop_buf_.num_alloc();
+  }
+
  private:
-  // temporal space
-  cv::Mat temp_;
+  // whether any affine transformation is enabled
+  bool HasAffine() const {
+    return param_.max_rotate_angle > 0 || param_.max_shear_ratio > 0.0f
+        || param_.rotate > 0 || rotate_list_.size() > 0 || param_.max_random_scale != 1.0
+        || param_.min_random_scale != 1.0 || param_.max_aspect_ratio != 0.0f
+        || param_.max_img_size != 1e10f || param_.min_img_size != 0.0f;
+  }
+  // reusable space of each stage, the result of a stage is never written by a later one
+  ImageBuffer resize_buf_, warp_buf_, pad_buf_, crop_buf_;
   // rotation param
   cv::Mat rotateM_;
   // parameters
@@ -37,6 +37,41 @@
 
 namespace mxnet {
 namespace io {
+/*!
+ * \brief reusable storage for images of varying size.
+ *  The storage only grows, so once the largest image has been seen
+ *  handing out images does not touch the heap anymore.
+ */
+class ImageBuffer {
+ public:
+  /*!
+   * \brief get an image backed by the buffer,
+   *  this invalidates images previously returned by the buffer
+   * \param rows number of rows
+   * \param cols number of columns
+   * \param type opencv type of the image
+   * \return continuous image that does not own its memory
+   */
+  inline cv::Mat Get(int rows, int cols, int type) {
+    const size_t bytes = static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type);
+    if (bytes > data_.size()) {
+      data_.resize(bytes);
+      ++num_alloc_;
+    }
+    return cv::Mat(rows, cols, type, dmlc::BeginPtr(data_));
+  }
+  /*! \return number of times the storage was (re)allocated */
+  inline size_t num_alloc() const {
+    return num_alloc_;
+  }
+
+ private:
+  /*! \brief the storage */
+  std::vector<uchar> data_;
+  /*! \brief allocation counter */
+  size_t num_alloc_ = 0;
+};
+
 /*!
  * \brief OpenCV based Image augmenter,
  *  The augmenter can contain internal temp state.
@@ -59,6 +94,40 @@ class ImageAugmenter {
    */
   virtual cv::Mat Process(const cv::Mat &src, std::vector<float> *label,
                           common::RANDOM_ENGINE *prnd) = 0;
+  /*!
+   * \brief the smallest shorter edge the source image can be decoded to
+   *   without changing the result of this augmenter.
+   *   Decoders use it to pick a reduced decoding resolution.
+   * \return the minimal shorter edge, or -1 if full resolution is required.
+   */
+  virtual int MinSourceEdge() const {
+    return -1;
+  }
+  /*!
+   * \brief whether Process amounts to a bilinear resize followed by a crop,
+   *   in which case callers may fuse it with their output conversion
+   *   through SampleResizeCrop instead of calling Process.
+   */
+  virtual bool IsResizeCrop() const {
+    return false;
+  }
+  /*!
+   * \brief draw the resize and crop Process would apply to an image,
+   *   consuming the same random numbers. Only valid if IsResizeCrop.
+   * \param rows number of rows of the source image
+   * \param cols number of columns of the source image
+   * \param prnd pointer to random number generator.
+   * \param resized size the source image is resized to
+   * \param roi crop window in the resized image
+   */
+  virtual void SampleResizeCrop(int rows, int cols, common::RANDOM_ENGINE *prnd,
+                                cv::Size *resized, cv::Rect *roi) {
+    LOG(FATAL) << "augmenter is not a resize and crop";
+  }
+  /*! \return number of heap allocations made for intermediate images so far */
+  virtual size_t NumAllocations() const {
+    return 0;
+  }
   // virtual destructor
   virtual ~ImageAugmenter() {}
   /*!
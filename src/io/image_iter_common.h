@@ -123,6 +123,10 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   size_t shuffle_chunk_size;
   /*! \brief the seed for chunk shuffling*/
   int shuffle_chunk_seed;
+  /*! \brief whether to decode jpeg at a reduced resolution when possible */
+  bool scaled_decode;
+  /*! \brief whether to fuse a plain resize and crop with the output conversion */
+  bool fuse_resize_crop;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecParserParam) {
@@ -157,6 +161,14 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
         .describe("The data shuffle buffer size in MB. Only valid if shuffle is true.");
     DMLC_DECLARE_FIELD(shuffle_chunk_seed).set_default(0)
         .describe("The random seed for shuffling");
+    DMLC_DECLARE_FIELD(scaled_decode).set_default(false)
+        .describe("Decode JPEG images at 1/2, 1/4 or 1/8 resolution when the shorter edge "
+                  "still covers the ``resize`` augmentation. Requires libjpeg-turbo.");
+    DMLC_DECLARE_FIELD(fuse_resize_crop).set_default(false)
+        .describe("When the only augmentation is a resize and a crop, interpolate the crop "
+                  "straight into the output batch instead of calling OpenCV. The output "
+                  "differs slightly from the OpenCV path: the resized pixels are not rounded "
+                  "to uint8 and large downscales are bilinear instead of area averaged.");
   }
 };
 
@@ -331,11 +343,25 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
   size_t prefetch_buffer;
   /*! \brief data type */
   dmlc::optional<int> dtype;
+  /*! \brief whether to adapt the prefetch depth */
+  bool adaptive_prefetch;
+  /*! \brief device type of the batches */
+  int ctx;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(PrefetcherParam) {
     DMLC_DECLARE_FIELD(prefetch_buffer).set_default(4)
         .describe("Maximum number of batches to prefetch.");
+    DMLC_DECLARE_FIELD(adaptive_prefetch).set_default(false)
+        .describe("Whether to adapt the number of batches prepared ahead, between 1 and 16, "
+                  "to how long the consumer waits for batches and the producer waits for room.");
+    DMLC_DECLARE_FIELD(ctx)
+      .add_enum("cpu", Context::kCPU)
+      .add_enum("cpu_pinned", Context::kCPUPinned)
+      .add_enum("cpu_shared", Context::kCPUShared)
+      .set_default(Context::kCPU)
+      .describe("Context of the output batches. ``cpu_pinned`` batches are copied to GPUs "
+                "without a staging copy, ``cpu_shared`` batches can be sent to other processes.");
     DMLC_DECLARE_FIELD(dtype)
       .add_enum("float32", mshadow::kFloat32)
       .add_enum("float64", mshadow::kFloat64)
@@ -26,7 +26,7 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
+#include "./parallel_text_parser.h"
 #include "./iter_prefetcher.h"
 #include "./iter_batchloader.h"
 
@@ -42,6 +42,14 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
   std::string label_csv;
   /*! \brief label shape */
   TShape label_shape;
+  /*! \brief partition the data into multiple parts */
+  int num_parts;
+  /*! \brief the index of the part will read */
+  int part_index;
+  /*! \brief number of parsing threads */
+  int preprocess_threads;
+  /*! \brief path of the binary cache */
+  std::string cache_file;
   // declare parameters
   DMLC_DECLARE_PARAMETER(CSVIterParam) {
     DMLC_DECLARE_FIELD(data_csv)
@@ -54,6 +62,16 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
     index_t shape1[] = {1};
     DMLC_DECLARE_FIELD(label_shape).set_default(TShape(shape1, shape1 + 1))
         .describe("The shape of one label.");
+    DMLC_DECLARE_FIELD(num_parts).set_lower_bound(1).set_default(1)
+        .describe("partition the data into multiple parts");
+    DMLC_DECLARE_FIELD(part_index).set_lower_bound(0).set_default(0)
+        .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads to parse the CSV text with.");
+    DMLC_DECLARE_FIELD(cache_file).set_default("")
+        .describe("If set, the parsed data is written to this binary file during the first "
+                  "pass, and later passes and runs read it instead of the CSV text until "
+                  "the CSV files change. Labels are cached in ``cache_file + '.label'``.");
   }
 };
 
@@ -67,9 +85,20 @@ class CSVIter: public IIterator<DataInst> {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
-    data_parser_.reset(dmlc::Parser<uint32_t>::Create(param_.data_csv.c_str(), 0, 1, "csv"));
+    CHECK_LT(param_.part_index, param_.num_parts) << "part_index should be less than num_parts";
+    // the files are split at byte offsets, which only agree on the rows of both files
+    // in special cases, so a separate label file cannot be partitioned
+    CHECK(param_.label_csv == "NULL" || param_.num_parts == 1)
+        << "CSVIter cannot partition the data when label_csv is set, "
+        << "num_parts must be 1";
+    data_parser_.reset(new ParallelTextParser(param_.data_csv, param_.part_index,
+                                              param_.num_parts, ParallelTextParser::kCSV,
+                                              param_.preprocess_threads, param_.cache_file));
     if (param_.label_csv != "NULL") {
-      label_parser_.reset(dmlc::Parser<uint32_t>::Create(param_.label_csv.c_str(), 0, 1, "csv"));
+      label_parser_.reset(new ParallelTextParser(
+          param_.label_csv, param_.part_index, param_.num_parts, ParallelTextParser::kCSV,
+          param_.preprocess_threads,
+          param_.cache_file.empty() ? "" : param_.cache_file + ".label"));
     } else {
       dummy_label.set_pad(false);
       dummy_label.Resize(mshadow::Shape1(1));
@@ -95,21 +124,21 @@ class CSVIter: public IIterator<DataInst> {
         end_ = true; return false;
       }
       data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
+      data_size_ = data_parser_->Value().Size();
     }
     out_.index = inst_counter_++;
     CHECK_LT(data_ptr_, data_size_);
-    out_.data[0] = AsTBlob(data_parser_->Value()[data_ptr_++], param_.data_shape);
+    out_.data[0] = AsTBlob(data_parser_->Value(), data_ptr_++, param_.data_shape);
 
     if (label_parser_.get() != nullptr) {
       while (label_ptr_ >= label_size_) {
         CHECK(label_parser_->Next())
             << "Data CSV's row is smaller than the number of rows in label_csv";
         label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
+        label_size_ = label_parser_->Value().Size();
       }
       CHECK_LT(label_ptr_, label_size_);
-      out_.data[1] = AsTBlob(label_parser_->Value()[label_ptr_++], param_.label_shape);
+      out_.data[1] = AsTBlob(label_parser_->Value(), label_ptr_++, param_.label_shape);
     } else {
       out_.data[1] = dummy_label;
     }
@@ -121,11 +150,12 @@ class CSVIter: public IIterator<DataInst> {
   }
 
  private:
-  inline TBlob AsTBlob(const dmlc::Row<uint32_t>& row, const TShape& shape) {
-    CHECK_EQ(row.length, shape.Size())
+  inline TBlob AsTBlob(const TextRowView& block, size_t row, const TShape& shape) {
+    const size_t length = block.offset[row + 1] - block.offset[row];
+    CHECK_EQ(length, shape.Size())
         << "The data size in CSV do not match size of shape: "
-        << "specified shape=" << shape << ", the csv row-length=" << row.length;
-    const real_t* ptr = row.value;
+        << "specified shape=" << shape << ", the csv row-length=" << length;
+    const real_t* ptr = block.value + block.offset[row];
     return TBlob((real_t*)ptr, shape, cpu::kDevMask, 0);  // NOLINT(*)
   }
 
@@ -141,8 +171,8 @@ class CSVIter: public IIterator<DataInst> {
   // label parser
   size_t label_ptr_{0}, label_size_{0};
   size_t data_ptr_{0}, data_size_{0};
-  std::unique_ptr<dmlc::Parser<uint32_t> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint32_t> > data_parser_;
+  std::unique_ptr<ParallelTextParser> label_parser_;
+  std::unique_ptr<ParallelTextParser> data_parser_;
 };
 
 
@@ -165,6 +195,15 @@ to set `round_batch` to False.
 
 If ``data_csv = 'data/'`` is set, then all the files in this directory will be read.
 
+When `num_parts` and `part_index` are provided, the data is split into `num_parts` partitions,
+and the iterator only reads the `part_index`-th partition. Partitioning is not supported
+together with `label_csv`.
+
+If `cache_file` is set, the first complete pass writes the parsed rows to that file,
+and later passes, as well as later iterators with the same `cache_file`, read the rows
+from it without parsing the CSV text. The cache is rebuilt when the size or modification
+time of a CSV file changes.
+
 ``reset()`` is expected to be called only after a complete pass of data.
 
 Examples::
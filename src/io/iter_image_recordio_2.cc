@@ -33,6 +33,9 @@
 #include <dmlc/omp.h>
 #include <dmlc/common.h>
 #include <dmlc/timer.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <type_traits>
 #if MXNET_USE_LIBJPEG_TURBO
 #include <turbojpeg.h>
@@ -45,6 +48,36 @@
 
 namespace mxnet {
 namespace io {
+#if MXNET_USE_OPENCV
+/*! \brief decoding state of one preprocess thread, reused across images */
+struct DecodeWorkspace {
+#if MXNET_USE_LIBJPEG_TURBO
+  /*! \brief turbojpeg decompressor, created on first use */
+  tjhandle handle = nullptr;
+#endif
+  /*! \brief storage of the decoded image */
+  ImageBuffer decoded;
+  /*! \brief number of images decoded */
+  size_t num_images = 0;
+  /*! \brief number of decoded images allocated by opencv instead of the buffer */
+  size_t num_alloc = 0;
+  /*! \brief number of images that took the fused resize and crop path */
+  size_t num_fused = 0;
+  /*! \brief seconds spent in decoding, augmentation and output conversion */
+  double decode_time = 0, augment_time = 0, convert_time = 0;
+  /*! \brief source column and weight of each output column of a fused resize */
+  std::vector<int> xofs;
+  std::vector<float> xweight;
+  /*! \brief two horizontally resized source rows, planar float */
+  std::vector<float> hrows;
+  ~DecodeWorkspace() {
+#if MXNET_USE_LIBJPEG_TURBO
+    if (handle != nullptr) tjDestroy(handle);
+#endif
+  }
+};
+#endif
+
 // parser to parse image recordio
 template<typename DType>
 class ImageRecordIOParser2 {
@@ -54,6 +87,9 @@ class ImageRecordIOParser2 {
 
   // set record to the head
   inline void BeforeFirst(void) {
+#if MXNET_USE_OPENCV
+    if (param_.verbose) ReportStats();
+#endif
     if (batch_param_.round_batch == 0 || !overflow) {
       n_parsed_ = 0;
       return source_->BeforeFirst();
@@ -71,12 +107,19 @@ class ImageRecordIOParser2 {
   void ProcessImage(const cv::Mat& res,
     mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
     const float illumination_scaled);
+  template<int n_channels>
+  void ResizeCropImage(const cv::Mat& src, const cv::Size& resized, const cv::Rect& roi,
+    mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
+    const float illumination_scaled, DecodeWorkspace *ws);
 #if MXNET_USE_LIBJPEG_TURBO
-  cv::Mat TJimdecode(cv::Mat buf, int color);
+  cv::Mat TJimdecode(cv::Mat buf, int color, int min_edge, DecodeWorkspace *ws);
 #endif
+  // log time spent per stage and how many buffer allocations were made
+  void ReportStats();
 #endif
   inline unsigned ParseChunk(DType* data_dptr, real_t* label_dptr, const unsigned current_size,
     dmlc::InputSplit::Blob * chunk);
+  inline void IndexRecords(dmlc::InputSplit::Blob * chunk);
   inline void CreateMeanImg(void);
 
   // magic number to seed prng
@@ -91,6 +134,8 @@ class ImageRecordIOParser2 {
   #if MXNET_USE_OPENCV
   /*! \brief augmenters */
   std::vector<std::vector<std::unique_ptr<ImageAugmenter> > > augmenters_;
+  /*! \brief per thread decoding state */
+  std::vector<std::unique_ptr<DecodeWorkspace> > workspaces_;
   #endif
   /*! \brief random samplers */
   std::vector<std::unique_ptr<common::RANDOM_ENGINE> > prnds_;
@@ -106,6 +151,12 @@ class ImageRecordIOParser2 {
   /*! \brief internal instance order */
   std::vector<std::pair<unsigned, unsigned> > inst_order_;
   unsigned inst_index_;
+  /*! \brief records of the chunk being parsed */
+  std::vector<dmlc::InputSplit::Blob> records_;
+  /*! \brief copy of the records the chunk reader had to reassemble */
+  std::string record_spill_;
+  /*! \brief where each record that did not go to the output was buffered */
+  std::vector<std::pair<unsigned, unsigned> > record_place_;
   /*! \brief internal counter tracking number of already parsed entries */
   unsigned n_parsed_;
   /*! \brief overflow marker */
@@ -119,6 +170,10 @@ class ImageRecordIOParser2 {
   bool legacy_shuffle_;
   // whether mean image is ready.
   bool meanfile_ready_;
+  // smallest shorter edge a jpeg may be decoded to, -1 for full resolution
+  int min_decode_edge_;
+  // whether augmentation is a resize and crop fused into the output conversion
+  bool fuse_resize_crop_;
 };
 
 template<typename DType>
@@ -151,6 +206,7 @@ inline void ImageRecordIOParser2<DType>::Init(
   std::vector<std::string> aug_names = dmlc::Split(param_.aug_seq, ',');
   augmenters_.clear();
   augmenters_.resize(threadget);
+  workspaces_.clear();
   // setup decoders
   for (int i = 0; i < threadget; ++i) {
     for (const auto& aug_name : aug_names) {
@@ -158,6 +214,24 @@ inline void ImageRecordIOParser2<DType>::Init(
       augmenters_[i].back()->Init(kwargs);
     }
     prnds_.emplace_back(new common::RANDOM_ENGINE((i + 1) * kRandMagic));
+    workspaces_.emplace_back(new DecodeWorkspace());
+  }
+  // a single augmenter that only resizes and crops may be fused with the output conversion
+  fuse_resize_crop_ = param_.fuse_resize_crop && augmenters_[0].size() == 1 &&
+                      augmenters_[0][0]->IsResizeCrop();
+  // only the first augmenter sees the decoded image
+  min_decode_edge_ = -1;
+  if (param_.scaled_decode) {
+#if MXNET_USE_LIBJPEG_TURBO
+    if (augmenters_[0].size() != 0) {
+      min_decode_edge_ = augmenters_[0].front()->MinSourceEdge();
+    }
+    if (min_decode_edge_ <= 0) {
+      LOG(INFO) << "scaled_decode is ignored because the augmenters need full resolution images";
+    }
+#else
+    LOG(INFO) << "scaled_decode is ignored because MXNet is built without libjpeg-turbo";
+#endif
   }
   if (param_.path_imglist.length() != 0) {
     label_map_.reset(new ImageLabelMap(param_.path_imglist.c_str(),
@@ -214,9 +288,9 @@ inline void ImageRecordIOParser2<DType>::Init(
     }
   }
   // Normalize init
+  meanfile_ready_ = false;
   if (!std::is_same<DType, uint8_t>::value) {
     meanimg_.set_pad(false);
-    meanfile_ready_ = false;
     if (normalize_param_.mean_img.length() != 0) {
       std::unique_ptr<dmlc::Stream> fi(
           dmlc::Stream::Create(normalize_param_.mean_img.c_str(), "r", true));
@@ -332,16 +406,18 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
       #pragma omp parallel for num_threads(param_.preprocess_threads)
       for (int i = 0; i < n_to_copy; ++i) {
         std::pair<unsigned, unsigned> place = inst_order_[inst_index_ + i];
-        const DataInst& batch = temp_[place.first][place.second];
-        for (unsigned j = 0; j < batch.data.size(); ++j) {
-          CHECK_EQ(unit_size_[j], batch.data[j].Size());
-          MSHADOW_TYPE_SWITCH(out->data[j].data().type_flag_, dtype, {
-          mshadow::Copy(
-              out->data[j].data().FlatTo1D<cpu, dtype>().Slice((current_size + i) * unit_size_[j],
-                (current_size + i + 1) * unit_size_[j]),
-              batch.data[j].get_with_shape<cpu, 1, dtype>(mshadow::Shape1(unit_size_[j])));
-          });
-        }
+        // copy straight from the tensors, building a DataInst would allocate
+        const InstVector<DType>& inst = temp_[place.first];
+        mshadow::Tensor<cpu, 3, DType> data = inst.data()[place.second];
+        mshadow::Tensor<cpu, 1, real_t> label = inst.label()[place.second];
+        CHECK_EQ(unit_size_[0], data.shape_.Size());
+        CHECK_EQ(unit_size_[1], label.shape_.Size());
+        std::copy(data.dptr_, data.dptr_ + unit_size_[0],
+                  static_cast<DType*>(out->data[0].data().dptr_) +
+                  (current_size + i) * unit_size_[0]);
+        std::copy(label.dptr_, label.dptr_ + unit_size_[1],
+                  static_cast<real_t*>(out->data[1].data().dptr_) +
+                  (current_size + i) * unit_size_[1]);
       }
       n_to_out = n_to_copy;
       inst_index_ += n_to_copy;
@@ -353,6 +429,17 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
 }
 
 #if MXNET_USE_OPENCV
+// convert a pixel computed in float to the output type
+template<typename DType>
+inline DType PixelCast(float v) {
+  return static_cast<DType>(v);
+}
+
+template<>
+inline uint8_t PixelCast<uint8_t>(float v) {
+  return static_cast<uint8_t>(std::min(std::max(v + 0.5f, 0.0f), 255.0f));
+}
+
 template<typename DType>
 template<int n_channels>
 void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
@@ -393,7 +480,8 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
     swap_indices[3] = 3;
   }
 
-  DType RGBA[n_channels] = {};
+  // computed in float, so that half precision output only rounds once
+  float RGBA[n_channels] = {};
   for (int i = 0; i < res.rows; ++i) {
     const uchar* im_data = res.ptr<uchar>(i);
     for (int j = 0; j < res.cols; ++j) {
@@ -415,9 +503,9 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
         // mirror here to avoid memory copies
         // logic from iter_normalize.h, function SetOutImg
         if (is_mirrored) {
-          data[k][i][res.cols - j - 1] = RGBA[k];
+          data[k][i][res.cols - j - 1] = PixelCast<DType>(RGBA[k]);
         } else {
-          data[k][i][j] = RGBA[k];
+          data[k][i][j] = PixelCast<DType>(RGBA[k]);
         }
       }
       im_data += n_channels;
@@ -425,6 +513,114 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
   }
 }
 
+template<typename DType>
+template<int n_channels>
+void ImageRecordIOParser2<DType>::ResizeCropImage(const cv::Mat& src, const cv::Size& resized,
+  const cv::Rect& roi, mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored,
+  const float contrast_scaled, const float illumination_scaled, DecodeWorkspace *ws) {
+  // Bilinear resize of src to resized, restricted to roi, which reads each source
+  // row once and writes the normalized CHW output straight away.
+  // Sampling positions follow cv::resize with INTER_LINEAR.
+  const float std_rgb[3] = {normalize_param_.std_r, normalize_param_.std_g,
+                            normalize_param_.std_b};
+  const float mean_rgb[3] = {normalize_param_.mean_r, normalize_param_.mean_g,
+                             normalize_param_.mean_b};
+  float mult[n_channels], bias[n_channels];  // NOLINT(*)
+  int src_channel[n_channels];  // NOLINT(*)
+  for (int k = 0; k < n_channels; ++k) {
+    // OpenCV stores BGR and we want RGB
+    src_channel[k] = n_channels - 1 - k;
+    mult[k] = 1.0f;
+    bias[k] = 0.0f;
+    if (!std::is_same<DType, uint8_t>::value) {
+      // same as ProcessImage: (v - mean) * contrast / std + illumination / std
+      mult[k] = contrast_scaled / std_rgb[k];
+      bias[k] = illumination_scaled / std_rgb[k] - mean_rgb[k] * mult[k];
+    }
+  }
+  const int out_h = roi.height;
+  const int out_w = roi.width;
+  const double scale_x = static_cast<double>(src.cols) / resized.width;
+  const double scale_y = static_cast<double>(src.rows) / resized.height;
+  // mirroring only changes which source column an output column reads
+  ws->xofs.resize(out_w);
+  ws->xweight.resize(out_w);
+  for (int j = 0; j < out_w; ++j) {
+    const int x = roi.x + (is_mirrored ? out_w - 1 - j : j);
+    float fx = static_cast<float>((x + 0.5) * scale_x - 0.5);
+    int sx = static_cast<int>(std::floor(fx));
+    fx -= sx;
+    if (sx < 0) {
+      sx = 0;
+      fx = 0;
+    }
+    if (sx >= src.cols - 1) {
+      sx = src.cols - 1;
+      fx = 0;
+    }
+    ws->xofs[j] = sx;
+    ws->xweight[j] = fx;
+  }
+  const size_t row_size = static_cast<size_t>(n_channels) * out_w;
+  ws->hrows.resize(2 * row_size);
+  float* hrow[2] = {dmlc::BeginPtr(ws->hrows), dmlc::BeginPtr(ws->hrows) + row_size};
+  int cached[2] = {-1, -1};
+  const int* xofs = dmlc::BeginPtr(ws->xofs);
+  const float* xweight = dmlc::BeginPtr(ws->xweight);
+  auto resize_row = [&](int sy, float* dst) {
+    const uchar* p = src.ptr<uchar>(sy);
+    const int last = (src.cols - 1) * n_channels;
+    for (int j = 0; j < out_w; ++j) {
+      const int x0 = xofs[j] * n_channels;
+      const int x1 = std::min(x0 + n_channels, last);
+      for (int k = 0; k < n_channels; ++k) {
+        const float v0 = p[x0 + src_channel[k]];
+        const float v1 = p[x1 + src_channel[k]];
+        dst[k * out_w + j] = v0 + xweight[j] * (v1 - v0);
+      }
+    }
+  };
+  mshadow::Tensor<cpu, 3, DType>& data = (*data_ptr);
+  for (int i = 0; i < out_h; ++i) {
+    float fy = static_cast<float>((roi.y + i + 0.5) * scale_y - 0.5);
+    int sy = static_cast<int>(std::floor(fy));
+    fy -= sy;
+    if (sy < 0) {
+      sy = 0;
+      fy = 0;
+    }
+    if (sy >= src.rows - 1) {
+      sy = src.rows - 1;
+      fy = 0;
+    }
+    const int sy1 = std::min(sy + 1, src.rows - 1);
+    // consecutive output rows mostly share source rows when downscaling mildly
+    if (cached[0] != sy) {
+      if (cached[1] == sy) {
+        std::swap(hrow[0], hrow[1]);
+        std::swap(cached[0], cached[1]);
+      } else {
+        resize_row(sy, hrow[0]);
+        cached[0] = sy;
+      }
+    }
+    if (cached[1] != sy1) {
+      resize_row(sy1, hrow[1]);
+      cached[1] = sy1;
+    }
+    for (int k = 0; k < n_channels; ++k) {
+      // contiguous loop without aliasing, left to the compiler to vectorize
+      const float* __restrict r0 = hrow[0] + k * out_w;
+      const float* __restrict r1 = hrow[1] + k * out_w;
+      DType* __restrict out = data[k][i].dptr_;
+      const float a = mult[k], b = bias[k];
+      for (int j = 0; j < out_w; ++j) {
+        out[j] = PixelCast<DType>((r0[j] + fy * (r1[j] - r0[j])) * a + b);
+      }
+    }
+  }
+}
+
 #if MXNET_USE_LIBJPEG_TURBO
 
 bool is_jpeg(unsigned char * file) {
@@ -435,8 +631,25 @@ bool is_jpeg(unsigned char * file) {
   }
 }
 
+// pick the strongest DCT scaling whose shorter edge still covers min_edge
+inline void ScaledJpegSize(int w, int h, int min_edge, int *scaled_w, int *scaled_h) {
+  static const tjscalingfactor kFactors[] = {{1, 8}, {1, 4}, {1, 2}};
+  *scaled_w = w;
+  *scaled_h = h;
+  for (const tjscalingfactor& sf : kFactors) {
+    const int sw = TJSCALED(w, sf);
+    const int sh = TJSCALED(h, sf);
+    if (std::min(sw, sh) >= min_edge) {
+      *scaled_w = sw;
+      *scaled_h = sh;
+      return;
+    }
+  }
+}
+
 template<typename DType>
-cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
+cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color, int min_edge,
+                                                DecodeWorkspace *ws) {
   unsigned char* jpeg = image.ptr();
   size_t jpeg_size = image.rows * image.cols;
 
@@ -445,9 +658,11 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
     return cv::imdecode(image, color);
   }
 
-  tjhandle handle = tjInitDecompress();
+  if (ws->handle == nullptr) {
+    ws->handle = tjInitDecompress();
+  }
   int h, w, subsamp;
-  int err = tjDecompressHeader2(handle,
+  int err = tjDecompressHeader2(ws->handle,
                                 jpeg,
                                 jpeg_size,
                                 &w, &h, &subsamp);
@@ -455,8 +670,11 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
     // If it is a malformed JPEG then fall back to OpenCV
     return cv::imdecode(image, color);
   }
-  cv::Mat ret = cv::Mat(h, w, color ? CV_8UC3 : CV_8UC1);
-  err = tjDecompress2(handle,
+  if (min_edge > 0) {
+    ScaledJpegSize(w, h, min_edge, &w, &h);
+  }
+  cv::Mat ret = ws->decoded.Get(h, w, color ? CV_8UC3 : CV_8UC1);
+  err = tjDecompress2(ws->handle,
                       jpeg,
                       jpeg_size,
                       ret.ptr(),
@@ -469,60 +687,111 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
     // If it is a malformed JPEG then fall back to OpenCV
     return cv::imdecode(image, color);
   }
-  tjDestroy(handle);
   return ret;
 }
 #endif
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::ReportStats() {
+  size_t num_images = 0, num_alloc = 0, num_fused = 0;
+  double decode_time = 0, augment_time = 0, convert_time = 0;
+  for (size_t i = 0; i < workspaces_.size(); ++i) {
+    const DecodeWorkspace& ws = *workspaces_[i];
+    num_images += ws.num_images;
+    num_alloc += ws.num_alloc + ws.decoded.num_alloc();
+    for (const auto& aug : augmenters_[i]) {
+      num_alloc += aug->NumAllocations();
+    }
+    num_fused += ws.num_fused;
+    decode_time += ws.decode_time;
+    augment_time += ws.augment_time;
+    convert_time += ws.convert_time;
+  }
+  if (num_images != 0) {
+    LOG(INFO) << "ImageRecordIOParser2: " << num_images << " images decoded with "
+              << num_alloc << " image buffer allocations";
+    const double ms = 1000.0 / num_images;
+    LOG(INFO) << "ImageRecordIOParser2: per image " << decode_time * ms << " ms decode, "
+              << augment_time * ms << " ms augment, " << convert_time * ms << " ms convert, "
+              << num_fused << " images with fused resize and crop";
+  }
+}
 #endif
 
+// Find the record boundaries of a chunk, so that threads can claim records without locking
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::IndexRecords(dmlc::InputSplit::Blob * chunk) {
+  dmlc::RecordIOChunkReader reader(*chunk, 0, 1);
+  dmlc::InputSplit::Blob blob;
+  const char* begin = static_cast<const char*>(chunk->dptr);
+  const char* end = begin + chunk->size;
+  // records split across several parts are reassembled in a buffer the reader
+  // reuses, keep their offsets into the spill and fix the pointers at the end
+  std::vector<std::pair<size_t, size_t> > spilled;
+  records_.clear();
+  record_spill_.clear();
+  while (reader.NextRecord(&blob)) {
+    const char* dptr = static_cast<const char*>(blob.dptr);
+    if (dptr < begin || dptr + blob.size > end) {
+      spilled.emplace_back(records_.size(), record_spill_.size());
+      record_spill_.append(dptr, blob.size);
+    }
+    records_.push_back(blob);
+  }
+  for (const auto& s : spilled) {
+    records_[s.first].dptr = &record_spill_[s.second];
+  }
+}
+
 // Returns the number of images that are put into output
 template<typename DType>
 inline unsigned ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t* label_dptr,
   const unsigned current_size, dmlc::InputSplit::Blob * chunk) {
   temp_.resize(param_.preprocess_threads);
 #if MXNET_USE_OPENCV
-  // save opencv out
-  dmlc::RecordIOChunkReader reader(*chunk, 0, 1);
-  unsigned gl_idx = current_size;
+  IndexRecords(chunk);
+  const unsigned num_records = records_.size();
+  // records before this one go straight to the output
+  const unsigned num_direct = current_size < batch_param_.batch_size ?
+      std::min(num_records, batch_param_.batch_size - current_size) : 0;
+  record_place_.resize(num_records);
+  std::atomic<unsigned> cursor(0);
+  // the stage times are only reported when verbose
+  const bool timing = param_.verbose;
+  auto now = [timing]() { return timing ? dmlc::GetTime() : 0.0; };
   #pragma omp parallel num_threads(param_.preprocess_threads)
   {
     CHECK(omp_get_num_threads() == param_.preprocess_threads);
     unsigned int tid = omp_get_thread_num();
-    // dmlc::RecordIOChunkReader reader(*chunk, tid, param_.preprocess_threads);
     ImageRecordIO rec;
-    dmlc::InputSplit::Blob blob;
     // image data
     InstVector<DType> &out_tmp = temp_[tid];
+    DecodeWorkspace *ws = workspaces_[tid].get();
     out_tmp.Clear();
     while (true) {
-      bool reader_has_data;
-      unsigned idx;
-      #pragma omp critical
-      {
-        reader_has_data = reader.NextRecord(&blob);
-        if (reader_has_data) {
-          idx = gl_idx++;
-          if (idx >= batch_param_.batch_size) {
-            inst_order_.push_back(std::make_pair(tid, out_tmp.Size()));
-          }
-        }
+      const unsigned i = cursor.fetch_add(1, std::memory_order_relaxed);
+      if (i >= num_records) break;
+      const dmlc::InputSplit::Blob& blob = records_[i];
+      const unsigned idx = current_size + i;
+      if (i >= num_direct) {
+        record_place_[i] = std::make_pair(tid, static_cast<unsigned>(out_tmp.Size()));
       }
-      if (!reader_has_data) break;
       // Opencv decode and augments
+      double tic = now();
       cv::Mat res;
       rec.Load(blob.dptr, blob.size);
       cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
       switch (param_.data_shape[0]) {
        case 1:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 0);
+        res = TJimdecode(buf, 0, min_decode_edge_, ws);
 #else
         res = cv::imdecode(buf, 0);
 #endif
         break;
        case 3:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 1);
+        res = TJimdecode(buf, 1, min_decode_edge_, ws);
 #else
         res = cv::imdecode(buf, 1);
 #endif
@@ -537,17 +806,36 @@ inline unsigned ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t
        default:
         LOG(FATAL) << "Invalid output shape " << param_.data_shape;
       }
+      // images not backed by the workspace were allocated by opencv
+      ws->num_alloc += res.u != nullptr;
+      ++ws->num_images;
       const int n_channels = res.channels();
-      for (auto& aug : augmenters_[tid]) {
-        res = aug->Process(res, nullptr, prnds_[tid].get());
+      double toc = now();
+      ws->decode_time += toc - tic;
+      tic = toc;
+      // a plain resize and crop is folded into the conversion below
+      const bool fused = fuse_resize_crop_ && !meanfile_ready_ && n_channels != 4;
+      cv::Size resized;
+      cv::Rect roi;
+      if (fused) {
+        augmenters_[tid].front()->SampleResizeCrop(res.rows, res.cols, prnds_[tid].get(),
+                                                   &resized, &roi);
+      } else {
+        for (auto& aug : augmenters_[tid]) {
+          res = aug->Process(res, nullptr, prnds_[tid].get());
+        }
+        roi = cv::Rect(0, 0, res.cols, res.rows);
       }
+      toc = now();
+      ws->augment_time += toc - tic;
+      tic = toc;
       mshadow::Tensor<cpu, 3, DType> data;
       if (idx < batch_param_.batch_size) {
         data = mshadow::Tensor<cpu, 3, DType>(data_dptr + idx*unit_size_[0],
-          mshadow::Shape3(n_channels, res.rows, res.cols));
+          mshadow::Shape3(n_channels, roi.height, roi.width));
       } else {
         out_tmp.Push(static_cast<unsigned>(rec.image_index()),
-                 mshadow::Shape3(n_channels, res.rows, res.cols),
+                 mshadow::Shape3(n_channels, roi.height, roi.width),
                  mshadow::Shape1(param_.label_width));
         data = out_tmp.data().Back();
       }
@@ -568,13 +856,23 @@ inline unsigned ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t
       }
       // For RGB or RGBA data, swap the B and R channel:
       // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
-      if (n_channels == 1) {
+      if (fused) {
+        if (n_channels == 1) {
+          ResizeCropImage<1>(res, resized, roi, &data, is_mirrored, contrast_scaled,
+                             illumination_scaled, ws);
+        } else {
+          ResizeCropImage<3>(res, resized, roi, &data, is_mirrored, contrast_scaled,
+                             illumination_scaled, ws);
+        }
+        ++ws->num_fused;
+      } else if (n_channels == 1) {
         ProcessImage<1>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       } else if (n_channels == 3) {
         ProcessImage<3>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       } else if (n_channels == 4) {
         ProcessImage<4>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       }
+      ws->convert_time += now() - tic;
 
       mshadow::Tensor<cpu, 1, real_t> label;
       if (idx < batch_param_.batch_size) {
@@ -601,7 +899,11 @@ inline unsigned ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t
       res.release();
     }
   }
-  return (std::min(batch_param_.batch_size, gl_idx) - current_size);
+  // buffered records are handed out in record order, whichever thread parsed them
+  for (unsigned i = num_direct; i < num_records; ++i) {
+    inst_order_.push_back(record_place_[i]);
+  }
+  return num_direct;
 #else
   LOG(FATAL) << "Opencv is needed for image decoding and augmenting.";
   return 0;
@@ -624,13 +926,12 @@ inline void ImageRecordIOParser2<DType>::CreateMeanImg(void) {
       ParseChunk(NULL, NULL, batch_param_.batch_size, &chunk);
       for (unsigned i = 0; i < inst_order_.size(); ++i) {
         std::pair<unsigned, unsigned> place = inst_order_[i];
-        mshadow::Tensor<cpu, 3> outimg =
-          temp_[place.first][place.second].data[0].template get<cpu, 3, real_t>();
+        mshadow::Tensor<cpu, 3, DType> outimg = temp_[place.first].data()[place.second];
         if (imcnt == 0) {
           meanimg_.Resize(outimg.shape_);
-          mshadow::Copy(meanimg_, outimg);
+          meanimg_ = mshadow::expr::tcast<real_t>(outimg);
         } else {
-          meanimg_ += outimg;
+          meanimg_ += mshadow::expr::tcast<real_t>(outimg);
         }
         imcnt += 1;
         double elapsed = dmlc::GetTime() - start;
@@ -721,6 +1022,51 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     ImageRecordIOParser2<DType> parser_;
 };
 
+/*!
+ * \brief ImageRecordIter that picks the output type from the dtype argument,
+ *  so that batches are produced in that type instead of being cast afterwards.
+ */
+class ImageRecordIter2Wrapper : public IIterator<DataBatch> {
+ public:
+  virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    PrefetcherParam prefetch_param;
+    prefetch_param.InitAllowUnknown(kwargs);
+    const int dtype = prefetch_param.dtype ? prefetch_param.dtype.value() : mshadow::kFloat32;
+    switch (dtype) {
+      case mshadow::kFloat32:
+        record_iter_.reset(new ImageRecordIter2<real_t>());
+        break;
+      case mshadow::kFloat16:
+        record_iter_.reset(new ImageRecordIter2<mshadow::half::half_t>());
+        break;
+      case mshadow::kUint8:
+        // raw pixels, normalization is left to the consumer
+        record_iter_.reset(new ImageRecordIter2<uint8_t>());
+        break;
+      default:
+        LOG(FATAL) << "ImageRecordIter only supports float32, float16 and uint8 output, got "
+                   << dtype;
+    }
+    record_iter_->Init(kwargs);
+  }
+
+  virtual void BeforeFirst(void) {
+    record_iter_->BeforeFirst();
+  }
+
+  virtual bool Next(void) {
+    return record_iter_->Next();
+  }
+
+  virtual const DataBatch &Value(void) const {
+    return record_iter_->Value();
+  }
+
+ private:
+  /*! \brief the typed iterator */
+  std::unique_ptr<IIterator<DataBatch> > record_iter_;
+};
+
 MXNET_REGISTER_IO_ITER(ImageRecordIter)
 .describe(R"code(Iterates on image RecordIO files
 
@@ -745,6 +1091,11 @@ Example::
   ...
   data_iter.reset() # To restart the iterator from the beginning.
 
+With ``dtype='float16'`` batches are normalized as usual but stored in half precision.
+With ``dtype='uint8'`` batches hold the raw augmented pixels and the normalization
+options are ignored, so normalization can be done on the device instead. Both cut
+the host memory traffic of prefetching and copying batches.
+
 )code" ADD_FILELINE)
 .add_arguments(ImageRecParserParam::__FIELDS__())
 .add_arguments(ImageRecordParam::__FIELDS__())
@@ -753,7 +1104,7 @@ Example::
 .add_arguments(ListDefaultAugParams())
 .add_arguments(ImageNormalizeParam::__FIELDS__())
 .set_body([]() {
-    return new ImageRecordIter2<real_t>();
+    return new ImageRecordIter2Wrapper();
     });
 
 MXNET_REGISTER_IO_ITER(ImageRecordUInt8Iter)
@@ -25,7 +25,8 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
+#include <algorithm>
+#include "./parallel_text_parser.h"
 #include "./iter_sparse_prefetcher.h"
 #include "./iter_sparse_batchloader.h"
 
@@ -45,6 +46,10 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
   int num_parts;
   /*! \brief the index of the part will read*/
   int part_index;
+  /*! \brief number of parsing threads */
+  int preprocess_threads;
+  /*! \brief path of the binary cache */
+  std::string cache_file;
   // declare parameters
   DMLC_DECLARE_PARAMETER(LibSVMIterParam) {
     DMLC_DECLARE_FIELD(data_libsvm)
@@ -61,6 +66,12 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
         .describe("partition the data into multiple parts");
     DMLC_DECLARE_FIELD(part_index).set_default(0)
         .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads to parse the LibSVM text with.");
+    DMLC_DECLARE_FIELD(cache_file).set_default("")
+        .describe("If set, the parsed data is written to this binary file during the first "
+                  "pass, and later passes and runs read it instead of the LibSVM text until "
+                  "the LibSVM files change. Labels are cached in ``cache_file + '.label'``.");
   }
 };
 
@@ -75,13 +86,14 @@ class LibSVMIter: public SparseIIterator<DataInst> {
     CHECK_EQ(param_.data_shape.ndim(), 1) << "dimension of data_shape is expected to be 1";
     CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
     CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
-    data_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.data_libsvm.c_str(),
-                                                      param_.part_index,
-                                                      param_.num_parts, "libsvm"));
+    data_parser_.reset(new ParallelTextParser(param_.data_libsvm, param_.part_index,
+                                              param_.num_parts, ParallelTextParser::kLibSVM,
+                                              param_.preprocess_threads, param_.cache_file));
     if (param_.label_libsvm != "NULL") {
-      label_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.label_libsvm.c_str(),
-                                                         param_.part_index,
-                                                         param_.num_parts, "libsvm"));
+      label_parser_.reset(new ParallelTextParser(
+          param_.label_libsvm, param_.part_index, param_.num_parts, ParallelTextParser::kLibSVM,
+          param_.preprocess_threads,
+          param_.cache_file.empty() ? "" : param_.cache_file + ".label"));
       CHECK_GT(param_.label_shape.Size(), 1)
         << "label_shape is not expected to be (1,) when param_.label_libsvm is set.";
     } else {
@@ -109,39 +121,43 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   }
 
   virtual bool Next() {
-    if (end_) return false;
+    return NextRows(1) != 0;
+  }
+
+  virtual size_t NextRows(size_t max_rows) {
+    if (end_) return 0;
     while (data_ptr_ >= data_size_) {
       if (!data_parser_->Next()) {
-        end_ = true; return false;
+        end_ = true; return 0;
       }
       data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
+      data_size_ = data_parser_->Value().Size();
     }
-    out_.index = inst_counter_++;
-    CHECK_LT(data_ptr_, data_size_);
-    const auto data_row = data_parser_->Value()[data_ptr_++];
-    // data, indices and indptr
-    out_.data[0] = AsDataBlob(data_row);
-    out_.data[1] = AsIdxBlob(data_row);
-    out_.data[2] = AsIndPtrPlaceholder(data_row);
-
+    // rows are handed out in bulk up to the end of the current block
+    size_t num_rows = std::min(max_rows, data_size_ - data_ptr_);
     if (label_parser_.get() != nullptr) {
       while (label_ptr_ >= label_size_) {
         CHECK(label_parser_->Next())
             << "Data LibSVM's row is smaller than the number of rows in label_libsvm";
         label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
+        label_size_ = label_parser_->Value().Size();
       }
-      CHECK_LT(label_ptr_, label_size_);
-      const auto label_row = label_parser_->Value()[label_ptr_++];
-      // data, indices and indptr
-      out_.data[3] = AsDataBlob(label_row);
-      out_.data[4] = AsIdxBlob(label_row);
-      out_.data[5] = AsIndPtrPlaceholder(label_row);
+      num_rows = std::min(num_rows, label_size_ - label_ptr_);
+    }
+    out_.index = inst_counter_;
+    inst_counter_ += num_rows;
+    const TextRowView& data = data_parser_->Value();
+    // data, indices and indptr
+    SetCSRRows(data, data_ptr_, num_rows, &data_indptr_, &out_.data[0]);
+    if (label_parser_.get() != nullptr) {
+      SetCSRRows(label_parser_->Value(), label_ptr_, num_rows, &label_indptr_, &out_.data[3]);
+      label_ptr_ += num_rows;
     } else {
-      out_.data[3] = AsScalarLabelBlob(data_row);
+      out_.data[3] = TBlob(const_cast<real_t*>(data.label) + data_ptr_,
+                           mshadow::Shape1(num_rows), cpu::kDevMask);
     }
-    return true;
+    data_ptr_ += num_rows;
+    return num_rows;
   }
 
   virtual const DataInst &Value(void) const {
@@ -159,25 +175,21 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   }
 
  private:
-  inline TBlob AsDataBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.value;
-    TShape shape(mshadow::Shape1(row.length));
-    return TBlob((real_t*) ptr, shape, cpu::kDevMask);  // NOLINT(*)
-  }
-
-  inline TBlob AsIdxBlob(const dmlc::Row<uint64_t>& row) {
-    const uint64_t* ptr = row.index;
-    TShape shape(mshadow::Shape1(row.length));
-    return TBlob((int64_t*) ptr, shape, cpu::kDevMask, mshadow::kInt64);  // NOLINT(*)
-  }
-
-  inline TBlob AsIndPtrPlaceholder(const dmlc::Row<uint64_t>& row) {
-    return TBlob(nullptr, mshadow::Shape1(0), cpu::kDevMask, mshadow::kInt64);
-  }
-
-  inline TBlob AsScalarLabelBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.label;
-    return TBlob((real_t*) ptr, mshadow::Shape1(1), cpu::kDevMask);  // NOLINT(*)
+  // point blobs at the values, indices and zero based indptr of rows [begin, begin + num_rows)
+  inline void SetCSRRows(const TextRowView& block, size_t begin, size_t num_rows,
+                         std::vector<int64_t>* indptr, TBlob* out) {
+    const size_t nnz_begin = block.offset[begin];
+    const size_t nnz = block.offset[begin + num_rows] - nnz_begin;
+    indptr->resize(num_rows + 1);
+    for (size_t i = 0; i <= num_rows; ++i) {
+      (*indptr)[i] = block.offset[begin + i] - nnz_begin;
+    }
+    out[0] = TBlob(const_cast<real_t*>(block.value) + nnz_begin,
+                   mshadow::Shape1(nnz), cpu::kDevMask);
+    out[1] = TBlob(const_cast<int64_t*>(block.index) + nnz_begin,
+                   mshadow::Shape1(nnz), cpu::kDevMask, mshadow::kInt64);
+    out[2] = TBlob(dmlc::BeginPtr(*indptr), mshadow::Shape1(num_rows + 1),
+                   cpu::kDevMask, mshadow::kInt64);
   }
 
   LibSVMIterParam param_;
@@ -190,8 +202,10 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   // label parser
   size_t label_ptr_{0}, label_size_{0};
   size_t data_ptr_{0}, data_size_{0};
-  std::unique_ptr<dmlc::Parser<uint64_t> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint64_t> > data_parser_;
+  // indptr of the rows handed out
+  std::vector<int64_t> data_indptr_, label_indptr_;
+  std::unique_ptr<ParallelTextParser> label_parser_;
+  std::unique_ptr<ParallelTextParser> data_parser_;
 };
 
 
@@ -220,6 +234,13 @@ dense array.
 The `LibSVMIter` only support `round_batch` parameter set to ``True``. Therefore, if `batch_size`
 is 3 and there are 4 total rows in libsvm file, 2 more examples are consumed at the first round.
 
+The text is parsed by `preprocess_threads` threads, which does not change the order of rows.
+
+If `cache_file` is set, the first complete pass writes the parsed rows to that file,
+and later passes, as well as later iterators with the same `cache_file`, read the rows
+from it without parsing the LibSVM text. The cache is rebuilt when the size or modification
+time of a LibSVM file changes. Each part of the data needs its own `cache_file`.
+
 When `num_parts` and `part_index` are provided, the data is split into `num_parts` partitions,
 and the iterator only reads the `part_index`-th partition. However, the partitions are not
 guaranteed to be even.
@@ -27,6 +27,9 @@
 #include <dmlc/io.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 #include <utility>
@@ -54,6 +57,8 @@ struct MNISTParam : public dmlc::Parameter<MNISTParam> {
   int num_parts;
   /*! \brief the index of the part will read*/
   int part_index;
+  /*! \brief whether to read the images batch by batch */
+  bool streaming;
   // declare parameters
   DMLC_DECLARE_PARAMETER(MNISTParam) {
     DMLC_DECLARE_FIELD(image).set_default("./train-images-idx3-ubyte")
@@ -74,12 +79,16 @@ struct MNISTParam : public dmlc::Parameter<MNISTParam> {
         .describe("partition the data into multiple parts");
     DMLC_DECLARE_FIELD(part_index).set_default(0)
         .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(streaming).set_default(false)
+        .describe("Dataset Param: Whether to read the images of each batch from the idx files "
+                  "instead of loading the whole part into memory. Batches are the same as "
+                  "without streaming.");
   }
 };
 
 class MNISTIter: public IIterator<TBlobBatch> {
  public:
-  MNISTIter(void) : loc_(0), inst_offset_(0) {
+  MNISTIter(void) : loc_(0), num_images_(0), inst_offset_(0) {
     img_.dptr_ = NULL;
     out_.data.resize(2);
   }
@@ -90,27 +99,42 @@ class MNISTIter: public IIterator<TBlobBatch> {
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     std::map<std::string, std::string> kmap(kwargs.begin(), kwargs.end());
     param_.InitAllowUnknown(kmap);
-    this->LoadImage();
-    this->LoadLabel();
+    if (param_.streaming) {
+      this->OpenStreams();
+    } else {
+      this->LoadImage();
+      this->LoadLabel();
+    }
     if (param_.flat) {
-      batch_data_.shape_ = mshadow::Shape4(param_.batch_size, 1, 1, img_.size(1) * img_.size(2));
+      batch_data_.shape_ = mshadow::Shape4(param_.batch_size, 1, 1, image_rows_ * image_cols_);
     } else {
-      batch_data_.shape_ = mshadow::Shape4(param_.batch_size, 1, img_.size(1), img_.size(2));
+      batch_data_.shape_ = mshadow::Shape4(param_.batch_size, 1, image_rows_, image_cols_);
     }
     out_.data.clear();
     batch_label_.shape_ = mshadow::Shape2(param_.batch_size, 1);
     batch_label_.stride_ = 1;
     batch_data_.stride_ = batch_data_.size(3);
     out_.batch_size = param_.batch_size;
-    if (param_.shuffle) this->Shuffle();
+    if (param_.streaming) {
+      // images are read in the shuffled order of inst_ instead of being moved
+      if (param_.shuffle) {
+        std::shuffle(inst_.begin(), inst_.end(), common::RANDOM_ENGINE(kRandMagic + param_.seed));
+      }
+      stream_img_.resize(batch_data_.shape_.Size());
+      stream_label_.resize(param_.batch_size);
+      batch_data_.dptr_ = dmlc::BeginPtr(stream_img_);
+      batch_label_.dptr_ = dmlc::BeginPtr(stream_label_);
+    } else if (param_.shuffle) {
+      this->Shuffle();
+    }
     if (param_.silent == 0) {
       TShape s;
       s = batch_data_.shape_;
       if (param_.flat) {
-        LOG(INFO) << "MNISTIter: load " << (unsigned)img_.size(0) << " images, shuffle="
+        LOG(INFO) << "MNISTIter: load " << num_images_ << " images, shuffle="
             << param_.shuffle << ", shape=" << s.FlatTo2D();
       } else {
-        LOG(INFO) << "MNISTIter: load " << (unsigned)img_.size(0) << " images, shuffle="
+        LOG(INFO) << "MNISTIter: load " << num_images_ << " images, shuffle="
             << param_.shuffle << ", shape=" << s;
       }
     }
@@ -119,9 +143,13 @@ class MNISTIter: public IIterator<TBlobBatch> {
     this->loc_ = 0;
   }
   virtual bool Next(void) {
-    if (loc_ + param_.batch_size <= img_.size(0)) {
-      batch_data_.dptr_ = img_[loc_].dptr_;
-      batch_label_.dptr_ = &labels_[loc_];
+    if (loc_ + param_.batch_size <= num_images_) {
+      if (param_.streaming) {
+        this->ReadBatch();
+      } else {
+        batch_data_.dptr_ = img_[loc_].dptr_;
+        batch_label_.dptr_ = &labels_[loc_];
+      }
       out_.data.clear();
       if (param_.flat) {
           out_.data.push_back(TBlob(batch_data_.FlatTo2D()));
@@ -168,6 +196,9 @@ class MNISTIter: public IIterator<TBlobBatch> {
 
     img_.shape_ = mshadow::Shape3(image_count, image_rows, image_cols);
     img_.stride_ = img_.size(2);
+    num_images_ = image_count;
+    image_rows_ = image_rows;
+    image_cols_ = image_cols;
 
     // allocate continuous memory
     img_.dptr_ = new float[img_.MSize()];
@@ -206,6 +237,62 @@ class MNISTIter: public IIterator<TBlobBatch> {
     }
     delete stdlabel;
   }
+  // read the headers and locate the part, leaving the images and labels in the files
+  inline void OpenStreams(void) {
+    img_stream_.reset(dmlc::SeekStream::CreateForRead(param_.image.c_str()));
+    ReadInt(img_stream_.get());
+    int image_count = ReadInt(img_stream_.get());
+    image_rows_ = ReadInt(img_stream_.get());
+    image_cols_ = ReadInt(img_stream_.get());
+    label_stream_.reset(dmlc::SeekStream::CreateForRead(param_.label.c_str()));
+    ReadInt(label_stream_.get());
+    int labels_count = ReadInt(label_stream_.get());
+    CHECK_EQ(labels_count, image_count)
+        << "number of labels in " << param_.label << " does not match number of images in "
+        << param_.image;
+
+    int start, end;
+    GetPart(image_count, &start, &end);
+    num_images_ = end - start;
+    const size_t image_size = static_cast<size_t>(image_rows_) * image_cols_;
+    img_begin_ = img_stream_->Tell() + start * image_size;
+    label_begin_ = label_stream_->Tell() + start;
+    img_pos_ = label_pos_ = std::numeric_limits<size_t>::max();
+    inst_.resize(num_images_);
+    for (index_t i = 0; i < num_images_; ++i) {
+      inst_[i] = i + inst_offset_;
+    }
+    buf_.resize(image_size);
+  }
+  // read len bytes at offset, seeking only when the previous read did not end there
+  inline static void ReadAt(dmlc::SeekStream *fi, size_t offset, size_t *pos,
+                            void *dst, size_t len) {
+    if (*pos != offset) fi->Seek(offset);
+    CHECK(fi->Read(dst, len) == len) << "invalid mnist format";
+    *pos = offset + len;
+  }
+  // read the images and labels of batch loc_ from the streams
+  inline void ReadBatch(void) {
+    const size_t image_size = static_cast<size_t>(image_rows_) * image_cols_;
+    // visit the images in file order, so that unshuffled batches are read sequentially
+    order_.clear();
+    for (int i = 0; i < param_.batch_size; ++i) {
+      order_.emplace_back(inst_[loc_ + i] - inst_offset_, i);
+    }
+    std::sort(order_.begin(), order_.end());
+    for (const auto& entry : order_) {
+      ReadAt(img_stream_.get(), img_begin_ + entry.first * image_size, &img_pos_,
+             dmlc::BeginPtr(buf_), image_size);
+      float *dst = dmlc::BeginPtr(stream_img_) + entry.second * image_size;
+      // normalize to 0-1
+      for (size_t k = 0; k < image_size; ++k) {
+        dst[k] = buf_[k] * (1.0f / 256.0f);
+      }
+      unsigned char ch;
+      ReadAt(label_stream_.get(), label_begin_ + entry.first, &label_pos_, &ch, sizeof(ch));
+      stream_label_[entry.second] = ch;
+    }
+  }
   inline void Shuffle(void) {
     std::shuffle(inst_.begin(), inst_.end(), common::RANDOM_ENGINE(kRandMagic + param_.seed));
     std::vector<float> tmplabel(labels_.size());
@@ -239,6 +326,10 @@ class MNISTIter: public IIterator<TBlobBatch> {
   TBlobBatch out_;
   /*! \brief current location */
   index_t loc_;
+  /*! \brief number of images in the part */
+  index_t num_images_;
+  /*! \brief image height and width */
+  int image_rows_, image_cols_;
   /*! \brief image content */
   mshadow::Tensor<cpu, 3> img_;
   /*! \brief label content */
@@ -251,6 +342,18 @@ class MNISTIter: public IIterator<TBlobBatch> {
   unsigned inst_offset_;
   /*! \brief instance index */
   std::vector<unsigned> inst_;
+  /*! \brief image and label files in streaming mode */
+  std::unique_ptr<dmlc::SeekStream> img_stream_, label_stream_;
+  /*! \brief file offsets of the first image and label of the part */
+  size_t img_begin_, label_begin_;
+  /*! \brief file offsets the streams are at */
+  size_t img_pos_, label_pos_;
+  /*! \brief pixels of one image */
+  std::vector<unsigned char> buf_;
+  /*! \brief (image, slot in batch) pairs of the batch, in file order */
+  std::vector<std::pair<unsigned, int> > order_;
+  /*! \brief batch storage in streaming mode */
+  std::vector<float> stream_img_, stream_label_;
   // magic number to setup randomness
   static const int kRandMagic = 0;
 };  // class MNISTIter
@@ -262,6 +365,9 @@ MXNET_REGISTER_IO_ITER(MNISTIter)
 
 One can download the dataset from http://yann.lecun.com/exdb/mnist/
 
+With ``streaming=True`` only the images of the current batch are held in memory, and
+shuffling permutes the image indices, so larger idx format datasets can be read as well.
+
 )code" ADD_FILELINE)
 .add_arguments(MNISTParam::__FIELDS__())
 .add_arguments(PrefetcherParam::__FIELDS__())
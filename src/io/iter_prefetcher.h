@@ -31,8 +31,11 @@
 #include <dmlc/logging.h>
 #include <dmlc/threadediter.h>
 #include <dmlc/optional.h>
+#include <dmlc/timer.h>
 #include <mshadow/tensor.h>
 #include <climits>
+#include <condition_variable>
+#include <mutex>
 #include <utility>
 #include <string>
 #include <vector>
@@ -56,6 +59,7 @@ class PrefetcherIter : public IIterator<DataBatch> {
       delete batch;
     }
     delete out_;
+    StopProducer();
     iter.Destroy();
   }
 
@@ -63,10 +67,13 @@ class PrefetcherIter : public IIterator<DataBatch> {
     std::vector<std::pair<std::string, std::string> > kwargs_left;
     // init image rec param
     kwargs_left = param_.InitAllowUnknown(kwargs);
-    // maximum prefetch threaded iter internal size
-    const int kMaxPrefetchBuffer = 16;
     // init thread iter
     iter.set_max_capacity(kMaxPrefetchBuffer);
+    // adaptive prefetching starts from double buffering
+    depth_ = kMaxPrefetchBuffer;
+    if (param_.adaptive_prefetch) depth_ = 2;
+    report_stats_ = dmlc::GetEnv("MXNET_PREFETCHER_STATS", false);
+    window_start_ = dmlc::GetTime();
   }
 
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
@@ -74,7 +81,7 @@ class PrefetcherIter : public IIterator<DataBatch> {
     // use the kwarg to init batch loader
     loader_->Init(kwargs);
     iter.Init([this](DataBatch **dptr) {
-        if (!loader_->Next()) return false;
+        if (!WaitForRoom() || !loader_->Next()) return false;
         const TBlobBatch& batch = loader_->Value();
         if (*dptr == nullptr) {
           // allocate databatch
@@ -87,7 +94,7 @@ class PrefetcherIter : public IIterator<DataBatch> {
                              ? param_.dtype.value()
                              : batch.data[i].type_flag_;
             (*dptr)->data.at(i) = NDArray(batch.data[i].shape_,
-                                          Context::CPU(), false,
+                                          BatchContext(), false,
                                           dtype);
           }
         }
@@ -95,10 +102,21 @@ class PrefetcherIter : public IIterator<DataBatch> {
         // copy data over
         for (size_t i = 0; i < batch.data.size(); ++i) {
           CHECK_EQ((*dptr)->data.at(i).shape(), batch.data[i].shape_);
-          MSHADOW_TYPE_SWITCH(batch.data[i].type_flag_, DType, {
-              mshadow::Copy(((*dptr)->data)[i].data().FlatTo2D<cpu, DType>(),
-                        batch.data[i].FlatTo2D<cpu, DType>());
-          });
+          const TBlob& out = ((*dptr)->data)[i].data();
+          if (out.type_flag_ == batch.data[i].type_flag_) {
+            MSHADOW_TYPE_SWITCH(batch.data[i].type_flag_, DType, {
+                mshadow::Copy(out.FlatTo2D<cpu, DType>(),
+                          batch.data[i].FlatTo2D<cpu, DType>());
+            });
+          } else {
+            // convert to the requested dtype while copying
+            MSHADOW_TYPE_SWITCH(out.type_flag_, DstType, {
+              MSHADOW_TYPE_SWITCH(batch.data[i].type_flag_, SrcType, {
+                mshadow::Tensor<cpu, 2, DstType> dst = out.FlatTo2D<cpu, DstType>();
+                dst = mshadow::expr::tcast<DstType>(batch.data[i].FlatTo2D<cpu, SrcType>());
+              });
+            });
+          }
           (*dptr)->num_batch_padd = batch.num_batch_padd;
         }
         if (batch.inst_index) {
@@ -106,12 +124,18 @@ class PrefetcherIter : public IIterator<DataBatch> {
                     batch.inst_index + batch.batch_size,
                     (*dptr)->index.begin());
         }
+        ProducedBatch();
        return true;
       },
-      [this]() { loader_->BeforeFirst(); });
+      [this]() {
+        loader_->BeforeFirst();
+        ResetProducer();
+      });
   }
 
   virtual void BeforeFirst(void) {
+    if (report_stats_) ReportStats();
+    StopProducer();
     iter.BeforeFirst();
   }
 
@@ -129,13 +153,114 @@ class PrefetcherIter : public IIterator<DataBatch> {
       recycle_queue_.pop();
       iter.Recycle(&old_batch);
     }
-    return iter.Next(&out_);
+    const double tic = dmlc::GetTime();
+    const bool ret = iter.Next(&out_);
+    consumer_wait_ += dmlc::GetTime() - tic;
+    if (ret) ConsumedBatch();
+    return ret;
   }
   virtual const DataBatch &Value(void) const {
     return *out_;
   }
 
  protected:
+  /*! \brief context of the output batches */
+  inline Context BatchContext() const {
+    switch (param_.ctx) {
+      case Context::kCPUPinned: return Context::CPUPinned(0);
+      case Context::kCPUShared: return Context::CPUShared(0);
+      default: return Context::CPU();
+    }
+  }
+
+  /*!
+   * \brief block the producer while depth_ batches are waiting to be consumed
+   * \return false if the producer should stop
+   */
+  inline bool WaitForRoom() {
+    std::unique_lock<std::mutex> lock(depth_mutex_);
+    if (num_ahead_ >= depth_ && !stop_producer_) {
+      const double tic = dmlc::GetTime();
+      depth_cond_.wait(lock, [this]() { return num_ahead_ < depth_ || stop_producer_; });
+      producer_wait_ += dmlc::GetTime() - tic;
+    }
+    return !stop_producer_;
+  }
+
+  /*! \brief called by the producer after a batch is ready */
+  inline void ProducedBatch() {
+    std::lock_guard<std::mutex> lock(depth_mutex_);
+    ++num_ahead_;
+  }
+
+  /*! \brief called by the producer on BeforeFirst, when no batch is left in the queue */
+  inline void ResetProducer() {
+    std::lock_guard<std::mutex> lock(depth_mutex_);
+    num_ahead_ = 0;
+    stop_producer_ = false;
+  }
+
+  /*! \brief wake up a waiting producer before the threaded iter is reset or destroyed */
+  inline void StopProducer() {
+    {
+      std::lock_guard<std::mutex> lock(depth_mutex_);
+      stop_producer_ = true;
+    }
+    depth_cond_.notify_one();
+  }
+
+  /*! \brief called by the consumer after a batch is taken */
+  inline void ConsumedBatch() {
+    {
+      std::lock_guard<std::mutex> lock(depth_mutex_);
+      --num_ahead_;
+      ++num_batches_;
+      if (param_.adaptive_prefetch && ++num_window_ == kAdaptWindow) AdaptDepth();
+    }
+    depth_cond_.notify_one();
+  }
+
+  /*!
+   * \brief grow the depth quickly when the consumer waits for batches,
+   *  and shrink it slowly when only the producer waits
+   */
+  inline void AdaptDepth() {
+    const double now = dmlc::GetTime();
+    const double wall = now - window_start_;
+    const double consumer_wait = consumer_wait_ - window_consumer_wait_;
+    const double producer_wait = producer_wait_ - window_producer_wait_;
+    if (consumer_wait > 0.05 * wall) {
+      depth_ *= 2;
+      if (depth_ > kMaxPrefetchBuffer) depth_ = kMaxPrefetchBuffer;
+    } else if (consumer_wait < 0.01 * wall && producer_wait > 0.5 * wall) {
+      if (depth_ > 1) --depth_;
+    }
+    num_window_ = 0;
+    window_start_ = now;
+    window_consumer_wait_ = consumer_wait_;
+    window_producer_wait_ = producer_wait_;
+  }
+
+  /*! \brief log the waiting times of the pass and clear them */
+  inline void ReportStats() {
+    std::lock_guard<std::mutex> lock(depth_mutex_);
+    if (num_batches_ != 0 || consumer_wait_ != 0) {
+      LOG(INFO) << "PrefetcherIter: " << num_batches_ << " batches, producer waited "
+                << producer_wait_
+                << " sec, consumer waited " << consumer_wait_
+                << " sec, prefetch depth " << depth_;
+    }
+    producer_wait_ = consumer_wait_ = 0;
+    num_batches_ = 0;
+    window_producer_wait_ = window_consumer_wait_ = 0;
+    num_window_ = 0;
+    window_start_ = dmlc::GetTime();
+  }
+
+  /*! \brief maximum prefetch threaded iter internal size */
+  static const int kMaxPrefetchBuffer = 16;
+  /*! \brief number of consumed batches between depth adaptations */
+  static const int kAdaptWindow = 16;
   /*! \brief prefetcher parameters */
   PrefetcherParam param_;
   /*! \brief backend thread */
@@ -148,6 +273,24 @@ class PrefetcherIter : public IIterator<DataBatch> {
   DataBatch *out_;
   /*! \brief queue to be recycled */
   std::queue<DataBatch*> recycle_queue_;
+  /*! \brief guards the prefetch depth state shared with the producer */
+  std::mutex depth_mutex_;
+  /*! \brief signals the producer that there is room or that it should stop */
+  std::condition_variable depth_cond_;
+  /*! \brief number of batches the producer may have ready */
+  int depth_{kMaxPrefetchBuffer};
+  /*! \brief number of produced batches not yet consumed */
+  int num_ahead_{0};
+  /*! \brief whether the producer should stop waiting */
+  bool stop_producer_{false};
+  /*! \brief total seconds the producer waited for room and the consumer for batches */
+  double producer_wait_{0}, consumer_wait_{0};
+  /*! \brief the waiting times and start time of the adaptation window */
+  double window_producer_wait_{0}, window_consumer_wait_{0}, window_start_{0};
+  /*! \brief batches consumed in the pass and in the adaptation window */
+  int num_batches_{0}, num_window_{0};
+  /*! \brief whether to log the waiting times on BeforeFirst */
+  bool report_stats_{false};
 };
 }  // namespace io
 }  // namespace mxnet
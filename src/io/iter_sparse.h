@@ -39,6 +39,18 @@ class SparseIIterator : public IIterator<DType> {
   virtual const NDArrayStorageType GetStorageType(bool is_data) const = 0;
   /*! \brief shape of the data or label */
   virtual const TShape GetShape(bool is_data) const = 0;
+  /*!
+   * \brief move forward by up to max_rows consecutive rows at once.
+   *  Afterwards Value holds the rows in the layout of a single instance,
+   *  index being the index of the first row. Each csr indptr holds one
+   *  entry per row plus one, starting at 0, while the indptr of a single
+   *  instance returned by Next may be empty.
+   * \param max_rows maximal number of rows to move forward by
+   * \return number of rows moved forward by, 0 at the end of the data
+   */
+  virtual size_t NextRows(size_t max_rows) {
+    return this->Next() ? 1 : 0;
+  }
 };  // class SparseIIterator
 
 }  // namespace mxnet
@@ -28,6 +28,7 @@
 #include <mxnet/base.h>
 #include <dmlc/logging.h>
 #include <mshadow/tensor.h>
+#include <cstring>
 #include <utility>
 #include <vector>
 #include <string>
@@ -67,53 +68,33 @@ class SparseBatchLoader : public BatchLoader, public SparseIIterator<TBlobBatch>
     this->head_ = 0;
     // if overflown from previous round, directly return false, until before first is called
     if (num_overflow_ != 0) return false;
+    ClearBatch();
+    // rows are taken from the base in bulk and appended to the batch right away
     index_t top = 0;
-    inst_cache_.clear();
-    while (sparse_base_->Next()) {
-      inst_cache_.emplace_back(sparse_base_->Value());
-      if (inst_cache_.size() >= param_.batch_size) break;
+    while (top < param_.batch_size) {
+      const size_t num_rows = sparse_base_->NextRows(param_.batch_size - top);
+      if (num_rows == 0) break;
+      AppendRows(sparse_base_->Value(), num_rows, top);
+      top += num_rows;
     }
     // no more data instance
-    if (inst_cache_.size() == 0) {
+    if (top == 0) {
       return false;
     }
-    if (inst_cache_.size() < param_.batch_size) {
+    if (top < param_.batch_size) {
       CHECK_GT(param_.round_batch, 0);
       num_overflow_ = 0;
       sparse_base_->BeforeFirst();
-      for (; inst_cache_.size() < param_.batch_size; ++num_overflow_) {
-        CHECK(sparse_base_->Next()) << "number of input must be bigger than batch size";
-        inst_cache_.emplace_back(sparse_base_->Value());
+      while (top < param_.batch_size) {
+        const size_t num_rows = sparse_base_->NextRows(param_.batch_size - top);
+        CHECK_GT(num_rows, 0) << "number of input must be bigger than batch size";
+        AppendRows(sparse_base_->Value(), num_rows, top);
+        top += num_rows;
+        num_overflow_ += num_rows;
       }
     }
     out_.num_batch_padd = num_overflow_;
-    CHECK_EQ(inst_cache_.size(), param_.batch_size);
-    this->InitDataFromBatch();
-    for (size_t j = 0; j < inst_cache_.size(); j++) {
-      const auto& d = inst_cache_[j];
-      out_.inst_index[top] = d.index;
-      // TODO(haibin) double check the type?
-      int64_t unit_size = 0;
-      for (size_t i = 0; i < d.data.size(); ++i) {
-        // indptr tensor
-        if (IsIndPtr(i)) {
-          auto indptr = data_[i].get<cpu, 1, int64_t>();
-          if (j == 0) indptr[0] = 0;
-          indptr[j + 1] = indptr[j] + unit_size;
-          offsets_[i] = j;
-        } else {
-          // indices and values tensor
-          unit_size = d.data[i].shape_.Size();
-          MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
-            const auto begin = offsets_[i];
-            const auto end = offsets_[i] + unit_size;
-            mshadow::Copy(data_[i].get<cpu, 1, DType>().Slice(begin, end),
-                          d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size)));
-            });
-          offsets_[i] += unit_size;
-        }
-      }
-    }
+    this->SetOutput();
     return true;
   }
 
@@ -136,16 +117,23 @@ class SparseBatchLoader : public BatchLoader, public SparseIIterator<TBlobBatch>
   }
 
  private:
+  /*! \brief growable storage of one output blob */
+  struct BatchBuffer {
+    /*! \brief content, kept across batches */
+    std::vector<char> bytes;
+    /*! \brief number of elements */
+    size_t size = 0;
+    /*! \brief element type */
+    int type_flag = mshadow::kFloat32;
+  };
   /*! \brief base sparse iterator */
   SparseIIterator<DataInst> *sparse_base_;
-  /*! \brief data instances */
-  std::vector<DataInst> inst_cache_;
   /*! \brief data storage type */
   NDArrayStorageType data_stype_;
   /*! \brief data label type */
   NDArrayStorageType label_stype_;
-  /*! \brief tensor offset for slicing */
-  std::vector<size_t> offsets_;
+  /*! \brief storage of each output blob */
+  std::vector<BatchBuffer> buffers_;
 
   // check whether ith position is the indptr tensor for a CSR tensor
   inline bool IsIndPtr(size_t i) {
@@ -163,39 +151,77 @@ class SparseBatchLoader : public BatchLoader, public SparseIIterator<TBlobBatch>
     return false;
   }
 
-  // initialize the data holder by using from the batch
-  inline void InitDataFromBatch() {
+  // append elements to a buffer
+  inline void Append(BatchBuffer* buf, const void* src, size_t size) {
+    const size_t elem_size = mshadow::mshadow_sizeof(buf->type_flag);
+    const size_t offset = buf->size * elem_size;
+    buf->bytes.resize(offset + size * elem_size);
+    if (size != 0) {
+      std::memcpy(dmlc::BeginPtr(buf->bytes) + offset, src, size * elem_size);
+    }
+    buf->size += size;
+  }
+
+  // empty the buffers, every indptr starts with 0
+  inline void ClearBatch() {
+    const int64_t zero = 0;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      buffers_[i].bytes.clear();
+      buffers_[i].size = 0;
+      if (IsIndPtr(i)) Append(&buffers_[i], &zero, 1);
+    }
+  }
+
+  // append num_rows rows held by d at position top of the batch
+  inline void AppendRows(const DataInst& d, size_t num_rows, index_t top) {
     CHECK(data_stype_ == kCSRStorage || label_stype_ == kCSRStorage);
-    CHECK_GT(inst_cache_.size(), 0);
-    out_.data.clear();
-    data_.clear();
-    offsets_.clear();
-
-    size_t total_size = inst_cache_[0].data.size();
-    data_.resize(total_size);
-    offsets_.resize(total_size, 0);
-    std::vector<size_t> vec_sizes(total_size, 0);
-    // accumulate the memory required for a batch
-    for (size_t i = 0; i < total_size; ++i) {
-      size_t size = 0;
-      // vec_size for indptr
-      if (IsIndPtr(i)) {
-        size = param_.batch_size + 1;
+    if (buffers_.size() == 0) {
+      buffers_.resize(d.data.size());
+      for (size_t i = 0; i < d.data.size(); ++i) {
+        buffers_[i].type_flag = IsIndPtr(i) ? mshadow::kInt64 : d.data[i].type_flag_;
+      }
+      ClearBatch();
+    }
+    CHECK_EQ(buffers_.size(), d.data.size());
+    for (size_t r = 0; r < num_rows; ++r) {
+      out_.inst_index[top + r] = d.index + r;
+    }
+    // indptr first, shifted by the entries of its values already in the batch
+    for (size_t i = 0; i < d.data.size(); ++i) {
+      if (!IsIndPtr(i)) continue;
+      BatchBuffer* buf = &buffers_[i];
+      const int64_t base = buffers_[i - 2].size;
+      const int64_t* indptr = static_cast<const int64_t*>(d.data[i].dptr_);
+      if (d.data[i].shape_.Size() == 0) {
+        // single instance without indptr
+        CHECK_EQ(num_rows, 1);
+        const int64_t end = base + d.data[i - 2].shape_.Size();
+        Append(buf, &end, 1);
       } else {
-        for (const auto &d : inst_cache_) size += d.data[i].shape_.Size();
+        CHECK_EQ(d.data[i].shape_.Size(), num_rows + 1);
+        for (size_t r = 1; r <= num_rows; ++r) {
+          const int64_t end = base + indptr[r];
+          Append(buf, &end, 1);
+        }
       }
-      vec_sizes[i] = size;
     }
+    // then indices, values and dense blobs
+    for (size_t i = 0; i < d.data.size(); ++i) {
+      if (IsIndPtr(i)) continue;
+      CHECK_EQ(d.data[i].type_flag_, buffers_[i].type_flag);
+      Append(&buffers_[i], d.data[i].dptr_, d.data[i].shape_.Size());
+    }
+  }
 
-    CHECK_EQ(vec_sizes[0], vec_sizes[1]);
-    for (size_t i = 0; i < total_size; ++i) {
-      int src_type_flag = inst_cache_[0].data[i].type_flag_;
-      // init object attributes
-      TShape dst_shape(mshadow::Shape1(vec_sizes[i]));
-      data_[i].resize(mshadow::Shape1(vec_sizes[i]), src_type_flag);
-      CHECK(data_[i].dptr_ != nullptr);
-      out_.data.push_back(TBlob(data_[i].dptr_, dst_shape, cpu::kDevMask, src_type_flag));
+  // point the output blobs at the buffers
+  inline void SetOutput() {
+    out_.data.clear();
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      BatchBuffer& buf = buffers_[i];
+      out_.data.push_back(TBlob(dmlc::BeginPtr(buf.bytes), mshadow::Shape1(buf.size),
+                                cpu::kDevMask, buf.type_flag));
     }
+    CHECK_EQ(buffers_[0].size, buffers_[1].size);
   }
 };  // class BatchLoader
 }  // namespace io
@@ -57,7 +57,7 @@ class SparsePrefetcherIter : public PrefetcherIter {
     // use the kwarg to init batch loader
     sparse_loader_->Init(kwargs);
     iter.Init([this](DataBatch **dptr) {
-        if (!sparse_loader_->Next()) return false;
+        if (!WaitForRoom() || !sparse_loader_->Next()) return false;
         const TBlobBatch& batch = sparse_loader_->Value();
         if (*dptr == nullptr) {
           // allocate databatch
@@ -74,10 +74,10 @@ class SparsePrefetcherIter : public PrefetcherIter {
             auto dtype = param_.dtype ? param_.dtype.value() : batch.data[data_iter].type_flag_;
             if (stype == kDefaultStorage) {
               (*dptr)->data.at(i) = NDArray(batch.data[data_iter].shape_,
-                                            Context::CPU(), false, dtype);
+                                            BatchContext(), false, dtype);
             } else {
               (*dptr)->data.at(i) = NDArray(stype, this->GetShape(is_data),
-                                            Context::CPU(), false, dtype);
+                                            BatchContext(), false, dtype);
             }
             data_iter += num_aux_data(stype) + 1;
           }
@@ -114,9 +114,13 @@ class SparsePrefetcherIter : public PrefetcherIter {
                     batch.inst_index + batch.batch_size,
                     (*dptr)->index.begin());
         }
+        ProducedBatch();
        return true;
       },
-      [this]() { sparse_loader_->BeforeFirst(); });
+      [this]() {
+        sparse_loader_->BeforeFirst();
+        ResetProducer();
+      });
   }
 
   virtual void BeforeFirst(void) {
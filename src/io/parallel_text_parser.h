@@ -0,0 +1,627 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file parallel_text_parser.h
+ * \brief parse csv and libsvm text files with several threads
+ */
+#ifndef MXNET_IO_PARALLEL_TEXT_PARSER_H_
+#define MXNET_IO_PARALLEL_TEXT_PARSER_H_
+
+#include <mxnet/base.h>
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/threadediter.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <dirent.h>
+#endif  // _WIN32
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../common/mapped_file.h"
+
+namespace mxnet {
+namespace io {
+/*! \brief read only rows in CSR layout, either parsed or mapped from a cache file */
+struct TextRowView {
+  /*! \brief number of rows */
+  size_t size{0};
+  /*! \brief row i spans [offset[i], offset[i + 1]) of index and value */
+  const uint64_t *offset{nullptr};
+  /*! \brief label of each row, libsvm only */
+  const real_t *label{nullptr};
+  /*! \brief column index of each entry, libsvm only */
+  const int64_t *index{nullptr};
+  /*! \brief value of each entry */
+  const real_t *value{nullptr};
+  /*! \return number of rows */
+  inline size_t Size() const {
+    return size;
+  }
+};
+
+/*! \brief rows parsed from text, in CSR layout */
+struct TextRowBlock {
+  /*! \brief row i spans [offset[i], offset[i + 1]) of index and value */
+  std::vector<uint64_t> offset;
+  /*! \brief label of each row, libsvm only */
+  std::vector<real_t> label;
+  /*! \brief column index of each entry, libsvm only */
+  std::vector<int64_t> index;
+  /*! \brief value of each entry */
+  std::vector<real_t> value;
+  /*! \return number of rows */
+  inline size_t Size() const {
+    return offset.size() - 1;
+  }
+  /*! \brief remove all rows, keeping the memory */
+  inline void Clear() {
+    offset.assign(1, 0);
+    label.clear();
+    index.clear();
+    value.clear();
+  }
+  /*! \return a view of the rows */
+  inline TextRowView GetView() const {
+    TextRowView view;
+    view.size = Size();
+    view.offset = dmlc::BeginPtr(offset);
+    view.label = dmlc::BeginPtr(label);
+    view.index = dmlc::BeginPtr(index);
+    view.value = dmlc::BeginPtr(value);
+    return view;
+  }
+};
+
+/*!
+ * \brief parser of csv and libsvm text that uses several threads per chunk.
+ *
+ *  Each chunk read from the input split is cut at line boundaries into one
+ *  piece per thread. The pieces are parsed concurrently and their rows are
+ *  concatenated in file order, so the output does not depend on the number
+ *  of threads. The next chunk is parsed in the background while the current
+ *  one is consumed.
+ *
+ *  When a cache file is given, the blocks of the first complete pass are also
+ *  written to it in binary form, and later passes and later runs map the file
+ *  instead of parsing the text. The cache records the size and modification
+ *  time of the source files and is rebuilt when they change.
+ */
+class ParallelTextParser {
+ public:
+  /*! \brief supported text formats */
+  enum Format {
+    kCSV,
+    kLibSVM
+  };
+  /*!
+   * \brief constructor
+   * \param uri path of the file or directory
+   * \param part_index the part of the data to read
+   * \param num_parts number of parts the data is split into
+   * \param format the text format
+   * \param nthread number of threads used to parse a chunk
+   * \param cache_file path of the binary cache, empty for none
+   */
+  ParallelTextParser(const std::string& uri, unsigned part_index, unsigned num_parts,
+                     Format format, int nthread, const std::string& cache_file = "")
+      : format_(format), nthread_(std::max(nthread, 1)), out_(nullptr) {
+    if (!cache_file.empty()) {
+      if (SourceSignature(uri, part_index, num_parts, format, &cache_signature_)) {
+        cache_file_ = cache_file;
+        if (OpenCache()) return;
+        StartCache();
+      } else {
+        LOG(WARNING) << "cache_file is ignored, cannot check " << uri << " for changes";
+      }
+    }
+    source_.reset(dmlc::InputSplit::Create(uri.c_str(), part_index, num_parts, "text"));
+    pieces_.resize(nthread_);
+    bounds_.resize(nthread_ + 1);
+    row_begin_.resize(nthread_ + 1);
+    nnz_begin_.resize(nthread_ + 1);
+    // one block handed out and one being parsed
+    iter_.set_max_capacity(2);
+    iter_.Init([this](TextRowBlock **dptr) {
+        if (*dptr == nullptr) {
+          *dptr = new TextRowBlock();
+        }
+        // an exception would terminate the background thread, end the data instead and
+        // let Next rethrow it to the reader
+        try {
+          return ParseChunk(*dptr);
+        } catch (dmlc::Error &err) {
+          std::lock_guard<std::mutex> lock(error_mutex_);
+          error_ = err.what();
+          return false;
+        }
+      },
+      [this]() {
+        source_->BeforeFirst();
+        // an incomplete pass restarts the cache
+        if (cache_out_ != nullptr) StartCache();
+      });
+  }
+
+  ~ParallelTextParser() {
+    if (out_ != nullptr) iter_.Recycle(&out_);
+    iter_.Destroy();
+  }
+
+  /*! \brief restart from the beginning of the data */
+  inline void BeforeFirst() {
+    if (out_ != nullptr) iter_.Recycle(&out_);
+    if (cache_written_) {
+      // the text is not needed any more
+      cache_written_ = false;
+      iter_.Destroy();
+      source_.reset();
+      CHECK(OpenCache()) << "Failed to read back " << cache_file_;
+    }
+    if (cache_map_ != nullptr) {
+      cache_ptr_ = 0;
+      return;
+    }
+    iter_.BeforeFirst();
+  }
+
+  /*!
+   * \brief move to the next non-empty block of rows,
+   *  which invalidates the previous block
+   * \return false at the end of the data
+   */
+  inline bool Next() {
+    if (cache_map_ != nullptr) {
+      if (cache_ptr_ == cache_blocks_.size()) return false;
+      view_ = cache_blocks_[cache_ptr_++];
+      return true;
+    }
+    if (out_ != nullptr) iter_.Recycle(&out_);
+    while (iter_.Next(&out_)) {
+      if (out_->Size() != 0) {
+        view_ = out_->GetView();
+        return true;
+      }
+      iter_.Recycle(&out_);
+    }
+    out_ = nullptr;
+    std::string error;
+    {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      error.swap(error_);
+    }
+    if (!error.empty()) throw dmlc::Error(error);
+    return false;
+  }
+
+  /*! \return the current block of rows */
+  inline const TextRowView& Value() const {
+    return view_;
+  }
+
+ private:
+  // start of the line p points into
+  static inline const char* LineBegin(const char* p, const char* head) {
+    while (p != head && *(p - 1) != '\n' && *(p - 1) != '\r') --p;
+    return p;
+  }
+
+  static inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t';
+  }
+
+  static inline bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  // parse an unsigned integer in [p, end)
+  static inline const char* ParseIndex(const char* p, const char* end, uint64_t* out) {
+    uint64_t v = 0;
+    while (p != end && IsDigit(*p)) {
+      v = v * 10 + (*p - '0');
+      ++p;
+    }
+    *out = v;
+    return p;
+  }
+
+  // parse a token that does not start with a digit, such as nan, inf or infinity, with
+  // strtod as the dmlc parsers do. Returns p if the token is not a number.
+  static inline const char* ParseRealToken(const char* p, const char* end, real_t* out) {
+    char token[64];
+    size_t n = 0;
+    while (p + n != end && n + 1 < sizeof(token) && !IsSpace(p[n]) && p[n] != ',' &&
+           p[n] != ':' && p[n] != '\n' && p[n] != '\r') {
+      token[n] = p[n];
+      ++n;
+    }
+    token[n] = '\0';
+    char* stop;
+    *out = static_cast<real_t>(std::strtod(token, &stop));
+    return p + (stop - token);
+  }
+
+  // parse a decimal number in [p, end), bounded so that chunks need no terminator
+  static inline const char* ParseReal(const char* p, const char* end, real_t* out) {
+    static const double kPow10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* begin = p;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      negative = *p == '-';
+      ++p;
+    }
+    if (p == end || (!IsDigit(*p) && *p != '.')) return ParseRealToken(begin, end, out);
+    uint64_t mantissa = 0;
+    int digits = 0, exp10 = 0;
+    for (; p != end && IsDigit(*p); ++p) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa != 0;
+      } else {
+        ++exp10;
+      }
+    }
+    if (p != end && *p == '.') {
+      for (++p; p != end && IsDigit(*p); ++p) {
+        if (digits < 19) {
+          mantissa = mantissa * 10 + (*p - '0');
+          digits += mantissa != 0;
+          --exp10;
+        }
+      }
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+      const char* q = p + 1;
+      bool exp_negative = false;
+      if (q != end && (*q == '-' || *q == '+')) {
+        exp_negative = *q == '-';
+        ++q;
+      }
+      if (q != end && IsDigit(*q)) {
+        uint64_t e;
+        p = ParseIndex(q, end, &e);
+        exp10 += exp_negative ? -static_cast<int>(e) : static_cast<int>(e);
+      }
+    }
+    double v = static_cast<double>(mantissa);
+    if (exp10 < 0) {
+      v = -exp10 <= 22 ? v / kPow10[-exp10] : v * std::pow(10.0, exp10);
+    } else if (exp10 > 0) {
+      v = exp10 <= 22 ? v * kPow10[exp10] : v * std::pow(10.0, exp10);
+    }
+    *out = static_cast<real_t>(negative ? -v : v);
+    return p;
+  }
+
+  // label[:weight] index[:value] ..., a missing value means 1
+  static void ParseLibSVM(const char* p, const char* end, TextRowBlock* out) {
+    while (p != end) {
+      const char* lend = p;
+      while (lend != end && *lend != '\n' && *lend != '\r') ++lend;
+      while (p != lend && IsSpace(*p)) ++p;
+      if (p != lend && *p != '#') {
+        real_t label;
+        const char* q = ParseReal(p, lend, &label);
+        CHECK(q != p) << "Invalid LibSVM format: " << std::string(p, lend);
+        p = q;
+        if (p != lend && *p == ':') {
+          real_t weight;
+          p = ParseReal(p + 1, lend, &weight);
+        }
+        out->label.push_back(label);
+        while (true) {
+          while (p != lend && IsSpace(*p)) ++p;
+          if (p == lend || *p == '#') break;
+          if (lend - p > 4 && std::strncmp(p, "qid:", 4) == 0) {
+            while (p != lend && !IsSpace(*p)) ++p;
+            continue;
+          }
+          uint64_t index;
+          q = ParseIndex(p, lend, &index);
+          CHECK(q != p) << "Invalid LibSVM format: " << std::string(p, lend);
+          p = q;
+          real_t value = 1.0f;
+          if (p != lend && *p == ':') {
+            p = ParseReal(p + 1, lend, &value);
+          }
+          out->index.push_back(static_cast<int64_t>(index));
+          out->value.push_back(value);
+        }
+        out->offset.push_back(out->value.size());
+      }
+      p = lend;
+      while (p != end && (*p == '\n' || *p == '\r')) ++p;
+    }
+  }
+
+  // comma separated values, one row per line
+  static void ParseCSV(const char* p, const char* end, TextRowBlock* out) {
+    while (p != end) {
+      const char* lend = p;
+      while (lend != end && *lend != '\n' && *lend != '\r') ++lend;
+      while (p != lend && IsSpace(*p)) ++p;
+      if (p != lend) {
+        while (true) {
+          real_t value;
+          p = ParseReal(p, lend, &value);
+          out->value.push_back(value);
+          while (p != lend && IsSpace(*p)) ++p;
+          if (p == lend) break;
+          CHECK_EQ(*p, ',') << "Invalid CSV format: " << std::string(p, lend);
+          ++p;
+          while (p != lend && IsSpace(*p)) ++p;
+        }
+        out->offset.push_back(out->value.size());
+      }
+      p = lend;
+      while (p != end && (*p == '\n' || *p == '\r')) ++p;
+    }
+  }
+
+  // append the stats of a local file, or of the files in a local directory
+  static bool AppendFileStats(const std::string& path, std::ostream* os) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+#ifndef _WIN32
+    if (S_ISDIR(st.st_mode)) {
+      DIR *dir = opendir(path.c_str());
+      if (dir == nullptr) return false;
+      std::vector<std::string> names;
+      for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name != "." && name != "..") names.push_back(name);
+      }
+      closedir(dir);
+      std::sort(names.begin(), names.end());
+      for (const std::string& name : names) {
+        if (!AppendFileStats(path + "/" + name, os)) return false;
+      }
+      return true;
+    }
+#endif  // _WIN32
+    *os << path << ' ' << st.st_size << ' ' << st.st_mtime << '\n';
+    return true;
+  }
+
+  // what the cache was built from, false when the source is not local
+  static bool SourceSignature(const std::string& uri, unsigned part_index, unsigned num_parts,
+                              Format format, std::string* signature) {
+    std::ostringstream os;
+    os << (format == kLibSVM ? "libsvm" : "csv") << ' ' << part_index << '/' << num_parts << '\n';
+    std::istringstream paths(uri);
+    std::string path;
+    while (std::getline(paths, path, ';')) {
+      if (path.empty()) continue;
+      if (path.compare(0, 7, "file://") == 0) path = path.substr(7);
+      if (path.find("://") != std::string::npos) return false;
+      if (!AppendFileStats(path, &os)) return false;
+    }
+    *signature = os.str();
+    return true;
+  }
+
+  // write n elements and pad to a multiple of 8 bytes, so that mapped arrays are aligned
+  template<typename DType>
+  inline void WriteCache(const DType* data, size_t n) {
+    static const char kZeros[8] = {0};
+    const size_t bytes = n * sizeof(DType);
+    if (bytes != 0) cache_out_->Write(data, bytes);
+    if (bytes % 8 != 0) cache_out_->Write(kZeros, 8 - bytes % 8);
+  }
+
+  // (re)start writing the cache, run by the parsing thread
+  void StartCache() {
+    cache_out_.reset(dmlc::Stream::Create((cache_file_ + ".tmp").c_str(), "w"));
+    const uint64_t header[] = {kCacheMagic, cache_signature_.size()};
+    WriteCache(header, 2);
+    WriteCache(cache_signature_.data(), cache_signature_.size());
+  }
+
+  // append a block to the cache, run by the parsing thread
+  void AppendCache(const TextRowBlock& block) {
+    if (block.Size() == 0) return;
+    const uint64_t sizes[] = {block.Size(), block.label.size(),
+                              block.index.size(), block.value.size()};
+    WriteCache(sizes, 4);
+    WriteCache(dmlc::BeginPtr(block.offset), block.offset.size());
+    WriteCache(dmlc::BeginPtr(block.label), block.label.size());
+    WriteCache(dmlc::BeginPtr(block.index), block.index.size());
+    WriteCache(dmlc::BeginPtr(block.value), block.value.size());
+  }
+
+  // the first pass is complete, run by the parsing thread
+  void FinishCache() {
+    cache_out_.reset();
+    const std::string tmp = cache_file_ + ".tmp";
+    std::remove(cache_file_.c_str());
+    CHECK_EQ(std::rename(tmp.c_str(), cache_file_.c_str()), 0)
+        << "Failed to move " << tmp << " to " << cache_file_;
+    LOG(INFO) << "Wrote text cache " << cache_file_;
+    cache_written_ = true;
+  }
+
+  // map the cache file, false if it is missing, damaged or out of date
+  bool OpenCache() {
+    std::FILE *fp = std::fopen(cache_file_.c_str(), "rb");
+    if (fp == nullptr) return false;
+    std::fclose(fp);
+    std::unique_ptr<common::MappedFile> map(new common::MappedFile(cache_file_));
+    const char *p = static_cast<const char*>(map->data());
+    const char *end = p + map->size();
+    // advance over n elements and their padding
+    auto take = [&p, end](size_t n, size_t elem_size, const void **out) {
+      const size_t bytes = (n * elem_size + 7) / 8 * 8;
+      if (n > static_cast<size_t>(end - p) / elem_size || bytes > static_cast<size_t>(end - p)) {
+        return false;
+      }
+      *out = p;
+      p += bytes;
+      return true;
+    };
+    const void *ptr;
+    if (!take(2, sizeof(uint64_t), &ptr)) return false;
+    const uint64_t *header = static_cast<const uint64_t*>(ptr);
+    if (header[0] != kCacheMagic || header[1] != cache_signature_.size() ||
+        !take(header[1], 1, &ptr) ||
+        std::memcmp(ptr, cache_signature_.data(), header[1]) != 0) {
+      LOG(INFO) << "Text cache " << cache_file_ << " is out of date, rebuilding it";
+      return false;
+    }
+    std::vector<TextRowView> blocks;
+    while (p != end) {
+      TextRowView view;
+      if (!take(4, sizeof(uint64_t), &ptr)) return false;
+      const uint64_t *sizes = static_cast<const uint64_t*>(ptr);
+      view.size = sizes[0];
+      if (!take(sizes[0] + 1, sizeof(uint64_t), &ptr)) return false;
+      view.offset = static_cast<const uint64_t*>(ptr);
+      if (!take(sizes[1], sizeof(real_t), &ptr)) return false;
+      view.label = sizes[1] != 0 ? static_cast<const real_t*>(ptr) : nullptr;
+      if (!take(sizes[2], sizeof(int64_t), &ptr)) return false;
+      view.index = sizes[2] != 0 ? static_cast<const int64_t*>(ptr) : nullptr;
+      if (!take(sizes[3], sizeof(real_t), &ptr)) return false;
+      view.value = static_cast<const real_t*>(ptr);
+      if (view.offset[view.size] != sizes[3]) return false;
+      blocks.push_back(view);
+    }
+    cache_blocks_.swap(blocks);
+    cache_map_ = std::move(map);
+    cache_ptr_ = 0;
+    return true;
+  }
+
+  // parse the next chunk of the source into out
+  bool ParseChunk(TextRowBlock* out) {
+    dmlc::InputSplit::Blob chunk;
+    if (!source_->NextChunk(&chunk)) {
+      if (cache_out_ != nullptr) FinishCache();
+      return false;
+    }
+    const char* head = static_cast<const char*>(chunk.dptr);
+    const size_t size = chunk.size;
+    const size_t step = (size + nthread_ - 1) / nthread_;
+    // cut at line starts, so neighbouring pieces agree on their common bound
+    bounds_[0] = head;
+    for (int i = 1; i < nthread_; ++i) {
+      bounds_[i] = LineBegin(head + std::min(size, i * step), head);
+    }
+    bounds_[nthread_] = head + size;
+    // exceptions cannot leave the parallel region, they are rethrown after it
+    std::vector<std::string> errors(nthread_);
+    #pragma omp parallel for num_threads(nthread_) schedule(static, 1)
+    for (int i = 0; i < nthread_; ++i) {
+      pieces_[i].Clear();
+      try {
+        if (format_ == kLibSVM) {
+          ParseLibSVM(bounds_[i], bounds_[i + 1], &pieces_[i]);
+        } else {
+          ParseCSV(bounds_[i], bounds_[i + 1], &pieces_[i]);
+        }
+      } catch (dmlc::Error &err) {
+        errors[i] = err.what();
+      }
+    }
+    for (const std::string& error : errors) {
+      if (!error.empty()) throw dmlc::Error(error);
+    }
+    // reassemble the pieces in order
+    row_begin_[0] = nnz_begin_[0] = 0;
+    for (int i = 0; i < nthread_; ++i) {
+      row_begin_[i + 1] = row_begin_[i] + pieces_[i].Size();
+      nnz_begin_[i + 1] = nnz_begin_[i] + pieces_[i].value.size();
+    }
+    out->offset.resize(row_begin_[nthread_] + 1);
+    out->offset[0] = 0;
+    out->value.resize(nnz_begin_[nthread_]);
+    if (format_ == kLibSVM) {
+      out->label.resize(row_begin_[nthread_]);
+      out->index.resize(nnz_begin_[nthread_]);
+    }
+    #pragma omp parallel for num_threads(nthread_) schedule(static, 1)
+    for (int i = 0; i < nthread_; ++i) {
+      const TextRowBlock& piece = pieces_[i];
+      for (size_t r = 0; r < piece.Size(); ++r) {
+        out->offset[row_begin_[i] + r + 1] = nnz_begin_[i] + piece.offset[r + 1];
+      }
+      std::copy(piece.value.begin(), piece.value.end(), out->value.begin() + nnz_begin_[i]);
+      if (format_ == kLibSVM) {
+        std::copy(piece.label.begin(), piece.label.end(), out->label.begin() + row_begin_[i]);
+        std::copy(piece.index.begin(), piece.index.end(), out->index.begin() + nnz_begin_[i]);
+      }
+    }
+    if (cache_out_ != nullptr) AppendCache(*out);
+    return true;
+  }
+
+  /*! \brief magic number of cache files */
+  static const uint64_t kCacheMagic = 0x3148434143545854ULL;
+
+  /*! \brief text format */
+  Format format_;
+  /*! \brief number of parsing threads */
+  int nthread_;
+  /*! \brief the text source */
+  std::unique_ptr<dmlc::InputSplit> source_;
+  /*! \brief rows parsed by each thread */
+  std::vector<TextRowBlock> pieces_;
+  /*! \brief text range of each thread */
+  std::vector<const char*> bounds_;
+  /*! \brief first row and first entry of each piece in the block */
+  std::vector<size_t> row_begin_, nnz_begin_;
+  /*! \brief background parsing of the next chunk */
+  dmlc::ThreadedIter<TextRowBlock> iter_;
+  /*! \brief block handed out */
+  TextRowBlock *out_;
+  /*! \brief rows handed out */
+  TextRowView view_;
+  /*! \brief error of the background parsing, rethrown by Next */
+  std::string error_;
+  std::mutex error_mutex_;
+  /*! \brief path of the cache file, empty if not caching */
+  std::string cache_file_;
+  /*! \brief sizes and modification times of the source files */
+  std::string cache_signature_;
+  /*! \brief cache being written by the first pass */
+  std::unique_ptr<dmlc::Stream> cache_out_;
+  /*! \brief whether the first pass has completed the cache */
+  std::atomic<bool> cache_written_{false};
+  /*! \brief the mapped cache file */
+  std::unique_ptr<common::MappedFile> cache_map_;
+  /*! \brief blocks of the mapped cache */
+  std::vector<TextRowView> cache_blocks_;
+  /*! \brief next block of the mapped cache */
+  size_t cache_ptr_{0};
+};
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_PARALLEL_TEXT_PARSER_H_
@@ -32,6 +32,7 @@
 #include <mxnet/imperative.h>
 #include <mshadow/tensor.h>
 #include "./ndarray_function.h"
+#include "../common/mapped_file.h"
 #include "../common/utils.h"
 #include "../operator/tensor/matrix_op-inl.h"
 #include "../operator/tensor/init_op.h"
@@ -1089,6 +1090,152 @@ void NDArray::Load(dmlc::Stream* fi,
       << "Invalid NDArray file format";
 }
 
+/* magic number and version of the memory mappable ndarray list format */
+const uint64_t kMXAPINDArrayMappableMagic = 0x113;
+const uint32_t kMXAPINDArrayMappableVersion = 1;
+/* alignment of the data of each array in the mappable format */
+const uint32_t kMXAPINDArrayMappableAlign = 64;
+
+/*
+ * Layout of the mappable format, all offsets are from the beginning of the file:
+ *   uint64 magic, uint32 version, uint32 alignment, uint64 number of arrays
+ *   per array: int32 type flag, uint32 ndim, int64 dims[ndim], uint64 data offset
+ *   names as std::vector<std::string>
+ *   data of each array, starting at a multiple of alignment
+ */
+void NDArray::SaveMappable(dmlc::Stream* fo,
+                           const std::vector<NDArray>& data,
+                           const std::vector<std::string>& names) {
+  CHECK(names.size() == 0 || names.size() == data.size())
+      << "number of names does not match the number of arrays";
+  const uint32_t align = kMXAPINDArrayMappableAlign;
+  auto aligned = [align](uint64_t offset) {
+    return (offset + align - 1) / align * align;
+  };
+  // size of the header, to compute the data offsets up front
+  uint64_t header_size = sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2;
+  for (const NDArray& nd : data) {
+    CHECK(nd.is_none() || nd.storage_type() == kDefaultStorage)
+        << "the mappable format only supports dense arrays";
+    header_size += sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t) +
+                   sizeof(int64_t) * nd.shape().ndim();
+  }
+  header_size += sizeof(uint64_t);
+  for (const std::string& name : names) {
+    header_size += sizeof(uint64_t) + name.length();
+  }
+  std::vector<uint64_t> offsets(data.size(), 0);
+  uint64_t end = aligned(header_size);
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (data[i].is_none()) continue;
+    offsets[i] = end;
+    end = aligned(end + data[i].shape().Size() * mshadow::mshadow_sizeof(data[i].dtype()));
+  }
+  // header
+  uint64_t header = kMXAPINDArrayMappableMagic, num_arrays = data.size();
+  uint32_t version = kMXAPINDArrayMappableVersion;
+  fo->Write(&header, sizeof(header));
+  fo->Write(&version, sizeof(version));
+  fo->Write(&align, sizeof(align));
+  fo->Write(&num_arrays, sizeof(num_arrays));
+  for (size_t i = 0; i < data.size(); ++i) {
+    int32_t type_flag = data[i].is_none() ? -1 : data[i].dtype();
+    const TShape& shape = data[i].shape();
+    uint32_t ndim = shape.ndim();
+    fo->Write(&type_flag, sizeof(type_flag));
+    fo->Write(&ndim, sizeof(ndim));
+    for (uint32_t k = 0; k < ndim; ++k) {
+      int64_t dim = shape[k];
+      fo->Write(&dim, sizeof(dim));
+    }
+    fo->Write(&offsets[i], sizeof(offsets[i]));
+  }
+  fo->Write(names);
+  // data
+  std::vector<char> padding(align, 0);
+  uint64_t pos = header_size;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (data[i].is_none()) continue;
+    fo->Write(padding.data(), offsets[i] - pos);
+    NDArray nd_cpu = data[i];
+    if (nd_cpu.ctx().dev_mask() != cpu::kDevMask) {
+      nd_cpu = data[i].Copy(Context::CPU());
+    }
+    nd_cpu.WaitToRead();
+    TBlob save_data = nd_cpu.data();
+    CHECK(save_data.CheckContiguous());
+    const size_t nbytes = save_data.Size() * mshadow::mshadow_sizeof(save_data.type_flag_);
+    fo->Write(save_data.dptr_, nbytes);
+    pos = offsets[i] + nbytes;
+  }
+  fo->Write(padding.data(), end - pos);
+}
+
+bool NDArray::IsMappable(dmlc::Stream* fi) {
+  uint64_t header;
+  return fi->Read(&header, sizeof(header)) == sizeof(header) &&
+         header == kMXAPINDArrayMappableMagic;
+}
+
+void NDArray::LoadMapped(const std::string& fname,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys,
+                         bool copy_on_write) {
+  std::shared_ptr<common::MappedFile> file =
+      std::make_shared<common::MappedFile>(fname, copy_on_write);
+  char* base = static_cast<char*>(file->data());
+  dmlc::MemoryFixedSizeStream fi(base, file->size());
+  uint64_t header, num_arrays;
+  uint32_t version, align;
+  CHECK(fi.Read(&header, sizeof(header)) == sizeof(header) &&
+        header == kMXAPINDArrayMappableMagic)
+      << "Invalid mappable NDArray file format";
+  CHECK(fi.Read(&version, sizeof(version)) == sizeof(version) &&
+        version <= kMXAPINDArrayMappableVersion)
+      << "Unsupported mappable NDArray file version";
+  CHECK_EQ(fi.Read(&align, sizeof(align)), sizeof(align))
+      << "Invalid mappable NDArray file format";
+  CHECK(align > 0 && (align & (align - 1)) == 0)
+      << "Invalid mappable NDArray file format: alignment " << align
+      << " is not a power of two";
+  CHECK_EQ(fi.Read(&num_arrays, sizeof(num_arrays)), sizeof(num_arrays))
+      << "Invalid mappable NDArray file format";
+  data->clear();
+  data->reserve(num_arrays);
+  for (uint64_t i = 0; i < num_arrays; ++i) {
+    int32_t type_flag;
+    uint32_t ndim;
+    uint64_t offset;
+    CHECK_EQ(fi.Read(&type_flag, sizeof(type_flag)), sizeof(type_flag))
+        << "Invalid mappable NDArray file format";
+    CHECK_EQ(fi.Read(&ndim, sizeof(ndim)), sizeof(ndim))
+        << "Invalid mappable NDArray file format";
+    TShape shape(ndim);
+    for (uint32_t k = 0; k < ndim; ++k) {
+      int64_t dim;
+      CHECK_EQ(fi.Read(&dim, sizeof(dim)), sizeof(dim))
+          << "Invalid mappable NDArray file format";
+      shape[k] = dim;
+    }
+    CHECK_EQ(fi.Read(&offset, sizeof(offset)), sizeof(offset))
+        << "Invalid mappable NDArray file format";
+    if (type_flag < 0) {
+      data->push_back(NDArray());
+      continue;
+    }
+    const size_t nbytes = shape.Size() * mshadow::mshadow_sizeof(type_flag);
+    CHECK(offset % align == 0 && offset + nbytes <= file->size())
+        << "Invalid mappable NDArray file format";
+    NDArray nd(TBlob(base + offset, shape, cpu::kDevMask, type_flag, 0), 0);
+    nd.ptr_->static_data_owner = file;
+    data->push_back(nd);
+  }
+  CHECK(fi.Read(keys))
+      << "Invalid mappable NDArray file format";
+  CHECK(keys->size() == 0 || keys->size() == data->size())
+      << "Invalid mappable NDArray file format";
+}
+
 NDArray NDArray::Copy(Context ctx) const {
   NDArray ret;
   if (kDefaultStorage == storage_type()) {
@@ -24,13 +24,75 @@
  * \author Chen Zhu
 */
 #include "./count_sketch-inl.h"
+#include "../../engine/openmp.h"
+namespace mshadow {
+
+// CountSketch Forward. Every sample owns its output row, so the samples are split
+// across threads without atomics and processing_batch_size is not needed.
+template <typename DType>
+inline void CountSketchForward(const Tensor<cpu, 2, DType> &out,
+                               const Tensor<cpu, 2, DType> &in,
+                               const Tensor<cpu, 1, DType> &h,
+                               const Tensor<cpu, 1, DType> &s,
+                               const int n_samples,
+                               const int processing_batch_size,
+                               const int in_dim,
+                               const int out_dim) {
+  DType *out_ptr = out.dptr_;
+  const DType *in_ptr = in.dptr_;
+  const DType *h_ptr = h.dptr_;
+  const DType *s_ptr = s.dptr_;
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int i = 0; i < n_samples; ++i) {
+    const DType *in_row = in_ptr + static_cast<index_t>(i) * in_dim;
+    DType *out_row = out_ptr + static_cast<index_t>(i) * out_dim;
+    for (int j = 0; j < in_dim; ++j) {
+      out_row[static_cast<int>(h_ptr[j])] += s_ptr[j] * in_row[j];
+    }
+  }
+}
+
+template<typename DType>
+inline void CountSketchBackward(const Tensor<cpu, 2, DType> &in_grad,
+                                const Tensor<cpu, 2, DType> &out_grad,
+                                const Tensor<cpu, 1, DType> &h,
+                                const Tensor<cpu, 1, DType> &s,
+                                const int n_samples,
+                                const int processing_batch_size,
+                                const int in_dim,
+                                const int out_dim) {
+  DType *in_grad_ptr = in_grad.dptr_;
+  const DType *out_grad_ptr = out_grad.dptr_;
+  const DType *h_ptr = h.dptr_;
+  const DType *s_ptr = s.dptr_;
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int i = 0; i < n_samples; ++i) {
+    DType *in_grad_row = in_grad_ptr + static_cast<index_t>(i) * in_dim;
+    const DType *out_grad_row = out_grad_ptr + static_cast<index_t>(i) * out_dim;
+    for (int j = 0; j < in_dim; ++j) {
+      in_grad_row[j] = out_grad_row[static_cast<int>(h_ptr[j])] * s_ptr[j];
+    }
+  }
+}
+}  // namespace mshadow
+
 namespace mxnet {
 namespace op {
 
 template<>
 Operator *CreateOp<cpu>(CountSketchParam param, int dtype) {
-    LOG(FATAL) << "CountSketch is only available for GPU.";
-    return NULL;
+  Operator *op = NULL;
+  switch (dtype) {
+    case mshadow::kFloat32:
+      op = new CountSketchOp<cpu, float>(param);
+      break;
+    case mshadow::kFloat64:
+      op = new CountSketchOp<cpu, double>(param);
+      break;
+    default:
+      LOG(FATAL) << "CountSketch on cpu only supports float32 and float64, got type " << dtype;
+  }
+  return op;
 }
 Operator *CountSketchProp::CreateOperatorEx(Context ctx, std::vector<TShape> *in_shape,
                                             std::vector<int> *in_type) const {
@@ -45,8 +107,6 @@ DMLC_REGISTER_PARAMETER(CountSketchParam);
 MXNET_REGISTER_OP_PROPERTY(_contrib_count_sketch, CountSketchProp)
 .describe(R"code(Apply CountSketch to input: map a d-dimension data to k-dimension data"
 
-.. note:: `count_sketch` is only available on GPU.
-
 Assume input data has shape (N, d), sign hash table s has shape (N, d),
 index hash table h has shape (N, d) and mapping dimension out_dim = k,
 each element in s is either +1 or -1, each element in h is random integer from 0 to k-1.
@@ -5,21 +5,77 @@
 #include <limits>
 #include <algorithm>
 #include <numeric>
+#include <vector>
 
 #include <dmlc/omp.h>
 
 #include "ctc_helper.h"
+#include "../../../vec_math.h"
 
 namespace mxnet_warpctc {
 
+namespace cpu_kernels {
+
+// y = log(softmax(x)) over [0, n)
+template<typename ProbT>
+inline void log_softmax(const ProbT* const x, ProbT* y, int n) {
+    ProbT max_activation = -std::numeric_limits<ProbT>::infinity();
+    for(int r = 0; r < n; ++r)
+        max_activation = std::max(max_activation, x[r]);
+
+    ProbT denom = ProbT(0.);
+    for(int r = 0; r < n; ++r) {
+        denom += std::exp(x[r] - max_activation);
+    }
+
+    const ProbT log_denom = std::log(denom);
+    for(int r = 0; r < n; ++r) {
+        y[r] = x[r] - max_activation - log_denom;
+    }
+}
+
+inline void log_softmax(const float* const x, float* y, int n) {
+    mxnet::op::vec_math::LogSoftmax(x, y, n);
+}
+
+// y = exp(x - shift) over [0, n)
+template<typename ProbT>
+inline void shifted_exp(const ProbT* const x, ProbT shift, ProbT* y, int n) {
+    for(int i = 0; i < n; ++i)
+        y[i] = std::exp(x[i] - shift);
+}
+
+inline void shifted_exp(const float* const x, float shift, float* y, int n) {
+    if (n > 0)
+        mxnet::op::vec_math::ExpSum(x, shift, y, n);
+}
+
+// y = log(exp(a) + exp(b) + exp(c)) over [0, n), y may be any of a, b and c
+template<typename ProbT>
+inline void log_sum_exp3(const ProbT* const a, const ProbT* const b, const ProbT* const c,
+                         ProbT* y, int n) {
+    for(int i = 0; i < n; ++i)
+        y[i] = ctc_helper::log_plus<ProbT>()(ctc_helper::log_plus<ProbT>()(a[i], b[i]), c[i]);
+}
+
+inline void log_sum_exp3(const float* const a, const float* const b, const float* const c,
+                         float* y, int n) {
+    if (n > 0)
+        mxnet::op::vec_math::LogSumExp3(a, b, c, y, n);
+}
+
+} // cpu_kernels
+
 template<typename ProbT>
 class CpuCTC {
 public:
     // Noncopyable
-    CpuCTC(int alphabet_size, int minibatch, void* workspace,
+    // The sequences of the minibatch are split across num_threads threads, and the workspace
+    // holds the alphas and betas of num_threads sequences.
+    CpuCTC(int alphabet_size, int minibatch, void* workspace, int num_threads,
            int blank_label) :
             alphabet_size_(alphabet_size), minibatch_(minibatch),
-            workspace_(workspace), blank_label_(blank_label) {
+            workspace_(workspace), num_threads_(num_threads), blank_label_(blank_label) {
 
     };
 
@@ -54,6 +110,7 @@ private:
 
         ProbT* alphas;
         ProbT* betas;
+        ProbT* scratch;
         int* labels_w_blanks;
         int* e_inc;
         int* s_inc;
@@ -64,10 +121,13 @@ private:
     int alphabet_size_; // Number of characters plus blank
     int minibatch_;
     void* workspace_;
+    int num_threads_;
     int blank_label_;
 
+    size_t per_thread_bytes(int maxS, int maxT) const;
+
     void log_softmax(const ProbT* const activations, ProbT* log_probs,
-                     const int* const input_lengths);
+                     const int* const input_lengths, int maxT);
 
     std::tuple<ProbT, bool>
             cost_and_grad_kernel(ProbT *grad, const ProbT* const log_probs,
@@ -78,7 +138,8 @@ private:
                          const int* const e_inc,
                          const int* const s_inc,
                          const int* const labels,
-                         ProbT* alphas);
+                         ProbT* alphas,
+                         ProbT* scratch);
 
     ProbT compute_betas_and_grad(ProbT* grad, const ProbT* const log_probs,
                                  ProbT log_partition, int repeats,
@@ -87,7 +148,15 @@ private:
                                  const int* const labels,
                                  ProbT* alphas,
                                  ProbT* betas,
+                                 ProbT* scratch,
                                  ProbT* output);
+
+    void compute_grad_column(ProbT* grad, const ProbT* const log_probs,
+                             ProbT log_partition, int start, int end,
+                             const int* const labels,
+                             const ProbT* const alphas,
+                             ProbT* scratch,
+                             ProbT* output);
 };
 
 template<typename ProbT>
@@ -103,6 +172,8 @@ CpuCTC<ProbT>::CpuCTC_metadata::CpuCTC_metadata(int L, int S, int T, int mb,
     betas = reinterpret_cast<ProbT *>(static_cast<char *>(workspace) + bytes_used);
     bytes_used += sizeof(ProbT) * S;
     std::fill(betas, betas + S, ctc_helper::neg_inf<ProbT>());
+    scratch = reinterpret_cast<ProbT *>(static_cast<char *>(workspace) + bytes_used);
+    bytes_used += sizeof(ProbT) * S;
     labels_w_blanks = reinterpret_cast<int *>(static_cast<char *>(workspace) + bytes_used);
     bytes_used += sizeof(int) * S;
     e_inc = reinterpret_cast<int *>(static_cast<char *>(workspace) + bytes_used);
@@ -149,28 +220,38 @@ int CpuCTC<ProbT>::CpuCTC_metadata::setup_labels(const int* const labels,
     return repeats;
 }
 
+template<typename ProbT>
+size_t CpuCTC<ProbT>::per_thread_bytes(int maxS, int maxT) const {
+    size_t bytes = 0;
+
+    //output
+    bytes += sizeof(ProbT) * alphabet_size_;
+
+    //alphas
+    bytes += sizeof(ProbT) * maxS * maxT;
+
+    //betas, scratch
+    bytes += 2 * sizeof(ProbT) * maxS;
+
+    //labels w/blanks, e_inc, s_inc
+    bytes += 3 * sizeof(int) * maxS;
+
+    return bytes;
+}
+
 template<typename ProbT>
 void
 CpuCTC<ProbT>::log_softmax(const ProbT* const activations, ProbT* log_probs,
-                           const int* const input_lengths) {
-#pragma omp parallel for
-    for (int mb = 0; mb < minibatch_; ++mb) {
-        for(int c = 0; c < input_lengths[mb]; ++c) {
-            int col_offset = (mb + minibatch_ * c) * alphabet_size_;
-            ProbT max_activation = -std::numeric_limits<ProbT>::infinity();
-            for(int r = 0; r < alphabet_size_; ++r)
-                max_activation = std::max(max_activation, activations[r + col_offset]);
-
-            ProbT denom = ProbT(0.);
-            for(int r = 0; r < alphabet_size_; ++r) {
-                denom += std::exp(activations[r + col_offset] - max_activation);
-            }
-
-            for(int r = 0; r < alphabet_size_; ++r) {
-                log_probs[r + col_offset] = activations[r + col_offset]
-                                            - max_activation - std::log(denom);
-            }
-        }
+                           const int* const input_lengths, int maxT) {
+    // one row per (time, sequence), so that short batches of long utterances use all threads
+#pragma omp parallel for num_threads(num_threads_)
+    for (int row = 0; row < maxT * minibatch_; ++row) {
+        const int c = row / minibatch_, mb = row % minibatch_;
+        if (c >= input_lengths[mb])
+            continue;
+        const size_t col_offset = static_cast<size_t>(row) * alphabet_size_;
+        cpu_kernels::log_softmax(activations + col_offset, log_probs + col_offset,
+                                 alphabet_size_);
     }
 }
 
@@ -192,13 +273,14 @@ CpuCTC<ProbT>::cost_and_grad_kernel(ProbT *grad, const ProbT* const log_probs,
 
     ProbT llForward = compute_alphas(log_probs, ctcm.repeats, S, T, ctcm.e_inc,
                                      ctcm.s_inc, ctcm.labels_w_blanks,
-                                     ctcm.alphas);
+                                     ctcm.alphas, ctcm.scratch);
 
     ProbT llBackward = compute_betas_and_grad(grad, log_probs, llForward, ctcm.repeats,
                                               S, T, ctcm.e_inc, ctcm.s_inc,
                                               ctcm.labels_w_blanks,
                                               ctcm.alphas,
                                               ctcm.betas,
+                                              ctcm.scratch,
                                               ctcm.output);
 
     ProbT diff = std::abs(llForward - llBackward);
@@ -210,12 +292,15 @@ CpuCTC<ProbT>::cost_and_grad_kernel(ProbT *grad, const ProbT* const log_probs,
 }
 
 // Computes forward probabilities
+// Each column is a log-sum-exp of up to three entries of the previous column,
+// which is computed for the whole column at once.
 template<typename ProbT>
 ProbT CpuCTC<ProbT>::compute_alphas(const ProbT* log_probs, int repeats, int S, int T,
                                     const int* const e_inc,
                                     const int* const s_inc,
                                     const int* const labels,
-                                    ProbT* alphas) {
+                                    ProbT* alphas,
+                                    ProbT* scratch) {
 
     int start =  (((S /2) + repeats - T) < 0) ? 0 : 1,
             end = S > 1 ? 2 : 1;
@@ -238,14 +323,18 @@ ProbT CpuCTC<ProbT>::compute_alphas(const ProbT* log_probs, int repeats, int S,
             startloop += 1;
         }
 
+        // Skip two if not on blank and not on repeat.
         for(int i = startloop; i < end; ++i) {
-            ProbT prev_sum = ctc_helper::log_plus<ProbT>()(alphas[i + idx2], alphas[(i-1) + idx2]);
+            scratch[i] = (labels[i] != blank_label_ && i != 1 && labels[i] != labels[i-2]) ?
+                         alphas[(i-2) + idx2] : ctc_helper::neg_inf<ProbT>();
+        }
 
-            // Skip two if not on blank and not on repeat.
-            if (labels[i] != blank_label_ && i != 1 && labels[i] != labels[i-2])
-                prev_sum = ctc_helper::log_plus<ProbT>()(prev_sum, alphas[(i-2) + idx2]);
+        cpu_kernels::log_sum_exp3(alphas + startloop + idx2, alphas + (startloop-1) + idx2,
+                                  scratch + startloop, alphas + startloop + idx1,
+                                  end - startloop);
 
-            alphas[i + idx1] = prev_sum + log_probs[labels[i] + idx3];
+        for(int i = startloop; i < end; ++i) {
+            alphas[i + idx1] += log_probs[labels[i] + idx3];
         }
     }
 
@@ -257,11 +346,46 @@ ProbT CpuCTC<ProbT>::compute_alphas(const ProbT* log_probs, int repeats, int S,
     return loglike;
 }
 
+// Sets the gradient of one time step. The alpha * beta products at positions [start, end)
+// of the column are reduced by label relative to the largest one, products more than
+// ~87 below it in log space underflow but their share of the sum is negligible.
+// Labels which are not in the column just get their probability.
+template<typename ProbT>
+void CpuCTC<ProbT>::compute_grad_column(ProbT* grad, const ProbT* const log_probs,
+                                        ProbT log_partition, int start, int end,
+                                        const int* const labels,
+                                        const ProbT* const alphas,
+                                        ProbT* scratch,
+                                        ProbT* output) {
+    cpu_kernels::shifted_exp(log_probs, ProbT(0), grad, alphabet_size_);
+    if (start >= end)
+        return;
+
+    const ProbT shift = *std::max_element(alphas + start, alphas + end);
+    if (shift == ctc_helper::neg_inf<ProbT>())
+        return;
+
+    //reduce-by-key in a sequential manner, output is zero outside of this function
+    cpu_kernels::shifted_exp(alphas + start, shift, scratch + start, end - start);
+    for(int i = start; i < end; ++i) {
+        output[labels[i]] += scratch[i];
+    }
+
+    for(int i = start; i < end; ++i) {
+        const int k = labels[i];
+        if (output[k] == ProbT(0))
+            continue;
+        if (log_probs[k] != ctc_helper::neg_inf<ProbT>()) {
+            grad[k] -= std::exp(std::log(output[k]) + shift - log_probs[k] - log_partition);
+        }
+        output[k] = ProbT(0);
+    }
+}
+
 // Starting from T, we sweep backward over the alpha array computing one column
 // of betas as we go.  At each position we can update product alpha * beta and then
 // sum into the gradient associated with each label.
 // NOTE computes gradient w.r.t UNNORMALIZED final layer activations.
-// Assumed passed in grads are already zeroed!
 template<typename ProbT>
 ProbT CpuCTC<ProbT>::compute_betas_and_grad(ProbT* grad, const ProbT* const log_probs,
                                             ProbT log_partition, int repeats,
@@ -270,11 +394,12 @@ ProbT CpuCTC<ProbT>::compute_betas_and_grad(ProbT* grad, const ProbT* const log_
                                             const int* const labels,
                                             ProbT* alphas,
                                             ProbT* betas,
+                                            ProbT* scratch,
                                             ProbT* output) {
     int start = S > 1 ? (S - 2) : 0,
             end = (T > (S / 2) + repeats) ? S : S-1;
 
-    std::fill(output, output + alphabet_size_, ctc_helper::neg_inf<ProbT>());
+    std::fill(output, output + alphabet_size_, ProbT(0));
 
     //set the starting values in the beta column at the very right edge
     for (int i = start; i < end; ++i) {
@@ -282,25 +407,13 @@ ProbT CpuCTC<ProbT>::compute_betas_and_grad(ProbT* grad, const ProbT* const log_
 
         //compute alpha * beta in log space at this position in (S, T) space
         alphas[i + (T - 1) * S] += betas[i];
-
-        //update the gradient associated with this label
-        //essentially performing a reduce-by-key in a sequential manner
-        output[labels[i]] =
-                ctc_helper::log_plus<ProbT>()(alphas[i + (T - 1) * S], output[labels[i]]);
     }
 
     //update the gradient wrt to each unique label
-    for (int i = 0; i < alphabet_size_; ++i) {
-        int idx3 = (T - 1) * alphabet_size_ * minibatch_ + i;
-
-        if (output[i] == 0.0 || output[i] == ctc_helper::neg_inf<ProbT>() ||
-            log_probs[idx3] == ctc_helper::neg_inf<ProbT>()) {
-            grad[idx3] = std::exp(log_probs[idx3]);
-        } else {
-            grad[idx3] = std::exp(log_probs[idx3])
-                         - std::exp(output[i] - log_probs[idx3] - log_partition);
-        }
-    }
+    compute_grad_column(grad + (T - 1) * alphabet_size_ * minibatch_,
+                        log_probs + (T - 1) * alphabet_size_ * minibatch_,
+                        log_partition, start, end, labels, alphas + (T - 1) * S,
+                        scratch, output);
 
     //loop from the second to last column all the way to the left
     for(int t = T - 2; t >= 0; --t) {
@@ -313,45 +426,31 @@ ProbT CpuCTC<ProbT>::compute_betas_and_grad(ProbT* grad, const ProbT* const log_
         int endloop = end == S ? end - 1 : end;
         int idx1 = t * S, idx3 = t * (alphabet_size_ * minibatch_);
 
-        std::fill(output, output + alphabet_size_, ctc_helper::neg_inf<ProbT>());
+        // Skip two if not on blank and not on repeat.
+        for(int i = start; i < endloop; ++i) {
+            scratch[i] = (labels[i] != blank_label_ && i != (S-2) && labels[i] != labels[i+2]) ?
+                         betas[i+2] : ctc_helper::neg_inf<ProbT>();
+        }
+
+        cpu_kernels::log_sum_exp3(betas + start, betas + start + 1, scratch + start,
+                                  scratch + start, endloop - start);
 
         for(int i = start; i < endloop; ++i) {
-            ProbT next_sum = ctc_helper::log_plus<ProbT>()(betas[i], betas[(i+1)]);
-            // Skip two if not on blank and not on repeat.
-            if (labels[i] != blank_label_ && i != (S-2) && labels[i] != labels[i+2]){
-                next_sum = ctc_helper::log_plus<ProbT>()(next_sum, betas[(i+2)]);
-            }
-            betas[i] = next_sum + log_probs[labels[i] + idx3];
+            betas[i] = scratch[i] + log_probs[labels[i] + idx3];
 
             //compute alpha * beta in log space
             alphas[i + idx1] += betas[i];
-
-            //update the gradient associated with this label
-            output[labels[i]] =
-                    ctc_helper::log_plus<ProbT>()(alphas[i + idx1], output[labels[i]]);
         }
 
         if (end == S) {
             betas[(S-1)] = betas[(S-1)] + log_probs[blank_label_ + idx3];
             alphas[(S-1) + idx1] += betas[(S-1)];
-
-            output[labels[S-1]] =
-                    ctc_helper::log_plus<ProbT>()(alphas[S-1 + idx1], output[labels[S-1]]);
         }
 
         //go over the unique labels and compute the final grad
         // wrt to each one at this time step
-        for (int i = 0; i < alphabet_size_; ++i) {
-
-            if (output[i] == 0.0 || output[i] == ctc_helper::neg_inf<ProbT>() ||
-                log_probs[idx3] == ctc_helper::neg_inf<ProbT>()) {
-                grad[idx3] = std::exp(log_probs[idx3]);
-            } else {
-                grad[idx3] = std::exp(log_probs[idx3])
-                             - std::exp(output[i] - log_probs[idx3] - log_partition);
-            }
-            ++idx3;
-        }
+        compute_grad_column(grad + idx3, log_probs + idx3, log_partition, start, end,
+                            labels, alphas + idx1, scratch, output);
     }
 
     ProbT loglike = ctc_helper::neg_inf<ProbT>();
@@ -385,27 +484,19 @@ CpuCTC<ProbT>::cost_and_grad(const ProbT* const activations,
 
     size_t bytes_used = sizeof(ProbT) * minibatch_ * alphabet_size_ * maxT;
 
-    //per minibatch memory
-    size_t per_minibatch_bytes = 0;
-
-    int maxL = *std::max_element(label_lengths, label_lengths + minibatch_);;
+    int maxL = *std::max_element(label_lengths, label_lengths + minibatch_);
     int maxS = 2 * maxL + 1;
 
-    //output
-    per_minibatch_bytes += sizeof(float) * alphabet_size_;
+    //per thread memory
+    size_t thread_bytes = per_thread_bytes(maxS, maxT);
 
-    //alphas
-    per_minibatch_bytes += sizeof(float) * maxS * maxT;
+    std::vector<int> label_offsets(minibatch_, 0);
+    std::partial_sum(label_lengths, label_lengths + minibatch_ - 1, label_offsets.begin() + 1);
 
-    //betas
-    per_minibatch_bytes += sizeof(float) * maxS;
+    log_softmax(activations, log_probs, input_lengths, maxT);
 
-    //labels w/blanks, e_inc, s_inc
-    per_minibatch_bytes += 3 * sizeof(int) * maxS;
-
-    log_softmax(activations, log_probs, input_lengths);
-
-#pragma omp parallel for
+    // utterances differ in length, so they are handed out one at a time
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads_)
     for (int mb = 0; mb < minibatch_; ++mb) {
         const int T = input_lengths[mb]; // Length of utterance (time)
         const int L = label_lengths[mb]; // Number of labels in transcription
@@ -415,9 +506,9 @@ CpuCTC<ProbT>::cost_and_grad(const ProbT* const activations,
         std::tie(costs[mb], mb_status) =
                 cost_and_grad_kernel(grads + mb * alphabet_size_,
                                      log_probs + mb * alphabet_size_,
-                                     flat_labels + std::accumulate(label_lengths, label_lengths + mb, 0),
+                                     flat_labels + label_offsets[mb],
                                      T, L, mb,
-                                     bytes_used + mb * per_minibatch_bytes);
+                                     bytes_used + omp_get_thread_num() * thread_bytes);
     }
 
     return CTC_STATUS_SUCCESS;
@@ -443,35 +534,27 @@ ctcStatus_t CpuCTC<ProbT>::score_forward(const ProbT* const activations,
 
     size_t bytes_used = sizeof(ProbT) * minibatch_ * alphabet_size_ * maxT;
 
-    //per minibatch memory
-    size_t per_minibatch_bytes = 0;
-
     int maxL = *std::max_element(label_lengths, label_lengths + minibatch_);
     int maxS = 2 * maxL + 1;
 
-    //output
-    per_minibatch_bytes += sizeof(float) * alphabet_size_;
-
-    //alphas
-    per_minibatch_bytes += sizeof(float) * maxS * maxT;
-
-    //betas
-    per_minibatch_bytes += sizeof(float) * maxS;
+    //per thread memory
+    size_t thread_bytes = per_thread_bytes(maxS, maxT);
 
-    //labels w/blanks, e_inc, s_inc
-    per_minibatch_bytes += 3 * sizeof(int) * maxS;
+    std::vector<int> label_offsets(minibatch_, 0);
+    std::partial_sum(label_lengths, label_lengths + minibatch_ - 1, label_offsets.begin() + 1);
 
-    log_softmax(activations, log_probs, input_lengths);
+    log_softmax(activations, log_probs, input_lengths, maxT);
 
-#pragma omp parallel for
+    // utterances differ in length, so they are handed out one at a time
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads_)
     for (int mb = 0; mb < minibatch_; ++mb) {
         const int T = input_lengths[mb]; // Length of utterance (time)
         const int L = label_lengths[mb]; // Number of labels in transcription
         const int S = 2*L + 1; // Number of labels with blanks
 
         CpuCTC_metadata ctcm(L, S, T, mb, alphabet_size_, workspace_,
-                             bytes_used + mb * per_minibatch_bytes, blank_label_,
-                             flat_labels + std::accumulate(label_lengths, label_lengths + mb, 0));
+                             bytes_used + omp_get_thread_num() * thread_bytes, blank_label_,
+                             flat_labels + label_offsets[mb]);
 
 
         if (L + ctcm.repeats > T)
@@ -479,7 +562,7 @@ ctcStatus_t CpuCTC<ProbT>::score_forward(const ProbT* const activations,
         else {
             costs[mb] = -compute_alphas(log_probs + mb * alphabet_size_, ctcm.repeats, S, T,
                                         ctcm.e_inc, ctcm.s_inc, ctcm.labels_w_blanks,
-                                        ctcm.alphas);
+                                        ctcm.alphas, ctcm.scratch);
         }
 
     }
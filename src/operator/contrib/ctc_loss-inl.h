@@ -39,6 +39,7 @@
 #include <cstring>
 #include <iostream>
 #include "../operator_common.h"
+#include "../../engine/openmp.h"
 #include "../sequence_op_common.h"
 #include "../mshadow_op.h"
 #include "../nn/sequence_mask-inl.h"
@@ -57,6 +58,13 @@ enum CTCLossOpOutputs { kOut, kGrad };
 enum CTCLossOpForwardResource { kTempSpace };
 }
 
+// The CPU implementation splits the sequences of a batch across this many threads,
+// each of which needs the workspace of one sequence.
+inline int ctc_cpu_num_threads(int minibatch) {
+  return std::max(1, std::min(minibatch,
+                              engine::OpenMP::Get()->GetRecommendedOMPThreadCount()));
+}
+
 template <typename T>
 inline void get_workspace_size(std::vector<int> *label_lengths,
                                std::vector<int> *data_lengths,
@@ -105,26 +113,22 @@ inline void get_workspace_size(std::vector<int> *label_lengths,
     *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
 
   } else {
-    // cpu can eventually replace all minibatch with
-    // max number of concurrent threads if memory is
-    // really tight
-
-    // per minibatch memory
-    size_t per_minibatch_bytes = 0;
+    // per thread memory
+    size_t per_thread_bytes = 0;
 
     // output
-    per_minibatch_bytes += sizeof(T) * alphabet_size;
+    per_thread_bytes += sizeof(T) * alphabet_size;
 
     // alphas
-    per_minibatch_bytes += sizeof(T) * S * maxT;
+    per_thread_bytes += sizeof(T) * S * maxT;
 
-    // betas
-    per_minibatch_bytes += sizeof(T) * S;
+    // betas, scratch
+    per_thread_bytes += 2 * sizeof(T) * S;
 
     // labels w/blanks, e_inc, s_inc
-    per_minibatch_bytes += 3 * sizeof(int) * S;
+    per_thread_bytes += 3 * sizeof(int) * S;
 
-    *size_bytes = per_minibatch_bytes * minibatch;
+    *size_bytes = per_thread_bytes * ctc_cpu_num_threads(minibatch);
 
     // probs
     *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
@@ -147,6 +151,7 @@ inline bool LabelTensorToPackedVector(mshadow::Tensor<xpu, 2, DType> labels,
   std::vector<int> cpu_labels(max_num_labels*batch);
   mshadow::Tensor<xpu, 1, DType> flat_labels = labels.FlatTo1D();
   IndexTensorToVector(flat_labels, &cpu_labels);
+  packed_labels->reserve(cpu_labels.size());
 
   for (int b = 0; b < batch; ++b) {
     auto start = cpu_labels.data()+b*max_num_labels;
@@ -180,6 +185,7 @@ inline bool PackLabelByLength(mshadow::Tensor<xpu, 2, DType> labels,
   std::vector<int> cpu_labels(max_num_labels*batch);
   mshadow::Tensor<xpu, 1, DType> flat_labels = labels.FlatTo1D();
   IndexTensorToVector(flat_labels, &cpu_labels);
+  packed_labels->reserve(cpu_labels.size());
 
   for (int b = 0; b < batch; ++b) {
     auto start = cpu_labels.data()+b*max_num_labels;
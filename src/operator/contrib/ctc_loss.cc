@@ -36,7 +36,8 @@ ctcStatus_t compute_ctc_cost(const Tensor<cpu, 3, DType> activations,
                              void *workspace, int train, int blank_label) {
   int minibatch = static_cast<int>(activations.size(1));
   int alphabet_size = static_cast<int>(activations.size(2));
-  mxnet_warpctc::CpuCTC<DType> ctc(alphabet_size, minibatch, workspace, blank_label);
+  mxnet_warpctc::CpuCTC<DType> ctc(alphabet_size, minibatch, workspace,
+                                   mxnet::op::ctc_cpu_num_threads(minibatch), blank_label);
   if (train) {
     return ctc.cost_and_grad(activations.dptr_, grads, costs, labels,
                              label_lengths, data_lengths);
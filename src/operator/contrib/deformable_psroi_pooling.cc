@@ -30,13 +30,102 @@
 #include <mshadow/packet-inl.h>
 #include <mshadow/dot_engine-inl.h>
 #include <cassert>
+#include "../../engine/openmp.h"
 
 using std::max;
 using std::min;
 using std::floor;
 using std::ceil;
+using std::round;
 
 namespace mshadow {
+  /*! \brief sampling window of the output bin (n, ctop, ph, pw) on its input channel */
+  template<typename DType>
+  struct DeformablePSROIBin {
+    int roi_batch_ind, class_id, part_h, part_w, c;
+    DType roi_width, roi_height, wstart, hstart, sub_bin_size_w, sub_bin_size_h;
+  };
+
+  template<typename DType>
+  inline DeformablePSROIBin<DType> GetDeformablePSROIBin(const DType* bottom_rois,
+    const DType* bottom_trans,
+    const bool no_trans,
+    const DType spatial_scale,
+    const DType trans_std,
+    const int n, const int ctop, const int ph, const int pw,
+    const int pooled_height, const int pooled_width,
+    const int sample_per_part,
+    const int group_size,
+    const int part_size,
+    const int num_classes,
+    const int channels_each_class) {
+    DeformablePSROIBin<DType> bin;
+    // [start, end) interval for spatial sampling
+    const DType* offset_bottom_rois = bottom_rois + n * 5;
+    bin.roi_batch_ind = offset_bottom_rois[0];
+    DType roi_start_w = static_cast<DType>(round(offset_bottom_rois[1])) * spatial_scale - 0.5;
+    DType roi_start_h = static_cast<DType>(round(offset_bottom_rois[2])) * spatial_scale - 0.5;
+    DType roi_end_w = static_cast<DType>(round(offset_bottom_rois[3]) + 1.) * spatial_scale - 0.5;
+    DType roi_end_h = static_cast<DType>(round(offset_bottom_rois[4]) + 1.) * spatial_scale - 0.5;
+
+    // Force too small ROIs to be 1x1
+    bin.roi_width = max(roi_end_w - roi_start_w, static_cast<DType>(0.1));  // avoid 0
+    bin.roi_height = max(roi_end_h - roi_start_h, static_cast<DType>(0.1));
+
+    // Compute w and h at bottom
+    DType bin_size_h = bin.roi_height / static_cast<DType>(pooled_height);
+    DType bin_size_w = bin.roi_width / static_cast<DType>(pooled_width);
+
+    bin.sub_bin_size_h = bin_size_h / static_cast<DType>(sample_per_part);
+    bin.sub_bin_size_w = bin_size_w / static_cast<DType>(sample_per_part);
+
+    bin.part_h = floor(static_cast<DType>(ph) / pooled_height * part_size);
+    bin.part_w = floor(static_cast<DType>(pw) / pooled_width * part_size);
+    bin.class_id = ctop / channels_each_class;
+    DType trans_x = no_trans ? static_cast<DType>(0) :
+      bottom_trans[(((n * num_classes + bin.class_id) * 2)
+                      * part_size + bin.part_h)
+                      * part_size + bin.part_w] * trans_std;
+    DType trans_y = no_trans ? static_cast<DType>(0) :
+      bottom_trans[(((n * num_classes + bin.class_id) * 2 + 1)
+                      * part_size + bin.part_h)
+                      * part_size + bin.part_w] * trans_std;
+
+    bin.wstart = static_cast<DType>(pw) * bin_size_w + roi_start_w;
+    bin.wstart += trans_x * bin.roi_width;
+    bin.hstart = static_cast<DType>(ph) * bin_size_h + roi_start_h;
+    bin.hstart += trans_y * bin.roi_height;
+
+    int gw = floor(static_cast<DType>(pw) * group_size / pooled_width);
+    int gh = floor(static_cast<DType>(ph) * group_size / pooled_height);
+    gw = min(max(gw, 0), group_size - 1);
+    gh = min(max(gh, 0), group_size - 1);
+    bin.c = (ctop * group_size + gh) * group_size + gw;
+    return bin;
+  }
+
+  template <typename DType>
+  inline DType bilinear_interp(
+    const DType* data,
+    const DType x,
+    const DType y,
+    const int width,
+    const int height) {
+    int x1 = floor(x);
+    int x2 = ceil(x);
+    int y1 = floor(y);
+    int y2 = ceil(y);
+    DType dist_x = static_cast<DType>(x - x1);
+    DType dist_y = static_cast<DType>(y - y1);
+    DType value11 = data[y1*width + x1];
+    DType value12 = data[y2*width + x1];
+    DType value21 = data[y1*width + x2];
+    DType value22 = data[y2*width + x2];
+    DType value = (1 - dist_x)*(1 - dist_y)*value11 + (1 - dist_x)*dist_y*value12
+      + dist_x*(1 - dist_y)*value21 + dist_x*dist_y*value22;
+    return value;
+  }
+
   template<typename DType>
   inline void DeformablePSROIPoolForward(const Tensor<cpu, 4, DType> &out,
     const Tensor<cpu, 4, DType> &data,
@@ -51,8 +140,56 @@ namespace mshadow {
     const int part_size,
     const int sample_per_part,
     const float trans_std) {
-    // NOT_IMPLEMENTED;
-    return;
+    const DType *bottom_data = data.dptr_;
+    const DType *bottom_rois = bbox.dptr_;
+    const DType *bottom_trans = no_trans ? NULL : trans.dptr_;
+    DType *top_data = out.dptr_;
+    DType *top_count_data = top_count.dptr_;
+    const int num_rois = bbox.size(0);
+    const int channels = data.size(1);
+    const int height = data.size(2);
+    const int width = data.size(3);
+    const int pooled_height = pooled_size;
+    const int pooled_width = pooled_size;
+    const int num_classes = no_trans ? 1 : trans.size(1) / 2;
+    const int channels_each_class = no_trans ? output_dim : output_dim / num_classes;
+
+    const int nthreads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    // every (roi, output channel) pair writes its own pooled_size x pooled_size block
+    #pragma omp parallel for num_threads(nthreads)
+    for (int index = 0; index < num_rois * output_dim; ++index) {
+      const int ctop = index % output_dim;
+      const int n = index / output_dim;
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          const DeformablePSROIBin<DType> bin = GetDeformablePSROIBin(bottom_rois, bottom_trans,
+            no_trans, static_cast<DType>(spatial_scale), static_cast<DType>(trans_std),
+            n, ctop, ph, pw, pooled_height, pooled_width, sample_per_part, group_size,
+            part_size, num_classes, channels_each_class);
+          const DType* offset_bottom_data =
+            bottom_data + (bin.roi_batch_ind * channels + bin.c) * height * width;
+          DType sum = 0;
+          int count = 0;
+          for (int ih = 0; ih < sample_per_part; ih++) {
+            for (int iw = 0; iw < sample_per_part; iw++) {
+              DType w = bin.wstart + iw * bin.sub_bin_size_w;
+              DType h = bin.hstart + ih * bin.sub_bin_size_h;
+              // bilinear interpolation
+              if (w < -0.5 || w > width - 0.5 || h < -0.5 || h > height - 0.5) {
+                continue;
+              }
+              w = min(max(w, static_cast<DType>(0)), static_cast<DType>(width - 1));
+              h = min(max(h, static_cast<DType>(0)), static_cast<DType>(height - 1));
+              sum += bilinear_interp(offset_bottom_data, w, h, width, height);
+              count++;
+            }
+          }
+          const int top_index = (index * pooled_height + ph) * pooled_width + pw;
+          top_data[top_index] = count == 0 ? static_cast<DType>(0) : sum / count;
+          top_count_data[top_index] = count;
+        }
+      }
+    }
   }
 
   template<typename DType>
@@ -71,8 +208,136 @@ namespace mshadow {
     const int part_size,
     const int sample_per_part,
     const float trans_std) {
-    // NOT_IMPLEMENTED;
-    return;
+    const DType *top_diff = out_grad.dptr_;
+    const DType *bottom_data = data.dptr_;
+    const DType *bottom_rois = bbox.dptr_;
+    const DType *bottom_trans = no_trans ? NULL : trans.dptr_;
+    DType *bottom_data_diff = in_grad.dptr_;
+    DType *bottom_trans_diff = no_trans ? NULL : trans_grad.dptr_;
+    const DType *top_count_data = top_count.dptr_;
+    const int num_rois = bbox.size(0);
+    const int channels = in_grad.size(1);
+    const int height = in_grad.size(2);
+    const int width = in_grad.size(3);
+    const int pooled_height = pooled_size;
+    const int pooled_width = pooled_size;
+    const int num_classes = no_trans ? 1 : trans_grad.size(1) / 2;
+    const int channels_each_class = no_trans ? output_dim : output_dim / num_classes;
+    const int nthreads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+    // Gradient of the features. Input channel c = (ctop * group_size + gh) * group_size + gw
+    // is only sampled by output channel ctop in group cell (gh, gw), so every thread
+    // accumulates into its own channels without atomics.
+    const int bottom_channels = min(channels, output_dim * group_size * group_size);
+    #pragma omp parallel for num_threads(nthreads)
+    for (int c = 0; c < bottom_channels; ++c) {
+      const int ctop = c / (group_size * group_size);
+      const int cgh = (c / group_size) % group_size;
+      const int cgw = c % group_size;
+      for (int n = 0; n < num_rois; ++n) {
+        for (int ph = 0; ph < pooled_height; ++ph) {
+          int gh = floor(static_cast<DType>(ph) * group_size / pooled_height);
+          gh = min(max(gh, 0), group_size - 1);
+          if (gh != cgh) continue;
+          for (int pw = 0; pw < pooled_width; ++pw) {
+            int gw = floor(static_cast<DType>(pw) * group_size / pooled_width);
+            gw = min(max(gw, 0), group_size - 1);
+            if (gw != cgw) continue;
+            const int top_index = ((n * output_dim + ctop) * pooled_height + ph)
+                                  * pooled_width + pw;
+            if (top_count_data[top_index] <= 0) {
+              continue;
+            }
+            const DeformablePSROIBin<DType> bin = GetDeformablePSROIBin(bottom_rois,
+              bottom_trans, no_trans, static_cast<DType>(spatial_scale),
+              static_cast<DType>(trans_std), n, ctop, ph, pw, pooled_height, pooled_width,
+              sample_per_part, group_size, part_size, num_classes, channels_each_class);
+            DType diff_val = top_diff[top_index] / top_count_data[top_index];
+            DType* offset_bottom_data_diff =
+              bottom_data_diff + (bin.roi_batch_ind * channels + c) * height * width;
+            for (int ih = 0; ih < sample_per_part; ih++) {
+              for (int iw = 0; iw < sample_per_part; iw++) {
+                DType w = bin.wstart + iw * bin.sub_bin_size_w;
+                DType h = bin.hstart + ih * bin.sub_bin_size_h;
+                // bilinear interpolation
+                if (w < -0.5 || w > width - 0.5 || h < -0.5 || h > height - 0.5) {
+                  continue;
+                }
+                w = min(max(w, static_cast<DType>(0)), static_cast<DType>(width - 1));
+                h = min(max(h, static_cast<DType>(0)), static_cast<DType>(height - 1));
+                int x0 = floor(w);
+                int x1 = ceil(w);
+                int y0 = floor(h);
+                int y1 = ceil(h);
+                DType dist_x = w - x0, dist_y = h - y0;
+                offset_bottom_data_diff[y0 * width + x0] += (1 - dist_x) * (1 - dist_y) * diff_val;
+                offset_bottom_data_diff[y1 * width + x0] += (1 - dist_x) * dist_y * diff_val;
+                offset_bottom_data_diff[y0 * width + x1] += dist_x * (1 - dist_y) * diff_val;
+                offset_bottom_data_diff[y1 * width + x1] += dist_x * dist_y * diff_val;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    if (no_trans) {
+      return;
+    }
+    // Gradient of the offsets, which belong to a single roi each.
+    #pragma omp parallel for num_threads(nthreads)
+    for (int n = 0; n < num_rois; ++n) {
+      for (int ctop = 0; ctop < output_dim; ++ctop) {
+        for (int ph = 0; ph < pooled_height; ++ph) {
+          for (int pw = 0; pw < pooled_width; ++pw) {
+            const int top_index = ((n * output_dim + ctop) * pooled_height + ph)
+                                  * pooled_width + pw;
+            if (top_count_data[top_index] <= 0) {
+              continue;
+            }
+            const DeformablePSROIBin<DType> bin = GetDeformablePSROIBin(bottom_rois,
+              bottom_trans, no_trans, static_cast<DType>(spatial_scale),
+              static_cast<DType>(trans_std), n, ctop, ph, pw, pooled_height, pooled_width,
+              sample_per_part, group_size, part_size, num_classes, channels_each_class);
+            DType diff_val = top_diff[top_index] / top_count_data[top_index];
+            const DType* offset_bottom_data =
+              bottom_data + (bin.roi_batch_ind * channels + bin.c) * height * width;
+            DType diff_x = 0, diff_y = 0;
+            for (int ih = 0; ih < sample_per_part; ih++) {
+              for (int iw = 0; iw < sample_per_part; iw++) {
+                DType w = bin.wstart + iw * bin.sub_bin_size_w;
+                DType h = bin.hstart + ih * bin.sub_bin_size_h;
+                // bilinear interpolation
+                if (w < -0.5 || w > width - 0.5 || h < -0.5 || h > height - 0.5) {
+                  continue;
+                }
+                w = min(max(w, static_cast<DType>(0)), static_cast<DType>(width - 1));
+                h = min(max(h, static_cast<DType>(0)), static_cast<DType>(height - 1));
+                int x0 = floor(w);
+                int x1 = ceil(w);
+                int y0 = floor(h);
+                int y1 = ceil(h);
+                DType dist_x = w - x0, dist_y = h - y0;
+                DType U00 = offset_bottom_data[y0 * width + x0];
+                DType U01 = offset_bottom_data[y1 * width + x0];
+                DType U10 = offset_bottom_data[y0 * width + x1];
+                DType U11 = offset_bottom_data[y1 * width + x1];
+                diff_x += (U11 * dist_y + U10 * (1 - dist_y) - U01 * dist_y - U00 * (1 - dist_y))
+                  * static_cast<DType>(trans_std) * diff_val * bin.roi_width;
+                diff_y += (U11 * dist_x + U01 * (1 - dist_x) - U10 * dist_x - U00 * (1 - dist_x))
+                  * static_cast<DType>(trans_std) * diff_val * bin.roi_height;
+              }
+            }
+            bottom_trans_diff[(((n * num_classes + bin.class_id) * 2)
+                                 * part_size + bin.part_h)
+                                 * part_size + bin.part_w] += diff_x;
+            bottom_trans_diff[(((n * num_classes + bin.class_id) * 2 + 1)
+                                 * part_size + bin.part_h)
+                                 * part_size + bin.part_w] += diff_y;
+          }
+        }
+      }
+    }
   }
 }  // namespace mshadow
 
@@ -31,6 +31,7 @@
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
+#include "./quantization_utils.h"
 
 namespace mxnet {
 namespace op {
@@ -55,6 +56,15 @@ struct dequantize {
   }
 };
 
+struct dequantize_symmetric {
+  template<typename DstDType, typename SrcDType>
+  MSHADOW_XINLINE static void Map(int i, DstDType *out, const SrcDType *in,
+                                  float *imin_range, float *imax_range, double max_limit) {
+    const float scale = quantization::MaxAbs(*imin_range, *imax_range) / max_limit;
+    out[i] = static_cast<DstDType>(in[i] * scale);
+  }
+};
+
 template<typename xpu>
 void DequantizeCompute(const nnvm::NodeAttrs& attrs,
                      const OpContext& ctx,
@@ -65,18 +75,24 @@ void DequantizeCompute(const nnvm::NodeAttrs& attrs,
   using namespace mxnet_op;
   Stream<xpu> *s = ctx.get_stream<xpu>();
 
-  // for now, only supports dequantize from float to uint8
-  typedef float   DstDType;
-  typedef uint8_t SrcDType;
-  double min_limit = static_cast<double>(std::numeric_limits<SrcDType>::min());
-  double max_limit = static_cast<double>(std::numeric_limits<SrcDType>::max());
-  float half_range = !std::is_signed<SrcDType>::value
-    ? 0.0f
-    : (max_limit - min_limit + 1) / 2.0;
-
-  Kernel<dequantize, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<DstDType>(),
-    inputs[0].dptr<SrcDType>(), inputs[1].dptr<float>(), inputs[2].dptr<float>(),
-    min_limit, max_limit, half_range);
+  // for now, only supports dequantize from uint8, int8 and int32 to float
+  typedef float DstDType;
+  if (inputs[0].type_flag_ == mshadow::kUint8) {
+    typedef uint8_t SrcDType;
+    double min_limit = static_cast<double>(std::numeric_limits<SrcDType>::min());
+    double max_limit = static_cast<double>(std::numeric_limits<SrcDType>::max());
+    Kernel<dequantize, xpu>::Launch(s, outputs[0].Size(), outputs[0].dptr<DstDType>(),
+      inputs[0].dptr<SrcDType>(), inputs[1].dptr<float>(), inputs[2].dptr<float>(),
+      min_limit, max_limit, 0.0f);
+  } else if (inputs[0].type_flag_ == mshadow::kInt8) {
+    Kernel<dequantize_symmetric, xpu>::Launch(s, outputs[0].Size(),
+      outputs[0].dptr<DstDType>(), inputs[0].dptr<int8_t>(), inputs[1].dptr<float>(),
+      inputs[2].dptr<float>(), static_cast<double>(quantization::kInt8Range));
+  } else {
+    Kernel<dequantize_symmetric, xpu>::Launch(s, outputs[0].Size(),
+      outputs[0].dptr<DstDType>(), inputs[0].dptr<int32_t>(), inputs[1].dptr<float>(),
+      inputs[2].dptr<float>(), quantization::kInt32Range);
+  }
 }
 
 inline bool DequantizeShape(const nnvm::NodeAttrs& attrs,
@@ -99,8 +115,9 @@ inline bool DequantizeType(const nnvm::NodeAttrs& attrs,
                          std::vector<int> *out_attrs) {
   CHECK_EQ(in_attrs->size(), 3U);
   CHECK_EQ(out_attrs->size(), 1U);
-  CHECK_EQ((*in_attrs)[0], mshadow::kUint8)
-    << "`dequantize` only supports uint8 input for now";
+  CHECK((*in_attrs)[0] == -1 || (*in_attrs)[0] == mshadow::kUint8 ||
+        (*in_attrs)[0] == mshadow::kInt8 || (*in_attrs)[0] == mshadow::kInt32)
+    << "`dequantize` only supports uint8, int8 and int32 input for now";
   CHECK_EQ((*in_attrs)[1], mshadow::kFloat32)
     << "the second input of `dequantize` should be a tensor with type of float";
   CHECK_EQ((*in_attrs)[2], mshadow::kFloat32)
@@ -28,12 +28,14 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 #include <iostream>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
+#include "./fft_cpu.h"
 
 #if MXNET_USE_CUDA
 #include <cufft.h>
@@ -215,6 +217,74 @@ class FFTOp : public Operator {
 };  // class FFTOp
 #endif  // MXNET_USE_CUDA
 
+/*!
+ * \brief CPU counterpart of FFTOp, with the same layout and the same unnormalized
+ *  transforms. The whole batch is transformed at once in parallel, so compute_size
+ *  is not used.
+ */
+template<typename DType>
+class CPUFFTOp : public Operator {
+ public:
+  explicit CPUFFTOp(FFTParam p) {
+    this->param_ = p;
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    CHECK_EQ(in_data.size(), 1);
+    CHECK_EQ(out_data.size(), 1);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const TShape& ishape = in_data[fft::kData].shape_;
+    const int n_ffts = ishape.ProdShape(0, ishape.ndim()-1);
+    const int dim = ishape[ishape.ndim()-1];
+    InitPlans(dim);
+    Tensor<cpu, 2, DType> data = in_data[fft::kData].get_with_shape<cpu, 2, DType>(
+          Shape2(n_ffts, dim), s);
+    Tensor<cpu, 2, DType> out = out_data[fft::kOutComplex].get_with_shape<cpu, 2, DType>(
+          Shape2(n_ffts, dim*2), s);
+    forward_->RealToComplex(data.dptr_, out.dptr_, n_ffts);
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    CHECK_EQ(out_grad.size(), 1);
+    CHECK(in_data.size() == 1 && in_grad.size() == 1);
+    CHECK_EQ(req.size(), 1);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const TShape& ishape = in_grad[fft::kData].shape_;
+    const int n_ffts = ishape.ProdShape(0, ishape.ndim()-1);
+    const int dim = ishape[ishape.ndim()-1];
+    InitPlans(dim);
+    Tensor<cpu, 2, DType> gdata = in_grad[fft::kData].get_with_shape<cpu, 2, DType>(
+          Shape2(n_ffts, dim), s);
+    Tensor<cpu, 2, DType> grad = out_grad[fft::kOutComplex].get_with_shape<cpu, 2, DType>(
+          Shape2(n_ffts, dim*2), s);
+    // the real part of the unnormalized inverse transform, as on GPU
+    inverse_->ComplexToReal(grad.dptr_, gdata.dptr_, n_ffts, req[fft::kData]);
+  }
+
+ private:
+  void InitPlans(int dim) {
+    if (forward_ == nullptr || forward_->size() != dim) {
+      forward_.reset(new fft::CPUPlan<DType>(dim, false));
+      inverse_.reset(new fft::CPUPlan<DType>(dim, true));
+    }
+  }
+
+  FFTParam param_;
+  std::unique_ptr<fft::CPUPlan<DType> > forward_, inverse_;
+};  // class CPUFFTOp
+
 // Declare Factory Function, used for dispatch specialization
 template<typename xpu>
 Operator* CreateOp(FFTParam param, int dtype);
@@ -0,0 +1,200 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fft_cpu.h
+ * \brief batched 1D complex FFT on CPU, used by the fft and ifft operators.
+ *  It is a mixed-radix decimation-in-time FFT with radix-4, radix-2 and generic odd radix
+ *  butterflies over precomputed twiddles. Like cuFFT it is unnormalized in both
+ *  directions, and the batch is split across OpenMP threads.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_FFT_CPU_H_
+#define MXNET_OPERATOR_CONTRIB_FFT_CPU_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/base.h>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+namespace fft {
+
+template<typename DType>
+class CPUPlan {
+ public:
+  typedef std::complex<DType> Complex;
+
+  /*!
+   * \param n length of the transform
+   * \param inverse compute sum_k x[k] exp(+2 pi i jk/n) instead of exp(-2 pi i jk/n)
+   */
+  CPUPlan(int n, bool inverse) : n_(n), inverse_(inverse), twiddles_(n) {
+    CHECK_GT(n, 0) << "FFT length must be positive";
+    const double sign = inverse ? 1.0 : -1.0;
+    for (int k = 0; k < n; ++k) {
+      // computed in double so float transforms do not accumulate the error of a recurrence
+      const double phase = sign * 2.0 * M_PI * k / n;
+      twiddles_[k] = Complex(static_cast<DType>(std::cos(phase)),
+                             static_cast<DType>(std::sin(phase)));
+    }
+    // factors as (radix, remaining length) pairs, radix 4 first, then 2, then odd radices
+    int p = 4, m = n;
+    while (m > 1) {
+      while (m % p) {
+        p = p == 4 ? 2 : (p == 2 ? 3 : p + 2);
+        if (p * p > m) p = m;
+      }
+      m /= p;
+      factors_.push_back(p);
+      factors_.push_back(m);
+    }
+  }
+
+  int size() const { return n_; }
+
+  /*! \brief transform one vector; in and out must not overlap */
+  void Execute(const Complex* in, Complex* out) const {
+    if (n_ == 1) {
+      out[0] = in[0];
+      return;
+    }
+    Work(out, in, 1, factors_.data());
+  }
+
+  /*!
+   * \brief transform `rows` real vectors of length n into interleaved complex vectors
+   *  [re0, im0, re1, im1, ...] of length 2n
+   */
+  void RealToComplex(const DType* in, DType* out, int rows) const {
+    #pragma omp parallel num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    {
+      std::vector<Complex> buffer(n_);
+      #pragma omp for
+      for (int r = 0; r < rows; ++r) {
+        const DType* src = in + static_cast<size_t>(r) * n_;
+        for (int j = 0; j < n_; ++j) buffer[j] = Complex(src[j], DType(0));
+        Execute(buffer.data(), reinterpret_cast<Complex*>(out + static_cast<size_t>(r) * 2 * n_));
+      }
+    }
+  }
+
+  /*!
+   * \brief transform `rows` interleaved complex vectors of length 2n and keep the real part,
+   *  assigned to out according to req
+   */
+  void ComplexToReal(const DType* in, DType* out, int rows, OpReqType req) const {
+    if (req == kNullOp) return;
+    #pragma omp parallel num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    {
+      std::vector<Complex> buffer(n_);
+      #pragma omp for
+      for (int r = 0; r < rows; ++r) {
+        Execute(reinterpret_cast<const Complex*>(in + static_cast<size_t>(r) * 2 * n_),
+                buffer.data());
+        DType* dst = out + static_cast<size_t>(r) * n_;
+        if (req == kAddTo) {
+          for (int j = 0; j < n_; ++j) dst[j] += buffer[j].real();
+        } else {
+          for (int j = 0; j < n_; ++j) dst[j] = buffer[j].real();
+        }
+      }
+    }
+  }
+
+ private:
+  /*!
+   * \brief out[0, p*m) = DFT of the p*m inputs in[0], in[stride], in[2*stride], ...,
+   *  computed from p sub-transforms of length m over every p-th input.
+   */
+  void Work(Complex* out, const Complex* in, int stride, const int* factors) const {
+    const int p = factors[0], m = factors[1];
+    if (m == 1) {
+      for (int q = 0; q < p; ++q) out[q] = in[q * stride];
+    } else {
+      for (int q = 0; q < p; ++q) {
+        Work(out + q * m, in + q * stride, stride * p, factors + 2);
+      }
+    }
+    switch (p) {
+      case 2: Butterfly2(out, stride, m); break;
+      case 4: Butterfly4(out, stride, m); break;
+      default: ButterflyGeneric(out, stride, m, p); break;
+    }
+  }
+
+  void Butterfly2(Complex* out, int stride, int m) const {
+    Complex* out2 = out + m;
+    for (int k = 0; k < m; ++k) {
+      const Complex t = out2[k] * twiddles_[k * stride];
+      out2[k] = out[k] - t;
+      out[k] += t;
+    }
+  }
+
+  void Butterfly4(Complex* out, int stride, int m) const {
+    for (int k = 0; k < m; ++k) {
+      const Complex s0 = out[k + m] * twiddles_[k * stride];
+      const Complex s1 = out[k + 2 * m] * twiddles_[2 * k * stride];
+      const Complex s2 = out[k + 3 * m] * twiddles_[3 * k * stride];
+      const Complex s5 = out[k] - s1;
+      const Complex s3 = s0 + s2;
+      const Complex s4 = s0 - s2;
+      out[k] += s1;
+      out[k + 2 * m] = out[k] - s3;
+      out[k] += s3;
+      // multiply s4 by -i (forward) or +i (inverse)
+      const Complex s4_rot = inverse_ ? Complex(-s4.imag(), s4.real())
+                                      : Complex(s4.imag(), -s4.real());
+      out[k + m] = s5 + s4_rot;
+      out[k + 3 * m] = s5 - s4_rot;
+    }
+  }
+
+  void ButterflyGeneric(Complex* out, int stride, int m, int p) const {
+    std::vector<Complex> scratch(p);
+    for (int u = 0; u < m; ++u) {
+      for (int q = 0; q < p; ++q) scratch[q] = out[u + q * m];
+      for (int q1 = 0; q1 < p; ++q1) {
+        const int k = u + q1 * m;
+        int twiddle = 0;
+        Complex sum = scratch[0];
+        for (int q = 1; q < p; ++q) {
+          twiddle += stride * k;
+          if (twiddle >= n_) twiddle %= n_;
+          sum += scratch[q] * twiddles_[twiddle];
+        }
+        out[k] = sum;
+      }
+    }
+  }
+
+  int n_;
+  bool inverse_;
+  std::vector<Complex> twiddles_;
+  std::vector<int> factors_;
+};
+
+}  // namespace fft
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_FFT_CPU_H_
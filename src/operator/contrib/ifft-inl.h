@@ -29,11 +29,13 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
+#include "./fft_cpu.h"
 
 #if MXNET_USE_CUDA
 #include <cufft.h>
@@ -206,6 +208,74 @@ class IFFTOp : public Operator {
 
 #endif  // MXNET_USE_CUDA
 
+/*!
+ * \brief CPU counterpart of IFFTOp, with the same layout and the same unnormalized
+ *  transforms. The whole batch is transformed at once in parallel, so compute_size
+ *  is not used.
+ */
+template<typename DType>
+class CPUIFFTOp : public Operator {
+ public:
+  explicit CPUIFFTOp(IFFTParam p) {
+    this->param_ = p;
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    CHECK_EQ(in_data.size(), 1);
+    CHECK_EQ(out_data.size(), 1);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const TShape& ishape = in_data[ifft::kData].shape_;
+    const int n_iffts = ishape.ProdShape(0, ishape.ndim()-1);
+    // remember that input is complex
+    const int dim = ishape[ishape.ndim()-1]/2;
+    InitPlans(dim);
+    Tensor<cpu, 2, DType> data = in_data[ifft::kData].get_with_shape<cpu, 2, DType>(
+          Shape2(n_iffts, dim*2), s);
+    Tensor<cpu, 2, DType> out = out_data[ifft::kOut].get_with_shape<cpu, 2, DType>(
+          Shape2(n_iffts, dim), s);
+    inverse_->ComplexToReal(data.dptr_, out.dptr_, n_iffts, req[ifft::kOut]);
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    CHECK_EQ(out_grad.size(), 1);
+    CHECK(in_data.size() == 1 && in_grad.size() == 1);
+    CHECK_EQ(req.size(), 1);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const TShape& ishape = in_grad[ifft::kData].shape_;
+    const int n_iffts = ishape.ProdShape(0, ishape.ndim()-1);
+    const int dim = ishape[ishape.ndim()-1]/2;
+    InitPlans(dim);
+    Tensor<cpu, 2, DType> gdata = in_grad[ifft::kData].get_with_shape<cpu, 2, DType>(
+          Shape2(n_iffts, dim*2), s);
+    Tensor<cpu, 2, DType> grad = out_grad[ifft::kOut].get_with_shape<cpu, 2, DType>(
+          Shape2(n_iffts, dim), s);
+    forward_->RealToComplex(grad.dptr_, gdata.dptr_, n_iffts);
+  }
+
+ private:
+  void InitPlans(int dim) {
+    if (forward_ == nullptr || forward_->size() != dim) {
+      forward_.reset(new fft::CPUPlan<DType>(dim, false));
+      inverse_.reset(new fft::CPUPlan<DType>(dim, true));
+    }
+  }
+
+  IFFTParam param_;
+  std::unique_ptr<fft::CPUPlan<DType> > forward_, inverse_;
+};  // class CPUIFFTOp
+
 // Declare Factory Function, used for dispatch specialization
 template<typename xpu>
 Operator* CreateOp(IFFTParam param, int dtype);
@@ -0,0 +1,227 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file int8_gemm.cc
+ * \brief int8 matrix products with int32 accumulation on CPU.
+ *  c is computed in kBlock x kBlock blocks of dot products along the contiguous K axis.
+ *  The AVX-512 VNNI kernel multiplies 64 unsigned by 64 signed bytes per instruction, so
+ *  signed data is offset by 128 and the offset is taken back out with the row sums of a.
+ *  pmaddubsw would saturate the pairwise sums of such products in int16, so the AVX2 kernel
+ *  widens both operands to int16 and uses pmaddwd, which is exact.
+ */
+#include "./int8_gemm.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "../../engine/openmp.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MXNET_INT8_GEMM_X86 1
+#include <immintrin.h>
+#else
+#define MXNET_INT8_GEMM_X86 0
+#endif
+
+// the avx512vnni target and cpu feature names need GCC 9 or clang 8
+#if MXNET_INT8_GEMM_X86 && \
+    ((defined(__clang__) && __clang_major__ >= 8) || (!defined(__clang__) && __GNUC__ >= 9))
+#define MXNET_INT8_GEMM_VNNI 1
+#else
+#define MXNET_INT8_GEMM_VNNI 0
+#endif
+
+namespace mxnet {
+namespace op {
+namespace int8_gemm {
+
+namespace {
+/*!
+ * \brief computes the block of c at rows [0, rows) and columns [0, cols) from the kBlock rows
+ *  of a and b, a_sums holds the row sums of a for the kernels which offset signed data
+ */
+template<typename BType>
+using BlockKernel = void (*)(const int8_t *a, const BType *b, int32_t *c, index_t K,
+                             index_t ldc, int rows, int cols, const int32_t *a_sums);
+
+template<typename BType>
+void BlockScalar(const int8_t *a, const BType *b, int32_t *c, index_t K, index_t ldc,
+                 int rows, int cols, const int32_t *a_sums) {
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      int32_t sum = 0;
+      for (index_t k = 0; k < K; ++k) {
+        sum += static_cast<int32_t>(a[i * K + k]) * static_cast<int32_t>(b[j * K + k]);
+      }
+      c[i * ldc + j] = sum;
+    }
+  }
+}
+
+#if MXNET_INT8_GEMM_X86
+__attribute__((target("avx2")))
+inline int32_t HorizontalSum8(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+
+__attribute__((target("avx2")))
+inline __m256i Widen(const int8_t *x) {
+  return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i Widen(const uint8_t *x) {
+  return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+}
+
+// two passes over kBlock x 2 blocks, which keep the accumulators in the 16 ymm registers
+template<typename BType>
+__attribute__((target("avx2")))
+void BlockAVX2(const int8_t *a, const BType *b, int32_t *c, index_t K, index_t ldc,
+               int rows, int cols, const int32_t *a_sums) {
+  for (int j0 = 0; j0 < cols; j0 += 2) {
+    __m256i acc[kBlock][2];
+    for (int i = 0; i < kBlock; ++i) {
+      acc[i][0] = _mm256_setzero_si256();
+      acc[i][1] = _mm256_setzero_si256();
+    }
+    const BType *b0 = b + j0 * K, *b1 = b0 + K;
+    for (index_t k = 0; k < K; k += 16) {
+      const __m256i vb0 = Widen(b0 + k), vb1 = Widen(b1 + k);
+      for (int i = 0; i < kBlock; ++i) {
+        const __m256i va = Widen(a + i * K + k);
+        acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(va, vb0));
+        acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(va, vb1));
+      }
+    }
+    for (int i = 0; i < rows; ++i) {
+      c[i * ldc + j0] = HorizontalSum8(acc[i][0]);
+      if (j0 + 1 < cols) c[i * ldc + j0 + 1] = HorizontalSum8(acc[i][1]);
+    }
+  }
+}
+#endif  // MXNET_INT8_GEMM_X86
+
+#if MXNET_INT8_GEMM_VNNI
+template<typename BType>
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+void BlockVNNI(const int8_t *a, const BType *b, int32_t *c, index_t K, index_t ldc,
+               int rows, int cols, const int32_t *a_sums) {
+  // signed data is offset by 128 into the unsigned operand of vpdpbusd
+  const bool offset = std::is_signed<BType>::value;
+  const __m512i flip = _mm512_set1_epi8(static_cast<char>(0x80));
+  __m512i acc[kBlock][kBlock];
+  for (int i = 0; i < kBlock; ++i) {
+    for (int j = 0; j < kBlock; ++j) acc[i][j] = _mm512_setzero_si512();
+  }
+  for (index_t k = 0; k < K; k += 64) {
+    __m512i vb[kBlock];
+    for (int j = 0; j < kBlock; ++j) {
+      vb[j] = _mm512_loadu_si512(b + j * K + k);
+      if (offset) vb[j] = _mm512_xor_si512(vb[j], flip);
+    }
+    for (int i = 0; i < kBlock; ++i) {
+      const __m512i va = _mm512_loadu_si512(a + i * K + k);
+      for (int j = 0; j < kBlock; ++j) {
+        acc[i][j] = _mm512_dpbusd_epi32(acc[i][j], vb[j], va);
+      }
+    }
+  }
+  for (int i = 0; i < rows; ++i) {
+    const int32_t correction = offset ? 128 * a_sums[i] : 0;
+    for (int j = 0; j < cols; ++j) {
+      c[i * ldc + j] = _mm512_reduce_add_epi32(acc[i][j]) - correction;
+    }
+  }
+}
+#endif  // MXNET_INT8_GEMM_VNNI
+
+struct Kernels {
+  BlockKernel<int8_t> block_s8;
+  BlockKernel<uint8_t> block_u8;
+  bool offset_s8;
+
+  Kernels() : block_s8(BlockScalar<int8_t>), block_u8(BlockScalar<uint8_t>), offset_s8(false) {
+#if MXNET_INT8_GEMM_X86
+    __builtin_cpu_init();
+#if MXNET_INT8_GEMM_VNNI
+    if (__builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw")) {
+      block_s8 = BlockVNNI<int8_t>;
+      block_u8 = BlockVNNI<uint8_t>;
+      offset_s8 = true;
+      return;
+    }
+#endif
+    if (__builtin_cpu_supports("avx2")) {
+      block_s8 = BlockAVX2<int8_t>;
+      block_u8 = BlockAVX2<uint8_t>;
+    }
+#endif
+  }
+
+  static const Kernels& Get() {
+    static const Kernels kernels;
+    return kernels;
+  }
+};
+
+template<typename BType>
+void Run(BlockKernel<BType> block, bool offset, const int8_t *a, const BType *b, int32_t *c,
+         index_t M, index_t N, index_t K, index_t ldc) {
+  const int m_blocks = static_cast<int>(RoundUp(M, kBlock) / kBlock);
+  const int n_blocks = static_cast<int>(RoundUp(N, kBlock) / kBlock);
+  std::vector<int32_t> a_sums;
+  if (offset) {
+    a_sums.resize(m_blocks * kBlock);
+    for (size_t m = 0; m < a_sums.size(); ++m) {
+      int32_t sum = 0;
+      for (index_t k = 0; k < K; ++k) sum += a[m * K + k];
+      a_sums[m] = sum;
+    }
+  }
+  // consecutive blocks share their rows of b, the rows of a are reused by every thread
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int id = 0; id < m_blocks * n_blocks; ++id) {
+    const index_t m0 = (id % m_blocks) * kBlock, n0 = (id / m_blocks) * kBlock;
+    block(a + m0 * K, b + n0 * K, c + m0 * ldc + n0, K, ldc,
+          static_cast<int>(std::min<index_t>(kBlock, M - m0)),
+          static_cast<int>(std::min<index_t>(kBlock, N - n0)),
+          offset ? a_sums.data() + m0 : NULL);
+  }
+}
+}  // namespace
+
+void Gemm(const int8_t *a, const int8_t *b, int32_t *c, index_t M, index_t N, index_t K,
+          index_t ldc) {
+  const Kernels& kernels = Kernels::Get();
+  Run(kernels.block_s8, kernels.offset_s8, a, b, c, M, N, K, ldc);
+}
+
+void Gemm(const int8_t *a, const uint8_t *b, int32_t *c, index_t M, index_t N, index_t K,
+          index_t ldc) {
+  Run(Kernels::Get().block_u8, false, a, b, c, M, N, K, ldc);
+}
+
+}  // namespace int8_gemm
+}  // namespace op
+}  // namespace mxnet
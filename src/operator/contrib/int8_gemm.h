@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file int8_gemm.h
+ * \brief int8 matrix products with int32 accumulation on CPU, used by the quantized
+ *  convolution and fully connected operators.
+ *  On x86 the AVX-512 VNNI or AVX2 kernels are picked at runtime when the CPU supports them.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_INT8_GEMM_H_
+#define MXNET_OPERATOR_CONTRIB_INT8_GEMM_H_
+
+#include <mxnet/base.h>
+#include <cstdint>
+
+namespace mxnet {
+namespace op {
+namespace int8_gemm {
+
+/*! \brief rows of both operands are zero padded to a multiple of kAlignK elements */
+const int kAlignK = 64;
+/*! \brief both operands hold a multiple of kBlock rows, the extra rows zero filled */
+const int kBlock = 4;
+
+/*! \brief the number of elements x rounded up to a multiple of align */
+inline index_t RoundUp(index_t x, index_t align) {
+  return (x + align - 1) / align * align;
+}
+
+/*!
+ * \brief c[m * ldc + n] = sum over k of a[m * K + k] * b[n * K + k], for m < M and n < N.
+ *  a holds the int8 weights, b the int8 or uint8 data, both row major with K a multiple of
+ *  kAlignK and RoundUp(M or N, kBlock) rows. The sums are exact in int32 as long as K is
+ *  at most 2^16. The blocks of c are split across OpenMP threads.
+ */
+void Gemm(const int8_t *a, const int8_t *b, int32_t *c, index_t M, index_t N, index_t K,
+          index_t ldc);
+
+void Gemm(const int8_t *a, const uint8_t *b, int32_t *c, index_t M, index_t N, index_t K,
+          index_t ldc);
+
+}  // namespace int8_gemm
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_INT8_GEMM_H_
@@ -26,6 +26,63 @@
 */
 
 #include "./multi_proposal-inl.h"
+#include <algorithm>
+#include "../../engine/openmp.h"
+
+//=====================
+// NMS Utils
+//=====================
+namespace mxnet {
+namespace op {
+namespace multi_proposal {
+
+// greedily keep the max detections of dets (num, 5), already sorted by score,
+// and stop once max_keep boxes are kept; returns the number of kept boxes
+inline int NonMaximumSuppression(const float *dets,
+                                 const int num,
+                                 const float thresh,
+                                 const int max_keep,
+                                 float *area,
+                                 char *suppressed,
+                                 int *keep) {
+  for (int i = 0; i < num; ++i) {
+    area[i] = (dets[i * 5 + 2] - dets[i * 5 + 0] + 1) *
+              (dets[i * 5 + 3] - dets[i * 5 + 1] + 1);
+    suppressed[i] = 0;
+  }
+  int out_size = 0;
+  for (int i = 0; i < num && out_size < max_keep; ++i) {
+    if (suppressed[i]) {
+      continue;
+    }
+    keep[out_size++] = i;
+    const float ix1 = dets[i * 5 + 0];
+    const float iy1 = dets[i * 5 + 1];
+    const float ix2 = dets[i * 5 + 2];
+    const float iy2 = dets[i * 5 + 3];
+    const float iarea = area[i];
+    for (int j = i + 1; j < num; ++j) {
+      if (suppressed[j]) {
+        continue;
+      }
+      const float xx1 = std::max(ix1, dets[j * 5 + 0]);
+      const float yy1 = std::max(iy1, dets[j * 5 + 1]);
+      const float xx2 = std::min(ix2, dets[j * 5 + 2]);
+      const float yy2 = std::min(iy2, dets[j * 5 + 3]);
+      const float w = std::max(0.0f, xx2 - xx1 + 1.0f);
+      const float h = std::max(0.0f, yy2 - yy1 + 1.0f);
+      const float inter = w * h;
+      if (inter / (iarea + area[j] - inter) > thresh) {
+        suppressed[j] = 1;
+      }
+    }
+  }
+  return out_size;
+}
+
+}  // namespace multi_proposal
+}  // namespace op
+}  // namespace mxnet
 
 
 namespace mxnet {
@@ -43,7 +100,162 @@ class MultiProposalOp : public Operator{
                        const std::vector<OpReqType> &req,
                        const std::vector<TBlob> &out_data,
                        const std::vector<TBlob> &aux_states) {
-    LOG(FATAL) << "not implemented";
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(in_data.size(), 3);
+    CHECK_EQ(out_data.size(), 2);
+    CHECK_GT(req.size(), 1);
+    CHECK_EQ(req[proposal::kOut], kWriteTo);
+
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<cpu, 4> scores = in_data[proposal::kClsProb].get<cpu, 4, real_t>(s);
+    Tensor<cpu, 4> bbox_deltas = in_data[proposal::kBBoxPred].get<cpu, 4, real_t>(s);
+    Tensor<cpu, 2> im_info = in_data[proposal::kImInfo].get<cpu, 2, real_t>(s);
+    Tensor<cpu, 2> out = out_data[proposal::kOut].get<cpu, 2, real_t>(s);
+    Tensor<cpu, 2> out_score = out_data[proposal::kScore].get<cpu, 2, real_t>(s);
+
+    const int num_images = scores.size(0);
+    const int num_anchors = scores.size(1) / 2;
+    const int height = scores.size(2);
+    const int width = scores.size(3);
+    const int count_anchors = num_anchors * height * width;  // count of total anchors
+    const int count = num_images * count_anchors;
+    // set to -1 for max
+    int rpn_pre_nms_top_n = (param_.rpn_pre_nms_top_n > 0) ? param_.rpn_pre_nms_top_n
+                                                           : count_anchors;
+    rpn_pre_nms_top_n = std::min(rpn_pre_nms_top_n, count_anchors);
+    const int rpn_post_nms_top_n = std::min(param_.rpn_post_nms_top_n, rpn_pre_nms_top_n);
+
+    // Generate first anchors based on base anchor
+    std::vector<float> base_anchor(4);
+    base_anchor[0] = 0.0;
+    base_anchor[1] = 0.0;
+    base_anchor[2] = param_.feature_stride - 1.0;
+    base_anchor[3] = param_.feature_stride - 1.0;
+    CHECK_EQ(num_anchors, param_.ratios.ndim() * param_.scales.ndim());
+    std::vector<float> anchors;
+    utils::GenerateAnchors(base_anchor,
+                           param_.ratios,
+                           param_.scales,
+                           &anchors);
+
+    // proposals of all images are (b, h * w * anchor, 5)
+    Tensor<cpu, 1> workspace = ctx.requested[proposal::kTempResource].get_space<cpu>(
+      Shape1(count * 5), s);
+    float *proposals = workspace.dptr_;
+    const float *score_ptr = scores.dptr_;
+    const float *delta_ptr = bbox_deltas.dptr_;
+    const float *im_info_ptr = im_info.dptr_;
+    const int feature_stride = param_.feature_stride;
+    const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+    // Shift the anchors over the feature map of every image, apply the predicted deltas,
+    // clip to the image and drop padded or too small boxes by setting their score to -1
+    #pragma omp parallel for num_threads(nthreads)
+    for (int index = 0; index < count; ++index) {
+      const int a = index % num_anchors;
+      const int w = (index / num_anchors) % width;
+      const int h = (index / num_anchors / width) % height;
+      const int b = index / num_anchors / width / height;
+      const float im_height = im_info_ptr[b * 3];
+      const float im_width = im_info_ptr[b * 3 + 1];
+      const float min_size = param_.rpn_min_size * im_info_ptr[b * 3 + 2];
+      const int real_height = static_cast<int>(im_height / feature_stride);
+      const int real_width = static_cast<int>(im_width / feature_stride);
+      const float x1 = anchors[a * 5 + 0] + w * feature_stride;
+      const float y1 = anchors[a * 5 + 1] + h * feature_stride;
+      const float x2 = anchors[a * 5 + 2] + w * feature_stride;
+      const float y2 = anchors[a * 5 + 3] + h * feature_stride;
+      const int ba = b * num_anchors + a;
+      const float d0 = delta_ptr[((ba * 4) * height + h) * width + w];
+      const float d1 = delta_ptr[((ba * 4 + 1) * height + h) * width + w];
+      const float d2 = delta_ptr[((ba * 4 + 2) * height + h) * width + w];
+      const float d3 = delta_ptr[((ba * 4 + 3) * height + h) * width + w];
+      float pred_x1, pred_y1, pred_x2, pred_y2;
+      if (param_.iou_loss) {
+        pred_x1 = x1 + d0;
+        pred_y1 = y1 + d1;
+        pred_x2 = x2 + d2;
+        pred_y2 = y2 + d3;
+      } else {
+        const float bbox_w = x2 - x1 + 1.0f;
+        const float bbox_h = y2 - y1 + 1.0f;
+        const float ctr_x = x1 + 0.5f * (bbox_w - 1.0f);
+        const float ctr_y = y1 + 0.5f * (bbox_h - 1.0f);
+        const float pred_ctr_x = d0 * bbox_w + ctr_x;
+        const float pred_ctr_y = d1 * bbox_h + ctr_y;
+        const float pred_w = std::exp(d2) * bbox_w;
+        const float pred_h = std::exp(d3) * bbox_h;
+        pred_x1 = pred_ctr_x - 0.5f * (pred_w - 1.0f);
+        pred_y1 = pred_ctr_y - 0.5f * (pred_h - 1.0f);
+        pred_x2 = pred_ctr_x + 0.5f * (pred_w - 1.0f);
+        pred_y2 = pred_ctr_y + 0.5f * (pred_h - 1.0f);
+      }
+      pred_x1 = std::max(std::min(pred_x1, im_width - 1.0f), 0.0f);
+      pred_y1 = std::max(std::min(pred_y1, im_height - 1.0f), 0.0f);
+      pred_x2 = std::max(std::min(pred_x2, im_width - 1.0f), 0.0f);
+      pred_y2 = std::max(std::min(pred_y2, im_height - 1.0f), 0.0f);
+      float score = score_ptr[((b * (2 * num_anchors) + a + num_anchors) * height + h) * width + w];
+      if (h >= real_height || w >= real_width) {
+        score = -1.0f;
+      }
+      const float iw = pred_x2 - pred_x1 + 1.0f;
+      const float ih = pred_y2 - pred_y1 + 1.0f;
+      if (iw < min_size || ih < min_size) {
+        pred_x1 -= min_size / 2;
+        pred_y1 -= min_size / 2;
+        pred_x2 += min_size / 2;
+        pred_y2 += min_size / 2;
+        score = -1.0f;
+      }
+      float *proposal = proposals + static_cast<size_t>(index) * 5;
+      proposal[0] = pred_x1;
+      proposal[1] = pred_y1;
+      proposal[2] = pred_x2;
+      proposal[3] = pred_y2;
+      proposal[4] = score;
+    }
+
+    // Every image ranks, suppresses and writes its own proposals
+    #pragma omp parallel for num_threads(std::min(nthreads, num_images))
+    for (int b = 0; b < num_images; ++b) {
+      const float *image_proposals = proposals + static_cast<size_t>(b) * count_anchors * 5;
+      // only the top rpn_pre_nms_top_n are needed; ties keep the anchor order like the
+      // stable sort on GPU
+      std::vector<int> order(count_anchors);
+      for (int i = 0; i < count_anchors; ++i) {
+        order[i] = i;
+      }
+      std::partial_sort(order.begin(), order.begin() + rpn_pre_nms_top_n, order.end(),
+                        [image_proposals](int i, int j) {
+                          const float si = image_proposals[i * 5 + 4];
+                          const float sj = image_proposals[j * 5 + 4];
+                          return si > sj || (si == sj && i < j);
+                        });
+      std::vector<float> dets(rpn_pre_nms_top_n * 5);
+      for (int i = 0; i < rpn_pre_nms_top_n; ++i) {
+        std::copy(image_proposals + order[i] * 5, image_proposals + order[i] * 5 + 5,
+                  dets.begin() + i * 5);
+      }
+
+      std::vector<float> area(rpn_pre_nms_top_n);
+      std::vector<char> suppressed(rpn_pre_nms_top_n);
+      std::vector<int> keep(rpn_post_nms_top_n);
+      const int out_size = multi_proposal::NonMaximumSuppression(
+        dets.data(), rpn_pre_nms_top_n, param_.threshold, rpn_post_nms_top_n,
+        area.data(), suppressed.data(), keep.data());
+
+      // fill in output rois and scores, repeating the kept boxes if there are too few
+      for (int i = 0; i < rpn_post_nms_top_n; ++i) {
+        const int index = keep[i < out_size ? i : i % out_size];
+        const int out_index = b * rpn_post_nms_top_n + i;
+        out[out_index][0] = b;
+        for (int j = 0; j < 4; ++j) {
+          out[out_index][j + 1] = dets[index * 5 + j];
+        }
+        out_score[out_index][0] = dets[index * 5 + 4];
+      }
+    }
   }
 
   virtual void Backward(const OpContext &ctx,
@@ -53,7 +265,19 @@ class MultiProposalOp : public Operator{
                         const std::vector<OpReqType> &req,
                         const std::vector<TBlob> &in_grad,
                         const std::vector<TBlob> &aux_states) {
-    LOG(FATAL) << "not implemented";
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(in_grad.size(), 3);
+
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<xpu, 4> gscores = in_grad[proposal::kClsProb].get<xpu, 4, real_t>(s);
+    Tensor<xpu, 4> gbbox = in_grad[proposal::kBBoxPred].get<xpu, 4, real_t>(s);
+    Tensor<xpu, 2> ginfo = in_grad[proposal::kImInfo].get<xpu, 2, real_t>(s);
+
+    // can not assume the grad would be zero
+    Assign(gscores, req[proposal::kClsProb], 0);
+    Assign(gbbox, req[proposal::kBBoxPred], 0);
+    Assign(ginfo, req[proposal::kImInfo], 0);
   }
 
  private:
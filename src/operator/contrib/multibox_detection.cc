@@ -25,6 +25,7 @@
 */
 #include "./multibox_detection-inl.h"
 #include <algorithm>
+#include "../../engine/openmp.h"
 
 namespace mshadow {
 template<typename DType>
@@ -71,11 +72,12 @@ inline void TransformLocations(DType *out, const DType *anchors,
 }
 
 template<typename DType>
-inline DType CalculateOverlap(const DType *a, const DType *b) {
+inline DType CalculateOverlap(const DType *a, const DType *b,
+                              const DType area_a, const DType area_b) {
   DType w = std::max(DType(0), std::min(a[2], b[2]) - std::max(a[0], b[0]));
   DType h = std::max(DType(0), std::min(a[3], b[3]) - std::max(a[1], b[1]));
   DType i = w * h;
-  DType u = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - i;
+  DType u = area_a + area_b - i;
   return u <= 0.f ? static_cast<DType>(0) : static_cast<DType>(i / u);
 }
 
@@ -96,6 +98,8 @@ inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
   const int num_anchors = cls_prob.size(2);
   const int num_batches = cls_prob.size(0);
   const DType *p_anchor = anchors.dptr_;
+  // images are decoded, sorted and suppressed independently, one per thread
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
   for (int nbatch = 0; nbatch < num_batches; ++nbatch) {
     const DType *p_cls_prob = cls_prob.dptr_ + nbatch * num_classes * num_anchors;
     const DType *p_loc_pred = loc_pred.dptr_ + nbatch * num_anchors * 4;
@@ -149,6 +153,12 @@ inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
         p_out[i * 6 + j] = ptemp[sorter[i].index * 6 + j];
       }
     }
+    // the copy in temp space is not needed any more, keep the box areas there
+    DType *area = ptemp;
+    for (int i = 0; i < valid_count; ++i) {
+      const DType *box = p_out + i * 6 + 2;
+      area[i] = (box[2] - box[0]) * (box[3] - box[1]);
+    }
     // apply nms
     for (int i = 0; i < valid_count; ++i) {
       int offset_i = i * 6;
@@ -158,7 +168,8 @@ inline void MultiBoxDetectionForward(const Tensor<cpu, 3, DType> &out,
         if (p_out[offset_j] < 0) continue;  // skip eliminated
         if (force_suppress || (p_out[offset_i] == p_out[offset_j])) {
           // when foce_suppress == true or class_id equals
-          DType iou = CalculateOverlap(p_out + offset_i + 2, p_out + offset_j + 2);
+          DType iou = CalculateOverlap(p_out + offset_i + 2, p_out + offset_j + 2,
+                                       area[i], area[j]);
           if (iou >= nms_threshold) {
             p_out[offset_j] = -1;
           }
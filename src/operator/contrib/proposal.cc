@@ -25,6 +25,8 @@
 */
 
 #include "./proposal-inl.h"
+#include <algorithm>
+#include "../../engine/openmp.h"
 
 //============================
 // Bounding Box Transform Utils
@@ -47,44 +49,43 @@ inline void BBoxTransformInv(const mshadow::Tensor<cpu, 2>& boxes,
   int heights = deltas.size(2);
   int widths = deltas.size(3);
 
-  for (int a = 0; a < anchors; ++a) {
-    for (int h = 0; h < heights; ++h) {
-      for (int w = 0; w < widths; ++w) {
-        index_t index = h * (widths * anchors) + w * (anchors) + a;
-        float width = boxes[index][2] - boxes[index][0] + 1.0;
-        float height = boxes[index][3] - boxes[index][1] + 1.0;
-        float ctr_x = boxes[index][0] + 0.5 * (width - 1.0);
-        float ctr_y = boxes[index][1] + 0.5 * (height - 1.0);
-
-        float dx = deltas[0][a*4 + 0][h][w];
-        float dy = deltas[0][a*4 + 1][h][w];
-        float dw = deltas[0][a*4 + 2][h][w];
-        float dh = deltas[0][a*4 + 3][h][w];
-
-        float pred_ctr_x = dx * width + ctr_x;
-        float pred_ctr_y = dy * height + ctr_y;
-        float pred_w = exp(dw) * width;
-        float pred_h = exp(dh) * height;
-
-        float pred_x1 = pred_ctr_x - 0.5 * (pred_w - 1.0);
-        float pred_y1 = pred_ctr_y - 0.5 * (pred_h - 1.0);
-        float pred_x2 = pred_ctr_x + 0.5 * (pred_w - 1.0);
-        float pred_y2 = pred_ctr_y + 0.5 * (pred_h - 1.0);
-
-        pred_x1 = std::max(std::min(pred_x1, im_width - 1.0f), 0.0f);
-        pred_y1 = std::max(std::min(pred_y1, im_height - 1.0f), 0.0f);
-        pred_x2 = std::max(std::min(pred_x2, im_width - 1.0f), 0.0f);
-        pred_y2 = std::max(std::min(pred_y2, im_height - 1.0f), 0.0f);
-
-        (*out_pred_boxes)[index][0] = pred_x1;
-        (*out_pred_boxes)[index][1] = pred_y1;
-        (*out_pred_boxes)[index][2] = pred_x2;
-        (*out_pred_boxes)[index][3] = pred_y2;
-
-        if (h >= real_height || w >= real_width) {
-          (*out_pred_boxes)[index][4] = -1.0;
-        }
-      }
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int index = 0; index < heights * widths * anchors; ++index) {
+    const int a = index % anchors;
+    const int w = index / anchors % widths;
+    const int h = index / anchors / widths;
+    float width = boxes[index][2] - boxes[index][0] + 1.0;
+    float height = boxes[index][3] - boxes[index][1] + 1.0;
+    float ctr_x = boxes[index][0] + 0.5 * (width - 1.0);
+    float ctr_y = boxes[index][1] + 0.5 * (height - 1.0);
+
+    float dx = deltas[0][a*4 + 0][h][w];
+    float dy = deltas[0][a*4 + 1][h][w];
+    float dw = deltas[0][a*4 + 2][h][w];
+    float dh = deltas[0][a*4 + 3][h][w];
+
+    float pred_ctr_x = dx * width + ctr_x;
+    float pred_ctr_y = dy * height + ctr_y;
+    float pred_w = exp(dw) * width;
+    float pred_h = exp(dh) * height;
+
+    float pred_x1 = pred_ctr_x - 0.5 * (pred_w - 1.0);
+    float pred_y1 = pred_ctr_y - 0.5 * (pred_h - 1.0);
+    float pred_x2 = pred_ctr_x + 0.5 * (pred_w - 1.0);
+    float pred_y2 = pred_ctr_y + 0.5 * (pred_h - 1.0);
+
+    pred_x1 = std::max(std::min(pred_x1, im_width - 1.0f), 0.0f);
+    pred_y1 = std::max(std::min(pred_y1, im_height - 1.0f), 0.0f);
+    pred_x2 = std::max(std::min(pred_x2, im_width - 1.0f), 0.0f);
+    pred_y2 = std::max(std::min(pred_y2, im_height - 1.0f), 0.0f);
+
+    (*out_pred_boxes)[index][0] = pred_x1;
+    (*out_pred_boxes)[index][1] = pred_y1;
+    (*out_pred_boxes)[index][2] = pred_x2;
+    (*out_pred_boxes)[index][3] = pred_y2;
+
+    if (h >= real_height || w >= real_width) {
+      (*out_pred_boxes)[index][4] = -1.0;
     }
   }
 }
@@ -103,39 +104,38 @@ inline void IoUTransformInv(const mshadow::Tensor<cpu, 2>& boxes,
   int heights = deltas.size(2);
   int widths = deltas.size(3);
 
-  for (int a = 0; a < anchors; ++a) {
-    for (int h = 0; h < heights; ++h) {
-      for (int w = 0; w < widths; ++w) {
-        index_t index = h * (widths * anchors) + w * (anchors) + a;
-        float x1 = boxes[index][0];
-        float y1 = boxes[index][1];
-        float x2 = boxes[index][2];
-        float y2 = boxes[index][3];
-
-        float dx1 = deltas[0][a * 4 + 0][h][w];
-        float dy1 = deltas[0][a * 4 + 1][h][w];
-        float dx2 = deltas[0][a * 4 + 2][h][w];
-        float dy2 = deltas[0][a * 4 + 3][h][w];
-
-        float pred_x1 = x1 + dx1;
-        float pred_y1 = y1 + dy1;
-        float pred_x2 = x2 + dx2;
-        float pred_y2 = y2 + dy2;
-
-        pred_x1 = std::max(std::min(pred_x1, im_width - 1.0f), 0.0f);
-        pred_y1 = std::max(std::min(pred_y1, im_height - 1.0f), 0.0f);
-        pred_x2 = std::max(std::min(pred_x2, im_width - 1.0f), 0.0f);
-        pred_y2 = std::max(std::min(pred_y2, im_height - 1.0f), 0.0f);
-
-        (*out_pred_boxes)[index][0] = pred_x1;
-        (*out_pred_boxes)[index][1] = pred_y1;
-        (*out_pred_boxes)[index][2] = pred_x2;
-        (*out_pred_boxes)[index][3] = pred_y2;
-
-        if (h >= real_height || w >= real_width) {
-          (*out_pred_boxes)[index][4] = -1.0f;
-        }
-      }
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int index = 0; index < heights * widths * anchors; ++index) {
+    const int a = index % anchors;
+    const int w = index / anchors % widths;
+    const int h = index / anchors / widths;
+    float x1 = boxes[index][0];
+    float y1 = boxes[index][1];
+    float x2 = boxes[index][2];
+    float y2 = boxes[index][3];
+
+    float dx1 = deltas[0][a * 4 + 0][h][w];
+    float dy1 = deltas[0][a * 4 + 1][h][w];
+    float dx2 = deltas[0][a * 4 + 2][h][w];
+    float dy2 = deltas[0][a * 4 + 3][h][w];
+
+    float pred_x1 = x1 + dx1;
+    float pred_y1 = y1 + dy1;
+    float pred_x2 = x2 + dx2;
+    float pred_y2 = y2 + dy2;
+
+    pred_x1 = std::max(std::min(pred_x1, im_width - 1.0f), 0.0f);
+    pred_y1 = std::max(std::min(pred_y1, im_height - 1.0f), 0.0f);
+    pred_x2 = std::max(std::min(pred_x2, im_width - 1.0f), 0.0f);
+    pred_y2 = std::max(std::min(pred_y2, im_height - 1.0f), 0.0f);
+
+    (*out_pred_boxes)[index][0] = pred_x1;
+    (*out_pred_boxes)[index][1] = pred_y1;
+    (*out_pred_boxes)[index][2] = pred_x2;
+    (*out_pred_boxes)[index][3] = pred_y2;
+
+    if (h >= real_height || w >= real_width) {
+      (*out_pred_boxes)[index][4] = -1.0f;
     }
   }
 }
@@ -144,7 +144,8 @@ inline void IoUTransformInv(const mshadow::Tensor<cpu, 2>& boxes,
 // * height or width < rpn_min_size
 inline void FilterBox(mshadow::Tensor<cpu, 2> *dets,
                       const float min_size) {
-  for (index_t i = 0; i < dets->size(0); i++) {
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int i = 0; i < static_cast<int>(dets->size(0)); i++) {
     float iw = (*dets)[i][2] - (*dets)[i][0] + 1.0f;
     float ih = (*dets)[i][3] - (*dets)[i][1] + 1.0f;
     if (iw < min_size || ih < min_size) {
@@ -173,8 +174,10 @@ struct ReverseArgsortCompl {
   explicit ReverseArgsortCompl(float *val)
     : val_(val) {}
   bool operator() (float i, float j) {
-    return (val_[static_cast<index_t>(i)] >
-            val_[static_cast<index_t>(j)]);
+    // ties are broken by position, which keeps the order of the stable sort used on GPU
+    const float vi = val_[static_cast<index_t>(i)];
+    const float vj = val_[static_cast<index_t>(j)];
+    return vi > vj || (vi == vj && i < j);
   }
 };
 
@@ -182,17 +185,19 @@ struct ReverseArgsortCompl {
 inline void CopyScore(const mshadow::Tensor<cpu, 2>& dets,
                       mshadow::Tensor<cpu, 1> *score,
                       mshadow::Tensor<cpu, 1> *order) {
-  for (index_t i = 0; i < dets.size(0); i++) {
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int i = 0; i < static_cast<int>(dets.size(0)); i++) {
     (*score)[i] = dets[i][4];
     (*order)[i] = i;
   }
 }
 
-// sort order array according to score
+// sort order array according to score, only the first top_n entries are ordered
 inline void ReverseArgsort(const mshadow::Tensor<cpu, 1>& score,
+                           const index_t top_n,
                            mshadow::Tensor<cpu, 1> *order) {
   ReverseArgsortCompl cmpl(score.dptr_);
-  std::sort(order->dptr_, order->dptr_ + score.size(0), cmpl);
+  std::partial_sort(order->dptr_, order->dptr_ + top_n, order->dptr_ + score.size(0), cmpl);
 }
 
 // reorder proposals according to order and keep the pre_nms_top_n proposals
@@ -202,7 +207,8 @@ inline void ReorderProposals(const mshadow::Tensor<cpu, 2>& prev_dets,
                              const index_t pre_nms_top_n,
                              mshadow::Tensor<cpu, 2> *dets) {
   CHECK_EQ(dets->size(0), pre_nms_top_n);
-  for (index_t i = 0; i < dets->size(0); i++) {
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int i = 0; i < static_cast<int>(dets->size(0)); i++) {
     const index_t index = order[i];
     for (index_t j = 0; j < dets->size(1); j++) {
       (*dets)[i][j] = prev_dets[index][j];
@@ -224,15 +230,18 @@ inline void NonMaximumSuppression(const mshadow::Tensor<cpu, 2>& dets,
   CHECK_EQ(area->CheckContiguous(), true);
   CHECK_EQ(suppressed->CheckContiguous(), true);
   CHECK_EQ(keep->CheckContiguous(), true);
+  const int num = dets.size(0);
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
   // calculate area
-  for (index_t i = 0; i < dets.size(0); ++i) {
+  #pragma omp parallel for num_threads(nthreads)
+  for (int i = 0; i < num; ++i) {
     (*area)[i] = (dets[i][2] - dets[i][0] + 1) *
                  (dets[i][3] - dets[i][1] + 1);
   }
 
-  // calculate nms
+  // calculate nms, every kept box suppresses the remaining boxes in parallel
   *out_size = 0;
-  for (index_t i = 0; i < dets.size(0) && (*out_size) < post_nms_top_n; ++i) {
+  for (int i = 0; i < num && (*out_size) < post_nms_top_n; ++i) {
     float ix1 = dets[i][0];
     float iy1 = dets[i][1];
     float ix2 = dets[i][2];
@@ -244,7 +253,8 @@ inline void NonMaximumSuppression(const mshadow::Tensor<cpu, 2>& dets,
     }
 
     (*keep)[(*out_size)++] = i;
-    for (index_t j = i + 1; j < dets.size(0); j ++) {
+    #pragma omp parallel for num_threads(nthreads)
+    for (int j = i + 1; j < num; j ++) {
       if ((*suppressed)[j] > 0.0f) {
         continue;
       }
@@ -290,7 +300,7 @@ class ProposalOp : public Operator{
     CHECK_GT(req.size(), 1);
     CHECK_EQ(req[proposal::kOut], kWriteTo);
     CHECK_EQ(in_data[proposal::kClsProb].shape_[0], 1)
-      << "Sorry, multiple images each device is not implemented.";
+      << "Sorry, multiple images each device is not implemented, use MultiProposal instead.";
 
     Stream<xpu> *s = ctx.get_stream<xpu>();
 
@@ -342,20 +352,18 @@ class ProposalOp : public Operator{
                            param_.ratios,
                            param_.scales,
                            &anchors);
-    std::memcpy(workspace_proposals.dptr_, &anchors[0], sizeof(float) * anchors.size());
 
     // Enumerate all shifted anchors
-    for (index_t i = 0; i < static_cast<index_t>(num_anchors); ++i) {
-      for (index_t j = 0; j < static_cast<index_t>(height); ++j) {
-        for (index_t k = 0; k < static_cast<index_t>(width); ++k) {
-          index_t index = j * (width * num_anchors) + k * (num_anchors) + i;
-          workspace_proposals[index][0] = workspace_proposals[i][0] + k * param_.feature_stride;
-          workspace_proposals[index][1] = workspace_proposals[i][1] + j * param_.feature_stride;
-          workspace_proposals[index][2] = workspace_proposals[i][2] + k * param_.feature_stride;
-          workspace_proposals[index][3] = workspace_proposals[i][3] + j * param_.feature_stride;
-          workspace_proposals[index][4] = scores[0][i][j][k];
-        }
-      }
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int index = 0; index < count; ++index) {
+      const int i = index % num_anchors;
+      const int k = index / num_anchors % width;
+      const int j = index / num_anchors / width;
+      workspace_proposals[index][0] = anchors[i * 5 + 0] + k * param_.feature_stride;
+      workspace_proposals[index][1] = anchors[i * 5 + 1] + j * param_.feature_stride;
+      workspace_proposals[index][2] = anchors[i * 5 + 2] + k * param_.feature_stride;
+      workspace_proposals[index][3] = anchors[i * 5 + 3] + j * param_.feature_stride;
+      workspace_proposals[index][4] = scores[0][i][j][k];
     }
 
     // prevent padded predictions
@@ -380,6 +388,7 @@ class ProposalOp : public Operator{
                      &score,
                      &order);
     utils::ReverseArgsort(score,
+                          rpn_pre_nms_top_n,
                           &order);
     utils::ReorderProposals(workspace_proposals,
                             order,
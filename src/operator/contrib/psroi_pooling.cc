@@ -31,11 +31,13 @@
 #include <mshadow/packet-inl.h>
 #include <mshadow/dot_engine-inl.h>
 #include <cassert>
+#include "../../engine/openmp.h"
 
 using std::max;
 using std::min;
 using std::floor;
 using std::ceil;
+using std::round;
 
 namespace mshadow {
 template<typename DType>
@@ -45,8 +47,72 @@ inline void PSROIPoolForward(const Tensor<cpu, 4, DType> &out,
                            const float spatial_scale_,
                            const int output_dim_,
                            const int group_size_) {
-  // NOT_IMPLEMENTED;
-  return;
+  const DType *bottom_data = data.dptr_;
+  const DType *bottom_rois = bbox.dptr_;
+  DType *top_data = out.dptr_;
+  const int num_rois = bbox.size(0);
+  const int channels = data.size(1);
+  const int height = data.size(2);
+  const int width = data.size(3);
+  const int pooled_height = out.size(2);
+  const int pooled_width = out.size(3);
+  const DType spatial_scale = static_cast<DType>(spatial_scale_);
+  // every (roi, output channel) pair writes its own pooled_height x pooled_width block
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int index = 0; index < num_rois * output_dim_; ++index) {
+    const int ctop = index % output_dim_;
+    const int n = index / output_dim_;
+
+    // [start, end) interval for spatial sampling
+    const DType* offset_bottom_rois = bottom_rois + n * 5;
+    int roi_batch_ind = offset_bottom_rois[0];
+    DType roi_start_w = static_cast<DType>(round(offset_bottom_rois[1])) * spatial_scale;
+    DType roi_start_h = static_cast<DType>(round(offset_bottom_rois[2])) * spatial_scale;
+    DType roi_end_w = static_cast<DType>(round(offset_bottom_rois[3]) + 1.) * spatial_scale;
+    DType roi_end_h = static_cast<DType>(round(offset_bottom_rois[4]) + 1.) * spatial_scale;
+
+    // Force too small ROIs to be 1x1
+    DType roi_width = max(roi_end_w - roi_start_w, static_cast<DType>(0.1));  // avoid 0
+    DType roi_height = max(roi_end_h - roi_start_h, static_cast<DType>(0.1));
+
+    // Compute w and h at bottom
+    DType bin_size_h = roi_height / static_cast<DType>(pooled_height);
+    DType bin_size_w = roi_width / static_cast<DType>(pooled_width);
+
+    DType* offset_top_data = top_data + index * pooled_height * pooled_width;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+      for (int pw = 0; pw < pooled_width; ++pw) {
+        int hstart = floor(static_cast<DType>(ph) * bin_size_h + roi_start_h);
+        int wstart = floor(static_cast<DType>(pw) * bin_size_w + roi_start_w);
+        int hend = ceil(static_cast<DType>(ph + 1) * bin_size_h + roi_start_h);
+        int wend = ceil(static_cast<DType>(pw + 1) * bin_size_w + roi_start_w);
+        // Add roi offsets and clip to input boundaries
+        hstart = min(max(hstart, 0), height);
+        hend = min(max(hend, 0), height);
+        wstart = min(max(wstart, 0), width);
+        wend = min(max(wend, 0), width);
+        bool is_empty = (hend <= hstart) || (wend <= wstart);
+
+        int gw = floor(static_cast<DType>(pw) * group_size_ / pooled_width);
+        int gh = floor(static_cast<DType>(ph) * group_size_ / pooled_height);
+        gw = min(max(gw, 0), group_size_ - 1);
+        gh = min(max(gh, 0), group_size_ - 1);
+        int c = (ctop * group_size_ + gh) * group_size_ + gw;
+
+        const DType* offset_bottom_data =
+          bottom_data + (roi_batch_ind * channels + c) * height * width;
+        DType out_sum = 0;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            out_sum += offset_bottom_data[h * width + w];
+          }
+        }
+
+        DType bin_area = (hend - hstart) * (wend - wstart);
+        offset_top_data[ph * pooled_width + pw] = is_empty ? (DType)0. : out_sum / bin_area;
+      }
+    }
+  }
 }
 
 template<typename DType>
@@ -56,8 +122,76 @@ inline void PSROIPoolBackwardAcc(const Tensor<cpu, 4, DType> &in_grad,
                             const float spatial_scale_,
                             const int output_dim_,
                             const int group_size_) {
-  // NOT_IMPLEMENTED;
-  return;
+  const DType *top_diff = out_grad.dptr_;
+  const DType *bottom_rois = bbox.dptr_;
+  DType *bottom_diff = in_grad.dptr_;
+  const int num_rois = bbox.size(0);
+  const int channels = in_grad.size(1);
+  const int height = in_grad.size(2);
+  const int width = in_grad.size(3);
+  const int pooled_height = out_grad.size(2);
+  const int pooled_width = out_grad.size(3);
+  const DType spatial_scale = static_cast<DType>(spatial_scale_);
+  // Each input channel c = (ctop * group_size + gh) * group_size + gw is only pooled by the
+  // bins of output channel ctop in group cell (gh, gw), so splitting the channels across
+  // threads lets every thread accumulate into its own planes without atomics.
+  const int bottom_channels = min(channels, output_dim_ * group_size_ * group_size_);
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int c = 0; c < bottom_channels; ++c) {
+    const int ctop = c / (group_size_ * group_size_);
+    const int cgh = (c / group_size_) % group_size_;
+    const int cgw = c % group_size_;
+    for (int n = 0; n < num_rois; ++n) {
+      // [start, end) interval for spatial sampling
+      const DType* offset_bottom_rois = bottom_rois + n * 5;
+      int roi_batch_ind = offset_bottom_rois[0];
+      DType roi_start_w = static_cast<DType>(round(offset_bottom_rois[1])) * spatial_scale;
+      DType roi_start_h = static_cast<DType>(round(offset_bottom_rois[2])) * spatial_scale;
+      DType roi_end_w = static_cast<DType>(round(offset_bottom_rois[3]) + 1.) * spatial_scale;
+      DType roi_end_h = static_cast<DType>(round(offset_bottom_rois[4]) + 1.) * spatial_scale;
+
+      // Force too small ROIs to be 1x1
+      DType roi_width = max(roi_end_w - roi_start_w, static_cast<DType>(0.1));  // avoid 0
+      DType roi_height = max(roi_end_h - roi_start_h, static_cast<DType>(0.1));
+
+      // Compute w and h at bottom
+      DType bin_size_h = roi_height / static_cast<DType>(pooled_height);
+      DType bin_size_w = roi_width / static_cast<DType>(pooled_width);
+
+      DType* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels + c) * height * width;
+      const DType* offset_top_diff =
+        top_diff + (n * output_dim_ + ctop) * pooled_height * pooled_width;
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        int gh = floor(static_cast<DType>(ph) * group_size_ / pooled_height);
+        gh = min(max(gh, 0), group_size_ - 1);
+        if (gh != cgh) continue;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          int gw = floor(static_cast<DType>(pw) * group_size_ / pooled_width);
+          gw = min(max(gw, 0), group_size_ - 1);
+          if (gw != cgw) continue;
+
+          int hstart = floor(static_cast<DType>(ph) * bin_size_h + roi_start_h);
+          int wstart = floor(static_cast<DType>(pw) * bin_size_w + roi_start_w);
+          int hend = ceil(static_cast<DType>(ph + 1) * bin_size_h + roi_start_h);
+          int wend = ceil(static_cast<DType>(pw + 1) * bin_size_w + roi_start_w);
+          // Add roi offsets and clip to input boundaries
+          hstart = min(max(hstart, 0), height);
+          hend = min(max(hend, 0), height);
+          wstart = min(max(wstart, 0), width);
+          wend = min(max(wend, 0), width);
+          if ((hend <= hstart) || (wend <= wstart)) continue;
+
+          DType bin_area = (hend - hstart) * (wend - wstart);
+          DType diff_val = offset_top_diff[ph * pooled_width + pw] / bin_area;
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              offset_bottom_diff[h * width + w] += diff_val;
+            }
+          }
+        }
+      }
+    }
+  }
 }
 }  // namespace mshadow
 
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantization_utils.h
+ * \brief range conventions shared by the quantized operators.
+ *  A quantized tensor travels with two float scalars min_range and max_range.
+ *  int8 and int32 tensors are symmetric: q represents q * R / 127 or q * R / (2^31 - 1),
+ *  where R = max(|min_range|, |max_range|). uint8 tensors represent
+ *  min_range + q * (max_range - min_range) / 255, and the quantized compute operators
+ *  require min_range == 0 for them so that the zero point is 0.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZATION_UTILS_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZATION_UTILS_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+namespace quantization {
+
+/*! \brief largest magnitude of a symmetric int8 tensor, -128 is never produced */
+const float kInt8Range = 127.0f;
+/*! \brief largest magnitude of a symmetric int32 tensor */
+const double kInt32Range = 2147483647.0;
+
+/*! \brief the magnitude R of the symmetric range covering [min_range, max_range] */
+MSHADOW_XINLINE float MaxAbs(float min_range, float max_range) {
+  return fmaxf(fabsf(min_range), fabsf(max_range));
+}
+
+/*! \brief round to nearest and saturate to [-limit, limit] */
+MSHADOW_XINLINE float RoundClamp(float x, float limit) {
+  return fminf(fmaxf(roundf(x), -limit), limit);
+}
+
+/*! \brief the real value of one quantized level of a tensor of type type_flag */
+inline double QuantizedUnit(int type_flag, float min_range, float max_range) {
+  switch (type_flag) {
+    case mshadow::kInt8:
+      return MaxAbs(min_range, max_range) / kInt8Range;
+    case mshadow::kUint8:
+      CHECK_EQ(min_range, 0.0f)
+        << "uint8 inputs of quantized operators must have min_range 0, got " << min_range;
+      return max_range / 255.0;
+    case mshadow::kInt32:
+      return MaxAbs(min_range, max_range) / kInt32Range;
+    default:
+      LOG(FATAL) << "unsupported quantized type " << type_flag;
+  }
+  return 0.0;
+}
+
+/*! \brief assigns shape (1,) to the range arguments [begin, end) */
+inline void AssignRangeShapes(std::vector<TShape> *shapes, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    SHAPE_ASSIGN_CHECK(*shapes, i, TShape{1});
+  }
+}
+
+/*! \brief assigns float32 to the range arguments [begin, end) */
+inline void AssignRangeTypes(std::vector<int> *types, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    TYPE_ASSIGN_CHECK(*types, i, mshadow::kFloat32);
+  }
+}
+
+/*! \brief checks that a data input is int8 or uint8, false while it is still unknown */
+inline bool CheckDataType(const std::vector<int> &types, size_t i, const char *op) {
+  if (types[i] == -1) return false;
+  CHECK(types[i] == mshadow::kInt8 || types[i] == mshadow::kUint8)
+    << op << " only supports int8 and uint8 data, got type " << types[i];
+  return true;
+}
+
+}  // namespace quantization
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZATION_UTILS_H_
@@ -31,6 +31,7 @@
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
+#include "./quantization_utils.h"
 
 namespace mxnet {
 namespace op {
@@ -40,8 +41,10 @@ struct QuantizeParam : public dmlc::Parameter<QuantizeParam> {
   DMLC_DECLARE_PARAMETER(QuantizeParam) {
     DMLC_DECLARE_FIELD(out_type)
     .add_enum("uint8", mshadow::kUint8)
+    .add_enum("int8", mshadow::kInt8)
     .set_default(mshadow::kUint8)
-    .describe("Output data type.");
+    .describe("Output data type. uint8 maps [min_range, max_range] onto [0, 255], int8 maps "
+              "[-R, R] onto [-127, 127] with R = max(|min_range|, |max_range|).");
   }
 };
 
@@ -52,12 +55,28 @@ struct quantize {
                                   const float *imin_range, const float *imax_range,
                                   double min_limit, double max_limit) {
     float scale = (max_limit - min_limit) / (*imax_range - *imin_range);
-    out[i] = static_cast<DstDType>((in[i] - *imin_range) * scale + 0.5);
+    // values outside of the range, e.g. beyond a calibrated range, saturate instead of wrapping
+    out[i] = static_cast<DstDType>(fminf(fmaxf((in[i] - *imin_range) * scale + 0.5,
+                                               min_limit), max_limit));
     *omin_range = *imin_range;
     *omax_range = *imax_range;
   }
 };
 
+struct quantize_symmetric {
+  template<typename DstDType, typename SrcDType>
+  MSHADOW_XINLINE static void Map(int i, DstDType *out, float *omin_range,
+                                  float *omax_range, const SrcDType *in,
+                                  const float *imin_range, const float *imax_range,
+                                  float max_limit) {
+    const float real_range = quantization::MaxAbs(*imin_range, *imax_range);
+    const float scale = real_range > 0.0f ? max_limit / real_range : 0.0f;
+    out[i] = static_cast<DstDType>(quantization::RoundClamp(in[i] * scale, max_limit));
+    *omin_range = -real_range;
+    *omax_range = real_range;
+  }
+};
+
 template<typename xpu>
 void QuantizeCompute(const nnvm::NodeAttrs& attrs,
                      const OpContext& ctx,
@@ -67,15 +86,23 @@ void QuantizeCompute(const nnvm::NodeAttrs& attrs,
   using namespace mshadow;
   using namespace mxnet_op;
   Stream<xpu> *s = ctx.get_stream<xpu>();
+  const QuantizeParam& param = nnvm::get<QuantizeParam>(attrs.parsed);
 
-  // for now, only supports quantize from uint8 to float
-  // TODO(ziheng) consider add MSHADOW_INTEGER_TYPE_SWITCH
-  typedef uint8_t DstDType;
+  // for now, only supports quantize from float to uint8 or int8
   typedef float SrcDType;
-  Kernel<quantize, xpu>::Launch(s, outputs[0].Size(),
-    outputs[0].dptr<DstDType>(), outputs[1].dptr<float>(), outputs[2].dptr<float>(),
-    inputs[0].dptr<SrcDType>(), inputs[1].dptr<float>(), inputs[2].dptr<float>(),
-    std::numeric_limits<DstDType>::min(), std::numeric_limits<DstDType>::max());
+  if (param.out_type == mshadow::kUint8) {
+    typedef uint8_t DstDType;
+    Kernel<quantize, xpu>::Launch(s, outputs[0].Size(),
+      outputs[0].dptr<DstDType>(), outputs[1].dptr<float>(), outputs[2].dptr<float>(),
+      inputs[0].dptr<SrcDType>(), inputs[1].dptr<float>(), inputs[2].dptr<float>(),
+      std::numeric_limits<DstDType>::min(), std::numeric_limits<DstDType>::max());
+  } else {
+    typedef int8_t DstDType;
+    Kernel<quantize_symmetric, xpu>::Launch(s, outputs[0].Size(),
+      outputs[0].dptr<DstDType>(), outputs[1].dptr<float>(), outputs[2].dptr<float>(),
+      inputs[0].dptr<SrcDType>(), inputs[1].dptr<float>(), inputs[2].dptr<float>(),
+      quantization::kInt8Range);
+  }
 }
 
 inline bool QuantizeShape(const nnvm::NodeAttrs& attrs,
@@ -106,7 +133,8 @@ inline bool QuantizeType(const nnvm::NodeAttrs& attrs,
     << "the second input of `quantize` should be a tensor with type of float";
   CHECK_EQ((*in_attrs)[2], mshadow::kFloat32)
     << "the third input of `quantize` should be a tensor with type of float";
-  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kUint8);
+  const QuantizeParam& param = nnvm::get<QuantizeParam>(attrs.parsed);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, param.out_type);
   TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kFloat32);
   TYPE_ASSIGN_CHECK(*out_attrs, 2, mshadow::kFloat32);
   return (*in_attrs)[0] != -1;
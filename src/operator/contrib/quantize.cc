@@ -37,7 +37,18 @@ the input data. Each value of the tensor will undergo the following:
 
 `out[i] = (in[i] - min_range) * range(OUTPUT_TYPE) / (max_range - min_range)`
 
-here `range(T) = numeric_limits<T>::max() - numeric_limits<T>::min()`
+here `range(T) = numeric_limits<T>::max() - numeric_limits<T>::min()`, and the output
+ranges are copies of the input ranges.
+
+With `out_type` int8 the quantization is symmetric around zero:
+
+`out[i] = round(in[i] * 127 / max(abs(min_range), abs(max_range)))`
+
+and the output ranges are `-max(abs(min_range), abs(max_range))` and
+`max(abs(min_range), abs(max_range))`. This is the representation consumed by the quantized
+convolution and fully connected operators.
+
+Values outside of the range saturate.
 )code" ADD_FILELINE)
 .set_attr_parser(ParamParser<QuantizeParam>)
 .set_num_inputs(3)
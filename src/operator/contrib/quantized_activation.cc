@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_activation.cc
+ * \brief relu of int8 or uint8 data, which keeps the input range
+ */
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "./quantization_utils.h"
+#include "../nn/activation-inl.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+void QuantizedActivationParamParser(nnvm::NodeAttrs* attrs) {
+  ActivationParam param;
+  param.Init(attrs->dict);
+  CHECK_EQ(param.act_type, activation::kReLU) << "quantized_act only supports relu";
+  attrs->parsed = std::move(param);
+}
+
+bool QuantizedActivationShape(const nnvm::NodeAttrs& attrs,
+                              std::vector<TShape> *in_shape,
+                              std::vector<TShape> *out_shape) {
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 3U);
+  quantization::AssignRangeShapes(in_shape, 1, 3);
+  quantization::AssignRangeShapes(out_shape, 1, 3);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, in_shape->at(0));
+  SHAPE_ASSIGN_CHECK(*in_shape, 0, out_shape->at(0));
+  return !shape_is_none(in_shape->at(0));
+}
+
+bool QuantizedActivationType(const nnvm::NodeAttrs& attrs,
+                             std::vector<int> *in_type,
+                             std::vector<int> *out_type) {
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 3U);
+  quantization::AssignRangeTypes(in_type, 1, 3);
+  quantization::AssignRangeTypes(out_type, 1, 3);
+  if (!quantization::CheckDataType(*in_type, 0, "quantized_act")) return false;
+  TYPE_ASSIGN_CHECK(*out_type, 0, in_type->at(0));
+  return true;
+}
+
+void QuantizedActivationForward(const nnvm::NodeAttrs& attrs,
+                                const OpContext& ctx,
+                                const std::vector<TBlob>& inputs,
+                                const std::vector<OpReqType>& req,
+                                const std::vector<TBlob>& outputs) {
+  CHECK_EQ(req[0], kWriteTo) << "quantized_act only supports req kWriteTo";
+  const int size = static_cast<int>(inputs[0].Size());
+  if (inputs[0].type_flag_ == mshadow::kUint8) {
+    // with min_range 0 every uint8 level is already non-negative
+    const float min_range = *inputs[1].dptr<float>();
+    CHECK_EQ(min_range, 0.0f)
+      << "uint8 inputs of quantized operators must have min_range 0, got " << min_range;
+    std::copy(inputs[0].dptr<uint8_t>(), inputs[0].dptr<uint8_t>() + size,
+              outputs[0].dptr<uint8_t>());
+  } else {
+    const int8_t *in = inputs[0].dptr<int8_t>();
+    int8_t *out = outputs[0].dptr<int8_t>();
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int i = 0; i < size; ++i) {
+      out[i] = std::max<int8_t>(in[i], 0);
+    }
+  }
+  *outputs[1].dptr<float>() = *inputs[1].dptr<float>();
+  *outputs[2].dptr<float>() = *inputs[2].dptr<float>();
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_act)
+.describe(R"code(Activation of quantized data, only `act_type` relu is supported.
+
+`data` is int8, or uint8 with `min_data` 0, the output has the same type and range as the
+input.
+)code" ADD_FILELINE)
+.set_attr_parser(QuantizedActivationParamParser)
+.set_num_inputs(3)
+.set_num_outputs(3)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "min_data", "max_data"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedActivationShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedActivationType)
+.set_attr<FCompute>("FCompute<cpu>", QuantizedActivationForward)
+.add_argument("data", "NDArray-or-Symbol", "Input data, int8 or uint8")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data")
+.add_arguments(ActivationParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,270 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_conv.cc
+ * \brief 2D convolution of int8 or uint8 data with int8 weights and int32 output.
+ *  Each image is unrolled into zero padded patch rows, so that every output channel of a
+ *  group is one int8 GEMM against the filters of that group.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "./int8_gemm.h"
+#include "./quantization_utils.h"
+#include "../nn/convolution-inl.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+namespace qconv {
+enum QuantizedConvInputs {kData, kWeight, kBias};
+}  // namespace qconv
+
+void QuantizedConvParamParser(nnvm::NodeAttrs* attrs) {
+  ConvolutionParam param;
+  param.Init(attrs->dict);
+  CHECK_EQ(param.kernel.ndim(), 2U) << "quantized_conv only supports 2D convolution";
+  CHECK(!param.layout.has_value() || param.layout.value() == mshadow::kNCHW)
+    << "quantized_conv only supports the NCHW layout";
+  param.layout = mshadow::kNCHW;
+  if (param.stride.ndim() == 0) param.stride = mshadow::Shape2(1, 1);
+  if (param.dilate.ndim() == 0) param.dilate = mshadow::Shape2(1, 1);
+  if (param.pad.ndim() == 0) param.pad = mshadow::Shape2(0, 0);
+  attrs->parsed = std::move(param);
+}
+
+/*! \brief number of tensor arguments, which precede their min and max ranges */
+inline uint32_t QuantizedConvNumTensors(const nnvm::NodeAttrs& attrs) {
+  return nnvm::get<ConvolutionParam>(attrs.parsed).no_bias ? 2 : 3;
+}
+
+bool QuantizedConvShape(const nnvm::NodeAttrs& attrs,
+                        std::vector<TShape> *in_shape,
+                        std::vector<TShape> *out_shape) {
+  const ConvolutionParam& param = nnvm::get<ConvolutionParam>(attrs.parsed);
+  const uint32_t num_tensors = QuantizedConvNumTensors(attrs);
+  CHECK_EQ(in_shape->size(), num_tensors * 3);
+  CHECK_EQ(out_shape->size(), 3U);
+  quantization::AssignRangeShapes(in_shape, num_tensors, in_shape->size());
+  quantization::AssignRangeShapes(out_shape, 1, 3);
+  const TShape& dshape = in_shape->at(qconv::kData);
+  if (shape_is_none(dshape)) return false;
+  CHECK_EQ(dshape.ndim(), 4U) << "quantized_conv: data should be 4D in (batch, channel, y, x)";
+  CHECK_EQ(dshape[1] % param.num_group, 0U) << "num_group must divide the input channels";
+  CHECK_EQ(param.num_filter % param.num_group, 0U) << "num_group must divide num_filter";
+  SHAPE_ASSIGN_CHECK(*in_shape, qconv::kWeight,
+                     mshadow::Shape4(param.num_filter, dshape[1] / param.num_group,
+                                     param.kernel[0], param.kernel[1]));
+  if (!param.no_bias) {
+    SHAPE_ASSIGN_CHECK(*in_shape, qconv::kBias, mshadow::Shape1(param.num_filter));
+  }
+  const index_t dilated_h = param.DilatedKernelSize(0), dilated_w = param.DilatedKernelSize(1);
+  CHECK_LE(dilated_h, dshape[2] + 2 * param.pad[0]) << "kernel size exceeds input";
+  CHECK_LE(dilated_w, dshape[3] + 2 * param.pad[1]) << "kernel size exceeds input";
+  const index_t out_h = (dshape[2] + 2 * param.pad[0] - dilated_h) / param.stride[0] + 1;
+  const index_t out_w = (dshape[3] + 2 * param.pad[1] - dilated_w) / param.stride[1] + 1;
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, mshadow::Shape4(dshape[0], param.num_filter, out_h, out_w));
+  return true;
+}
+
+bool QuantizedConvType(const nnvm::NodeAttrs& attrs,
+                       std::vector<int> *in_type,
+                       std::vector<int> *out_type) {
+  const uint32_t num_tensors = QuantizedConvNumTensors(attrs);
+  CHECK_EQ(in_type->size(), num_tensors * 3);
+  CHECK_EQ(out_type->size(), 3U);
+  for (uint32_t i = qconv::kWeight; i < num_tensors; ++i) {
+    TYPE_ASSIGN_CHECK(*in_type, i, mshadow::kInt8);
+  }
+  quantization::AssignRangeTypes(in_type, num_tensors, in_type->size());
+  TYPE_ASSIGN_CHECK(*out_type, 0, mshadow::kInt32);
+  quantization::AssignRangeTypes(out_type, 1, 3);
+  return quantization::CheckDataType(*in_type, qconv::kData, "quantized_conv");
+}
+
+template<typename DType>
+void QuantizedConvCompute(const ConvolutionParam& param, const OpContext& ctx,
+                          const std::vector<TBlob>& inputs, const std::vector<int32_t>& bias,
+                          const TBlob& output) {
+  using int8_gemm::RoundUp;
+  const TShape& ishape = inputs[qconv::kData].shape_;
+  const TShape& oshape = output.shape_;
+  const int group = param.num_group;
+  const index_t channels = ishape[1] / group, filters = param.num_filter / group;
+  const index_t height = ishape[2], width = ishape[3];
+  const index_t out_width = oshape[3], patches = oshape[2] * oshape[3];
+  const index_t kernel_h = param.kernel[0], kernel_w = param.kernel[1];
+  const index_t K = channels * kernel_h * kernel_w;
+  const index_t K_pad = RoundUp(K, int8_gemm::kAlignK);
+  CHECK_LE(K_pad, 1U << 16) << "quantized_conv: too many inputs per filter for int32 sums";
+  const index_t filter_rows = RoundUp(filters, int8_gemm::kBlock);
+  const index_t patch_rows = RoundUp(patches, int8_gemm::kBlock);
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  // the filters of each group padded to filter_rows x K_pad, then the patches of one image
+  const size_t weight_bytes = static_cast<size_t>(group) * filter_rows * K_pad;
+  const size_t patch_bytes = static_cast<size_t>(patch_rows) * K_pad * sizeof(DType);
+  mshadow::Tensor<cpu, 1, char> workspace = ctx.requested[0].get_space_typed<cpu, 1, char>(
+      mshadow::Shape1(weight_bytes + patch_bytes), ctx.get_stream<cpu>());
+  int8_t *packed_weight = reinterpret_cast<int8_t*>(workspace.dptr_);
+  DType *patch = reinterpret_cast<DType*>(workspace.dptr_ + weight_bytes);
+  std::memset(workspace.dptr_, 0, weight_bytes + patch_bytes);
+  const int8_t *weight = inputs[qconv::kWeight].dptr<int8_t>();
+  for (index_t f = 0; f < param.num_filter; ++f) {
+    std::memcpy(packed_weight + ((f / filters) * filter_rows + f % filters) * K_pad,
+                weight + f * K, K);
+  }
+
+  const DType *in = inputs[qconv::kData].dptr<DType>();
+  int32_t *out = output.dptr<int32_t>();
+  const int stride_h = param.stride[0], stride_w = param.stride[1];
+  const int dilate_h = param.dilate[0], dilate_w = param.dilate[1];
+  const int pad_h = param.pad[0], pad_w = param.pad[1];
+  for (index_t n = 0; n < ishape[0]; ++n) {
+    for (int g = 0; g < group; ++g) {
+      const DType *in_group = in + (n * ishape[1] + g * channels) * height * width;
+      #pragma omp parallel for num_threads(omp_threads)
+      for (int p = 0; p < static_cast<int>(patches); ++p) {
+        const int h0 = p / static_cast<int>(out_width) * stride_h - pad_h;
+        const int w0 = p % static_cast<int>(out_width) * stride_w - pad_w;
+        DType *row = patch + p * K_pad;
+        for (int c = 0; c < static_cast<int>(channels); ++c) {
+          const DType *in_channel = in_group + c * height * width;
+          for (int kh = 0; kh < static_cast<int>(kernel_h); ++kh) {
+            const int h = h0 + kh * dilate_h;
+            for (int kw = 0; kw < static_cast<int>(kernel_w); ++kw) {
+              const int w = w0 + kw * dilate_w;
+              *row++ = h >= 0 && h < static_cast<int>(height) &&
+                       w >= 0 && w < static_cast<int>(width)
+                       ? in_channel[h * width + w] : DType(0);
+            }
+          }
+        }
+      }
+      int32_t *out_group = out + (n * param.num_filter + g * filters) * patches;
+      int8_gemm::Gemm(packed_weight + g * filter_rows * K_pad, patch, out_group,
+                      filters, patches, K_pad, patches);
+      if (!bias.empty()) {
+        #pragma omp parallel for num_threads(omp_threads)
+        for (int f = 0; f < static_cast<int>(filters); ++f) {
+          const int32_t b = bias[g * filters + f];
+          for (index_t p = 0; p < patches; ++p) out_group[f * patches + p] += b;
+        }
+      }
+    }
+  }
+}
+
+void QuantizedConvForward(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  const ConvolutionParam& param = nnvm::get<ConvolutionParam>(attrs.parsed);
+  CHECK_EQ(req[0], kWriteTo) << "quantized_conv only supports req kWriteTo";
+  const uint32_t num_tensors = QuantizedConvNumTensors(attrs);
+  auto range = [&](uint32_t tensor, int which) {
+    return *inputs[num_tensors + 2 * tensor + which].dptr<float>();
+  };
+  const double data_unit = quantization::QuantizedUnit(inputs[qconv::kData].type_flag_,
+                                                       range(qconv::kData, 0),
+                                                       range(qconv::kData, 1));
+  const double weight_unit = quantization::QuantizedUnit(mshadow::kInt8,
+                                                         range(qconv::kWeight, 0),
+                                                         range(qconv::kWeight, 1));
+  const double out_unit = data_unit * weight_unit;
+  std::vector<int32_t> bias;
+  if (!param.no_bias) {
+    // bias has its own int8 range and is moved to the units of the output
+    const double bias_unit = quantization::QuantizedUnit(mshadow::kInt8,
+                                                         range(qconv::kBias, 0),
+                                                         range(qconv::kBias, 1));
+    const double scale = out_unit > 0.0 ? bias_unit / out_unit : 0.0;
+    const int8_t *b = inputs[qconv::kBias].dptr<int8_t>();
+    bias.resize(param.num_filter);
+    for (index_t f = 0; f < param.num_filter; ++f) {
+      bias[f] = static_cast<int32_t>(std::max(std::min(std::round(b[f] * scale),
+                                                        quantization::kInt32Range),
+                                               -quantization::kInt32Range));
+    }
+  }
+  if (inputs[qconv::kData].type_flag_ == mshadow::kUint8) {
+    QuantizedConvCompute<uint8_t>(param, ctx, inputs, bias, outputs[0]);
+  } else {
+    QuantizedConvCompute<int8_t>(param, ctx, inputs, bias, outputs[0]);
+  }
+  *outputs[1].dptr<float>() = -out_unit * quantization::kInt32Range;
+  *outputs[2].dptr<float>() = out_unit * quantization::kInt32Range;
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_conv)
+.describe(R"code(2D convolution of quantized data, with int32 accumulation and output.
+
+Takes the same parameters as `Convolution`, restricted to 2D kernels and the NCHW layout.
+`data` is int8, or uint8 with `min_data` 0, `weight` and `bias` are int8 with the symmetric
+ranges produced by `quantize` with `out_type` int8. The int32 output represents
+`out[i] * max(abs(min_output), abs(max_output)) / (2^31 - 1)` and is exact: the ranges are
+chosen so that one output level is the product of one data level and one weight level.
+Use `requantize` to narrow it back to int8, or `dequantize` to convert it into float32.
+
+On x86 CPUs the products run on AVX-512 VNNI or AVX2 when the CPU supports them.
+)code" ADD_FILELINE)
+.set_attr_parser(QuantizedConvParamParser)
+.set_num_inputs([](const nnvm::NodeAttrs& attrs) {
+    return QuantizedConvNumTensors(attrs) * 3;
+  })
+.set_num_outputs(3)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    if (nnvm::get<ConvolutionParam>(attrs.parsed).no_bias) {
+      return std::vector<std::string>{"data", "weight", "min_data", "max_data",
+                                      "min_weight", "max_weight"};
+    }
+    return std::vector<std::string>{"data", "weight", "bias", "min_data", "max_data",
+                                    "min_weight", "max_weight", "min_bias", "max_bias"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedConvShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedConvType)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedConvForward)
+.add_argument("data", "NDArray-or-Symbol", "Input data, int8 or uint8")
+.add_argument("weight", "NDArray-or-Symbol", "int8 weight")
+.add_argument("bias", "NDArray-or-Symbol", "int8 bias")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data")
+.add_argument("min_weight", "NDArray-or-Symbol", "Minimum value of weight")
+.add_argument("max_weight", "NDArray-or-Symbol", "Maximum value of weight")
+.add_argument("min_bias", "NDArray-or-Symbol", "Minimum value of bias")
+.add_argument("max_bias", "NDArray-or-Symbol", "Maximum value of bias")
+.add_arguments(ConvolutionParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_flatten.cc
+ * \brief flattens int8 or uint8 data, which keeps the input range
+ */
+#include <cstring>
+#include <string>
+#include <vector>
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+bool QuantizedFlattenShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape> *in_shape,
+                           std::vector<TShape> *out_shape) {
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 3U);
+  quantization::AssignRangeShapes(in_shape, 1, 3);
+  quantization::AssignRangeShapes(out_shape, 1, 3);
+  const TShape& dshape = in_shape->at(0);
+  if (shape_is_none(dshape)) return false;
+  SHAPE_ASSIGN_CHECK(*out_shape, 0,
+                     mshadow::Shape2(dshape[0], dshape.ProdShape(1, dshape.ndim())));
+  return true;
+}
+
+bool QuantizedFlattenType(const nnvm::NodeAttrs& attrs,
+                          std::vector<int> *in_type,
+                          std::vector<int> *out_type) {
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 3U);
+  quantization::AssignRangeTypes(in_type, 1, 3);
+  quantization::AssignRangeTypes(out_type, 1, 3);
+  if (!quantization::CheckDataType(*in_type, 0, "quantized_flatten")) return false;
+  TYPE_ASSIGN_CHECK(*out_type, 0, in_type->at(0));
+  return true;
+}
+
+void QuantizedFlattenForward(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+  if (req[0] != kWriteInplace) {
+    CHECK_EQ(req[0], kWriteTo) << "quantized_flatten only supports req kWriteTo";
+    std::memcpy(outputs[0].dptr_, inputs[0].dptr_, inputs[0].Size());
+  }
+  *outputs[1].dptr<float>() = *inputs[1].dptr<float>();
+  *outputs[2].dptr<float>() = *inputs[2].dptr<float>();
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_flatten)
+.describe(R"code(Flattens quantized data into 2D like `Flatten`.
+
+`data` is int8 or uint8, the output has the same type and range as the input.
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(3)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "min_data", "max_data"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedFlattenShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedFlattenType)
+.set_attr<nnvm::FInplaceOption>("FInplaceOption",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::pair<int, int> >{{0, 0}};
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedFlattenForward)
+.add_argument("data", "NDArray-or-Symbol", "Input data, int8 or uint8")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data");
+
+}  // namespace op
+}  // namespace mxnet
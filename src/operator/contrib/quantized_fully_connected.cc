@@ -0,0 +1,223 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_fully_connected.cc
+ * \brief fully connected layer on int8 or uint8 data with int8 weights and int32 output
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "./int8_gemm.h"
+#include "./quantization_utils.h"
+#include "../nn/fully_connected-inl.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+namespace qfc {
+enum QuantizedFullyConnectedInputs {kData, kWeight, kBias};
+}  // namespace qfc
+
+/*! \brief number of tensor arguments, which precede their min and max ranges */
+inline uint32_t QuantizedFullyConnectedNumTensors(const nnvm::NodeAttrs& attrs) {
+  return nnvm::get<FullyConnectedParam>(attrs.parsed).no_bias ? 2 : 3;
+}
+
+bool QuantizedFullyConnectedShape(const nnvm::NodeAttrs& attrs,
+                                  std::vector<TShape> *in_shape,
+                                  std::vector<TShape> *out_shape) {
+  const FullyConnectedParam& param = nnvm::get<FullyConnectedParam>(attrs.parsed);
+  const uint32_t num_tensors = QuantizedFullyConnectedNumTensors(attrs);
+  CHECK_EQ(in_shape->size(), num_tensors * 3);
+  CHECK_EQ(out_shape->size(), 3U);
+  quantization::AssignRangeShapes(in_shape, num_tensors, in_shape->size());
+  quantization::AssignRangeShapes(out_shape, 1, 3);
+  const TShape& dshape = in_shape->at(qfc::kData);
+  if (shape_is_none(dshape)) return false;
+  index_t num_input;
+  TShape oshape = dshape;
+  if (param.flatten) {
+    num_input = dshape.ProdShape(1, dshape.ndim());
+    oshape = mshadow::Shape2(dshape[0], param.num_hidden);
+  } else {
+    num_input = dshape[dshape.ndim() - 1];
+    oshape[dshape.ndim() - 1] = param.num_hidden;
+  }
+  SHAPE_ASSIGN_CHECK(*in_shape, qfc::kWeight, mshadow::Shape2(param.num_hidden, num_input));
+  if (!param.no_bias) {
+    SHAPE_ASSIGN_CHECK(*in_shape, qfc::kBias, mshadow::Shape1(param.num_hidden));
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  return true;
+}
+
+bool QuantizedFullyConnectedType(const nnvm::NodeAttrs& attrs,
+                                 std::vector<int> *in_type,
+                                 std::vector<int> *out_type) {
+  const uint32_t num_tensors = QuantizedFullyConnectedNumTensors(attrs);
+  CHECK_EQ(in_type->size(), num_tensors * 3);
+  CHECK_EQ(out_type->size(), 3U);
+  for (uint32_t i = qfc::kWeight; i < num_tensors; ++i) {
+    TYPE_ASSIGN_CHECK(*in_type, i, mshadow::kInt8);
+  }
+  quantization::AssignRangeTypes(in_type, num_tensors, in_type->size());
+  TYPE_ASSIGN_CHECK(*out_type, 0, mshadow::kInt32);
+  quantization::AssignRangeTypes(out_type, 1, 3);
+  return quantization::CheckDataType(*in_type, qfc::kData, "quantized_fully_connected");
+}
+
+template<typename DType>
+void QuantizedFullyConnectedCompute(const FullyConnectedParam& param, const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<int32_t>& bias, const TBlob& output) {
+  using int8_gemm::RoundUp;
+  const index_t num_hidden = param.num_hidden;
+  const index_t K = inputs[qfc::kWeight].shape_[1];
+  const index_t batch = inputs[qfc::kData].Size() / K;
+  const index_t K_pad = RoundUp(K, int8_gemm::kAlignK);
+  CHECK_LE(K_pad, 1U << 16) << "quantized_fully_connected: too many inputs for int32 sums";
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  // both operands padded to K_pad columns, then the transposed int32 product
+  const size_t weight_bytes = static_cast<size_t>(RoundUp(num_hidden, int8_gemm::kBlock)) * K_pad;
+  const size_t data_bytes = static_cast<size_t>(RoundUp(batch, int8_gemm::kBlock)) * K_pad *
+                            sizeof(DType);
+  const size_t product_bytes = static_cast<size_t>(num_hidden) * batch * sizeof(int32_t);
+  mshadow::Tensor<cpu, 1, char> workspace = ctx.requested[0].get_space_typed<cpu, 1, char>(
+      mshadow::Shape1(product_bytes + weight_bytes + data_bytes), ctx.get_stream<cpu>());
+  int32_t *product = reinterpret_cast<int32_t*>(workspace.dptr_);
+  int8_t *packed_weight = reinterpret_cast<int8_t*>(workspace.dptr_ + product_bytes);
+  DType *packed_data = reinterpret_cast<DType*>(workspace.dptr_ + product_bytes + weight_bytes);
+  std::memset(packed_weight, 0, weight_bytes + data_bytes);
+  const int8_t *weight = inputs[qfc::kWeight].dptr<int8_t>();
+  const DType *data = inputs[qfc::kData].dptr<DType>();
+  for (index_t h = 0; h < num_hidden; ++h) {
+    std::memcpy(packed_weight + h * K_pad, weight + h * K, K);
+  }
+  for (index_t n = 0; n < batch; ++n) {
+    std::memcpy(packed_data + n * K_pad, data + n * K, K * sizeof(DType));
+  }
+
+  // the weights are the signed operand, so the product comes out as (num_hidden, batch)
+  int8_gemm::Gemm(packed_weight, packed_data, product, num_hidden, batch, K_pad, batch);
+  int32_t *out = output.dptr<int32_t>();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int n = 0; n < static_cast<int>(batch); ++n) {
+    for (index_t h = 0; h < num_hidden; ++h) {
+      out[n * num_hidden + h] = product[h * batch + n] + (bias.empty() ? 0 : bias[h]);
+    }
+  }
+}
+
+void QuantizedFullyConnectedForward(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+  const FullyConnectedParam& param = nnvm::get<FullyConnectedParam>(attrs.parsed);
+  CHECK_EQ(req[0], kWriteTo) << "quantized_fully_connected only supports req kWriteTo";
+  const uint32_t num_tensors = QuantizedFullyConnectedNumTensors(attrs);
+  auto range = [&](uint32_t tensor, int which) {
+    return *inputs[num_tensors + 2 * tensor + which].dptr<float>();
+  };
+  const double data_unit = quantization::QuantizedUnit(inputs[qfc::kData].type_flag_,
+                                                       range(qfc::kData, 0),
+                                                       range(qfc::kData, 1));
+  const double weight_unit = quantization::QuantizedUnit(mshadow::kInt8,
+                                                         range(qfc::kWeight, 0),
+                                                         range(qfc::kWeight, 1));
+  const double out_unit = data_unit * weight_unit;
+  std::vector<int32_t> bias;
+  if (!param.no_bias) {
+    // bias has its own int8 range and is moved to the units of the output
+    const double bias_unit = quantization::QuantizedUnit(mshadow::kInt8,
+                                                         range(qfc::kBias, 0),
+                                                         range(qfc::kBias, 1));
+    const double scale = out_unit > 0.0 ? bias_unit / out_unit : 0.0;
+    const int8_t *b = inputs[qfc::kBias].dptr<int8_t>();
+    bias.resize(param.num_hidden);
+    for (int h = 0; h < param.num_hidden; ++h) {
+      bias[h] = static_cast<int32_t>(std::max(std::min(std::round(b[h] * scale),
+                                                        quantization::kInt32Range),
+                                               -quantization::kInt32Range));
+    }
+  }
+  if (inputs[qfc::kData].type_flag_ == mshadow::kUint8) {
+    QuantizedFullyConnectedCompute<uint8_t>(param, ctx, inputs, bias, outputs[0]);
+  } else {
+    QuantizedFullyConnectedCompute<int8_t>(param, ctx, inputs, bias, outputs[0]);
+  }
+  *outputs[1].dptr<float>() = -out_unit * quantization::kInt32Range;
+  *outputs[2].dptr<float>() = out_unit * quantization::kInt32Range;
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_fully_connected)
+.describe(R"code(Fully connected layer on quantized data, with int32 accumulation and output.
+
+Takes the same parameters as `FullyConnected`. `data` is int8, or uint8 with `min_data` 0,
+`weight` and `bias` are int8 with the symmetric ranges produced by `quantize` with `out_type`
+int8. The int32 output represents `out[i] * max(abs(min_output), abs(max_output)) / (2^31 - 1)`
+and is exact. Use `requantize` to narrow it back to int8, or `dequantize` to convert it into
+float32.
+
+On x86 CPUs the products run on AVX-512 VNNI or AVX2 when the CPU supports them.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<FullyConnectedParam>)
+.set_num_inputs([](const nnvm::NodeAttrs& attrs) {
+    return QuantizedFullyConnectedNumTensors(attrs) * 3;
+  })
+.set_num_outputs(3)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    if (nnvm::get<FullyConnectedParam>(attrs.parsed).no_bias) {
+      return std::vector<std::string>{"data", "weight", "min_data", "max_data",
+                                      "min_weight", "max_weight"};
+    }
+    return std::vector<std::string>{"data", "weight", "bias", "min_data", "max_data",
+                                    "min_weight", "max_weight", "min_bias", "max_bias"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedFullyConnectedShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedFullyConnectedType)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedFullyConnectedForward)
+.add_argument("data", "NDArray-or-Symbol", "Input data, int8 or uint8")
+.add_argument("weight", "NDArray-or-Symbol", "int8 weight")
+.add_argument("bias", "NDArray-or-Symbol", "int8 bias")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data")
+.add_argument("min_weight", "NDArray-or-Symbol", "Minimum value of weight")
+.add_argument("max_weight", "NDArray-or-Symbol", "Maximum value of weight")
+.add_argument("min_bias", "NDArray-or-Symbol", "Minimum value of bias")
+.add_argument("max_bias", "NDArray-or-Symbol", "Maximum value of bias")
+.add_arguments(FullyConnectedParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
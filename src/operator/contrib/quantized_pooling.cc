@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_pooling.cc
+ * \brief 2D max and average pooling of int8 or uint8 data, which keeps the input range
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "./quantization_utils.h"
+#include "../nn/pooling-inl.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+void QuantizedPoolingParamParser(nnvm::NodeAttrs* attrs) {
+  PoolingParam param;
+  param.Init(attrs->dict);
+  CHECK_EQ(param.kernel.ndim(), 2U) << "quantized_pooling only supports 2D pooling";
+  CHECK(param.pool_type == pool_enum::kMaxPooling || param.pool_type == pool_enum::kAvgPooling)
+    << "quantized_pooling only supports max and avg pooling";
+  if (param.stride.ndim() == 0) param.stride = mshadow::Shape2(1, 1);
+  if (param.pad.ndim() == 0) param.pad = mshadow::Shape2(0, 0);
+  attrs->parsed = std::move(param);
+}
+
+bool QuantizedPoolingShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape> *in_shape,
+                           std::vector<TShape> *out_shape) {
+  const PoolingParam& param = nnvm::get<PoolingParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 3U);
+  quantization::AssignRangeShapes(in_shape, 1, 3);
+  quantization::AssignRangeShapes(out_shape, 1, 3);
+  const TShape& dshape = in_shape->at(0);
+  if (shape_is_none(dshape)) return false;
+  CHECK_EQ(dshape.ndim(), 4U)
+    << "quantized_pooling: data should be 4D in (batch, channel, y, x)";
+  TShape oshape = dshape;
+  if (param.global_pool) {
+    oshape[2] = 1;
+    oshape[3] = 1;
+  } else {
+    for (int i = 0; i < 2; ++i) {
+      CHECK_LE(param.kernel[i], dshape[i + 2] + 2 * param.pad[i]) << "kernel size exceeds input";
+      if (param.pooling_convention == pool_enum::kValid) {
+        oshape[i + 2] = 1 + (dshape[i + 2] + 2 * param.pad[i] - param.kernel[i]) /
+                            param.stride[i];
+      } else {
+        oshape[i + 2] = 1 + static_cast<int>(ceil(static_cast<float>(
+                            dshape[i + 2] + 2 * param.pad[i] - param.kernel[i]) /
+                            param.stride[i]));
+      }
+    }
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  return true;
+}
+
+bool QuantizedPoolingType(const nnvm::NodeAttrs& attrs,
+                          std::vector<int> *in_type,
+                          std::vector<int> *out_type) {
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 3U);
+  quantization::AssignRangeTypes(in_type, 1, 3);
+  quantization::AssignRangeTypes(out_type, 1, 3);
+  if (!quantization::CheckDataType(*in_type, 0, "quantized_pooling")) return false;
+  TYPE_ASSIGN_CHECK(*out_type, 0, in_type->at(0));
+  return true;
+}
+
+/*!
+ * \brief pools every channel with the window clipping of the float pool_max_2d_cpu and
+ *  pool_sum_2d_cpu; averages are summed in int32 and rounded to the nearest level
+ */
+template<typename DType>
+void QuantizedPool2D(const PoolingParam& param, const TBlob& data, const TBlob& output) {
+  const TShape& ishape = data.shape_;
+  const TShape& oshape = output.shape_;
+  const int height = ishape[2], width = ishape[3];
+  const int pooled_height = oshape[2], pooled_width = oshape[3];
+  const int kernel_h = param.global_pool ? height : param.kernel[0];
+  const int kernel_w = param.global_pool ? width : param.kernel[1];
+  const int stride_h = param.global_pool ? 1 : param.stride[0];
+  const int stride_w = param.global_pool ? 1 : param.stride[1];
+  const int pad_h = param.global_pool ? 0 : param.pad[0];
+  const int pad_w = param.global_pool ? 0 : param.pad[1];
+  const int channels = static_cast<int>(ishape[0] * ishape[1]);
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int c = 0; c < channels; ++c) {
+    const DType *in = data.dptr<DType>() + c * height * width;
+    DType *out = output.dptr<DType>() + c * pooled_height * pooled_width;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+      for (int pw = 0; pw < pooled_width; ++pw) {
+        int hstart = ph * stride_h - pad_h;
+        int wstart = pw * stride_w - pad_w;
+        if (param.pool_type == pool_enum::kMaxPooling) {
+          const int hend = std::min(hstart + kernel_h, height);
+          const int wend = std::min(wstart + kernel_w, width);
+          hstart = std::max(hstart, 0);
+          wstart = std::max(wstart, 0);
+          DType max_val = std::numeric_limits<DType>::lowest();
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              max_val = std::max(max_val, in[h * width + w]);
+            }
+          }
+          out[ph * pooled_width + pw] = max_val;
+        } else {
+          int hend = std::min(hstart + kernel_h, height + pad_h);
+          int wend = std::min(wstart + kernel_w, width + pad_w);
+          const int pool_size = (hend - hstart) * (wend - wstart);
+          hstart = std::max(hstart, 0);
+          wstart = std::max(wstart, 0);
+          hend = std::min(hend, height);
+          wend = std::min(wend, width);
+          int32_t sum = 0;
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              sum += in[h * width + w];
+            }
+          }
+          out[ph * pooled_width + pw] = static_cast<DType>(
+              std::round(static_cast<float>(sum) / pool_size));
+        }
+      }
+    }
+  }
+}
+
+void QuantizedPoolingForward(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+  const PoolingParam& param = nnvm::get<PoolingParam>(attrs.parsed);
+  CHECK_EQ(req[0], kWriteTo) << "quantized_pooling only supports req kWriteTo";
+  if (inputs[0].type_flag_ == mshadow::kUint8) {
+    QuantizedPool2D<uint8_t>(param, inputs[0], outputs[0]);
+  } else {
+    QuantizedPool2D<int8_t>(param, inputs[0], outputs[0]);
+  }
+  *outputs[1].dptr<float>() = *inputs[1].dptr<float>();
+  *outputs[2].dptr<float>() = *inputs[2].dptr<float>();
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_pooling)
+.describe(R"code(2D max or average pooling of quantized data.
+
+Takes the same parameters as `Pooling`, restricted to 2D kernels and the max and avg pooling
+types. `data` is int8 or uint8, the output has the same type and range as the input.
+Averages are rounded to the nearest quantized level.
+)code" ADD_FILELINE)
+.set_attr_parser(QuantizedPoolingParamParser)
+.set_num_inputs(3)
+.set_num_outputs(3)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "min_data", "max_data"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", QuantizedPoolingShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedPoolingType)
+.set_attr<FCompute>("FCompute<cpu>", QuantizedPoolingForward)
+.add_argument("data", "NDArray-or-Symbol", "Input data, int8 or uint8")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data")
+.add_arguments(PoolingParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
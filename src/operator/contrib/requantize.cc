@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file requantize.cc
+ * \brief narrows the int32 outputs of the quantized operators back to int8
+ */
+#include <dmlc/omp.h>
+#include <dmlc/optional.h>
+#include <algorithm>
+#include <cstdlib>
+#include "./quantization_utils.h"
+#include "../elemwise_op_common.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+struct RequantizeParam : public dmlc::Parameter<RequantizeParam> {
+  dmlc::optional<float> min_calib_range;
+  dmlc::optional<float> max_calib_range;
+  DMLC_DECLARE_PARAMETER(RequantizeParam) {
+    DMLC_DECLARE_FIELD(min_calib_range)
+    .set_default(dmlc::optional<float>())
+    .describe("The minimum value of the real output, usually found by calibration. "
+              "When either calibrated value is missing the range of the input data is used.");
+    DMLC_DECLARE_FIELD(max_calib_range)
+    .set_default(dmlc::optional<float>())
+    .describe("The maximum value of the real output, usually found by calibration.");
+  }
+};
+
+DMLC_REGISTER_PARAMETER(RequantizeParam);
+
+inline bool RequantizeShape(const nnvm::NodeAttrs& attrs,
+                            std::vector<TShape> *in_attrs,
+                            std::vector<TShape> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  quantization::AssignRangeShapes(in_attrs, 1, 3);
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(0));
+  quantization::AssignRangeShapes(out_attrs, 1, 3);
+  return !shape_is_none(in_attrs->at(0));
+}
+
+inline bool RequantizeType(const nnvm::NodeAttrs& attrs,
+                           std::vector<int> *in_attrs,
+                           std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, mshadow::kInt32);
+  quantization::AssignRangeTypes(in_attrs, 1, 3);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kInt8);
+  quantization::AssignRangeTypes(out_attrs, 1, 3);
+  return true;
+}
+
+void RequantizeForward(const nnvm::NodeAttrs& attrs,
+                       const OpContext& ctx,
+                       const std::vector<TBlob>& inputs,
+                       const std::vector<OpReqType>& req,
+                       const std::vector<TBlob>& outputs) {
+  using quantization::kInt8Range;
+  const RequantizeParam& param = nnvm::get<RequantizeParam>(attrs.parsed);
+  const int32_t *in = inputs[0].dptr<int32_t>();
+  int8_t *out = outputs[0].dptr<int8_t>();
+  const int size = static_cast<int>(inputs[0].Size());
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const double in_unit = quantization::QuantizedUnit(mshadow::kInt32,
+                                                     *inputs[1].dptr<float>(),
+                                                     *inputs[2].dptr<float>());
+  float out_range;
+  if (param.min_calib_range.has_value() && param.max_calib_range.has_value()) {
+    out_range = quantization::MaxAbs(param.min_calib_range.value(),
+                                     param.max_calib_range.value());
+  } else {
+    std::vector<int64_t> thread_max(omp_threads, 0);
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      int64_t max_abs = 0;
+      #pragma omp for
+      for (int i = 0; i < size; ++i) {
+        max_abs = std::max(max_abs, std::abs(static_cast<int64_t>(in[i])));
+      }
+      thread_max[omp_get_thread_num()] = max_abs;
+    }
+    out_range = *std::max_element(thread_max.begin(), thread_max.end()) * in_unit;
+  }
+  const float scale = out_range > 0.0f ? in_unit * kInt8Range / out_range : 0.0f;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int i = 0; i < size; ++i) {
+    out[i] = static_cast<int8_t>(quantization::RoundClamp(in[i] * scale, kInt8Range));
+  }
+  *outputs[1].dptr<float>() = -out_range;
+  *outputs[2].dptr<float>() = out_range;
+}
+
+NNVM_REGISTER_OP(_contrib_requantize)
+.describe(R"code(Converts the int32 output of a quantized operator into int8.
+
+The int32 input represents `in[i] * max(abs(min_range), abs(max_range)) / (2^31 - 1)`. The
+output uses the symmetric int8 range `R = max(abs(min_calib_range), abs(max_calib_range))`
+when both calibrated values are given, and otherwise the smallest range that covers the input:
+
+`out[i] = round(in[i] * max(abs(min_range), abs(max_range)) / (2^31 - 1) * 127 / R)`
+
+Values outside of a calibrated range saturate to -127 and 127. The output ranges are -R and R.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<RequantizeParam>)
+.set_num_inputs(3)
+.set_num_outputs(3)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "min_range", "max_range"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape", RequantizeShape)
+.set_attr<nnvm::FInferType>("FInferType", RequantizeType)
+.set_attr<FCompute>("FCompute<cpu>", RequantizeForward)
+.add_argument("data", "NDArray-or-Symbol", "An int32 ndarray/symbol")
+.add_argument("min_range", "NDArray-or-Symbol", "The minimum scalar value "
+  "possibly produced for the data")
+.add_argument("max_range", "NDArray-or-Symbol", "The maximum scalar value "
+  "possibly produced for the data")
+.add_arguments(RequantizeParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
@@ -23,10 +23,102 @@
  * \brief loss function that takes a data and label
 */
 #include "./loss_binary_op-inl.h"
+#include <algorithm>
+#include <cmath>
+#include "./vec_math.h"
+#include "../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
 
+// For float data the CPU loss and gradient are computed row by row from the logits with the
+// vectorized kernels of vec_math.h, and the softmax probabilities are never stored.
+void SoftmaxCrossEntropyForwardCPU(const nnvm::NodeAttrs& attrs,
+                                   const OpContext& ctx,
+                                   const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+  if (inputs[0].type_flag_ != mshadow::kFloat32 || outputs[0].type_flag_ != mshadow::kFloat32 ||
+      inputs[1].type_flag_ != mshadow::kFloat32) {
+    SoftmaxCrossEntropyForward<cpu>(attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  if (req[0] == kNullOp) return;
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  mshadow::Tensor<cpu, 2, float> mdata = inputs[0].get<cpu, 2, float>(s);
+  mshadow::Tensor<cpu, 1, float> mlabel = inputs[1].get<cpu, 1, float>(s);
+  float *out = outputs[0].dptr<float>();
+  const int rows = mdata.size(0);
+  const int cols = mdata.size(1);
+  // -log(p) is capped at -log(1e-8), like the generic kernel clips the probabilities to 1e-8
+  const float max_loss = -std::log(1e-8f);
+  double loss = 0;
+  int invalid = 0;
+  #pragma omp parallel for reduction(+:loss, invalid) \
+    num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int y = 0; y < rows; ++y) {
+    const float *row = mdata[y].dptr_;
+    const int k = static_cast<int>(mlabel[y]);
+    if (k < 0 || k >= cols) {
+      ++invalid;
+      continue;
+    }
+    const float mmax = vec_math::Max(row, cols);
+    const float log_sum = std::log(vec_math::ExpSum(row, mmax, NULL, cols));
+    loss += std::min(log_sum - (row[k] - mmax), max_loss);
+  }
+  CHECK_EQ(invalid, 0) << "SoftmaxCrossEntropy: label out of range [0, " << cols << ")";
+  if (req[0] == kAddTo) {
+    out[0] += static_cast<float>(loss);
+  } else {
+    out[0] = static_cast<float>(loss);
+  }
+}
+
+void SoftmaxCrossEntropyBackwardCPU(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+  if (inputs[1].type_flag_ != mshadow::kFloat32 || outputs[0].type_flag_ != mshadow::kFloat32) {
+    SoftmaxCrossEntropyBackward<cpu>(attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  CHECK_EQ(req[1], kNullOp)
+      << "SoftmaxCrossEntropy: Cannot take gradient wrt label";
+  if (req[0] == kNullOp) return;
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  const float scale = inputs[0].dptr<float>()[0];
+  const float *label = inputs[2].dptr<float>();
+  mshadow::Tensor<cpu, 2, float> mdata = inputs[1].get<cpu, 2, float>(s);
+  mshadow::Tensor<cpu, 2, float> mdata_grad = outputs[0].get<cpu, 2, float>(s);
+  const int rows = mdata.size(0);
+  const int cols = mdata.size(1);
+  int invalid = 0;
+  #pragma omp parallel num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  {
+    std::vector<float> prob(req[0] == kAddTo ? cols : 0);
+    #pragma omp for reduction(+:invalid)
+    for (int y = 0; y < rows; ++y) {
+      const int k = static_cast<int>(label[y]);
+      if (k < 0 || k >= cols) {
+        ++invalid;
+        continue;
+      }
+      float *grad = mdata_grad[y].dptr_;
+      float *dst = req[0] == kAddTo ? prob.data() : grad;
+      vec_math::Softmax(mdata[y].dptr_, dst, cols);
+      dst[k] -= 1.0f;
+      if (req[0] == kAddTo) {
+        for (int j = 0; j < cols; ++j) grad[j] += scale * dst[j];
+      } else {
+        for (int j = 0; j < cols; ++j) grad[j] *= scale;
+      }
+    }
+  }
+  CHECK_EQ(invalid, 0) << "SoftmaxCrossEntropy: label out of range [0, " << cols << ")";
+}
+
 NNVM_REGISTER_OP(softmax_cross_entropy)
 .describe(R"code(Calculate cross entropy of softmax output and one-hot label.
 
@@ -65,7 +157,7 @@ Example::
   [](const NodeAttrs& attrs) {
     return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
   })
-.set_attr<FCompute>("FCompute<cpu>", SoftmaxCrossEntropyForward<cpu>)
+.set_attr<FCompute>("FCompute<cpu>", SoftmaxCrossEntropyForwardCPU)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_softmax_cross_entropy"})
 .add_argument("data", "NDArray-or-Symbol", "Input data")
 .add_argument("label", "NDArray-or-Symbol", "Input label");
@@ -78,7 +170,7 @@ NNVM_REGISTER_OP(_backward_softmax_cross_entropy)
     return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
   })
 .set_attr<nnvm::TIsBackward>("TIsBackward", true)
-.set_attr<FCompute>("FCompute<cpu>", SoftmaxCrossEntropyBackward<cpu>);
+.set_attr<FCompute>("FCompute<cpu>", SoftmaxCrossEntropyBackwardCPU);
 
 }  // namespace op
 }  // namespace mxnet
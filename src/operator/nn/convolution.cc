@@ -25,6 +25,7 @@
 */
 
 #include "./convolution-inl.h"
+#include "./convolution_cpu-inl.h"
 #if MXNET_USE_MKL2017 == 1
 #include <mkl_memory.h>
 #include "../mkl/mkl_memory-inl.h"
@@ -47,7 +48,7 @@ Operator* CreateOp<cpu>(ConvolutionParam param, int dtype,
   // If 1D convolution, use MXNet implementation
   if (param.kernel.ndim() == 1) {
     MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
-      op = new ConvolutionOp<cpu, DType>(param);
+      op = new CPUConvolutionOp<DType>(param);
     })
     return op;
   }
@@ -80,7 +81,7 @@ Operator* CreateOp<cpu>(ConvolutionParam param, int dtype,
   }
 #endif
   MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
-    op = new ConvolutionOp<cpu, DType>(param);
+    op = new CPUConvolutionOp<DType>(param);
   })
   return op;
 }
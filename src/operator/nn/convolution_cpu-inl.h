@@ -0,0 +1,489 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file convolution_cpu-inl.h
+ * \brief CPU convolution that lowers several images at once into one GEMM
+ *
+ * ConvolutionOp runs im2col and a GEMM per image, which leaves layers with a
+ * small output (e.g. 7x7 or 14x14) with many tiny GEMMs that cannot keep the
+ * BLAS threads busy. This operator lays the columns of a chunk of images side
+ * by side, so each group needs one GEMM of width images * out_h * out_w.
+ * The chunk grows until the GEMM is wide enough or the workspace budget of
+ * the layer is used up. 1x1 stride-1 convolutions skip im2col and only pack
+ * the input channels, and 3x3 stride-1 forward passes use Winograd F(2x2, 3x3),
+ * which needs 16 instead of 36 multiplications per 2x2 output tile.
+*/
+#ifndef MXNET_OPERATOR_NN_CONVOLUTION_CPU_INL_H_
+#define MXNET_OPERATOR_NN_CONVOLUTION_CPU_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "../../engine/openmp.h"
+#include "./convolution-inl.h"
+#include "./im2col.h"
+#include "../linalg.h"
+
+namespace mxnet {
+namespace op {
+namespace conv_cpu {
+
+/*! \brief GEMM width (columns) after which adding more images to a chunk stops paying off */
+const index_t kTargetCols = 4096;
+/*! \brief number of transformed elements in a Winograd F(2x2, 3x3) tile */
+const int kTile = 16;
+
+/*!
+ * \brief transform a 3x3 filter g into the 4x4 Winograd domain, U = G g G^T
+ * \param u output, element xi is written to u[xi * u_stride]
+ */
+template<typename DType>
+inline void WinogradFilter(const DType* g, DType* u, index_t u_stride) {
+  DType t[4][3];
+  for (int j = 0; j < 3; ++j) {
+    t[0][j] = g[j];
+    t[1][j] = DType(0.5) * (g[j] + g[3 + j] + g[6 + j]);
+    t[2][j] = DType(0.5) * (g[j] - g[3 + j] + g[6 + j]);
+    t[3][j] = g[6 + j];
+  }
+  for (int i = 0; i < 4; ++i) {
+    u[(4 * i + 0) * u_stride] = t[i][0];
+    u[(4 * i + 1) * u_stride] = DType(0.5) * (t[i][0] + t[i][1] + t[i][2]);
+    u[(4 * i + 2) * u_stride] = DType(0.5) * (t[i][0] - t[i][1] + t[i][2]);
+    u[(4 * i + 3) * u_stride] = t[i][2];
+  }
+}
+
+/*!
+ * \brief transform the overlapping 4x4 input tiles of one channel plane, V = B^T d B
+ * \param v output, element xi of tile t is written to v[xi * v_stride + t]
+ */
+template<typename DType>
+inline void WinogradInput(const DType* data, int height, int width, int pad_h, int pad_w,
+                          int tiles_h, int tiles_w, DType* v, index_t v_stride) {
+  for (int ty = 0; ty < tiles_h; ++ty) {
+    for (int tx = 0; tx < tiles_w; ++tx) {
+      DType d[4][4];
+      const int y0 = 2 * ty - pad_h, x0 = 2 * tx - pad_w;
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          d[i][j] = is_a_ge_zero_and_a_lt_b(y0 + i, height) &&
+                    is_a_ge_zero_and_a_lt_b(x0 + j, width) ?
+                    data[(y0 + i) * width + x0 + j] : DType(0);
+        }
+      }
+      DType t[4][4];
+      for (int j = 0; j < 4; ++j) {
+        t[0][j] = d[0][j] - d[2][j];
+        t[1][j] = d[1][j] + d[2][j];
+        t[2][j] = d[2][j] - d[1][j];
+        t[3][j] = d[1][j] - d[3][j];
+      }
+      DType* out = v + ty * tiles_w + tx;
+      for (int i = 0; i < 4; ++i) {
+        out[(4 * i + 0) * v_stride] = t[i][0] - t[i][2];
+        out[(4 * i + 1) * v_stride] = t[i][1] + t[i][2];
+        out[(4 * i + 2) * v_stride] = t[i][2] - t[i][1];
+        out[(4 * i + 3) * v_stride] = t[i][1] - t[i][3];
+      }
+    }
+  }
+}
+
+/*!
+ * \brief fold the Winograd products of one output plane back into 2x2 tiles, Y = A^T m A
+ * \param m products, element xi of tile t is read from m[xi * m_stride + t]
+ */
+template<typename DType>
+inline void WinogradOutput(const DType* m, index_t m_stride, int tiles_h, int tiles_w,
+                           int out_h, int out_w, DType bias, DType* out) {
+  for (int ty = 0; ty < tiles_h; ++ty) {
+    for (int tx = 0; tx < tiles_w; ++tx) {
+      const DType* in = m + ty * tiles_w + tx;
+      DType t[2][4];
+      for (int j = 0; j < 4; ++j) {
+        const DType m0 = in[j * m_stride], m1 = in[(4 + j) * m_stride];
+        const DType m2 = in[(8 + j) * m_stride], m3 = in[(12 + j) * m_stride];
+        t[0][j] = m0 + m1 + m2;
+        t[1][j] = m1 - m2 - m3;
+      }
+      for (int i = 0; i < 2 && 2 * ty + i < out_h; ++i) {
+        DType* row = out + (2 * ty + i) * out_w + 2 * tx;
+        row[0] = t[i][0] + t[i][1] + t[i][2] + bias;
+        if (2 * tx + 1 < out_w) row[1] = t[i][1] - t[i][2] - t[i][3] + bias;
+      }
+    }
+  }
+}
+
+}  // namespace conv_cpu
+
+template<typename DType>
+class CPUConvolutionOp : public ConvolutionOp<cpu, DType> {
+ public:
+  explicit CPUConvolutionOp(ConvolutionParam p)
+      : ConvolutionOp<cpu, DType>(p) {
+    this->param_ = p;
+    // convert MBytes first to Bytes and then to elements.
+    param_.workspace = (param_.workspace << 20) / sizeof(DType);
+    winograd_ = dmlc::GetEnv("MXNET_CPU_WINOGRAD_CONV", true);
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    if (param_.kernel.ndim() > 2) {
+      ConvolutionOp<cpu, DType>::Forward(ctx, in_data, req, out_data, aux_args);
+      return;
+    }
+    CHECK_EQ(req[conv::kOut], kWriteTo);
+    LayerSetUp(in_data[conv::kData].shape_, out_data[conv::kOut].shape_);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const DType* data = in_data[conv::kData].dptr<DType>();
+    const DType* weight = in_data[conv::kWeight].dptr<DType>();
+    const DType* bias = bias_term_ ? in_data[conv::kBias].dptr<DType>() : NULL;
+    DType* out = out_data[conv::kOut].dptr<DType>();
+    if (UseWinograd()) {
+      ForwardWinograd(ctx, data, weight, bias, out);
+      return;
+    }
+
+    const index_t M = num_filter_ / group_;
+    const index_t K = kernel_dim_;
+    const index_t N = out_spatial_;
+    const index_t nb = ImagesPerChunk((group_ * K + num_filter_) * N, N);
+    // with one image per chunk the GEMM writes straight into the output,
+    // and a 1x1 convolution reads straight from the input
+    const index_t col_size = is_1x1_ && nb == 1 ? 0 : group_ * K * nb * N;
+    const index_t out_size = nb == 1 ? 0 : num_filter_ * nb * N;
+    Tensor<cpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<cpu, 1, DType>(Shape1(std::max<index_t>(col_size + out_size, 1)), s);
+    DType* col_buffer = workspace.dptr_;
+    DType* out_buffer = workspace.dptr_ + col_size;
+
+    for (index_t n0 = 0; n0 < num_; n0 += nb) {
+      const index_t b = std::min(nb, num_ - n0);
+      const index_t ld = b * N;
+      const DType* col = Lower(data + n0 * in_dim_, b, col_buffer);
+      DType* dst = nb == 1 ? out + n0 * out_dim_ : out_buffer;
+      for (index_t g = 0; g < group_; ++g) {
+        linalg_gemm(Tensor<cpu, 2, DType>(const_cast<DType*>(weight) + g * M * K,
+                                          Shape2(M, K), K, s),
+                    Tensor<cpu, 2, DType>(const_cast<DType*>(col) + g * K * ld,
+                                          Shape2(K, ld), ld, s),
+                    Tensor<cpu, 2, DType>(dst + g * M * ld, Shape2(M, ld), ld, s),
+                    false, false, s, kWriteTo);
+      }
+      if (nb > 1) {
+        Unpack(out_buffer, b, num_filter_, bias, kWriteTo, out + n0 * out_dim_);
+      } else if (bias != NULL) {
+        AddBias(bias, dst);
+      }
+    }
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob>& out_grad,
+                        const std::vector<TBlob>& in_data,
+                        const std::vector<TBlob>& out_data,
+                        const std::vector<OpReqType>& req,
+                        const std::vector<TBlob>& in_grad,
+                        const std::vector<TBlob>& aux_args) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    if (param_.kernel.ndim() > 2) {
+      ConvolutionOp<cpu, DType>::Backward(ctx, out_grad, in_data, out_data, req, in_grad,
+                                          aux_args);
+      return;
+    }
+    CHECK_EQ(in_data[conv::kWeight].CheckContiguous(), true);
+    LayerSetUp(in_grad[conv::kData].shape_, out_grad[conv::kOut].shape_);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const DType* data = in_data[conv::kData].dptr<DType>();
+    const DType* weight = in_data[conv::kWeight].dptr<DType>();
+    const DType* dout = out_grad[conv::kOut].dptr<DType>();
+    DType* ddata = in_grad[conv::kData].dptr<DType>();
+    DType* dweight = in_grad[conv::kWeight].dptr<DType>();
+
+    const index_t M = num_filter_ / group_;
+    const index_t K = kernel_dim_;
+    const index_t N = out_spatial_;
+    const index_t nb = ImagesPerChunk((group_ * K + num_filter_) * N, N);
+    const index_t col_size = is_1x1_ && nb == 1 ? 0 : group_ * K * nb * N;
+    const index_t dout_size = nb == 1 ? 0 : num_filter_ * nb * N;
+    Tensor<cpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<cpu, 1, DType>(Shape1(std::max<index_t>(col_size + dout_size, 1)), s);
+    DType* col_buffer = workspace.dptr_;
+    DType* dout_buffer = workspace.dptr_ + col_size;
+
+    for (index_t n0 = 0; n0 < num_; n0 += nb) {
+      const index_t b = std::min(nb, num_ - n0);
+      const index_t ld = b * N;
+      const DType* dout_mat = dout + n0 * out_dim_;
+      if (nb > 1) {
+        Pack(dout_mat, b, num_filter_, dout_buffer);
+        dout_mat = dout_buffer;
+      }
+      // gradient w.r.t. input data
+      if (req[conv::kData] != kNullOp) {
+        DType* dcol = is_1x1_ && nb == 1 ? ddata + n0 * in_dim_ : col_buffer;
+        const OpReqType dcol_req = is_1x1_ && nb == 1 ? req[conv::kData] : kWriteTo;
+        for (index_t g = 0; g < group_; ++g) {
+          linalg_gemm(Tensor<cpu, 2, DType>(const_cast<DType*>(weight) + g * M * K,
+                                            Shape2(M, K), K, s),
+                      Tensor<cpu, 2, DType>(const_cast<DType*>(dout_mat) + g * M * ld,
+                                            Shape2(M, ld), ld, s),
+                      Tensor<cpu, 2, DType>(dcol + g * K * ld, Shape2(K, ld), ld, s),
+                      true, false, s, dcol_req);
+        }
+        if (dcol == col_buffer) Raise(col_buffer, b, req[conv::kData], ddata + n0 * in_dim_);
+      }
+      // gradient w.r.t. weight, accumulated across the chunks
+      if (req[conv::kWeight] != kNullOp) {
+        const DType* col = Lower(data + n0 * in_dim_, b, col_buffer);
+        const OpReqType wreq = n0 == 0 ? req[conv::kWeight] : kAddTo;
+        for (index_t g = 0; g < group_; ++g) {
+          linalg_gemm(Tensor<cpu, 2, DType>(const_cast<DType*>(dout_mat) + g * M * ld,
+                                            Shape2(M, ld), ld, s),
+                      Tensor<cpu, 2, DType>(const_cast<DType*>(col) + g * K * ld,
+                                            Shape2(K, ld), ld, s),
+                      Tensor<cpu, 2, DType>(dweight + g * M * K, Shape2(M, K), K, s),
+                      false, true, s, wreq);
+        }
+      }
+    }
+
+    // gradient w.r.t bias
+    if (bias_term_) {
+      Tensor<cpu, 1, DType> dbias = in_grad[conv::kBias].get<cpu, 1, DType>(s);
+      Tensor<cpu, 3, DType> dout_3d = out_grad[conv::kOut].get_with_shape<cpu, 3, DType>(
+          Shape3(num_, num_filter_, out_spatial_), s);
+      ASSIGN_DISPATCH(dbias, req[conv::kBias], sumall_except_dim<1>(dout_3d));
+    }
+  }
+
+ private:
+  void LayerSetUp(const TShape& ishape, const TShape& oshape) {
+    // a 1-D convolution is a 2-D convolution of height 1
+    const bool is_2d = param_.kernel.ndim() == 2;
+    num_ = ishape[0];
+    channels_ = ishape[1];
+    height_ = is_2d ? ishape[2] : 1;
+    width_ = ishape[ishape.ndim() - 1];
+    out_h_ = is_2d ? oshape[2] : 1;
+    out_w_ = oshape[oshape.ndim() - 1];
+    kernel_h_ = is_2d ? param_.kernel[0] : 1;
+    kernel_w_ = param_.kernel[param_.kernel.ndim() - 1];
+    pad_h_ = is_2d ? param_.pad[0] : 0;
+    pad_w_ = param_.pad[param_.pad.ndim() - 1];
+    stride_h_ = is_2d ? param_.stride[0] : 1;
+    stride_w_ = param_.stride[param_.stride.ndim() - 1];
+    dilate_h_ = is_2d ? param_.dilate[0] : 1;
+    dilate_w_ = param_.dilate[param_.dilate.ndim() - 1];
+    group_ = param_.num_group;
+    num_filter_ = param_.num_filter;
+    bias_term_ = !param_.no_bias;
+    kernel_dim_ = channels_ / group_ * kernel_h_ * kernel_w_;
+    out_spatial_ = out_h_ * out_w_;
+    in_dim_ = channels_ * height_ * width_;
+    out_dim_ = num_filter_ * out_spatial_;
+    is_1x1_ = kernel_h_ == 1 && kernel_w_ == 1 && stride_h_ == 1 && stride_w_ == 1 &&
+              pad_h_ == 0 && pad_w_ == 0;
+  }
+
+  /*!
+   * \brief number of images lowered into one GEMM: enough to reach kTargetCols columns,
+   *  but no more than the workspace budget allows; at least one.
+   */
+  index_t ImagesPerChunk(index_t per_image, index_t cols_per_image) const {
+    index_t nb = (conv_cpu::kTargetCols + cols_per_image - 1) / cols_per_image;
+    nb = std::min(nb, static_cast<index_t>(param_.workspace / std::max<index_t>(per_image, 1)));
+    return std::max<index_t>(1, std::min(nb, num_));
+  }
+
+  /*!
+   * \brief lay out the columns of b images side by side in col_buffer,
+   *  a (channels * kernel_h * kernel_w, b * out_h * out_w) matrix.
+   * \return the column matrix, which is the input itself for a 1x1 convolution of one image
+   */
+  const DType* Lower(const DType* data, index_t b, DType* col_buffer) const {
+    if (is_1x1_) {
+      if (b == 1) return data;
+      Pack(data, b, channels_, col_buffer);
+      return col_buffer;
+    }
+    const index_t ld = b * out_spatial_;
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int i = 0; i < static_cast<int>(b); ++i) {
+      im2col_cpu(data + i * in_dim_, channels_, height_, width_, kernel_h_, kernel_w_,
+                 pad_h_, pad_w_, stride_h_, stride_w_, dilate_h_, dilate_w_,
+                 col_buffer + i * out_spatial_, static_cast<int>(ld));
+    }
+    return col_buffer;
+  }
+
+  /*! \brief scatter the column gradients of b images back into their images */
+  void Raise(const DType* col_buffer, index_t b, OpReqType req, DType* ddata) const {
+    if (is_1x1_) {
+      Unpack(col_buffer, b, channels_, NULL, req, ddata);
+      return;
+    }
+    const index_t ld = b * out_spatial_;
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int i = 0; i < static_cast<int>(b); ++i) {
+      col2im_cpu(col_buffer + i * out_spatial_, channels_, height_, width_,
+                 kernel_h_, kernel_w_, pad_h_, pad_w_, stride_h_, stride_w_,
+                 dilate_h_, dilate_w_, ddata + i * in_dim_, req, static_cast<int>(ld));
+    }
+  }
+
+  /*! \brief gather (b, rows, out_spatial) into a (rows, b * out_spatial) matrix */
+  void Pack(const DType* src, index_t b, index_t rows, DType* dst) const {
+    const index_t N = out_spatial_;
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int r = 0; r < static_cast<int>(rows); ++r) {
+      for (index_t i = 0; i < b; ++i) {
+        std::memcpy(dst + (r * b + i) * N, src + (i * rows + r) * N, N * sizeof(DType));
+      }
+    }
+  }
+
+  /*! \brief scatter a (rows, b * out_spatial) matrix into (b, rows, out_spatial) */
+  void Unpack(const DType* src, index_t b, index_t rows, const DType* bias, OpReqType req,
+              DType* dst) const {
+    const index_t N = out_spatial_;
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int r = 0; r < static_cast<int>(rows); ++r) {
+      const DType offset = bias != NULL ? bias[r] : DType(0);
+      for (index_t i = 0; i < b; ++i) {
+        const DType* in = src + (r * b + i) * N;
+        DType* out = dst + (i * rows + r) * N;
+        if (req == kAddTo) {
+          for (index_t p = 0; p < N; ++p) out[p] += in[p] + offset;
+        } else {
+          for (index_t p = 0; p < N; ++p) out[p] = in[p] + offset;
+        }
+      }
+    }
+  }
+
+  /*! \brief add the bias to the output planes of one image */
+  void AddBias(const DType* bias, DType* out) const {
+    const index_t N = out_spatial_;
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int o = 0; o < static_cast<int>(num_filter_); ++o) {
+      for (index_t p = 0; p < N; ++p) out[o * N + p] += bias[o];
+    }
+  }
+
+  /*!
+   * \brief whether this forward pass takes the Winograd F(2x2, 3x3) path. The transforms
+   *  cost about as much as a GEMM with 32 channels, so thin layers stay on im2col.
+   */
+  bool UseWinograd() const {
+    if (!winograd_ || param_.kernel.ndim() != 2 || group_ != 1) return false;
+    if (kernel_h_ != 3 || kernel_w_ != 3 || stride_h_ != 1 || stride_w_ != 1 ||
+        dilate_h_ != 1 || dilate_w_ != 1) return false;
+    if (channels_ < 32 || num_filter_ < 32) return false;
+    const index_t tiles = ((out_h_ + 1) / 2) * ((out_w_ + 1) / 2);
+    return conv_cpu::kTile * (num_filter_ * channels_ + (channels_ + num_filter_) * tiles)
+        <= param_.workspace;
+  }
+
+  void ForwardWinograd(const OpContext &ctx, const DType* data, const DType* weight,
+                       const DType* bias, DType* out) {
+    using namespace mshadow;
+    using conv_cpu::kTile;
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const int tiles_h = (out_h_ + 1) / 2, tiles_w = (out_w_ + 1) / 2;
+    const index_t tiles = tiles_h * tiles_w;
+    const index_t C = channels_, F = num_filter_;
+    const index_t filter_size = kTile * F * C;
+    index_t nb = (conv_cpu::kTargetCols + tiles - 1) / tiles;
+    nb = std::min(nb, (param_.workspace - filter_size) / (kTile * (C + F) * tiles));
+    nb = std::max<index_t>(1, std::min(nb, num_));
+    Tensor<cpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<cpu, 1, DType>(Shape1(filter_size + kTile * (C + F) * nb * tiles), s);
+    DType* u = workspace.dptr_;
+    DType* v = u + filter_size;
+    DType* m = v + kTile * C * nb * tiles;
+
+    // u is laid out as kTile (F, C) matrices
+    #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+    for (int fc = 0; fc < static_cast<int>(F * C); ++fc) {
+      conv_cpu::WinogradFilter(weight + fc * 9, u + fc, F * C);
+    }
+    for (index_t n0 = 0; n0 < num_; n0 += nb) {
+      const index_t b = std::min(nb, num_ - n0);
+      const index_t T = b * tiles;
+      // v is laid out as kTile (C, T) matrices, m as kTile (F, T) matrices
+      #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+      for (int ic = 0; ic < static_cast<int>(b * C); ++ic) {
+        const index_t i = ic / C, c = ic % C;
+        conv_cpu::WinogradInput(data + (n0 + i) * in_dim_ + c * height_ * width_,
+                                height_, width_, pad_h_, pad_w_, tiles_h, tiles_w,
+                                v + c * T + i * tiles, C * T);
+      }
+      for (int xi = 0; xi < kTile; ++xi) {
+        linalg_gemm(Tensor<cpu, 2, DType>(u + xi * F * C, Shape2(F, C), C, s),
+                    Tensor<cpu, 2, DType>(v + xi * C * T, Shape2(C, T), T, s),
+                    Tensor<cpu, 2, DType>(m + xi * F * T, Shape2(F, T), T, s),
+                    false, false, s, kWriteTo);
+      }
+      #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+      for (int io = 0; io < static_cast<int>(b * F); ++io) {
+        const index_t i = io / F, o = io % F;
+        conv_cpu::WinogradOutput(m + o * T + i * tiles, F * T, tiles_h, tiles_w,
+                                 out_h_, out_w_, bias != NULL ? bias[o] : DType(0),
+                                 out + (n0 + i) * out_dim_ + o * out_spatial_);
+      }
+    }
+  }
+
+  ConvolutionParam param_;
+  bool winograd_;
+  index_t num_;
+  index_t channels_;
+  index_t height_, width_;
+  index_t out_h_, out_w_;
+  int kernel_h_, kernel_w_;
+  int pad_h_, pad_w_;
+  int stride_h_, stride_w_;
+  int dilate_h_, dilate_w_;
+  index_t group_;
+  index_t num_filter_;
+  index_t kernel_dim_;  // number of input channels per group * kernel size
+  index_t out_spatial_;  // number of pixels of output images per channel
+  index_t in_dim_;  // input image size (#channels * height * width)
+  index_t out_dim_;  // output image size (#filters * out_h * out_w)
+  bool bias_term_;
+  bool is_1x1_;
+};  // class CPUConvolutionOp
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_CONVOLUTION_CPU_INL_H_
@@ -103,6 +103,9 @@ inline bool is_a_ge_zero_and_a_lt_b(int a, int b) {
  * \brief im2col 2D cpu version.
  * DO NOT call this function directly.
  * Use the wrapper function im2col() instead.
+ * \param col_stride distance between consecutive rows of data_col, so that
+ * several images can be laid side by side in one column buffer;
+ * 0 means the rows are dense (output_h * output_w).
  */
 template <typename DType>
 inline void im2col_cpu(const DType* data_im, const int channels,
@@ -110,12 +113,13 @@ inline void im2col_cpu(const DType* data_im, const int channels,
     const int pad_h, const int pad_w,
     const int stride_h, const int stride_w,
     const int dilation_h, const int dilation_w,
-    DType* data_col) {
+    DType* data_col, const int col_stride = 0) {
   const int output_h = (height + 2 * pad_h -
     (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1;
   const int output_w = (width + 2 * pad_w -
     (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
   const int channel_size = height * width;
+  const int col_skip = col_stride ? col_stride - output_h * output_w : 0;
   // TODO(junwu): we tested adding openmp (w/ & w/o collapse clause) here
   // for testing the performance of convolution operator,
   // but the total runtime increased by 0.8s for images of shape
@@ -147,6 +151,7 @@ inline void im2col_cpu(const DType* data_im, const int channels,
           }
           input_row += stride_h;
         }
+        data_col += col_skip;
       }
     }
   }
@@ -270,6 +275,7 @@ inline void im2col(mshadow::Stream<cpu>* s,
 /*!
  * \brief col2im 2D cpu version.
  * DO NOT call this function directly. Use wrapper function col2im() instead.
+ * \param col_stride distance between consecutive rows of data_col, 0 if dense.
  */
 template <typename DType>
 inline void col2im_cpu(const DType* data_col, const int channels,
@@ -277,7 +283,7 @@ inline void col2im_cpu(const DType* data_col, const int channels,
     const int pad_h, const int pad_w,
     const int stride_h, const int stride_w,
     const int dilation_h, const int dilation_w,
-    DType* data_im, OpReqType req) {
+    DType* data_im, OpReqType req, const int col_stride = 0) {
   if (mxnet::kNullOp == req) return;
   if (mxnet::kAddTo != req) {
     std::fill(data_im, data_im+height*width*channels, static_cast<DType>(0));
@@ -287,6 +293,7 @@ inline void col2im_cpu(const DType* data_col, const int channels,
   const int output_w = (width + 2 * pad_w -
     (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
   const int channel_size = height * width;
+  const int col_skip = col_stride ? col_stride - output_h * output_w : 0;
   // TODO(junwu): we tested adding openmp (w/ & w/o collapse clause) here
   // for testing the performance of convolution operator,
   // but the total runtime increased by 0.8s for images of shape
@@ -315,6 +322,7 @@ inline void col2im_cpu(const DType* data_col, const int channels,
           }
           input_row += stride_h;
         }
+        data_col += col_skip;
       }
     }
   }
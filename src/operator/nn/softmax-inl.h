@@ -25,11 +25,13 @@
 #ifndef MXNET_OPERATOR_NN_SOFTMAX_INL_H_
 #define MXNET_OPERATOR_NN_SOFTMAX_INL_H_
 
+#include <algorithm>
 #include <vector>
 
 #include "../mxnet_op.h"
 #include "../operator_common.h"
 #include "../tensor/broadcast_reduce_op.h"
+#include "../vec_math.h"
 
 namespace mxnet {
 namespace op {
@@ -51,6 +53,26 @@ struct log_softmax_fwd {
 };
 
 
+// softmax of a contiguous row with the vectorized kernels of vec_math.h,
+// returns false if there is none for OP and DType
+template<typename OP, typename DType>
+inline bool SoftmaxContiguous(const DType *in, DType *out, index_t M) {
+  return false;
+}
+
+template<>
+inline bool SoftmaxContiguous<softmax_fwd, float>(const float *in, float *out, index_t M) {
+  vec_math::Softmax(in, out, M);
+  return true;
+}
+
+template<>
+inline bool SoftmaxContiguous<log_softmax_fwd, float>(const float *in, float *out, index_t M) {
+  vec_math::LogSoftmax(in, out, M);
+  return true;
+}
+
+
 template<typename OP, typename DType, int ndim>
 inline void Softmax(Stream<cpu> *s, DType *in, DType *out,
                     Shape<ndim> shape, int axis) {
@@ -64,6 +86,7 @@ inline void Softmax(Stream<cpu> *s, DType *in, DType *out,
   #pragma omp parallel for
   for (int i = 0; i < static_cast<int>(N); ++i) {
     index_t base = unravel_dot(i, sshape, stride);
+    if (sa == 1 && SoftmaxContiguous<OP>(in + base, out + base, M)) continue;
 
     DType mmax = in[base];
     for (index_t j = 1; j < M; ++j) {
@@ -98,6 +121,36 @@ struct log_softmax_bwd {
 };
 
 
+// softmax gradient of a contiguous row with the vectorized exp of vec_math.h,
+// returns false if there is none for OP2 and DType
+template<typename OP2, typename DType>
+inline bool SoftmaxGradContiguous(const DType *out, const DType *ograd,
+                                  DType *igrad, index_t M) {
+  return false;
+}
+
+template<>
+inline bool SoftmaxGradContiguous<log_softmax_bwd, float>(const float *out, const float *ograd,
+                                                          float *igrad, index_t M) {
+  const index_t kChunk = 256;
+  float prob[kChunk];
+  // log_softmax is registered with OP1 = left, so the sum is over ograd
+  float sum = 0.0f;
+  for (index_t j = 0; j < M; ++j) {
+    sum += ograd[j];
+  }
+  // igrad may be ograd, so exp(out) goes through a buffer
+  for (index_t j = 0; j < M; j += kChunk) {
+    const index_t len = std::min(kChunk, M - j);
+    vec_math::ExpSum(out + j, 0.0f, prob, len);
+    for (index_t k = 0; k < len; ++k) {
+      igrad[j + k] = ograd[j + k] - prob[k] * sum;
+    }
+  }
+  return true;
+}
+
+
 template<typename OP1, typename OP2, typename DType, int ndim>
 inline void SoftmaxGrad(Stream<cpu> *s, DType *out, DType *ograd,
                         DType *igrad, Shape<ndim> shape, int axis) {
@@ -111,6 +164,9 @@ inline void SoftmaxGrad(Stream<cpu> *s, DType *out, DType *ograd,
   #pragma omp parallel for
   for (int i = 0; i < static_cast<int>(N); ++i) {
     index_t base = unravel_dot(i, sshape, stride);
+    if (sa == 1 && SoftmaxGradContiguous<OP2>(out + base, ograd + base, igrad + base, M)) {
+      continue;
+    }
 
     DType sum = DType(0);
     for (index_t j = 0; j < M; ++j) {
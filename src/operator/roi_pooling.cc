@@ -29,6 +29,7 @@
 #include <mshadow/packet-inl.h>
 #include <mshadow/dot_engine-inl.h>
 #include <cassert>
+#include "../engine/openmp.h"
 
 using std::max;
 using std::min;
@@ -54,13 +55,20 @@ inline void ROIPoolForward(const Tensor<cpu, 4, Dtype> &out,
 
   const int num_rois = bbox.size(0);
   const int data_size = data.size(1) * data.size(2) * data.size(3);
-  // For each ROI R = [batch_index x1 y1 x2 y2]: max pool over R
-  for (int n = 0; n < num_rois; ++n) {
-    int roi_batch_ind = bottom_rois[0];
-    int roi_start_w = round(bottom_rois[1] * spatial_scale_);
-    int roi_start_h = round(bottom_rois[2] * spatial_scale_);
-    int roi_end_w = round(bottom_rois[3] * spatial_scale_);
-    int roi_end_h = round(bottom_rois[4] * spatial_scale_);
+  const int data_size_c = data.size(2) * data.size(3);
+  const int out_size_c = out.size(2) * out.size(3);
+  // For each ROI R = [batch_index x1 y1 x2 y2]: max pool over R.
+  // Every (roi, channel) pair writes its own output plane, so they are split across threads.
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int nc = 0; nc < num_rois * channels_; ++nc) {
+    const int n = nc / channels_;
+    const int c = nc % channels_;
+    const Dtype *offset_bottom_rois = bottom_rois + n * bbox.size(1);
+    int roi_batch_ind = offset_bottom_rois[0];
+    int roi_start_w = round(offset_bottom_rois[1] * spatial_scale_);
+    int roi_start_h = round(offset_bottom_rois[2] * spatial_scale_);
+    int roi_end_w = round(offset_bottom_rois[3] * spatial_scale_);
+    int roi_end_h = round(offset_bottom_rois[4] * spatial_scale_);
     assert(roi_batch_ind >= 0);
     assert(static_cast<index_t>(roi_batch_ind) < data.size(0) /* batch size */);
 
@@ -72,54 +80,48 @@ inline void ROIPoolForward(const Tensor<cpu, 4, Dtype> &out,
     const Dtype bin_size_w = static_cast<Dtype>(roi_width)
                              / static_cast<Dtype>(pooled_width_);
 
-    const Dtype* batch_data = bottom_data + data_size * roi_batch_ind;
-
-    for (int c = 0; c < channels_; ++c) {
-      for (int ph = 0; ph < pooled_height_; ++ph) {
-        for (int pw = 0; pw < pooled_width_; ++pw) {
-          // Compute pooling region for this output unit:
-          //  start (included) = floor(ph * roi_height / pooled_height_)
-          //  end (excluded) = ceil((ph + 1) * roi_height / pooled_height_)
-          int hstart = static_cast<int>(floor(static_cast<Dtype>(ph)
-                                              * bin_size_h));
-          int wstart = static_cast<int>(floor(static_cast<Dtype>(pw)
-                                              * bin_size_w));
-          int hend = static_cast<int>(ceil(static_cast<Dtype>(ph + 1)
-                                           * bin_size_h));
-          int wend = static_cast<int>(ceil(static_cast<Dtype>(pw + 1)
-                                           * bin_size_w));
-
-          hstart = min(max(hstart + roi_start_h, 0), height_);
-          hend = min(max(hend + roi_start_h, 0), height_);
-          wstart = min(max(wstart + roi_start_w, 0), width_);
-          wend = min(max(wend + roi_start_w, 0), width_);
-
-          bool is_empty = (hend <= hstart) || (wend <= wstart);
-
-          const int pool_index = ph * pooled_width_ + pw;
-          if (is_empty) {
-            top_data[pool_index] = 0;
-            argmax_data[pool_index] = -1;
-          }
+    const Dtype* batch_data = bottom_data + data_size * roi_batch_ind + data_size_c * c;
+    Dtype *offset_top_data = top_data + out_size_c * nc;
+    Dtype *offset_argmax_data = argmax_data + out_size_c * nc;
+
+    for (int ph = 0; ph < pooled_height_; ++ph) {
+      for (int pw = 0; pw < pooled_width_; ++pw) {
+        // Compute pooling region for this output unit:
+        //  start (included) = floor(ph * roi_height / pooled_height_)
+        //  end (excluded) = ceil((ph + 1) * roi_height / pooled_height_)
+        int hstart = static_cast<int>(floor(static_cast<Dtype>(ph)
+                                            * bin_size_h));
+        int wstart = static_cast<int>(floor(static_cast<Dtype>(pw)
+                                            * bin_size_w));
+        int hend = static_cast<int>(ceil(static_cast<Dtype>(ph + 1)
+                                         * bin_size_h));
+        int wend = static_cast<int>(ceil(static_cast<Dtype>(pw + 1)
+                                         * bin_size_w));
+
+        hstart = min(max(hstart + roi_start_h, 0), height_);
+        hend = min(max(hend + roi_start_h, 0), height_);
+        wstart = min(max(wstart + roi_start_w, 0), width_);
+        wend = min(max(wend + roi_start_w, 0), width_);
+
+        bool is_empty = (hend <= hstart) || (wend <= wstart);
+
+        const int pool_index = ph * pooled_width_ + pw;
+        if (is_empty) {
+          offset_top_data[pool_index] = 0;
+          offset_argmax_data[pool_index] = -1;
+        }
 
-          for (int h = hstart; h < hend; ++h) {
-            for (int w = wstart; w < wend; ++w) {
-              const int index = h * width_ + w;
-              if (batch_data[index] > top_data[pool_index]) {
-                top_data[pool_index] = batch_data[index];
-                argmax_data[pool_index] = index;
-              }
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            const int index = h * width_ + w;
+            if (batch_data[index] > offset_top_data[pool_index]) {
+              offset_top_data[pool_index] = batch_data[index];
+              offset_argmax_data[pool_index] = index;
             }
           }
         }
       }
-      // Increment all data pointers by one channel
-      batch_data += data.size(2) * data.size(3);
-      top_data += out.size(2) * out.size(3);
-      argmax_data += max_idx.size(2) * max_idx.size(3);
     }
-    // Increment ROI data pointer
-    bottom_rois += bbox.size(1);
   }
 
   return;
@@ -145,73 +147,69 @@ inline void ROIPoolBackwardAcc(const Tensor<cpu, 4, Dtype> &in_grad,
 
   const int num_rois = bbox.size(0);
 
-  for (int b = 0; b < batch_size_; ++b) {
-    for (int c = 0; c < channels_; ++c) {
-      for (int h = 0; h < height_; ++h) {
-        for (int w = 0; w < width_; ++w) {
-          int offset_bottom_diff = (b * channels_ + c) * height_ * width_;
-          offset_bottom_diff += h * width_ + w;
-
-          Dtype gradient = 0;
-          // Accumulate gradient over all ROIs that pooled this element
-          for (int roi_n = 0; roi_n < num_rois; ++roi_n) {
-            const Dtype* offset_bottom_rois = bottom_rois + roi_n * 5;
-            int roi_batch_ind = offset_bottom_rois[0];
-            assert(roi_batch_ind >= 0);
-            assert(roi_batch_ind < batch_size_);
-            if (b != roi_batch_ind) {
-              continue;
-            }
-
-            int roi_start_w = round(offset_bottom_rois[1] * spatial_scale_);
-            int roi_start_h = round(offset_bottom_rois[2] * spatial_scale_);
-            int roi_end_w = round(offset_bottom_rois[3] * spatial_scale_);
-            int roi_end_h = round(offset_bottom_rois[4] * spatial_scale_);
-
-            bool in_roi = (w >= roi_start_w && w <= roi_end_w &&
-                           h >= roi_start_h && h <= roi_end_h);
-            if (!in_roi) {
-              continue;
-            }
+  // Scatter the gradient of every pooled bin to the element it took its max from, instead of
+  // searching all ROIs for every input element. The channels are split across threads, which
+  // keeps every thread on its own input planes. An element only receives the gradient of the
+  // bins whose pooling region, computed back from the element, contains it, as on GPU.
+  #pragma omp parallel for num_threads(mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int c = 0; c < channels_; ++c) {
+    for (int roi_n = 0; roi_n < num_rois; ++roi_n) {
+      const Dtype* offset_bottom_rois = bottom_rois + roi_n * 5;
+      int roi_batch_ind = offset_bottom_rois[0];
+      assert(roi_batch_ind >= 0);
+      assert(roi_batch_ind < batch_size_);
+
+      int roi_start_w = round(offset_bottom_rois[1] * spatial_scale_);
+      int roi_start_h = round(offset_bottom_rois[2] * spatial_scale_);
+      int roi_end_w = round(offset_bottom_rois[3] * spatial_scale_);
+      int roi_end_h = round(offset_bottom_rois[4] * spatial_scale_);
+
+      // force malformed ROIs to be 1 * 1
+      int roi_height = max(roi_end_h - roi_start_h + 1, 1);
+      int roi_width = max(roi_end_w - roi_start_w + 1, 1);
+      const Dtype bin_size_h = static_cast<Dtype>(roi_height)
+                               / static_cast<Dtype>(pooled_height_);
+      const Dtype bin_size_w = static_cast<Dtype>(roi_width)
+                               / static_cast<Dtype>(pooled_width_);
+
+      int offset = (roi_n * channels_ + c) * pooled_height_ * pooled_width_;
+      const Dtype* offset_top_diff = top_diff + offset;
+      const Dtype* offset_argmax_data = argmax_data + offset;
+      Dtype* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels_ + c) * height_ * width_;
+      for (int ph = 0; ph < pooled_height_; ++ph) {
+        for (int pw = 0; pw < pooled_width_; ++pw) {
+          const int pooled_index = ph * pooled_width_ + pw;
+          const int argmax = static_cast<int>(offset_argmax_data[pooled_index]);
+          if (argmax < 0) {
+            continue;
+          }
+          const int h = argmax / width_;
+          const int w = argmax % width_;
+          bool in_roi = (w >= roi_start_w && w <= roi_end_w &&
+                         h >= roi_start_h && h <= roi_end_h);
+          if (!in_roi) {
+            continue;
+          }
 
-            // force malformed ROIs to be 1 * 1
-            int roi_height = max(roi_end_h - roi_start_h + 1, 1);
-            int roi_width = max(roi_end_w - roi_start_w + 1, 1);
-            const Dtype bin_size_h = static_cast<Dtype>(roi_height)
-                                     / static_cast<Dtype>(pooled_height_);
-            const Dtype bin_size_w = static_cast<Dtype>(roi_width)
-                                     / static_cast<Dtype>(pooled_width_);
-
-            // compute pooled regions correspond to original (h, w) point
-            int phstart = static_cast<int>(floor(static_cast<Dtype>(h - roi_start_h)
-                                                 / bin_size_h));
-            int pwstart = static_cast<int>(floor(static_cast<Dtype>(w - roi_start_w)
-                                                 / bin_size_w));
-            int phend = static_cast<int>(ceil(static_cast<Dtype>(h - roi_start_h + 1)
-                                              / bin_size_h));
-            int pwend = static_cast<int>(ceil(static_cast<Dtype>(w - roi_start_w + 1)
-                                              / bin_size_w));
-
-            // clip to boundaries of pooled region
-            phstart = min(max(phstart, 0), pooled_height_);
-            phend = min(max(phend, 0), pooled_height_);
-            pwstart = min(max(pwstart, 0), pooled_width_);
-            pwend = min(max(pwend, 0), pooled_width_);
-
-            // accumulate over gradients in pooled regions
-            int offset = (roi_n * channels_ + c) * pooled_height_ * pooled_width_;
-            const Dtype* offset_top_diff = top_diff + offset;
-            const Dtype* offset_argmax_data = argmax_data + offset;
-            for (int ph = phstart; ph < phend; ++ph) {
-              for (int pw = pwstart; pw < pwend; ++pw) {
-                const int pooled_index = ph * pooled_width_ + pw;
-                if (static_cast<int>(offset_argmax_data[pooled_index]) == h * width_ + w) {
-                  gradient += offset_top_diff[pooled_index];
-                }
-              }
-            }
+          // compute pooled regions correspond to original (h, w) point
+          int phstart = static_cast<int>(floor(static_cast<Dtype>(h - roi_start_h)
+                                               / bin_size_h));
+          int pwstart = static_cast<int>(floor(static_cast<Dtype>(w - roi_start_w)
+                                               / bin_size_w));
+          int phend = static_cast<int>(ceil(static_cast<Dtype>(h - roi_start_h + 1)
+                                            / bin_size_h));
+          int pwend = static_cast<int>(ceil(static_cast<Dtype>(w - roi_start_w + 1)
+                                            / bin_size_w));
+
+          // clip to boundaries of pooled region
+          phstart = min(max(phstart, 0), pooled_height_);
+          phend = min(max(phend, 0), pooled_height_);
+          pwstart = min(max(pwstart, 0), pooled_width_);
+          pwend = min(max(pwend, 0), pooled_width_);
+          if (ph < phstart || ph >= phend || pw < pwstart || pw >= pwend) {
+            continue;
           }
-          bottom_diff[offset_bottom_diff] += gradient;
+          offset_bottom_diff[argmax] += offset_top_diff[pooled_index];
         }
       }
     }
@@ -90,6 +90,18 @@ struct SoftmaxOutputParam : public dmlc::Parameter<SoftmaxOutputParam> {
   };
 };
 
+/*! \brief softmax of every row of data */
+template<typename xpu, typename DType>
+inline void SoftmaxRows(mshadow::Tensor<xpu, 2, DType> out,
+                        const mshadow::Tensor<xpu, 2, DType> &data) {
+  mshadow::Softmax(out, data);
+}
+
+/*! \brief float rows on CPU go through the vectorized softmax of vec_math.h */
+template<>
+void SoftmaxRows<mshadow::cpu, float>(mshadow::Tensor<mshadow::cpu, 2, float> out,
+                                      const mshadow::Tensor<mshadow::cpu, 2, float> &data);
+
 template<typename xpu, typename DType>
 class SoftmaxOutputOp : public Operator {
  public:
@@ -118,7 +130,7 @@ class SoftmaxOutputOp : public Operator {
       if (param_.preserve_shape) {
         Tensor<xpu, 2, DType> data = in_data[softmaxout_enum::kData].FlatTo2D<xpu, DType>(s);
         Tensor<xpu, 2, DType> out = out_data[softmaxout_enum::kOut].FlatTo2D<xpu, DType>(s);
-        Softmax(out, data);
+        SoftmaxRows(out, data);
       } else {
         int n = in_data[softmaxout_enum::kData].size(0);
         int k = in_data[softmaxout_enum::kData].Size()/n;
@@ -127,7 +139,7 @@ class SoftmaxOutputOp : public Operator {
             in_data[softmaxout_enum::kData].get_with_shape<xpu, 2, DType>(s2, s);
         Tensor<xpu, 2, DType> out =
             out_data[softmaxout_enum::kOut].get_with_shape<xpu, 2, DType>(s2, s);
-        Softmax(out, data);
+        SoftmaxRows(out, data);
       }
     }
   }
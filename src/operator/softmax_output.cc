@@ -24,9 +24,22 @@
  * \author Bing Xu
 */
 #include "./softmax_output-inl.h"
+#include "./vec_math.h"
+#include "../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
+template<>
+void SoftmaxRows<cpu, float>(mshadow::Tensor<cpu, 2, float> out,
+                             const mshadow::Tensor<cpu, 2, float> &data) {
+  CHECK_EQ(out.shape_, data.shape_) << "Softmax: shape mismatch";
+  const int rows = out.size(0);
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int y = 0; y < rows; ++y) {
+    vec_math::Softmax(data[y].dptr_, out[y].dptr_, out.size(1));
+  }
+}
+
 template<>
 Operator *CreateOp<cpu>(SoftmaxOutputParam param, int dtype) {
   Operator *op = NULL;
@@ -31,6 +31,7 @@
 #include <string>
 #include <utility>
 #include "../mshadow_op.h"
+#include "../mxnet_op.h"
 
 namespace mxnet {
 namespace op {
@@ -140,45 +141,72 @@ MSHADOW_XINLINE void assign(DType* dst, const bool addto, const DType src) {
   }
 }
 
-template<int ndim, typename DType, typename OP>
-MSHADOW_XINLINE void binary_broadcast_assign(const int idx, const bool addto,
-                                             const DType* __restrict lhs,
-                                             const DType* __restrict rhs, DType* out,
-                                             const Shape<ndim>& lshape, const Shape<ndim>& rshape,
-                                             const Shape<ndim>& oshape) {
-  const Shape<ndim> coord = unravel(idx, oshape);
-  const int j = ravel(coord, lshape);
-  const int k = ravel(coord, rshape);
-  assign(&out[idx], addto, OP::Map(lhs[j], rhs[k]));
+#ifdef __CUDACC__
+#include "broadcast_reduce-inl.cuh"
+
+#else
+
+/*! \brief element count below which the cpu kernels run on one thread */
+const int kMinParallelWork = 1 << 15;
+/*! \brief number of outputs reduced together along a kept contiguous axis */
+const int kReduceLanes = 256;
+
+/*!
+ * \brief the last axis longer than one, along which the innermost loops run
+ *  over contiguous memory
+ */
+template<int ndim>
+inline int inner_axis(const Shape<ndim>& shape) {
+  int axis = ndim - 1;
+  while (axis > 0 && shape[axis] == 1) --axis;
+  return axis;
 }
 
-template<typename Reducer, int ndim, typename DType, typename OP>
-MSHADOW_XINLINE void seq_reduce_assign(const int idx, const int M, const bool addto,
-                                       const DType* __restrict big, DType *small,
-                                       const Shape<ndim>& bshape, const Shape<ndim>& sshape,
-                                       const Shape<ndim>& rshape, const Shape<ndim>& rstride) {
-  Shape<ndim> coord = unravel(idx, sshape);
-  int j = ravel(coord, bshape);
-  DType val, residual;
-  Reducer::SetInitValue(val, residual);
-  for (int k = 0; k < M; ++k) {
-    coord = unravel(k, rshape);
-    Reducer::Reduce(val, OP::Map(big[j + dot(coord, rstride)]), residual);
-  }
-  assign(&small[idx], addto, val);
+/*! \brief number of threads for a cpu kernel doing work element operations */
+inline int cpu_threads(const int64_t work) {
+  return work < kMinParallelWork ? 1 : engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
 }
 
-#ifdef __CUDACC__
-#include "broadcast_reduce-inl.cuh"
+/*!
+ * \brief Reducer::Reduce through non-volatile references, so that independent
+ *  accumulators can be kept in registers and vectorized
+ */
+template<typename Reducer, typename DType>
+MSHADOW_XINLINE void reduce_into(DType& val, const DType src, DType& residual) {  // NOLINT(*)
+  Reducer::Reduce(val, src, residual);
+}
 
-#else
+/*! \brief Kahan summation of mshadow::red::sum */
+template<>
+MSHADOW_XINLINE void reduce_into<mshadow::red::sum, float>(
+    float& val, const float src, float& residual) {  // NOLINT(*)
+  const float y = src - residual;
+  const float t = val + y;
+  residual = (t - val) - y;
+  val = t;
+}
 
-template<int ndim, typename DType, typename OP>
-void binary_broadcast_compute(const int N, const bool addto, const DType *lhs,
-                              const DType *rhs, DType *out, const Shape<ndim> lshape,
-                              const Shape<ndim> rshape, const Shape<ndim> oshape) {
-  for (int idx = 0; idx < N; ++idx) {
-    binary_broadcast_assign<ndim, DType, OP>(idx, addto, lhs, rhs, out, lshape, rshape, oshape);
+template<>
+MSHADOW_XINLINE void reduce_into<mshadow::red::sum, double>(
+    double& val, const double src, double& residual) {  // NOLINT(*)
+  const double y = src - residual;
+  const double t = val + y;
+  residual = (t - val) - y;
+  val = t;
+}
+
+/*! \brief out[i] (+)= OP(lhs[i * lstep], rhs[i * rstep]) for one contiguous output row */
+template<typename DType, typename OP, int lstep, int rstep>
+inline void binary_broadcast_row(const int n, const bool addto, const DType* __restrict lhs,
+                                 const DType* __restrict rhs, DType* out) {
+  if (addto) {
+    for (int i = 0; i < n; ++i) {
+      out[i] += OP::Map(lhs[i * lstep], rhs[i * rstep]);
+    }
+  } else {
+    for (int i = 0; i < n; ++i) {
+      out[i] = OP::Map(lhs[i * lstep], rhs[i * rstep]);
+    }
   }
 }
 
@@ -186,20 +214,76 @@ template<int ndim, typename DType, typename OP>
 void BinaryBroadcastComputeImpl(Stream<cpu> *s, const OpReqType req,
                                 const TBlob& lhs, const TBlob& rhs, const TBlob& out) {
   if (req == kNullOp) return;
-  int N = out.shape_.Size();
-  binary_broadcast_compute<ndim, DType, OP>(N, req == kAddTo, lhs.dptr<DType>(), rhs.dptr<DType>(),
-                           out.dptr<DType>(), lhs.shape_.get<ndim>(), rhs.shape_.get<ndim>(),
-                           out.shape_.get<ndim>());
+  const int N = out.shape_.Size();
+  if (N == 0) return;
+  const Shape<ndim> lshape = lhs.shape_.get<ndim>();
+  const Shape<ndim> rshape = rhs.shape_.get<ndim>();
+  const Shape<ndim> oshape = out.shape_.get<ndim>();
+  const bool addto = req == kAddTo;
+  const DType *lptr = lhs.dptr<DType>(), *rptr = rhs.dptr<DType>();
+  DType *optr = out.dptr<DType>();
+  // the output is processed in rows along the inner axis, where each input
+  // either advances with the output or repeats a single value
+  const int axis = inner_axis(oshape);
+  const int L = oshape[axis];
+  const int rows = N / L;
+  const bool lmove = lshape[axis] > 1, rmove = rshape[axis] > 1;
+  const int nthread = cpu_threads(N);
+  // rows are cut into segments when there are fewer rows than threads
+  const int nseg = rows >= nthread ? 1 : std::max(1, std::min((nthread + rows - 1) / rows,
+                                                              L / (kMinParallelWork / 8)));
+  #pragma omp parallel for num_threads(nthread)
+  for (int u = 0; u < rows * nseg; ++u) {
+    const int r = u / nseg, seg = u % nseg;
+    const int begin = static_cast<int64_t>(L) * seg / nseg;
+    const int end = static_cast<int64_t>(L) * (seg + 1) / nseg;
+    const Shape<ndim> coord = unravel(r * L, oshape);
+    const DType *l = lptr + ravel(coord, lshape) + (lmove ? begin : 0);
+    const DType *rr = rptr + ravel(coord, rshape) + (rmove ? begin : 0);
+    DType *o = optr + r * L + begin;
+    if (lmove && rmove) {
+      binary_broadcast_row<DType, OP, 1, 1>(end - begin, addto, l, rr, o);
+    } else if (lmove) {
+      binary_broadcast_row<DType, OP, 1, 0>(end - begin, addto, l, rr, o);
+    } else if (rmove) {
+      binary_broadcast_row<DType, OP, 0, 1>(end - begin, addto, l, rr, o);
+    } else {
+      binary_broadcast_row<DType, OP, 0, 0>(end - begin, addto, l, rr, o);
+    }
+  }
 }
 
+/*!
+ * \brief reduce the elements [begin, end) of the reduced axes starting at big,
+ *  when the inner axis is reduced and its elements form contiguous runs
+ */
 template<typename Reducer, int ndim, typename DType, typename OP>
-void seq_reduce_compute(const int N, const int M, const bool addto,
-                        const DType *big, DType *small, const Shape<ndim> bshape,
-                        const Shape<ndim> sshape, const Shape<ndim> rshape,
-                        const Shape<ndim> rstride) {
-  for (int idx = 0; idx < N; ++idx) {
-    seq_reduce_assign<Reducer, ndim, DType, OP>(idx, M, addto, big, small, bshape, sshape, rshape,
-      rstride);
+inline void reduce_runs(const DType* big, const int begin, const int end, const int L,
+                        const Shape<ndim>& rshape, const Shape<ndim>& rstride,
+                        DType* val, DType* residual) {
+  for (int k = begin; k < end;) {
+    const int run_end = std::min(end, (k / L + 1) * L);
+    const DType* __restrict run = big + unravel_dot(k, rshape, rstride);
+    for (int i = 0; i < run_end - k; ++i) {
+      reduce_into<Reducer>(*val, OP::Map(run[i]), *residual);
+    }
+    k = run_end;
+  }
+}
+
+/*!
+ * \brief reduce the elements [begin, end) of the reduced axes into width
+ *  consecutive outputs along the kept inner axis
+ */
+template<typename Reducer, int ndim, typename DType, typename OP>
+inline void reduce_lanes(const DType* big, const int begin, const int end, const int width,
+                         const Shape<ndim>& rshape, const Shape<ndim>& rstride,
+                         DType* __restrict val, DType* __restrict residual) {
+  for (int k = begin; k < end; ++k) {
+    const DType* __restrict row = big + unravel_dot(k, rshape, rstride);
+    for (int i = 0; i < width; ++i) {
+      reduce_into<Reducer>(val[i], OP::Map(row[i]), residual[i]);
+    }
   }
 }
 
@@ -209,10 +293,63 @@ void Reduce(Stream<cpu> *s, const TBlob& small, const OpReqType req,
   if (req == kNullOp) return;
   Shape<ndim> rshape, rstride;
   diff(small.shape_.get<ndim>(), big.shape_.get<ndim>(), &rshape, &rstride);
-  int N = small.shape_.Size(), M = rshape.Size();
-  seq_reduce_compute<Reducer, ndim, DType, OP>(
-    N, M, req == kAddTo, big.dptr<DType>(), small.dptr<DType>(), big.shape_.get<ndim>(),
-    small.shape_.get<ndim>(), rshape, rstride);
+  const int N = small.shape_.Size(), M = rshape.Size();
+  if (N == 0) return;
+  const Shape<ndim> bshape = big.shape_.get<ndim>();
+  const Shape<ndim> sshape = small.shape_.get<ndim>();
+  const bool addto = req == kAddTo;
+  const DType *bptr = big.dptr<DType>();
+  DType *sptr = small.dptr<DType>();
+  const int nthread = cpu_threads(static_cast<int64_t>(N) * M);
+  const int axis = inner_axis(bshape);
+  // outputs reduce contiguous runs when the inner axis is reduced, otherwise
+  // kReduceLanes neighbouring outputs along the inner axis are reduced together
+  const bool runs = sshape[axis] == 1;
+  const int L = bshape[axis];
+  const int lanes = runs ? 1 : std::min(L, kReduceLanes);
+  const int nlane = runs ? 1 : (L + lanes - 1) / lanes;
+  const int units = runs ? N : N / L * nlane;
+  // when there are fewer units than threads, the reduced axes are split as well
+  const int nsplit = units >= nthread ? 1 : std::max(1, std::min(nthread / units, M / 1024));
+  std::vector<DType> partial(nsplit > 1 ? static_cast<size_t>(N) * nsplit : 0);
+  #pragma omp parallel for num_threads(nthread)
+  for (int t = 0; t < units * nsplit; ++t) {
+    const int u = t / nsplit, split = t % nsplit;
+    const int begin = static_cast<int64_t>(M) * split / nsplit;
+    const int end = static_cast<int64_t>(M) * (split + 1) / nsplit;
+    // first output of the unit and its number of outputs
+    const int first = runs ? u : u / nlane * L + u % nlane * lanes;
+    const int width = runs ? 1 : std::min(lanes, L - u % nlane * lanes);
+    const DType *b = bptr + ravel(unravel(first, sshape), bshape);
+    DType val[kReduceLanes], residual[kReduceLanes];
+    for (int i = 0; i < width; ++i) {
+      Reducer::SetInitValue(val[i], residual[i]);
+    }
+    if (runs) {
+      reduce_runs<Reducer, ndim, DType, OP>(b, begin, end, L, rshape, rstride, val, residual);
+    } else {
+      reduce_lanes<Reducer, ndim, DType, OP>(b, begin, end, width, rshape, rstride,
+                                             val, residual);
+    }
+    for (int i = 0; i < width; ++i) {
+      if (nsplit > 1) {
+        partial[static_cast<size_t>(split) * N + first + i] = val[i];
+      } else {
+        assign(&sptr[first + i], addto, val[i]);
+      }
+    }
+  }
+  if (nsplit > 1) {
+    // combine the partial results in a fixed order
+    for (int idx = 0; idx < N; ++idx) {
+      DType val, residual;
+      Reducer::SetInitValue(val, residual);
+      for (int split = 0; split < nsplit; ++split) {
+        reduce_into<Reducer>(val, partial[static_cast<size_t>(split) * N + idx], residual);
+      }
+      assign(&sptr[idx], addto, val);
+    }
+  }
 }
 
 template<int ndim, typename DType>
@@ -266,6 +403,7 @@ void seq_reduce_compute(const int N, const int M, const bool addto,
                         const Shape<ndim> lhs_shape, const Shape<ndim> lhs_stride,
                         const Shape<ndim> rhs_shape, const Shape<ndim> rhs_stride,
                         const Shape<ndim>& lhs_shape0, const Shape<ndim>& rhs_shape0) {
+  #pragma omp parallel for num_threads(cpu_threads(static_cast<int64_t>(N) * M))
   for (int idx = 0; idx < N; ++idx) {
     seq_reduce_assign<Reducer, ndim, DType, OP1, OP2>(idx, M, addto, big, lhs, rhs, small,
       big_shape, lhs_shape0, rhs_shape0, small_shape, rshape, lhs_shape, rhs_shape, rstride,
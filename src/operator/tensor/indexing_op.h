@@ -97,7 +97,8 @@ AddTakeGradLargeBatchWorkspaceSize(size_t num_keys);
 /*!
  * \brief CPU/GPU: Gradient accumulate of embedding matrix.
                    dst[sorted[i]] += src[index[i]]
-                   Called when the batchsize of src is larger than the featuredim
+                   Called when the batchsize of src is larger than the featuredim.
+                   On CPU the runs of equal row ids are split across threads.
  * \param dst destination
  * \param sorted the sorted indices
  * \param index original index of the sorted indices
@@ -110,8 +111,30 @@ inline void AddTakeGradLargeBatch(mshadow::Tensor<cpu, 2, DType> dst,
                                   const mshadow::Tensor<cpu, 1, IndexType>& index,
                                   const mshadow::Tensor<cpu, 2, DType> &src,
                                   mshadow::Tensor<cpu, 1, char>* workspace = NULL) {
-  for (index_t y = 0; y < sorted.size(0); ++y) {
-    dst[sorted[y]] += src[index[y]];
+  const index_t num_items = sorted.size(0);
+  const index_t row_length = dst.size(1);
+  // below this many accumulated elements a single thread is faster
+  const index_t kMinWorkPerChunk = 1 << 15;
+  const int nchunks = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(
+      engine::OpenMP::Get()->GetRecommendedOMPThreadCount(),
+      static_cast<uint64_t>(num_items) * row_length / kMinWorkPerChunk)));
+  // Split the sorted keys into equal ranges and move every boundary forward to the start
+  // of the next run of equal row ids, so each row of dst is updated by exactly one chunk
+  // and the chunks need no atomics. The inner loop is a plain row add the compiler
+  // vectorizes.
+  #pragma omp parallel for num_threads(nchunks)
+  for (int chunk = 0; chunk < nchunks; ++chunk) {
+    index_t begin = static_cast<uint64_t>(num_items) * chunk / nchunks;
+    index_t end = static_cast<uint64_t>(num_items) * (chunk + 1) / nchunks;
+    while (begin > 0 && begin < num_items && sorted[begin] == sorted[begin - 1]) ++begin;
+    while (end < num_items && sorted[end] == sorted[end - 1]) ++end;
+    for (index_t y = begin; y < end; ++y) {
+      DType* out = dst.dptr_ + static_cast<index_t>(sorted[y]) * dst.stride_;
+      const DType* in = src.dptr_ + static_cast<index_t>(index[y]) * src.stride_;
+      for (index_t j = 0; j < row_length; ++j) {
+        out[j] += in[j];
+      }
+    }
   }
 }
 /*!
@@ -31,6 +31,8 @@
 #include <algorithm>
 #include <vector>
 #include <type_traits>
+#include <utility>
+#include "../../engine/openmp.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
 #include "./sort_op.h"
@@ -152,6 +154,82 @@ inline void ParseTopKParam(const TShape& src_shape, const TopKParam& param, TSha
                                       << *element_num << ", get k = " << *k;
 }
 
+/*! \brief above this k the CPU top-k selects with nth_element instead of a bounded heap */
+const int kTopKHeapMax = 64;
+
+/*!
+ * \brief CPU implementation of TopK that selects the top k of every row independently,
+ *  in parallel over the rows, instead of sorting the whole tensor three times.
+ *  A small k keeps a bounded heap while scanning the row, so most elements cost a single
+ *  comparison against the current k-th best; a larger k uses nth_element and sorts the
+ *  first k. Ties are broken by the lower index, the order the stable sort produces.
+ */
+inline void TopKImplRows(const TBlob& src, const std::vector<TBlob>& ret,
+                         const TopKParam& param, int batch_size, int element_num, int k,
+                         int axis, bool is_ascend) {
+  typedef std::pair<real_t, int> Entry;
+  const real_t* dat = src.dptr<real_t>();
+  // rows are strided by `inner` when the axis is not the last one
+  const index_t inner = static_cast<bool>(param.axis) ?
+                        src.shape_.ProdShape(axis + 1, src.shape_.ndim()) : 1;
+  real_t* ret_value = NULL;
+  real_t* ret_indices = NULL;
+  if (param.ret_typ == topk_enum::kReturnMask) {
+    std::fill(ret[0].dptr<real_t>(), ret[0].dptr<real_t>() + ret[0].Size(), real_t(0));
+  } else if (param.ret_typ == topk_enum::kReturnIndices) {
+    ret_indices = ret[0].dptr<real_t>();
+  } else {
+    ret_value = ret[0].dptr<real_t>();
+    if (param.ret_typ == topk_enum::kReturnBoth) ret_indices = ret[1].dptr<real_t>();
+  }
+  // `before(a, b)` is true when a ranks ahead of b
+  auto before = [is_ascend](const Entry& a, const Entry& b) {
+    return is_ascend ? (a.first < b.first || (a.first == b.first && a.second < b.second))
+                     : (a.first > b.first || (a.first == b.first && a.second < b.second));
+  };
+  const bool use_heap = k <= kTopKHeapMax && k < element_num;
+  #pragma omp parallel num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  {
+    std::vector<Entry> row(use_heap ? k : element_num);
+    #pragma omp for
+    for (int r = 0; r < batch_size; ++r) {
+      const index_t outer = r / inner, i = r % inner;
+      const real_t* in = dat + outer * element_num * inner + i;
+      if (use_heap) {
+        // a max-heap w.r.t. `before`, so the front is the worst of the k kept so far;
+        // later elements only win strictly since they have larger indices
+        for (int j = 0; j < k; ++j) row[j] = Entry(in[j * inner], j);
+        std::make_heap(row.begin(), row.end(), before);
+        for (int j = k; j < element_num; ++j) {
+          const real_t v = in[j * inner];
+          if (is_ascend ? v < row[0].first : v > row[0].first) {
+            std::pop_heap(row.begin(), row.end(), before);
+            row[k - 1] = Entry(v, j);
+            std::push_heap(row.begin(), row.end(), before);
+          }
+        }
+        std::sort_heap(row.begin(), row.end(), before);
+      } else {
+        for (int j = 0; j < element_num; ++j) row[j] = Entry(in[j * inner], j);
+        if (k < element_num) {
+          std::nth_element(row.begin(), row.begin() + k - 1, row.end(), before);
+        }
+        std::sort(row.begin(), row.begin() + k, before);
+      }
+      if (param.ret_typ == topk_enum::kReturnMask) {
+        real_t* mask = ret[0].dptr<real_t>() + outer * element_num * inner + i;
+        for (int j = 0; j < k; ++j) mask[row[j].second * inner] = 1;
+        continue;
+      }
+      const index_t offset = outer * k * inner + i;
+      for (int j = 0; j < k; ++j) {
+        if (ret_value != NULL) ret_value[offset + j * inner] = row[j].first;
+        if (ret_indices != NULL) ret_indices[offset + j * inner] = row[j].second;
+      }
+    }
+  }
+}
+
 /*!
    * \brief Implementation of the TopK operation
    *
@@ -190,6 +268,10 @@ void TopKImpl(RunContext ctx,
   TShape target_shape;
   ParseTopKParam(src.shape_, param,
                  &target_shape, &batch_size, &element_num, &axis, &k, &do_transpose, &is_ascend);
+  if (std::is_same<xpu, cpu>::value) {
+    TopKImplRows(src, ret, param, batch_size, element_num, k, axis, is_ascend);
+    return;
+  }
   Tensor<xpu, 3, real_t> dat = src.FlatTo3D<xpu, real_t>(axis, axis, s);
   size_t temp_size = mxnet::op::SortByKeyWorkspaceSize<int, int, xpu>(src.Size());
   temp_size = std::max(temp_size, mxnet::op::SortByKeyWorkspaceSize<int, real_t, xpu>(src.Size()));
@@ -0,0 +1,430 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file vec_math.cc
+ * \brief vectorized exp, log, reductions and softmax over contiguous float arrays on CPU.
+ *  The AVX2 and AVX-512 kernels are compiled with target attributes, so the library does not
+ *  need to be built for those instruction sets, and the first call picks the widest kernels
+ *  the running CPU supports. Other CPUs and compilers use the scalar kernels.
+ */
+#include "./vec_math.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MXNET_VEC_MATH_X86 1
+#include <immintrin.h>
+#else
+#define MXNET_VEC_MATH_X86 0
+#endif
+
+namespace mxnet {
+namespace op {
+namespace vec_math {
+
+namespace {
+// exp(r) for |r| <= ln(2)/2, Cephes polynomial
+const float kExpP0 = 1.9875691500e-4f;
+const float kExpP1 = 1.3981999507e-3f;
+const float kExpP2 = 8.3334519073e-3f;
+const float kExpP3 = 4.1665795894e-2f;
+const float kExpP4 = 1.6666665459e-1f;
+const float kExpP5 = 5.0000001201e-1f;
+const float kLog2e = 1.44269504088896341f;
+// ln(2) split in two so that k * kLn2Hi is exact
+const float kLn2Hi = 0.693359375f;
+const float kLn2Lo = -2.12194440e-4f;
+// exp of inputs below log(FLT_MIN) is flushed to zero, above log(FLT_MAX) it saturates
+const float kExpLow = -87.3365448f;
+const float kExpHigh = 88.3762626f;
+// log(1 + r) for sqrt(1/2) - 1 <= r < sqrt(2) - 1, Cephes polynomial
+const float kLogP0 = 7.0376836292e-2f;
+const float kLogP1 = -1.1514610310e-1f;
+const float kLogP2 = 1.1676998740e-1f;
+const float kLogP3 = -1.2420140846e-1f;
+const float kLogP4 = 1.4249322787e-1f;
+const float kLogP5 = -1.6668057665e-1f;
+const float kLogP6 = 2.0000714765e-1f;
+const float kLogP7 = -2.4999993993e-1f;
+const float kLogP8 = 3.3333331174e-1f;
+const float kSqrtHalf = 0.707106781186547524f;
+
+float MaxScalar(const float *x, index_t n) {
+  float mmax = x[0];
+  for (index_t i = 0; i < n; ++i) {
+    if (std::isnan(x[i])) return x[i];
+    if (mmax < x[i]) mmax = x[i];
+  }
+  return mmax;
+}
+
+float ExpSumScalar(const float *x, float shift, float *y, index_t n) {
+  float sum = 0.0f;
+  for (index_t i = 0; i < n; ++i) {
+    const float e = std::exp(x[i] - shift);
+    if (y) y[i] = e;
+    sum += e;
+  }
+  return sum;
+}
+
+void LogSumExp3Scalar(const float *a, const float *b, const float *c, float *y, index_t n) {
+  for (index_t i = 0; i < n; ++i) {
+    const float va = a[i], vb = b[i], vc = c[i];
+    const float m = std::max(std::max(va, vb), vc);
+    y[i] = m == -std::numeric_limits<float>::infinity() ? m :
+           m + std::log(std::exp(va - m) + std::exp(vb - m) + std::exp(vc - m));
+  }
+}
+
+#if MXNET_VEC_MATH_X86
+__attribute__((target("avx2,fma")))
+inline __m256 Exp8(__m256 v) {
+  // NaN lanes are passed through like std::exp does
+  const __m256 nan = _mm256_and_ps(_mm256_cmp_ps(v, v, _CMP_UNORD_Q), v);
+  const __m256 valid = _mm256_cmp_ps(v, _mm256_set1_ps(kExpLow), _CMP_GE_OQ);
+  // lanes below kExpLow are computed as exp(0) and masked at the end, clamping them to kExpLow
+  // instead would make the last multiply produce denormals, which are slow on many CPUs
+  v = _mm256_min_ps(_mm256_and_ps(v, valid), _mm256_set1_ps(kExpHigh));
+  // v = k * ln(2) + r
+  const __m256 k = _mm256_floor_ps(_mm256_fmadd_ps(v, _mm256_set1_ps(kLog2e),
+                                                   _mm256_set1_ps(0.5f)));
+  __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kLn2Hi), v);
+  r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kLn2Lo), r);
+  __m256 p = _mm256_set1_ps(kExpP0);
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP1));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP2));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP3));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP4));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP5));
+  p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+  // 2^k from the exponent bits
+  const __m256i e = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+  return _mm256_or_ps(_mm256_and_ps(_mm256_mul_ps(p, _mm256_castsi256_ps(e)), valid), nan);
+}
+
+__attribute__((target("avx2,fma")))
+inline float HorizontalSum8(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2,fma")))
+float MaxAVX2(const float *x, index_t n) {
+  __m256 acc = _mm256_set1_ps(x[0]);
+  // max_ps drops NaN in its first operand, so NaN lanes are tracked separately
+  __m256 nan = _mm256_setzero_ps();
+  index_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 v = _mm256_loadu_ps(x + i);
+    acc = _mm256_max_ps(acc, v);
+    nan = _mm256_or_ps(nan, _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+  }
+  if (_mm256_movemask_ps(nan)) return std::numeric_limits<float>::quiet_NaN();
+  float lanes[8];
+  _mm256_storeu_ps(lanes, acc);
+  float mmax = MaxScalar(lanes, 8);
+  for (; i < n; ++i) {
+    if (std::isnan(x[i])) return x[i];
+    if (mmax < x[i]) mmax = x[i];
+  }
+  return mmax;
+}
+
+__attribute__((target("avx2,fma")))
+float ExpSumAVX2(const float *x, float shift, float *y, index_t n) {
+  const __m256 vshift = _mm256_set1_ps(shift);
+  __m256 acc = _mm256_setzero_ps();
+  index_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 e = Exp8(_mm256_sub_ps(_mm256_loadu_ps(x + i), vshift));
+    if (y) _mm256_storeu_ps(y + i, e);
+    acc = _mm256_add_ps(acc, e);
+  }
+  if (i < n) {
+    // the tail is padded with -inf, whose exp is zero
+    float tail[8];
+    const int len = static_cast<int>(n - i);
+    for (int j = 0; j < 8; ++j) {
+      tail[j] = j < len ? x[i + j] : -std::numeric_limits<float>::infinity();
+    }
+    const __m256 e = Exp8(_mm256_sub_ps(_mm256_loadu_ps(tail), vshift));
+    _mm256_storeu_ps(tail, e);
+    if (y) std::copy(tail, tail + len, y + i);
+    acc = _mm256_add_ps(acc, e);
+  }
+  return HorizontalSum8(acc);
+}
+
+// log(v) for positive normal v
+__attribute__((target("avx2,fma")))
+inline __m256 Log8(__m256 v) {
+  // v = m * 2^e with m in [sqrt(1/2), sqrt(2))
+  const __m256i bits = _mm256_castps_si256(v);
+  __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23),
+                                                 _mm256_set1_epi32(126)));
+  __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+      _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+  const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(kSqrtHalf), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1.0f)));
+  m = _mm256_add_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_and_ps(small, m));
+  const __m256 z = _mm256_mul_ps(m, m);
+  __m256 p = _mm256_set1_ps(kLogP0);
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP1));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP2));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP3));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP4));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP5));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP6));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP7));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP8));
+  p = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+  p = _mm256_fmadd_ps(e, _mm256_set1_ps(kLn2Lo), p);
+  p = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), p);
+  return _mm256_fmadd_ps(e, _mm256_set1_ps(kLn2Hi), _mm256_add_ps(m, p));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 LogSumExp3x8(__m256 a, __m256 b, __m256 c) {
+  const __m256 ninf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+  const __m256 m = _mm256_max_ps(_mm256_max_ps(a, b), c);
+  // shift by zero where all three are -inf so that the exps are zero instead of NaN
+  const __m256 empty = _mm256_cmp_ps(m, ninf, _CMP_EQ_OQ);
+  const __m256 shift = _mm256_andnot_ps(empty, m);
+  // the largest term is exp(0) = 1, so the log is taken of a value in [1, 3]
+  const __m256 sum = _mm256_add_ps(_mm256_add_ps(Exp8(_mm256_sub_ps(a, shift)),
+                                                 Exp8(_mm256_sub_ps(b, shift))),
+                                   Exp8(_mm256_sub_ps(c, shift)));
+  return _mm256_blendv_ps(_mm256_add_ps(shift, Log8(sum)), ninf, empty);
+}
+
+__attribute__((target("avx2,fma")))
+void LogSumExp3AVX2(const float *a, const float *b, const float *c, float *y, index_t n) {
+  index_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i, LogSumExp3x8(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                                         _mm256_loadu_ps(c + i)));
+  }
+  if (i < n) {
+    float tail[3][8];
+    const int len = static_cast<int>(n - i);
+    for (int j = 0; j < 8; ++j) {
+      const bool valid = j < len;
+      tail[0][j] = valid ? a[i + j] : -std::numeric_limits<float>::infinity();
+      tail[1][j] = valid ? b[i + j] : -std::numeric_limits<float>::infinity();
+      tail[2][j] = valid ? c[i + j] : -std::numeric_limits<float>::infinity();
+    }
+    _mm256_storeu_ps(tail[0], LogSumExp3x8(_mm256_loadu_ps(tail[0]), _mm256_loadu_ps(tail[1]),
+                                           _mm256_loadu_ps(tail[2])));
+    std::copy(tail[0], tail[0] + len, y + i);
+  }
+}
+
+__attribute__((target("avx512f")))
+inline __m512 Exp16(__m512 v) {
+  // NaN lanes are passed through like std::exp does
+  const __mmask16 nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+  const __m512 input = v;
+  const __mmask16 valid = _mm512_cmp_ps_mask(v, _mm512_set1_ps(kExpLow), _CMP_GE_OQ);
+  // lanes below kExpLow are computed as exp(0) and masked at the end, clamping them to kExpLow
+  // instead would make the last multiply produce denormals, which are slow on many CPUs
+  v = _mm512_min_ps(_mm512_maskz_mov_ps(valid, v), _mm512_set1_ps(kExpHigh));
+  // v = k * ln(2) + r
+  const __m512 k = _mm512_roundscale_ps(
+      _mm512_fmadd_ps(v, _mm512_set1_ps(kLog2e), _mm512_set1_ps(0.5f)),
+      _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  __m512 r = _mm512_fnmadd_ps(k, _mm512_set1_ps(kLn2Hi), v);
+  r = _mm512_fnmadd_ps(k, _mm512_set1_ps(kLn2Lo), r);
+  __m512 p = _mm512_set1_ps(kExpP0);
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP1));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP2));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP3));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP4));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP5));
+  p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.0f)));
+  // 2^k from the exponent bits
+  const __m512i e = _mm512_slli_epi32(
+      _mm512_add_epi32(_mm512_cvtps_epi32(k), _mm512_set1_epi32(127)), 23);
+  return _mm512_mask_mov_ps(_mm512_maskz_mul_ps(valid, p, _mm512_castsi512_ps(e)), nan, input);
+}
+
+__attribute__((target("avx512f")))
+float MaxAVX512(const float *x, index_t n) {
+  __m512 acc = _mm512_set1_ps(x[0]);
+  // max_ps drops NaN in its first operand, so NaN lanes are tracked separately
+  __mmask16 nan = 0;
+  index_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 v = _mm512_loadu_ps(x + i);
+    acc = _mm512_max_ps(acc, v);
+    nan |= _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+  }
+  if (i < n) {
+    const __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+    const __m512 v = _mm512_maskz_loadu_ps(tail, x + i);
+    acc = _mm512_mask_max_ps(acc, tail, acc, v);
+    nan |= _mm512_mask_cmp_ps_mask(tail, v, v, _CMP_UNORD_Q);
+  }
+  if (nan) return std::numeric_limits<float>::quiet_NaN();
+  return _mm512_reduce_max_ps(acc);
+}
+
+__attribute__((target("avx512f")))
+float ExpSumAVX512(const float *x, float shift, float *y, index_t n) {
+  const __m512 vshift = _mm512_set1_ps(shift);
+  __m512 acc = _mm512_setzero_ps();
+  index_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 e = Exp16(_mm512_sub_ps(_mm512_loadu_ps(x + i), vshift));
+    if (y) _mm512_storeu_ps(y + i, e);
+    acc = _mm512_add_ps(acc, e);
+  }
+  if (i < n) {
+    const __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+    const __m512 e = _mm512_maskz_mov_ps(
+        tail, Exp16(_mm512_sub_ps(_mm512_maskz_loadu_ps(tail, x + i), vshift)));
+    if (y) _mm512_mask_storeu_ps(y + i, tail, e);
+    acc = _mm512_add_ps(acc, e);
+  }
+  return _mm512_reduce_add_ps(acc);
+}
+
+// log(v) for positive normal v
+__attribute__((target("avx512f")))
+inline __m512 Log16(__m512 v) {
+  // v = m * 2^e with m in [sqrt(1/2), sqrt(2))
+  const __m512i bits = _mm512_castps_si512(v);
+  __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23),
+                                                 _mm512_set1_epi32(126)));
+  __m512 m = _mm512_castsi512_ps(_mm512_or_si512(
+      _mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f000000)));
+  const __mmask16 small = _mm512_cmp_ps_mask(m, _mm512_set1_ps(kSqrtHalf), _CMP_LT_OQ);
+  e = _mm512_mask_sub_ps(e, small, e, _mm512_set1_ps(1.0f));
+  const __m512 m1 = _mm512_sub_ps(m, _mm512_set1_ps(1.0f));
+  m = _mm512_mask_add_ps(m1, small, m1, m);
+  const __m512 z = _mm512_mul_ps(m, m);
+  __m512 p = _mm512_set1_ps(kLogP0);
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP1));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP2));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP3));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP4));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP5));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP6));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP7));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP8));
+  p = _mm512_mul_ps(_mm512_mul_ps(p, m), z);
+  p = _mm512_fmadd_ps(e, _mm512_set1_ps(kLn2Lo), p);
+  p = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), p);
+  return _mm512_fmadd_ps(e, _mm512_set1_ps(kLn2Hi), _mm512_add_ps(m, p));
+}
+
+__attribute__((target("avx512f")))
+inline __m512 LogSumExp3x16(__m512 a, __m512 b, __m512 c) {
+  const __m512 ninf = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+  const __m512 m = _mm512_max_ps(_mm512_max_ps(a, b), c);
+  // shift by zero where all three are -inf so that the exps are zero instead of NaN
+  const __mmask16 valid = _mm512_cmp_ps_mask(m, ninf, _CMP_NEQ_OQ);
+  const __m512 shift = _mm512_maskz_mov_ps(valid, m);
+  // the largest term is exp(0) = 1, so the log is taken of a value in [1, 3]
+  const __m512 sum = _mm512_add_ps(_mm512_add_ps(Exp16(_mm512_sub_ps(a, shift)),
+                                                 Exp16(_mm512_sub_ps(b, shift))),
+                                   Exp16(_mm512_sub_ps(c, shift)));
+  return _mm512_mask_add_ps(ninf, valid, shift, Log16(sum));
+}
+
+__attribute__((target("avx512f")))
+void LogSumExp3AVX512(const float *a, const float *b, const float *c, float *y, index_t n) {
+  index_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(y + i, LogSumExp3x16(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                                          _mm512_loadu_ps(c + i)));
+  }
+  if (i < n) {
+    const __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+    const __m512 ninf = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+    _mm512_mask_storeu_ps(y + i, tail, LogSumExp3x16(_mm512_mask_loadu_ps(ninf, tail, a + i),
+                                                     _mm512_mask_loadu_ps(ninf, tail, b + i),
+                                                     _mm512_mask_loadu_ps(ninf, tail, c + i)));
+  }
+}
+#endif  // MXNET_VEC_MATH_X86
+
+struct Kernels {
+  float (*max)(const float *x, index_t n);
+  float (*exp_sum)(const float *x, float shift, float *y, index_t n);
+  void (*log_sum_exp3)(const float *a, const float *b, const float *c, float *y, index_t n);
+
+  Kernels() : max(MaxScalar), exp_sum(ExpSumScalar), log_sum_exp3(LogSumExp3Scalar) {
+#if MXNET_VEC_MATH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      max = MaxAVX512;
+      exp_sum = ExpSumAVX512;
+      log_sum_exp3 = LogSumExp3AVX512;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      max = MaxAVX2;
+      exp_sum = ExpSumAVX2;
+      log_sum_exp3 = LogSumExp3AVX2;
+    }
+#endif
+  }
+
+  static const Kernels& Get() {
+    static const Kernels kernels;
+    return kernels;
+  }
+};
+}  // namespace
+
+float Max(const float *x, index_t n) {
+  return Kernels::Get().max(x, n);
+}
+
+float ExpSum(const float *x, float shift, float *y, index_t n) {
+  return Kernels::Get().exp_sum(x, shift, y, n);
+}
+
+void Softmax(const float *x, float *y, index_t n) {
+  const float scale = 1.0f / ExpSum(x, Max(x, n), y, n);
+  for (index_t i = 0; i < n; ++i) {
+    y[i] *= scale;
+  }
+}
+
+void LogSoftmax(const float *x, float *y, index_t n) {
+  const float mmax = Max(x, n);
+  const float log_sum = std::log(ExpSum(x, mmax, NULL, n));
+  for (index_t i = 0; i < n; ++i) {
+    y[i] = (x[i] - mmax) - log_sum;
+  }
+}
+
+void LogSumExp3(const float *a, const float *b, const float *c, float *y, index_t n) {
+  Kernels::Get().log_sum_exp3(a, b, c, y, n);
+}
+
+}  // namespace vec_math
+}  // namespace op
+}  // namespace mxnet
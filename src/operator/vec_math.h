@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file vec_math.h
+ * \brief vectorized exp, reductions and softmax over contiguous float arrays on CPU,
+ *  used by the softmax, SoftmaxOutput, softmax cross entropy and CTC loss kernels.
+ *  On x86 the AVX-512 or AVX2 kernels are picked at runtime when the CPU supports them.
+ */
+#ifndef MXNET_OPERATOR_VEC_MATH_H_
+#define MXNET_OPERATOR_VEC_MATH_H_
+
+#include <mxnet/base.h>
+
+namespace mxnet {
+namespace op {
+namespace vec_math {
+
+/*! \brief the largest of x[0, n), NaN if there is one, n must be positive */
+float Max(const float *x, index_t n);
+
+/*!
+ * \brief the sum of exp(x[i] - shift) over x[0, n).
+ *  The exponentials are also written to y[0, n) unless y is NULL, y may be x.
+ *  The AVX2 and AVX-512 kernels use a polynomial exp with a relative error of about 2 ulp,
+ *  which flushes results below FLT_MIN to zero. NaN inputs give NaN.
+ */
+float ExpSum(const float *x, float shift, float *y, index_t n);
+
+/*! \brief y = softmax(x) over x[0, n), y may be x */
+void Softmax(const float *x, float *y, index_t n);
+
+/*! \brief y = log(softmax(x)) over x[0, n), y may be x */
+void LogSoftmax(const float *x, float *y, index_t n);
+
+/*!
+ * \brief y[i] = log(exp(a[i]) + exp(b[i]) + exp(c[i])) over [0, n), -inf where all three are
+ *  -inf. y may be any of a, b and c.
+ */
+void LogSumExp3(const float *a, const float *b, const float *c, float *y, index_t n);
+
+}  // namespace vec_math
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_VEC_MATH_H_
@@ -1192,6 +1192,14 @@ def test_psroipooling_with_type():
                  'psroipool_data': (1, 18, 14, 14),
                  'psroipool_rois': (2, 5),
                  'type_dict': {'psroipool_data': np.float16, 'psroipool_rois': np.float16}},
+                {'ctx': mx.cpu(0),
+                 'psroipool_data': (1, 18, 14, 14),
+                 'psroipool_rois': (2, 5),
+                 'type_dict': {'psroipool_data': np.float64, 'psroipool_rois': np.float64}},
+                {'ctx': mx.cpu(0),
+                 'psroipool_data': (1, 18, 14, 14),
+                 'psroipool_rois': (2, 5),
+                 'type_dict': {'psroipool_data': np.float32, 'psroipool_rois': np.float32}},
                 ]
 
     check_consistency(sym, ctx_list, grad_req={'psroipool_data': 'write',
@@ -1224,12 +1232,40 @@ def test_deformable_psroipooling_with_type():
                  'deformable_psroipool_trans': (2, 4, 3, 3),
                  'type_dict': {'deformable_psroipool_data': np.float16, 'deformable_psroipool_rois': np.float16,
                                'deformable_psroipool_trans': np.float16}},
+                {'ctx': mx.cpu(0),
+                 'deformable_psroipool_data': (1, 18, 14, 14),
+                 'deformable_psroipool_rois': (2, 5),
+                 'deformable_psroipool_trans': (2, 4, 3, 3),
+                 'type_dict': {'deformable_psroipool_data': np.float64, 'deformable_psroipool_rois': np.float64,
+                               'deformable_psroipool_trans': np.float64}},
+                {'ctx': mx.cpu(0),
+                 'deformable_psroipool_data': (1, 18, 14, 14),
+                 'deformable_psroipool_rois': (2, 5),
+                 'deformable_psroipool_trans': (2, 4, 3, 3),
+                 'type_dict': {'deformable_psroipool_data': np.float32, 'deformable_psroipool_rois': np.float32,
+                               'deformable_psroipool_trans': np.float32}},
                 ]
 
     check_consistency(sym, ctx_list, grad_req={'deformable_psroipool_data': 'write',
                                                'deformable_psroipool_rois': 'null',
                                                'deformable_psroipool_trans': 'write'}, arg_params=arg_params)
 
+def test_multi_proposal_with_type():
+    np.random.seed(1234)
+    num_images, num_anchors, feat_height, feat_width = 2, 12, 14, 20
+    arg_params = {
+        'multi_proposal_cls_prob': np.random.uniform(size=(num_images, 2 * num_anchors, feat_height, feat_width)),
+        'multi_proposal_bbox_pred': np.random.normal(0, 0.1, (num_images, 4 * num_anchors, feat_height, feat_width)),
+        'multi_proposal_im_info': np.array([[feat_height * 16, feat_width * 16, 1.0],
+                                            [feat_height * 16 - 40, feat_width * 16 - 70, 1.5]])}
+    sym = mx.sym.contrib.MultiProposal(rpn_pre_nms_top_n=1000, rpn_post_nms_top_n=100, output_score=True,
+                                       name='multi_proposal')
+    shapes = {'multi_proposal_cls_prob': (num_images, 2 * num_anchors, feat_height, feat_width),
+              'multi_proposal_bbox_pred': (num_images, 4 * num_anchors, feat_height, feat_width),
+              'multi_proposal_im_info': (num_images, 3)}
+    ctx_list = [dict(ctx=mx.gpu(0), **shapes), dict(ctx=mx.cpu(0), **shapes)]
+    check_consistency(sym, ctx_list, grad_req='null', arg_params=arg_params)
+
 def test_deformable_convolution_with_type():
     np.random.seed(1234)
     sym = mx.sym.contrib.DeformableConvolution(num_filter=3, kernel=(3,3), name='deformable_conv')
@@ -226,6 +226,164 @@ def test_bipartite_matching_op():
     assert_match([[0.5, 0.6], [0.1, 0.2], [0.3, 0.4]], [1, -1, 0], [2, 0], 1e-12, False)
     assert_match([[0.5, 0.6], [0.1, 0.2], [0.3, 0.4]], [-1, 0, 1], [1, 2], 100, True)
 
+def np_proposal(cls_prob, bbox_pred, im_info, scales, ratios, feature_stride,
+                pre_nms_top_n, post_nms_top_n, threshold, min_size):
+    """Proposal of a single image, without the batch index column of the rois"""
+    anchors = []
+    for ratio in ratios:
+        for scale in scales:
+            size = float(feature_stride * feature_stride)
+            w = np.floor(np.sqrt(np.floor(size / ratio)) + 0.5)
+            h = np.floor(w * ratio + 0.5)
+            w, h, ctr = w * scale, h * scale, 0.5 * (feature_stride - 1)
+            anchors.append([ctr - 0.5 * (w - 1), ctr - 0.5 * (h - 1),
+                            ctr + 0.5 * (w - 1), ctr + 0.5 * (h - 1)])
+    anchors = np.array(anchors, dtype=np.float32)
+    num_anchors, height, width = len(anchors), cls_prob.shape[2], cls_prob.shape[3]
+    # proposals are ordered by row, column and anchor
+    shift_y, shift_x = np.meshgrid(np.arange(height) * feature_stride,
+                                   np.arange(width) * feature_stride, indexing='ij')
+    shifts = np.stack([shift_x, shift_y, shift_x, shift_y], axis=-1).astype(np.float32)
+    boxes = (anchors[None, None] + shifts[:, :, None]).reshape((-1, 4))
+    scores = cls_prob[0, num_anchors:].transpose((1, 2, 0)).reshape(-1).copy()
+    deltas = bbox_pred[0].reshape((num_anchors, 4, height, width)).transpose((2, 3, 0, 1))
+    deltas = deltas.reshape((-1, 4))
+
+    widths = boxes[:, 2] - boxes[:, 0] + 1
+    heights = boxes[:, 3] - boxes[:, 1] + 1
+    ctr_x = deltas[:, 0] * widths + boxes[:, 0] + 0.5 * (widths - 1)
+    ctr_y = deltas[:, 1] * heights + boxes[:, 1] + 0.5 * (heights - 1)
+    pred_w = np.exp(deltas[:, 2]) * widths
+    pred_h = np.exp(deltas[:, 3]) * heights
+    pred = np.stack([ctr_x - 0.5 * (pred_w - 1), ctr_y - 0.5 * (pred_h - 1),
+                     ctr_x + 0.5 * (pred_w - 1), ctr_y + 0.5 * (pred_h - 1)], axis=1)
+    pred[:, 0::2] = np.clip(pred[:, 0::2], 0, im_info[0, 1] - 1)
+    pred[:, 1::2] = np.clip(pred[:, 1::2], 0, im_info[0, 0] - 1)
+    rows = np.arange(len(pred)) // num_anchors // width
+    cols = np.arange(len(pred)) // num_anchors % width
+    padded = (rows >= int(im_info[0, 0] / feature_stride)) | \
+             (cols >= int(im_info[0, 1] / feature_stride))
+    scores[padded] = -1
+    min_size *= im_info[0, 2]
+    small = (pred[:, 2] - pred[:, 0] + 1 < min_size) | (pred[:, 3] - pred[:, 1] + 1 < min_size)
+    pred[small] += np.array([-1, -1, 1, 1]) * min_size / 2
+    scores[small] = -1
+
+    order = np.argsort(-scores, kind='stable')[:pre_nms_top_n]
+    pred, scores = pred[order], scores[order]
+    area = (pred[:, 2] - pred[:, 0] + 1) * (pred[:, 3] - pred[:, 1] + 1)
+    suppressed = np.zeros(len(pred), dtype=bool)
+    keep = []
+    for i in range(len(pred)):
+        if len(keep) >= post_nms_top_n:
+            break
+        if suppressed[i]:
+            continue
+        keep.append(i)
+        w = np.maximum(0, np.minimum(pred[i, 2], pred[i + 1:, 2]) -
+                       np.maximum(pred[i, 0], pred[i + 1:, 0]) + 1)
+        h = np.maximum(0, np.minimum(pred[i, 3], pred[i + 1:, 3]) -
+                       np.maximum(pred[i, 1], pred[i + 1:, 1]) + 1)
+        inter = w * h
+        suppressed[i + 1:] |= inter / (area[i] + area[i + 1:] - inter) > threshold
+    keep = [keep[i % len(keep)] for i in range(post_nms_top_n)]
+    return pred[keep], scores[keep]
+
+def test_proposal_op():
+    num_anchors, feat_height, feat_width, post_nms = 12, 6, 8, 40
+    cls_prob = np.random.uniform(size=(1, 2 * num_anchors, feat_height, feat_width))
+    bbox_pred = np.random.normal(0, 0.1, (1, 4 * num_anchors, feat_height, feat_width))
+    cls_prob, bbox_pred = cls_prob.astype(np.float32), bbox_pred.astype(np.float32)
+    im_info = np.array([[feat_height * 16 - 20, feat_width * 16 - 40, 1.0]], dtype=np.float32)
+    rois, scores = mx.nd.contrib.Proposal(
+        mx.nd.array(cls_prob), mx.nd.array(bbox_pred), mx.nd.array(im_info),
+        rpn_pre_nms_top_n=300, rpn_post_nms_top_n=post_nms, output_score=True)
+    expected_rois, expected_scores = np_proposal(
+        cls_prob, bbox_pred, im_info, scales=(4, 8, 16, 32), ratios=(0.5, 1, 2),
+        feature_stride=16, pre_nms_top_n=300, post_nms_top_n=post_nms, threshold=0.7,
+        min_size=16)
+    assert_array_equal(rois.asnumpy()[:, 0], np.zeros(post_nms))
+    assert_allclose(rois.asnumpy()[:, 1:], expected_rois, rtol=1e-4, atol=1e-3)
+    assert_allclose(scores.asnumpy()[:, 0], expected_scores, rtol=1e-5, atol=1e-6)
+
+def test_multi_proposal_op():
+    # a batch through MultiProposal gives the same rois as each image through Proposal
+    num_images, num_anchors, feat_height, feat_width = 3, 12, 12, 16
+    post_nms = 50
+    cls_prob = np.random.uniform(size=(num_images, 2 * num_anchors, feat_height, feat_width))
+    bbox_pred = np.random.normal(0, 0.1, (num_images, 4 * num_anchors, feat_height, feat_width))
+    im_info = np.array([[feat_height * 16, feat_width * 16, 1.0],
+                        [feat_height * 16 - 40, feat_width * 16 - 70, 1.5],
+                        [feat_height * 16 - 20, feat_width * 16, 0.5]])
+    for iou_loss in [False, True]:
+        rois, scores = mx.nd.contrib.MultiProposal(
+            mx.nd.array(cls_prob), mx.nd.array(bbox_pred), mx.nd.array(im_info),
+            rpn_pre_nms_top_n=600, rpn_post_nms_top_n=post_nms, iou_loss=iou_loss,
+            output_score=True)
+        rois, scores = rois.asnumpy(), scores.asnumpy()
+        for i in range(num_images):
+            expected_rois, expected_scores = mx.nd.contrib.Proposal(
+                mx.nd.array(cls_prob[i:i+1]), mx.nd.array(bbox_pred[i:i+1]),
+                mx.nd.array(im_info[i:i+1]), rpn_pre_nms_top_n=600,
+                rpn_post_nms_top_n=post_nms, iou_loss=iou_loss, output_score=True)
+            batch = slice(i * post_nms, (i + 1) * post_nms)
+            assert_array_equal(rois[batch, 0], np.full(post_nms, i))
+            assert_allclose(rois[batch, 1:], expected_rois.asnumpy()[:, 1:], rtol=1e-4, atol=1e-3)
+            assert_allclose(scores[batch], expected_scores.asnumpy(), rtol=1e-5, atol=1e-6)
+
+def test_fft_ifft_op():
+    def to_complex(x):
+        return x[..., 0::2] + 1j * x[..., 1::2]
+
+    def to_interleaved(x):
+        out = np.empty(x.shape[:-1] + (2 * x.shape[-1],))
+        out[..., 0::2] = x.real
+        out[..., 1::2] = x.imag
+        return out
+
+    # powers of 2 and 3 as well as prime lengths, which take the generic radix path
+    for dim in [1, 2, 3, 8, 12, 17, 60, 97, 256]:
+        for shape in [(5, dim), (2, 3, 2, dim)]:
+            for dtype, rtol, atol in [(np.float32, 1e-3, 1e-3), (np.float64, 1e-8, 1e-8)]:
+                data = np.random.normal(size=shape)
+                x = mx.nd.array(data, dtype=dtype)
+                x.attach_grad()
+                with mx.autograd.record():
+                    y = mx.nd.contrib.fft(x)
+                assert_almost_equal(y.asnumpy(), to_interleaved(np.fft.fft(data)), rtol, atol)
+                ograd = np.random.normal(size=y.shape)
+                y.backward(mx.nd.array(ograd, dtype=dtype))
+                # both directions are unnormalized, as with cuFFT
+                expected = (np.fft.ifft(to_complex(ograd)) * dim).real
+                assert_almost_equal(x.grad.asnumpy(), expected, rtol, atol)
+
+                data = np.random.normal(size=shape[:-1] + (2 * dim,))
+                x = mx.nd.array(data, dtype=dtype)
+                x.attach_grad()
+                with mx.autograd.record():
+                    y = mx.nd.contrib.ifft(x)
+                expected = (np.fft.ifft(to_complex(data)) * dim).real
+                assert_almost_equal(y.asnumpy(), expected, rtol, atol)
+                ograd = np.random.normal(size=y.shape)
+                y.backward(mx.nd.array(ograd, dtype=dtype))
+                assert_almost_equal(x.grad.asnumpy(), to_interleaved(np.fft.fft(ograd)), rtol, atol)
+
+def test_count_sketch_op():
+    for n, in_dim, out_dim in [(1, 7, 3), (37, 100, 16), (200, 64, 128)]:
+        data = np.random.uniform(-10, 10, (n, in_dim))
+        h = np.random.randint(0, out_dim, (1, in_dim))
+        s = np.random.randint(0, 2, (1, in_dim)) * 2 - 1
+        x = mx.nd.array(data)
+        x.attach_grad()
+        with mx.autograd.record():
+            y = mx.nd.contrib.count_sketch(x, mx.nd.array(h), mx.nd.array(s), out_dim=out_dim)
+        expected = np.zeros((n, out_dim))
+        np.add.at(expected.T, h[0], (data * s).T)
+        assert_almost_equal(y.asnumpy(), expected, rtol=1e-3, atol=1e-4)
+        ograd = np.random.normal(size=(n, out_dim))
+        y.backward(mx.nd.array(ograd))
+        assert_almost_equal(x.grad.asnumpy(), ograd[:, h[0]] * s, rtol=1e-3, atol=1e-4)
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
@@ -0,0 +1,193 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+from __future__ import print_function
+import json
+import numpy as np
+import mxnet as mx
+from numpy.testing import assert_allclose, assert_array_equal
+
+INT32_RANGE = 2147483647.0
+
+
+def random_int8(shape):
+    return mx.nd.array(np.random.randint(-127, 128, size=shape), dtype=np.int8)
+
+
+def scalar(value):
+    return mx.nd.array([value])
+
+
+def test_quantize_dequantize_int8():
+    a = np.random.uniform(-3, 2, size=(4, 5)).astype(np.float32)
+    qa, qmin, qmax = mx.nd.contrib.quantize(mx.nd.array(a), scalar(-3), scalar(2),
+                                            out_type='int8')
+    assert qa.dtype == np.int8
+    assert_allclose(qmin.asnumpy(), [-3])
+    assert_allclose(qmax.asnumpy(), [3])
+    assert_array_equal(qa.asnumpy(), np.round(a * 127 / 3))
+    a_ = mx.nd.contrib.dequantize(qa, qmin, qmax, out_type='float32')
+    assert_allclose(a_.asnumpy(), a, atol=3 / 127. / 2 + 1e-6)
+    # values beyond the range saturate
+    qa, _, _ = mx.nd.contrib.quantize(mx.nd.array([[-5, 5]]), scalar(-1), scalar(1),
+                                      out_type='int8')
+    assert_array_equal(qa.asnumpy(), [[-127, 127]])
+
+
+def test_requantize():
+    data = np.random.randint(-2**20, 2**20, size=(3, 7)).astype(np.int32)
+    real = data * 10. / INT32_RANGE
+    out, omin, omax = mx.nd.contrib.requantize(mx.nd.array(data, dtype=np.int32),
+                                               scalar(-10), scalar(10))
+    max_abs = np.abs(real).max()
+    assert out.dtype == np.int8
+    assert_allclose(omax.asnumpy(), [max_abs], rtol=1e-5)
+    assert_allclose(omin.asnumpy(), [-max_abs], rtol=1e-5)
+    assert np.abs(out.asnumpy() - real * 127 / max_abs).max() <= 0.5 + 1e-3
+    out, omin, omax = mx.nd.contrib.requantize(mx.nd.array(data, dtype=np.int32),
+                                               scalar(-10), scalar(10),
+                                               min_calib_range=-max_abs / 2,
+                                               max_calib_range=max_abs / 2)
+    assert_allclose(omax.asnumpy(), [max_abs / 2], rtol=1e-5)
+    expected = np.clip(real * 127 / (max_abs / 2), -127, 127)
+    assert np.abs(out.asnumpy() - expected).max() <= 0.5 + 1e-3
+
+
+def test_quantized_conv():
+    def check(data_type, shape, num_filter, kernel, stride, pad, num_group, no_bias):
+        if data_type == 'uint8':
+            data = mx.nd.array(np.random.randint(0, 256, size=shape), dtype=np.uint8)
+            min_data, max_data, data_unit = 0., 2.55, 2.55 / 255
+        else:
+            data = random_int8(shape)
+            min_data, max_data, data_unit = -2., 1., 2. / 127
+        weight = random_int8((num_filter, shape[1] // num_group) + kernel)
+        bias = random_int8((num_filter,))
+        out_unit = data_unit * 0.5 / 127
+        args = [data, weight] + ([] if no_bias else [bias])
+        args += [scalar(min_data), scalar(max_data), scalar(-0.5), scalar(0.25)]
+        args += [] if no_bias else [scalar(-3), scalar(1)]
+        out, omin, omax = mx.nd.contrib.quantized_conv(
+            *args, kernel=kernel, stride=stride, pad=pad, num_filter=num_filter,
+            num_group=num_group, no_bias=no_bias)
+        # the integer products are exact in float32 for these sizes
+        expected = mx.nd.Convolution(data.astype(np.float32), weight.astype(np.float32),
+                                     kernel=kernel, stride=stride, pad=pad,
+                                     num_filter=num_filter, num_group=num_group,
+                                     no_bias=True).asnumpy()
+        if not no_bias:
+            bias_int32 = np.round(bias.asnumpy() * (3. / 127) / out_unit)
+            expected += bias_int32.reshape((1, -1, 1, 1))
+        assert out.dtype == np.int32
+        assert_array_equal(out.asnumpy(), expected)
+        assert_allclose(omax.asnumpy(), [out_unit * INT32_RANGE], rtol=1e-5)
+        assert_allclose(omin.asnumpy(), [-out_unit * INT32_RANGE], rtol=1e-5)
+
+    check('int8', (2, 3, 9, 7), 5, (3, 3), (1, 1), (1, 1), 1, False)
+    check('int8', (1, 4, 8, 8), 6, (3, 2), (2, 1), (0, 1), 2, True)
+    check('uint8', (3, 8, 6, 6), 8, (1, 1), (1, 1), (0, 0), 1, False)
+    check('uint8', (1, 70, 5, 5), 3, (3, 3), (2, 2), (1, 1), 1, False)
+
+
+def test_quantized_fully_connected():
+    for data_type, shape, num_hidden in [('int8', (5, 3, 4, 4), 7), ('uint8', (9, 130), 4)]:
+        if data_type == 'uint8':
+            data = mx.nd.array(np.random.randint(0, 256, size=shape), dtype=np.uint8)
+            data_unit = 1. / 255
+        else:
+            data = random_int8(shape)
+            data_unit = 1. / 127
+        num_input = int(np.prod(shape[1:]))
+        weight = random_int8((num_hidden, num_input))
+        bias = random_int8((num_hidden,))
+        out, omin, omax = mx.nd.contrib.quantized_fully_connected(
+            data, weight, bias, scalar(0), scalar(1), scalar(-1), scalar(0.5),
+            scalar(-1), scalar(1), num_hidden=num_hidden)
+        out_unit = data_unit / 127
+        expected = np.dot(data.asnumpy().reshape((shape[0], -1)).astype(np.int64),
+                          weight.asnumpy().T.astype(np.int64))
+        expected += np.round(bias.asnumpy() * (1. / 127) / out_unit).astype(np.int64)
+        assert_array_equal(out.asnumpy(), expected)
+        assert_allclose(omax.asnumpy(), [out_unit * INT32_RANGE], rtol=1e-5)
+
+
+def test_quantized_pooling_act_flatten():
+    data = random_int8((2, 3, 7, 6))
+    fdata = data.astype(np.float32)
+    for pool_type in ['max', 'avg']:
+        out, omin, omax = mx.nd.contrib.quantized_pooling(
+            data, scalar(-2), scalar(2), kernel=(3, 2), stride=(2, 2), pad=(1, 0),
+            pool_type=pool_type)
+        expected = mx.nd.Pooling(fdata, kernel=(3, 2), stride=(2, 2), pad=(1, 0),
+                                 pool_type=pool_type).asnumpy()
+        assert out.dtype == np.int8
+        assert np.abs(out.asnumpy() - expected).max() <= 0.5
+        assert_allclose(omax.asnumpy(), [2])
+    out, _, _ = mx.nd.contrib.quantized_pooling(data, scalar(-2), scalar(2), kernel=(1, 1),
+                                                global_pool=True, pool_type='max')
+    assert_array_equal(out.asnumpy(), fdata.asnumpy().max(axis=(2, 3), keepdims=True))
+    out, _, omax = mx.nd.contrib.quantized_act(data, scalar(-2), scalar(2), act_type='relu')
+    assert_array_equal(out.asnumpy(), np.maximum(data.asnumpy(), 0))
+    out, _, _ = mx.nd.contrib.quantized_flatten(data, scalar(-2), scalar(2))
+    assert_array_equal(out.asnumpy(), data.asnumpy().reshape((2, -1)))
+
+
+def test_quantize_model():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Convolution(data, kernel=(3, 3), pad=(1, 1), num_filter=8, name='conv0')
+    net = mx.sym.Activation(net, act_type='relu', name='relu0')
+    net = mx.sym.Pooling(net, kernel=(2, 2), stride=(2, 2), pool_type='max', name='pool0')
+    net = mx.sym.Convolution(net, kernel=(3, 3), num_filter=16, name='conv1')
+    net = mx.sym.Flatten(net, name='flatten0')
+    net = mx.sym.FullyConnected(net, num_hidden=10, name='fc0')
+    data_shape = (4, 3, 12, 12)
+    arg_shapes, _, _ = net.infer_shape(data=data_shape)
+    arg_params = {name: mx.nd.random.normal(scale=0.2, shape=shape)
+                  for name, shape in zip(net.list_arguments(), arg_shapes) if name != 'data'}
+    x = np.random.uniform(-1, 1, size=(16,) + data_shape[1:])
+    calib_data = mx.io.NDArrayIter(x, batch_size=data_shape[0])
+
+    def forward(sym, arg_params):
+        mod = mx.mod.Module(sym, label_names=None, context=mx.cpu())
+        mod.bind(for_training=False, data_shapes=[('data', data_shape)])
+        mod.set_params(arg_params, {})
+        mod.forward(mx.io.DataBatch([mx.nd.array(x[:data_shape[0]])]), is_train=False)
+        return mod.get_outputs()[0].asnumpy()
+
+    expected = forward(net, arg_params)
+    for calib in [None, calib_data]:
+        qsym, qarg_params, _ = mx.contrib.quantization.quantize_model(
+            net, arg_params, {}, calib_data=calib, num_calib_examples=8)
+        ops = [node['op'] for node in json.loads(qsym.tojson())['nodes']]
+        for op in ['_contrib_quantized_conv', '_contrib_quantized_act',
+                   '_contrib_quantized_pooling', '_contrib_quantized_flatten',
+                   '_contrib_quantized_fully_connected']:
+            assert op in ops
+        assert 'Convolution' not in ops and 'FullyConnected' not in ops
+        assert qarg_params['conv0_weight_quantize'].dtype == np.int8
+        out = forward(qsym, qarg_params)
+        assert np.abs(out - expected).max() <= 0.05 * np.abs(expected).max()
+    qsym, _, _ = mx.contrib.quantization.quantize_model(net, arg_params, {},
+                                                        excluded_sym_names=['conv0'])
+    ops = [node['op'] for node in json.loads(qsym.tojson())['nodes']]
+    assert 'Convolution' in ops and '_contrib_quantized_conv' in ops
+
+
+if __name__ == '__main__':
+    import nose
+    nose.runmodule()
@@ -15,6 +15,7 @@
 # specific language governing permissions and limitations
 # under the License.
 
+import os
 import numpy as np
 import mxnet as mx
 
@@ -157,6 +158,63 @@ def test_reshape():
     exe.forward(is_train=False)
     assert np.all(exe.outputs[0].asnumpy() == 4)
 
+def test_arena_memory_plan():
+    data = mx.sym.Variable('data')
+    fc1 = mx.sym.FullyConnected(data, num_hidden=32, name='fc1')
+    branches = [mx.sym.Activation(mx.sym.FullyConnected(fc1, num_hidden=16, name='fc_b%d' % i),
+                                  act_type='relu') for i in range(3)]
+    net = mx.sym.FullyConnected(mx.sym.Concat(*branches), num_hidden=8, name='fc2')
+    net = mx.sym.SoftmaxOutput(net, name='softmax')
+
+    def run(arena):
+        os.environ['MXNET_EXEC_ARENA_MEMORY_PLAN'] = '1' if arena else '0'
+        exe = net.simple_bind(mx.cpu(), data=(10, 20))
+        np.random.seed(0)
+        for name, arr in sorted(exe.arg_dict.items()):
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        exe.arg_dict['softmax_label'][:] = np.random.randint(0, 8, (10,))
+        # the second pass reuses the arenas of the first one
+        for _ in range(2):
+            exe.forward(is_train=True)
+            exe.backward()
+        return exe, [exe.outputs[0].asnumpy()] + [g.asnumpy() for g in exe.grad_arrays]
+
+    try:
+        exe, expected = run(False)
+        arena_exe, actual = run(True)
+    finally:
+        del os.environ['MXNET_EXEC_ARENA_MEMORY_PLAN']
+    for e, a in zip(expected, actual):
+        assert reldiff(e, a) < 1e-6
+    assert 'lower bound' in arena_exe.debug_str()
+    assert 'lower bound' not in exe.debug_str()
+
+def test_bulk_exec_parallel_branch():
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data, kernel=(1, 1), num_filter=8, name='conv')
+    towers = [mx.sym.Activation(mx.sym.Convolution(conv, kernel=(k, k), pad=(k // 2, k // 2),
+                                                   num_filter=4, name='tower%d' % k),
+                                act_type='relu') for k in (1, 3, 5)]
+    towers.append(mx.sym.Pooling(conv, kernel=(3, 3), pad=(1, 1), pool_type='max'))
+    net = mx.sym.FullyConnected(mx.sym.Concat(*towers), num_hidden=10, name='fc')
+    net = mx.sym.softmax(net)
+
+    def run(parallel_branch):
+        os.environ['MXNET_EXEC_BULK_EXEC_PARALLEL_BRANCH'] = '1' if parallel_branch else '0'
+        exe = net.simple_bind(mx.cpu(), data=(4, 3, 12, 12), grad_req='null')
+        np.random.seed(0)
+        for name, arr in sorted(exe.arg_dict.items()):
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        return [exe.forward(is_train=False)[0].asnumpy() for _ in range(2)]
+
+    try:
+        expected = run(False)
+        actual = run(True)
+    finally:
+        del os.environ['MXNET_EXEC_BULK_EXEC_PARALLEL_BRANCH']
+    for e, a in zip(expected, actual):
+        assert np.allclose(e, a, rtol=1e-5, atol=1e-6)
+
 if __name__ == "__main__":
     import nose
     nose.runmodule()
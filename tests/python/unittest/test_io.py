@@ -59,6 +59,19 @@ def test_MNISTIter():
     train_dataiter.iter_next()
     label_1 = train_dataiter.getlabel().asnumpy().flatten()
     assert(sum(label_0 - label_1) == 0)
+    # streaming gives the same batches as loading the whole part
+    for shuffle in [0, 1]:
+        kwargs = dict(image="data/train-images-idx3-ubyte", label="data/train-labels-idx1-ubyte",
+                      batch_size=batch_size, shuffle=shuffle, flat=0, seed=10,
+                      num_parts=3, part_index=1)
+        memory_iter = mx.io.MNISTIter(**kwargs)
+        stream_iter = mx.io.MNISTIter(streaming=1, **kwargs)
+        num_batches = 0
+        for memory_batch, stream_batch in zip(memory_iter, stream_iter):
+            assert_almost_equal(memory_batch.data[0].asnumpy(), stream_batch.data[0].asnumpy())
+            assert_almost_equal(memory_batch.label[0].asnumpy(), stream_batch.label[0].asnumpy())
+            num_batches += 1
+        assert num_batches == 20000 // batch_size
 
 def test_Cifar10Rec():
     get_data.GetCifar10()
@@ -84,6 +97,28 @@ def test_Cifar10Rec():
     for i in range(10):
         assert(labelcount[i] == 5000)
 
+def test_ImageRecordIter_dtype():
+    get_data.GetCifar10()
+    def first_batch(dtype):
+        dataiter = mx.io.ImageRecordIter(
+                path_imgrec="data/cifar/train.rec",
+                rand_crop=False,
+                rand_mirror=False,
+                shuffle=False,
+                data_shape=(3,28,28),
+                batch_size=32,
+                preprocess_threads=1,
+                dtype=dtype)
+        return dataiter.next().data[0]
+    f32 = first_batch('float32')
+    f16 = first_batch('float16')
+    u8 = first_batch('uint8')
+    assert f16.dtype == np.float16
+    assert u8.dtype == np.uint8
+    # without normalization options all three hold the raw pixels
+    assert_almost_equal(f16.asnumpy().astype(np.float32), f32.asnumpy())
+    assert_almost_equal(u8.asnumpy().astype(np.float32), f32.asnumpy())
+
 def test_NDArrayIter():
     data = np.ones([1000, 2, 2])
     label = np.ones([1000, 1])
@@ -250,9 +285,137 @@ def test_LibSVMIter():
             assert(num_batches == int(expected_num_batches)), num_batches
             data_train.reset()
 
+    def check_libSVMIter_cache():
+        cwd = os.getcwd()
+        data_path = os.path.join(cwd, 'data_cache.t')
+        cache_path = os.path.join(cwd, 'data_cache.bin')
+        with open(data_path, 'w') as fout:
+            for i in range(100):
+                fout.write('%d %d:%d %d:0.5\n' % (i, i % 7, i, 7 + i % 3))
+
+        def read_all():
+            data_iter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(10, ),
+                                         batch_size=10, cache_file=cache_path)
+            epochs = []
+            for epoch in range(2):
+                data_iter.reset()
+                epochs.append([(batch.data[0].asnumpy(), batch.label[0].asnumpy())
+                               for batch in data_iter])
+            return epochs
+
+        expected = [(np.zeros((10, 10)), np.arange(10 * b, 10 * b + 10)) for b in range(10)]
+        for b, (data, label) in enumerate(expected):
+            for r in range(10):
+                i = 10 * b + r
+                data[r, i % 7] = i
+                data[r, 7 + i % 3] = 0.5
+        # the first pass writes the cache, the second pass and the second iterator read it
+        for _ in range(2):
+            for epoch in read_all():
+                assert len(epoch) == len(expected)
+                for (data, label), (expected_data, expected_label) in zip(epoch, expected):
+                    assert_almost_equal(data, expected_data)
+                    assert_almost_equal(label, expected_label)
+        assert os.path.exists(cache_path)
+        # changing the source invalidates the cache
+        with open(data_path, 'w') as fout:
+            for i in range(100):
+                fout.write('1 0:2\n')
+        for epoch in read_all():
+            for data, label in epoch:
+                assert_almost_equal(label, np.ones((10, )))
+                assert_almost_equal(data[:, 0], np.full((10, ), 2))
+        os.remove(data_path)
+        os.remove(cache_path)
+
     check_libSVMIter_synthetic()
+    check_libSVMIter_cache()
     check_libSVMIter_news_data()
 
+def test_LibSVMIter_parse():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_parse.t')
+    with open(data_path, 'w') as fout:
+        fout.write('1.5 0:nan 2:-inf 3:1e-3\n')
+        fout.write('-2 1:Infinity 2:-2.5E+2\n')
+        fout.write('inf 0:.5 3:-7\n')
+    expected_label = np.array([1.5, -2, np.inf], dtype=np.float32)
+    expected_data = np.array([[np.nan, 0, -np.inf, 1e-3],
+                              [0, np.inf, -250, 0],
+                              [0.5, 0, 0, -7]], dtype=np.float32)
+    for num_threads in [1, 4]:
+        data_iter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(4, ), batch_size=3,
+                                     preprocess_threads=num_threads)
+        batch = next(iter(data_iter))
+        assert np.allclose(batch.data[0].asnumpy(), expected_data, equal_nan=True)
+        assert np.allclose(batch.label[0].asnumpy(), expected_label)
+
+    with open(data_path, 'w') as fout:
+        fout.write('1 0:1 2:2\n')
+        fout.write('1 0:1 a:2\n')
+    data_iter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(4, ), batch_size=2)
+    assert_exception(lambda: [batch for batch in data_iter], mx.base.MXNetError)
+    os.remove(data_path)
+
+def test_CSVIter_parse():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_parse.csv')
+    with open(data_path, 'w') as fout:
+        fout.write('nan,-inf,1e-3\n')
+        fout.write('Infinity,-2.5E+2,.5\n')
+        fout.write('+3,-7,0\n')
+    expected = np.array([[np.nan, -np.inf, 1e-3],
+                         [np.inf, -250, 0.5],
+                         [3, -7, 0]], dtype=np.float32)
+    for num_threads in [1, 4]:
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(3, ), batch_size=3,
+                                  preprocess_threads=num_threads)
+        batch = next(iter(data_iter))
+        assert np.allclose(batch.data[0].asnumpy(), expected, equal_nan=True)
+
+    with open(data_path, 'w') as fout:
+        fout.write('1,2,3\n')
+        fout.write('1,x,3\n')
+    data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(3, ), batch_size=2)
+    assert_exception(lambda: [batch for batch in data_iter], mx.base.MXNetError)
+    os.remove(data_path)
+
+def test_MultiProcessIter():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_multiprocess.csv')
+    expected = np.arange(1000 * 4).reshape((1000, 4)) + 1000
+    np.savetxt(data_path, expected, fmt='%d', delimiter=',')
+    data_iter = mx.io.MultiProcessIter('CSVIter', num_workers=2, data_csv=data_path,
+                                       data_shape=(4, ), batch_size=10)
+    for epoch in range(2):
+        data_iter.reset()
+        rows = []
+        for batch in data_iter:
+            assert batch.data[0].context == mx.Context('cpu_shared', 0)
+            data = batch.data[0].asnumpy()
+            rows.append(data[:data.shape[0] - batch.pad])
+        rows = np.concatenate(rows)
+        assert_almost_equal(rows[np.argsort(rows[:, 0])], expected)
+    data_iter.close()
+    # each worker caches its own part
+    cache_path = os.path.join(cwd, 'data_multiprocess.bin')
+    data_iter = mx.io.MultiProcessIter('CSVIter', num_workers=2, data_csv=data_path,
+                                       data_shape=(4, ), batch_size=10, cache_file=cache_path)
+    rows = np.concatenate([batch.data[0].asnumpy()[:10 - batch.pad] for batch in data_iter])
+    assert_almost_equal(rows[np.argsort(rows[:, 0])], expected)
+    data_iter.close()
+    for rank in range(2):
+        os.remove('%s.%d' % (cache_path, rank))
+    # errors of the workers are raised in the trainer instead of hanging
+    assertRaises(mx.base.MXNetError, mx.io.MultiProcessIter, 'CSVIter', num_workers=2,
+                 data_csv=os.path.join(cwd, 'missing.csv'), data_shape=(4, ), batch_size=10)
+    # a separate label file cannot be partitioned
+    assert_exception(lambda: mx.io.CSVIter(data_csv=data_path, data_shape=(4, ),
+                                           label_csv=data_path, label_shape=(4, ),
+                                           batch_size=10, num_parts=2, part_index=0),
+                     mx.base.MXNetError)
+    os.remove(data_path)
+
 @unittest.skip("test fails intermittently. temporarily disabled till it gets fixed. tracked at https://github.com/apache/incubator-mxnet/issues/7826")
 def test_CSVIter():
     def check_CSVIter_synthetic():
@@ -274,6 +437,40 @@ def test_CSVIter():
 
     check_CSVIter_synthetic()
 
+def test_CSVIter_cache():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_cache.csv')
+    cache_path = os.path.join(cwd, 'data_cache.bin')
+    expected = np.arange(300 * 4).reshape((300, 4))
+    np.savetxt(data_path, expected, fmt='%d', delimiter=',')
+    for _ in range(2):
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(4, ), batch_size=30,
+                                  cache_file=cache_path)
+        for epoch in range(2):
+            data_iter.reset()
+            batches = [batch.data[0].asnumpy() for batch in data_iter]
+            assert_almost_equal(np.concatenate(batches), expected)
+    assert os.path.exists(cache_path)
+    os.remove(data_path)
+    os.remove(cache_path)
+
+def test_CSVIter_prefetch():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_prefetch.csv')
+    expected = np.arange(500 * 4).reshape((500, 4))
+    np.savetxt(data_path, expected, fmt='%d', delimiter=',')
+    for ctx in ['cpu', 'cpu_pinned']:
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(4, ), batch_size=10,
+                                  adaptive_prefetch=True, ctx=ctx)
+        for epoch in range(2):
+            data_iter.reset()
+            batches = []
+            for batch in data_iter:
+                assert batch.data[0].context == mx.Context(ctx, 0)
+                batches.append(batch.data[0].asnumpy())
+            assert_almost_equal(np.concatenate(batches), expected)
+    os.remove(data_path)
+
 if __name__ == "__main__":
     test_NDArrayIter()
     if h5py:
@@ -281,5 +478,10 @@ if __name__ == "__main__":
     test_MNISTIter()
     test_Cifar10Rec()
     test_LibSVMIter()
+    test_LibSVMIter_parse()
+    test_CSVIter_parse()
     test_NDArrayIter_csr()
     test_CSVIter()
+    test_CSVIter_cache()
+    test_CSVIter_prefetch()
+    test_MultiProcessIter()
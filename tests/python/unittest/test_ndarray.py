@@ -23,6 +23,7 @@ import unittest
 from nose.tools import raises
 from mxnet.test_utils import almost_equal
 from mxnet.test_utils import assert_almost_equal
+from mxnet.test_utils import assert_exception
 from mxnet.test_utils import default_context
 from mxnet.test_utils import np_reduce
 from mxnet.test_utils import same
@@ -263,6 +264,39 @@ def test_ndarray_saveload():
         assert np.sum(single_ndarray.asnumpy() != single_ndarray_loaded.asnumpy()) == 0
     os.remove(fname)
 
+
+def test_ndarray_saveload_mappable():
+    np.random.seed(0)
+    fname = 'tmp_mappable.bin'
+    legacy_fname = 'tmp_legacy.bin'
+    data = {'arr %d' % i: random_ndarray(np.random.randint(1, 5)) for i in range(10)}
+    data['half'] = data['arr 0'].astype(np.float16)
+    mx.nd.save(fname, data, mappable=True)
+    loaded = mx.nd.load(fname)
+    assert len(loaded) == len(data)
+    for k, x in data.items():
+        assert loaded[k].dtype == x.dtype
+        assert np.sum(x.asnumpy() != loaded[k].asnumpy()) == 0
+    # writes to the mapped arrays are private to the process
+    expected = data['arr 1'].asnumpy()
+    loaded['arr 1'][:] = 0
+    del loaded
+    assert np.sum(mx.nd.load(fname)['arr 1'].asnumpy() != expected) == 0
+    # conversion from the default format
+    mx.nd.save(legacy_fname, data)
+    mx.nd.convert_to_mappable(legacy_fname, fname)
+    converted = mx.nd.load(fname)
+    for k, x in data.items():
+        assert np.sum(x.asnumpy() != converted[k].asnumpy()) == 0
+    del converted
+    # a corrupt alignment, stored after the 8 byte magic and the 4 byte version, is rejected
+    with open(fname, 'r+b') as f:
+        f.seek(12)
+        f.write(np.zeros(1, dtype=np.uint32).tobytes())
+    assert_exception(mx.nd.load, mx.base.MXNetError, fname)
+    os.remove(fname)
+    os.remove(legacy_fname)
+
 def test_ndarray_legacy_load():
     data = []
     for i in range(6):
@@ -17,6 +17,7 @@
 
 # pylint: skip-file
 from __future__ import print_function
+import os
 import numpy as np
 import mxnet as mx
 import random
@@ -548,6 +549,26 @@ def test_embedding():
     assert_almost_equal(grad_map["embed_weight"].asnumpy(), np.dot(np_onehot.T, np_grad))
 
 
+def test_embedding_large_batch():
+    # large enough to take the sorted accumulation, with every row hit many times
+    in_dim, out_dim, batch = 1000, 32, 20000
+    data = mx.sym.Variable("data")
+    embed = mx.sym.Embedding(data=data, input_dim=in_dim, output_dim=out_dim, name="embed")
+    exe_test = embed.simple_bind(default_context(), grad_req={'data': 'null', 'embed_weight': 'write'}, data=(batch,))
+    np_data = np.random.randint(low=0, high=in_dim, size=batch)
+    np_weight = np.random.uniform(-0.01, 0.01, (in_dim, out_dim))
+    exe_test.arg_dict["data"][:] = np_data
+    exe_test.arg_dict["embed_weight"][:] = np_weight
+    exe_test.forward(is_train=True)
+    assert_almost_equal(exe_test.outputs[0].asnumpy(), np_weight[np_data])
+    np_grad = np.random.uniform(-1, 1, exe_test.outputs[0].shape)
+    exe_test.backward([mx.nd.array(np_grad)])
+    expected = np.zeros((in_dim, out_dim))
+    np.add.at(expected, np_data, np_grad)
+    assert_almost_equal(exe_test.grad_dict["embed_weight"].asnumpy(), expected,
+                        rtol=1e-4, atol=1e-4)
+
+
 # check ops handle duplicate input correctly.
 def test_binary_op_duplicate_input():
     data = mx.symbol.Variable('data')
@@ -1105,6 +1126,88 @@ def test_convolution_grouping():
             np.testing.assert_allclose(arr1.asnumpy(), arr2.asnumpy(), rtol=1e-3, atol=1e-4)
 
 
+def np_convolution(x, w, b, dy, stride, pad, num_group):
+    """Convolution of 2-D images, and its gradients for the output gradient dy"""
+    N, C, H, W = x.shape
+    F, Cg, KH, KW = w.shape
+    Fg = F // num_group
+    OH = (H + 2 * pad[0] - KH) // stride[0] + 1
+    OW = (W + 2 * pad[1] - KW) // stride[1] + 1
+    xpad = np.pad(x, ((0, 0), (0, 0), (pad[0], pad[0]), (pad[1], pad[1])), 'constant')
+    rows = lambda i: slice(i, i + stride[0] * OH, stride[0])
+    cols = lambda j: slice(j, j + stride[1] * OW, stride[1])
+    patches = np.empty((N, C, KH, KW, OH, OW))
+    for i in range(KH):
+        for j in range(KW):
+            patches[:, :, i, j] = xpad[:, :, rows(i), cols(j)]
+    y = np.empty((N, F, OH, OW))
+    dw = np.empty(w.shape)
+    dpatches = np.empty(patches.shape)
+    for g in range(num_group):
+        fs, cs = slice(g * Fg, (g + 1) * Fg), slice(g * Cg, (g + 1) * Cg)
+        y[:, fs] = np.einsum('nckluv,fckl->nfuv', patches[:, cs], w[fs])
+        dw[fs] = np.einsum('nckluv,nfuv->fckl', patches[:, cs], dy[:, fs])
+        dpatches[:, cs] = np.einsum('fckl,nfuv->nckluv', w[fs], dy[:, fs])
+    y += b.reshape((1, F, 1, 1))
+    dxpad = np.zeros(xpad.shape)
+    for i in range(KH):
+        for j in range(KW):
+            dxpad[:, :, rows(i), cols(j)] += dpatches[:, :, i, j]
+    dx = dxpad[:, :, pad[0]:pad[0] + H, pad[1]:pad[1] + W]
+    return y, dx, dw, dy.sum(axis=(0, 2, 3))
+
+
+def test_convolution_batched():
+    # a batch lowered into one GEMM (or through Winograd) must match convolving the
+    # images one by one with im2col, and a numpy reference
+    num_images = 5
+    for kernel, stride, pad, num_group, channels, size in [((1, 1), (1, 1), (0, 0), 1, 8, 5),
+                                                           ((1, 1), (2, 2), (0, 0), 1, 8, 6),
+                                                           ((3, 3), (1, 1), (1, 1), 1, 32, 7),
+                                                           ((3, 3), (1, 1), (0, 0), 1, 32, 8),
+                                                           ((3, 3), (2, 2), (1, 1), 2, 8, 9),
+                                                           ((3,), (1,), (1,), 1, 4, 11)]:
+        shape = (num_images, channels) + (size,) * len(kernel)
+        x = mx.sym.Variable('x')
+        w = mx.sym.Variable('w')
+        b = mx.sym.Variable('b')
+        conv = lambda data: mx.sym.Convolution(data=data, weight=w, bias=b, num_filter=32,
+                                               num_group=num_group, kernel=kernel,
+                                               stride=stride, pad=pad)
+        y1 = conv(x)
+        xslice = mx.sym.SliceChannel(data=x, num_outputs=num_images, axis=0)
+        y2 = mx.sym.Concat(*[conv(xslice[i]) for i in range(num_images)], dim=0)
+
+        exe1 = y1.simple_bind(mx.cpu(), x=shape)
+        os.environ['MXNET_CPU_WINOGRAD_CONV'] = '0'
+        try:
+            exe2 = y2.simple_bind(mx.cpu(), x=shape)
+        finally:
+            del os.environ['MXNET_CPU_WINOGRAD_CONV']
+        for arr1, arr2 in zip(exe1.arg_arrays, exe2.arg_arrays):
+            arr1[:] = np.random.normal(size=arr1.shape)
+            arr2[:] = arr1
+        exe1.forward(is_train=True)
+        exe1.backward(exe1.outputs[0])
+        exe2.forward(is_train=True)
+        exe2.backward(exe2.outputs[0])
+
+        for arr1, arr2 in zip(exe1.outputs + exe1.grad_arrays, exe2.outputs + exe2.grad_arrays):
+            np.testing.assert_allclose(arr1.asnumpy(), arr2.asnumpy(), rtol=1e-3, atol=1e-3)
+
+        # the numpy reference works on 2-D images, 1-D ones get a trailing axis
+        to_2d = lambda a: a.reshape(a.shape + (1,) * (4 - a.ndim))
+        args = [to_2d(exe1.arg_dict[name].asnumpy().astype(np.float64)) for name in 'xw']
+        y = to_2d(exe1.outputs[0].asnumpy().astype(np.float64))
+        expected = np_convolution(args[0], args[1], exe1.arg_dict['b'].asnumpy(), y,
+                                  stride + (1,) * (2 - len(kernel)),
+                                  pad + (0,) * (2 - len(kernel)), num_group)
+        actual = [exe1.outputs[0]] + [exe1.grad_dict[name] for name in 'xwb']
+        for arr, ref in zip(actual, expected):
+            np.testing.assert_allclose(arr.asnumpy(), ref.reshape(arr.shape),
+                                       rtol=1e-3, atol=1e-3)
+
+
 @unittest.skip("test fails intermittently. temporarily disabled till it gets fixed. tracked at https://github.com/apache/incubator-mxnet/issues/8712")
 def test_depthwise_convolution():
     for dim in [1,2]:
@@ -1656,6 +1759,31 @@ def test_reduce():
                       mx.symbol.min)
 
 
+def test_reduce_large():
+    # shapes above the single thread limit of the cpu kernels, where the reduced axes are
+    # split across threads and outputs along a kept inner axis are reduced together
+    for shape, axis in [((4, 20000), 1), ((300, 200), None), ((20000, 8), 0),
+                        ((50, 40, 300), 1), ((7, 6000, 3), (0, 1))]:
+        data = np.random.uniform(-1, 1, shape).astype(np.float32)
+        x = mx.nd.array(data)
+        for mx_func, np_func in [(mx.nd.sum, np.sum), (mx.nd.mean, np.mean),
+                                 (mx.nd.max, np.max)]:
+            out = mx_func(x, axis=axis) if axis is not None else mx_func(x)
+            expected = np_func(data.astype(np.float64), axis=axis)
+            assert_almost_equal(out.asnumpy(), np.array(expected).reshape(out.shape),
+                                rtol=1e-4, atol=1e-4)
+
+
+def test_broadcast_large():
+    # few long rows are cut into segments, many short rows run one per thread
+    for lshape, rshape in [((3, 20000), (3, 1)), ((3, 20000), (1, 20000)),
+                           ((20000, 4), (1, 4)), ((2, 1, 40000), (1, 3, 1))]:
+        lhs = np.random.uniform(-1, 1, lshape).astype(np.float32)
+        rhs = np.random.uniform(-1, 1, rshape).astype(np.float32)
+        out = mx.nd.broadcast_add(mx.nd.array(lhs), mx.nd.array(rhs))
+        assert_almost_equal(out.asnumpy(), lhs + rhs)
+
+
 def test_broadcast():
     sample_num = 200
     for i in range(sample_num):
@@ -2762,6 +2890,31 @@ def test_order():
                                              is_ascend=True)])
 
 
+def test_topk_long_rows():
+    # many ties and rows long enough for both the heap and the nth_element selection;
+    # ties must come out in index order, as a stable sort orders them
+    dshape = (3, 700, 4)
+    a_npy = np.random.randint(0, 50, size=dshape).astype(np.float32)
+    for axis in [1, 2]:
+        for k in [1, 10, 64, 65, 300]:
+            if k > dshape[axis]:
+                continue
+            for is_ascend in [True, False]:
+                key = a_npy if is_ascend else -a_npy
+                order = np.argsort(key, axis=axis, kind='mergesort')
+                indices = np.take(order, np.arange(k), axis=axis)
+                values = np.take(np.sort(key, axis=axis), np.arange(k), axis=axis)
+                values = values if is_ascend else -values
+                mask = (np.argsort(order, axis=axis) < k).astype(np.float32)
+                out = mx.nd.topk(mx.nd.array(a_npy), axis=axis, k=k, ret_typ='both',
+                                 is_ascend=is_ascend)
+                assert_almost_equal(out[0].asnumpy(), values)
+                assert_almost_equal(out[1].asnumpy(), indices)
+                out = mx.nd.topk(mx.nd.array(a_npy), axis=axis, k=k, ret_typ='mask',
+                                 is_ascend=is_ascend)
+                assert_almost_equal(out.asnumpy(), mask)
+
+
 def test_blockgrad():
     a = mx.sym.Variable('a')
     b = mx.sym.BlockGrad(a)
@@ -3456,6 +3609,58 @@ def test_log_softmax():
             check_numeric_gradient(sym, [data], rtol=0.05, atol=1e-3)
 
 
+def test_softmax_long_rows():
+    # rows long enough for the vectorized kernels, with a tail, and very small probabilities
+    for shape in [(3, 1037), (2, 5, 203)]:
+        data = np.random.uniform(-20, 20, size=shape).astype(np.float32)
+        data[0, 0] = 100
+        ograd = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+        prob = np_softmax(data)
+        check_symbolic_forward(mx.sym.softmax(), [data], [prob], rtol=1e-4, atol=1e-6)
+        check_symbolic_backward(mx.sym.softmax(), [data], [ograd],
+                                [prob * (ograd - (ograd * prob).sum(axis=-1, keepdims=True))],
+                                rtol=1e-4, atol=1e-6)
+        shifted = data.astype(np.float64) - data.max(axis=-1, keepdims=True)
+        log_prob = shifted - np.log(np.exp(shifted).sum(axis=-1, keepdims=True))
+        check_symbolic_forward(mx.sym.log_softmax(), [data], [log_prob], rtol=1e-4, atol=1e-4)
+        check_symbolic_backward(mx.sym.log_softmax(), [data], [ograd],
+                                [ograd - prob * ograd.sum(axis=-1, keepdims=True)],
+                                rtol=1e-4, atol=1e-5)
+
+
+def test_softmax_cross_entropy():
+    for batch, classes in [(4, 3), (16, 1037)]:
+        data = np.random.uniform(-10, 10, size=(batch, classes)).astype(np.float32)
+        label = np.random.randint(0, classes, size=batch).astype(np.float32)
+        prob = np_softmax(data)
+        picked = prob[np.arange(batch), label.astype(np.int64)]
+        loss = -np.log(np.maximum(picked, 1e-8)).sum()
+        grad = prob.copy()
+        grad[np.arange(batch), label.astype(np.int64)] -= 1
+        sym = mx.sym.softmax_cross_entropy(mx.sym.Variable('data'), mx.sym.Variable('label'))
+        check_symbolic_forward(sym, [data, label], [np.array([loss])], rtol=1e-4, atol=1e-4)
+        check_symbolic_backward(sym, [data, label], [np.array([2.0])], [2 * grad],
+                                grad_req={'data': 'write', 'label': 'null'},
+                                rtol=1e-4, atol=1e-6)
+
+
+def test_softmax_nan():
+    # a NaN logit makes its row NaN, in the vectorized body as well as in the tail of a row
+    for cols in [5, 37]:
+        data = np.random.uniform(-1, 1, size=(4, cols)).astype(np.float32)
+        data[0, 0] = data[1, -1] = data[2, cols // 2] = np.nan
+        x = mx.nd.array(data)
+        label = mx.nd.zeros((4,))
+        for out in [mx.nd.softmax(x), mx.nd.SoftmaxOutput(x, label)]:
+            out = out.asnumpy()
+            assert np.isnan(out[:3]).all()
+            assert_almost_equal(out[3], np_softmax(data[3:])[0], rtol=1e-4, atol=1e-6)
+        out = mx.nd.log_softmax(x).asnumpy()
+        assert np.isnan(out[:3]).all()
+        assert_almost_equal(out[3], np.log(np_softmax(data[3:])[0]), rtol=1e-4, atol=1e-5)
+        assert np.isnan(mx.nd.softmax_cross_entropy(x[1:2], label[:1]).asscalar())
+
+
 def test_pick():
     def test_pick_helper(index_type=np.int32):
         for _ in range(100):
@@ -3616,6 +3821,40 @@ def test_ctc_loss_grad():
     check_ctc_loss_grad('last')
 
 
+def test_ctc_loss_batch():
+    # sequences of different lengths in one batch give the same loss and gradient as alone
+    np.random.seed(7)
+    seq_len, batch, alphabet, max_label_len = 40, 13, 12, 9
+    acts = np.random.normal(0, 3, (seq_len, batch, alphabet)).astype(np.float32)
+    data_lens = np.random.randint(max_label_len * 2, seq_len + 1, batch)
+    label_lens = np.random.randint(0, max_label_len + 1, batch)
+    labels = np.zeros((batch, max_label_len), dtype=np.float32)
+    for i in range(batch):
+        labels[i, :label_lens[i]] = np.random.randint(1, alphabet, label_lens[i])
+        if label_lens[i] > 1:
+            labels[i, 1] = labels[i, 0]
+
+    def ctc(acts, labels, data_lens, label_lens):
+        data = mx.nd.array(acts)
+        data.attach_grad()
+        with mx.autograd.record():
+            loss = mx.nd.contrib.CTCLoss(data, mx.nd.array(labels),
+                                         mx.nd.array(data_lens), mx.nd.array(label_lens),
+                                         use_data_lengths=True, use_label_lengths=True)
+        loss.backward()
+        return loss.asnumpy(), data.grad.asnumpy()
+
+    with default_context():
+        loss, grad = ctc(acts, labels, data_lens, label_lens)
+        for i in range(batch):
+            loss_i, grad_i = ctc(acts[:, i:i+1], labels[i:i+1], data_lens[i:i+1],
+                                 label_lens[i:i+1])
+            assert_almost_equal(loss[i:i+1], loss_i, rtol=1e-5, atol=1e-5)
+            assert_almost_equal(grad[:, i:i+1], grad_i, rtol=1e-5, atol=1e-5)
+        padding = np.arange(seq_len)[:, None] >= data_lens[None, :]
+        assert np.all(grad[padding] == 0)
+
+
 def test_quantization_op():
     min0 = mx.nd.array([0.0])
     max0 = mx.nd.array([1.0])
@@ -0,0 +1,195 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import ctypes
+import os
+import tempfile
+import threading
+import numpy as np
+import mxnet as mx
+from mxnet.base import _LIB, check_call, c_str, c_array, mx_uint
+
+mx_float_p = ctypes.POINTER(ctypes.c_float)
+
+
+def _fc_model(num_input, num_hidden, softmax=False):
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=num_hidden, name='fc')
+    net = mx.sym.Activation(net, act_type='tanh')
+    if softmax:
+        # like a training checkpoint, softmax_label is an argument missing from the params
+        net = mx.sym.SoftmaxOutput(net, name='softmax')
+    weight = np.random.uniform(-1, 1, (num_hidden, num_input)).astype(np.float32)
+    bias = np.random.uniform(-1, 1, (num_hidden,)).astype(np.float32)
+    fname = os.path.join(tempfile.mkdtemp(), 'fc.params')
+    mx.nd.save(fname, {'arg:fc_weight': mx.nd.array(weight), 'arg:fc_bias': mx.nd.array(bias)})
+    with open(fname, 'rb') as f:
+        param_bytes = bytearray(f.read())
+
+    def reference(x):
+        y = np.tanh(x.dot(weight.T) + bias)
+        if softmax:
+            y = np.exp(y - y.max(axis=1, keepdims=True))
+            y /= y.sum(axis=1, keepdims=True)
+        return y
+    return net, param_bytes, fname, reference
+
+
+def _predict(handle, x, num_hidden):
+    check_call(_LIB.MXPredSetInput(handle, c_str('data'), x.ctypes.data_as(mx_float_p),
+                                   mx_uint(x.size)))
+    check_call(_LIB.MXPredForward(handle))
+    y = np.zeros((x.shape[0], num_hidden), dtype=np.float32)
+    check_call(_LIB.MXPredGetOutput(handle, mx_uint(0), y.ctypes.data_as(mx_float_p),
+                                    mx_uint(y.size)))
+    return y
+
+
+def test_predictor_param_file():
+    num_input, num_hidden = 6, 5
+    np.random.seed(0)
+    net, _, fname, reference = _fc_model(num_input, num_hidden)
+    mappable_fname = fname + '.mappable'
+    mx.nd.convert_to_mappable(fname, mappable_fname)
+    for param_file in (fname, mappable_fname):
+        handle = ctypes.c_void_p()
+        check_call(_LIB.MXPredCreateFromParamFile(
+            c_str(net.tojson()), c_str(param_file), ctypes.c_int(1), ctypes.c_int(0),
+            mx_uint(1), c_array(ctypes.c_char_p, [c_str('data')]),
+            c_array(mx_uint, [0, 2]), c_array(mx_uint, [2, num_input]),
+            mx_uint(0), None, ctypes.byref(handle)))
+        # a second predictor for another batch size shares the weights of the first one
+        shared = ctypes.c_void_p()
+        check_call(_LIB.MXPredCreateShared(
+            handle, ctypes.c_int(1), ctypes.c_int(0),
+            mx_uint(1), c_array(ctypes.c_char_p, [c_str('data')]),
+            c_array(mx_uint, [0, 2]), c_array(mx_uint, [3, num_input]),
+            ctypes.byref(shared)))
+        try:
+            for h, batch_size in ((handle, 2), (shared, 3)):
+                x = np.random.uniform(-1, 1, (batch_size, num_input)).astype(np.float32)
+                assert np.allclose(_predict(h, x, num_hidden), reference(x),
+                                   rtol=1e-5, atol=1e-5)
+        finally:
+            check_call(_LIB.MXPredFree(shared))
+            check_call(_LIB.MXPredFree(handle))
+
+
+def test_predictor_shared_softmax():
+    num_input, num_hidden = 6, 5
+    np.random.seed(0)
+    net, param_bytes, _, reference = _fc_model(num_input, num_hidden, softmax=True)
+    handle = ctypes.c_void_p()
+    check_call(_LIB.MXPredCreate(
+        c_str(net.tojson()), (ctypes.c_char * len(param_bytes)).from_buffer(param_bytes),
+        ctypes.c_int(len(param_bytes)), ctypes.c_int(1), ctypes.c_int(0),
+        mx_uint(1), c_array(ctypes.c_char_p, [c_str('data')]),
+        c_array(mx_uint, [0, 2]), c_array(mx_uint, [2, num_input]), ctypes.byref(handle)))
+    # softmax_label has the batch size of each predictor, only the weights are shared
+    shared = ctypes.c_void_p()
+    check_call(_LIB.MXPredCreateShared(
+        handle, ctypes.c_int(1), ctypes.c_int(0),
+        mx_uint(1), c_array(ctypes.c_char_p, [c_str('data')]),
+        c_array(mx_uint, [0, 2]), c_array(mx_uint, [3, num_input]),
+        ctypes.byref(shared)))
+    try:
+        for h, batch_size in ((handle, 2), (shared, 3)):
+            x = np.random.uniform(-1, 1, (batch_size, num_input)).astype(np.float32)
+            assert np.allclose(_predict(h, x, num_hidden), reference(x), rtol=1e-5, atol=1e-5)
+    finally:
+        check_call(_LIB.MXPredFree(shared))
+        check_call(_LIB.MXPredFree(handle))
+
+
+def test_batch_predictor_softmax():
+    num_input, num_hidden, max_batch_size = 6, 5, 3
+    np.random.seed(0)
+    net, param_bytes, _, reference = _fc_model(num_input, num_hidden, softmax=True)
+    # every batch size is bound on creation, with its own softmax_label
+    handle = ctypes.c_void_p()
+    check_call(_LIB.MXPredBatchCreate(
+        c_str(net.tojson()),
+        (ctypes.c_char * len(param_bytes)).from_buffer(param_bytes),
+        ctypes.c_int(len(param_bytes)), ctypes.c_int(1), ctypes.c_int(0),
+        mx_uint(1), c_array(ctypes.c_char_p, [c_str('data')]),
+        c_array(mx_uint, [0, 1]), c_array(mx_uint, [num_input]),
+        mx_uint(max_batch_size), mx_uint(2000), ctypes.byref(handle)))
+    try:
+        x = np.random.uniform(-1, 1, (num_input,)).astype(np.float32)
+        y = np.zeros((num_hidden,), dtype=np.float32)
+        check_call(_LIB.MXPredBatchPredict(
+            handle, c_array(mx_float_p, [x.ctypes.data_as(mx_float_p)]),
+            c_array(mx_float_p, [y.ctypes.data_as(mx_float_p)])))
+        assert np.allclose(y, reference(x[None])[0], rtol=1e-5, atol=1e-5)
+    finally:
+        check_call(_LIB.MXPredBatchFree(handle))
+
+
+def test_batch_predictor():
+    num_input, num_hidden, max_batch_size = 6, 5, 4
+    np.random.seed(0)
+    net, param_bytes, _, reference = _fc_model(num_input, num_hidden)
+    handle = ctypes.c_void_p()
+    check_call(_LIB.MXPredBatchCreate(
+        c_str(net.tojson()),
+        (ctypes.c_char * len(param_bytes)).from_buffer(param_bytes),
+        ctypes.c_int(len(param_bytes)), ctypes.c_int(1), ctypes.c_int(0),
+        mx_uint(1), c_array(ctypes.c_char_p, [c_str('data')]),
+        c_array(mx_uint, [0, 1]), c_array(mx_uint, [num_input]),
+        mx_uint(max_batch_size), mx_uint(2000), ctypes.byref(handle)))
+    try:
+        shape_data = ctypes.POINTER(mx_uint)()
+        shape_ndim = mx_uint()
+        check_call(_LIB.MXPredBatchGetOutputShape(handle, mx_uint(0), ctypes.byref(shape_data),
+                                                  ctypes.byref(shape_ndim)))
+        assert tuple(shape_data[:shape_ndim.value]) == (num_hidden,)
+
+        num_requests = 11
+        inputs = [np.random.uniform(-1, 1, (num_input,)).astype(np.float32)
+                  for _ in range(num_requests)]
+        outputs = [np.zeros((num_hidden,), dtype=np.float32) for _ in range(num_requests)]
+        errors = []
+
+        def predict(i):
+            try:
+                check_call(_LIB.MXPredBatchPredict(
+                    handle, c_array(mx_float_p, [inputs[i].ctypes.data_as(mx_float_p)]),
+                    c_array(mx_float_p, [outputs[i].ctypes.data_as(mx_float_p)])))
+            except mx.base.MXNetError as err:
+                errors.append(err)
+
+        threads = [threading.Thread(target=predict, args=(i,)) for i in range(num_requests)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert not errors
+        for x, y in zip(inputs, outputs):
+            assert np.allclose(y, reference(x[None])[0], rtol=1e-5, atol=1e-5)
+
+        stats = [mx_uint(), mx_uint(), ctypes.c_float(), ctypes.c_float(), ctypes.c_float()]
+        check_call(_LIB.MXPredBatchGetStats(handle, *[ctypes.byref(s) for s in stats]))
+        assert stats[0].value == num_requests
+        assert -(-num_requests // max_batch_size) <= stats[1].value <= num_requests
+        assert 0 <= stats[2].value <= stats[3].value
+    finally:
+        check_call(_LIB.MXPredBatchFree(handle))
+
+
+if __name__ == '__main__':
+    import nose
+    nose.runmodule()